@@ -27,6 +27,8 @@
 #include "entry.h"
 #include "entrygroup.h"
 #include "derivedvalue.h"
+#include "valueindex.h"
+#include "fulltextindex.h"
 #include "fieldformat.h"
 #include "utils/string_utils.h"
 #include "utils/stringset.h"
@@ -40,15 +42,20 @@
 using namespace Tellico;
 using Tellico::Data::Collection;
 
+namespace {
+  // the value pool is not swept until it has at least this many values
+  static const int MIN_VALUE_POOL_SWEEP_SIZE = 1024;
+}
+
 const QString Collection::s_peopleGroupName = QLatin1String("_people");
 
 Collection::Collection(const QString& title_)
-    : QObject(), QSharedData(), m_nextEntryId(1), m_title(title_), m_trackGroups(false) {
+    : QObject(), QSharedData(), m_nextEntryId(1), m_title(title_), m_fullTextIndex(nullptr), m_allFieldsModified(false), m_valuePoolSweepSize(MIN_VALUE_POOL_SWEEP_SIZE), m_derivedFieldsUsingFound(false), m_fieldGeneration(0), m_trackGroups(false) {
   m_id = getID();
 }
 
 Collection::Collection(bool addDefaultFields_, const QString& title_)
-    : QObject(), QSharedData(), m_nextEntryId(1), m_title(title_), m_trackGroups(false) {
+    : QObject(), QSharedData(), m_nextEntryId(1), m_title(title_), m_fullTextIndex(nullptr), m_allFieldsModified(false), m_valuePoolSweepSize(MIN_VALUE_POOL_SWEEP_SIZE), m_derivedFieldsUsingFound(false), m_fieldGeneration(0), m_trackGroups(false) {
   if(m_title.isEmpty()) {
     m_title = i18n("My Collection");
   }
@@ -68,6 +75,8 @@ Collection::~Collection() {
   }
   qDeleteAll(m_entryGroupDicts);
   m_entryGroupDicts.clear();
+  qDeleteAll(m_valueIndexes);
+  delete m_fullTextIndex;
 }
 
 bool Collection::addFields(Tellico::Data::FieldList list_) {
@@ -93,6 +102,7 @@ bool Collection::addField(Tellico::Data::FieldPtr field_) {
   m_fields.append(field_);
   m_fieldByName.insert(field_->name(), field_.data());
   m_fieldByTitle.insert(field_->title(), field_.data());
+  addFieldSlot(field_->name());
 
   if(field_->formatType() == FieldFormat::FormatName) {
     m_peopleFields.append(field_); // list of people attributes
@@ -134,6 +144,9 @@ bool Collection::addField(Tellico::Data::FieldPtr field_) {
   }
 
   // refresh all dependent fields, in case one references this new one
+  invalidateDerivedValues();
+  ++m_fieldGeneration;
+  invalidateValueIndexes();
   foreach(FieldPtr existingField, m_fields) {
     if(existingField->hasFlag(Field::Derived)) {
       emit signalRefreshField(existingField);
@@ -223,6 +236,9 @@ bool Collection::mergeField(Tellico::Data::FieldPtr newField_) {
 
   // combine flags
   currField->setFlags(currField->flags() | newField_->flags());
+  // the template or the flags may have changed
+  invalidateDerivedValues();
+  ++m_fieldGeneration;
   return true;
 }
 
@@ -282,8 +298,8 @@ bool Collection::modifyField(Tellico::Data::FieldPtr newField_) {
     }
   }
 
-  // keep track of if the entry groups will need to be reset
-  bool resetGroups = false;
+  // keep track of which entry groups will need to be reset
+  QStringList resetGroups;
 
   // if format is different, go ahead and invalidate all formatted entry values
   if(oldField->formatType() != newField_->formatType()) {
@@ -291,7 +307,13 @@ bool Collection::modifyField(Tellico::Data::FieldPtr newField_) {
     foreach(EntryPtr entry, m_entries) {
       entry->invalidateFormattedFieldValue(fieldName);
     }
-    resetGroups = true;
+    resetGroups << fieldName;
+  } else if(oldField->type() != newField_->type() ||
+            oldField->property(QLatin1String("lcc")) != newField_->property(QLatin1String("lcc"))) {
+    // the cached sort keys depend on the field type, too
+    foreach(EntryPtr entry, m_entries) {
+      entry->invalidateFormattedFieldValue(fieldName);
+    }
   }
 
   // check to see if the people "pseudo-group" needs to be updated
@@ -301,7 +323,7 @@ bool Collection::modifyField(Tellico::Data::FieldPtr newField_) {
   if(wasPeople) {
     m_peopleFields.removeAll(oldField);
     if(!isPeople) {
-      resetGroups = true;
+      resetGroups << s_peopleGroupName;
     }
   }
   if(isPeople) {
@@ -314,7 +336,7 @@ bool Collection::modifyField(Tellico::Data::FieldPtr newField_) {
     }
     m_peopleFields.append(newField_);
     if(!wasPeople) {
-      resetGroups = true;
+      resetGroups << s_peopleGroupName;
     }
   }
 
@@ -324,9 +346,10 @@ bool Collection::modifyField(Tellico::Data::FieldPtr newField_) {
     if(!isGrouped) {
       // in order to keep list in the same order, don't remove unless new field is not groupable
       m_entryGroups.removeAll(fieldName);
+      // clear the groups out of the entries before the dict goes away
+      invalidateGroups(QStringList() << fieldName);
       delete m_entryGroupDicts.take(fieldName); // no auto-delete here
       myDebug() << "no longer grouped: " << fieldName;
-      resetGroups = true;
     } else {
       // don't do this, it wipes out the old groups!
 //      m_entryGroupDicts.replace(fieldName, new EntryGroupDict());
@@ -338,7 +361,7 @@ bool Collection::modifyField(Tellico::Data::FieldPtr newField_) {
       // cache the possible groups of entries
       m_entryGroups << fieldName;
     }
-    resetGroups = true;
+    // the new dict is empty and gets populated on demand
   }
 
   if(oldField->type() == Field::Image) {
@@ -348,11 +371,16 @@ bool Collection::modifyField(Tellico::Data::FieldPtr newField_) {
     m_imageFields.append(newField_);
   }
 
-  if(resetGroups) {
+  if(!resetGroups.isEmpty()) {
 //    myLog() << "invalidating groups";
-    invalidateGroups();
+    invalidateGroups(resetGroups);
   }
 
+  // a derived value might use the field by name or title, or use its formatted value
+  invalidateDerivedValues();
+  ++m_fieldGeneration;
+  invalidateValueIndexes();
+
   // now to update all entries if the field is a derived value and the template changed
   if(newField_->hasFlag(Field::Derived) &&
      oldField->property(QLatin1String("template")) != newField_->property(QLatin1String("template"))) {
@@ -402,8 +430,8 @@ bool Collection::removeField(Tellico::Data::FieldPtr field_, bool force_/*=false
   }
 
   if(field_->hasFlag(Field::AllowGrouped)) {
-    EntryGroupDict* dict = m_entryGroupDicts.take(field_->name());
-    qDeleteAll(*dict);
+    invalidateGroups(QStringList() << field_->name());
+    delete m_entryGroupDicts.take(field_->name());
     m_entryGroups.removeAll(field_->name());
     if(field_->name() == m_defaultGroupField && !m_entryGroups.isEmpty()) {
       setDefaultGroupField(m_entryGroups.first());
@@ -415,6 +443,9 @@ bool Collection::removeField(Tellico::Data::FieldPtr field_, bool force_/*=false
   // refresh all dependent fields, rather lazy, but there's
   // likely to be weird effects when checking dependent fields
   // while removing one, so refresh all of them
+  invalidateDerivedValues();
+  ++m_fieldGeneration;
+  invalidateValueIndexes();
   foreach(FieldPtr field, m_fields) {
     if(field->hasFlag(Field::Derived)) {
       emit signalRefreshField(field);
@@ -442,6 +473,10 @@ void Collection::addEntries(const Tellico::Data::EntryList& entries_) {
     return;
   }
 
+  const bool hasCDate = hasField(QLatin1String("cdate"));
+  const bool hasMDate = hasField(QLatin1String("mdate"));
+  const QString today = QDate::currentDate().toString(Qt::ISODate);
+  m_entries.reserve(m_entries.count() + entries_.count());
   foreach(EntryPtr entry, entries_) {
     if(!entry) {
       Q_ASSERT(entry);
@@ -470,20 +505,23 @@ void Collection::addEntries(const Tellico::Data::EntryList& entries_) {
     }
     m_entryById.insert(entry->id(), entry.data());
 
-    if(hasField(QLatin1String("cdate")) && entry->field(QLatin1String("cdate")).isEmpty()) {
-      entry->setField(QLatin1String("cdate"), QDate::currentDate().toString(Qt::ISODate));
+    if(hasCDate && entry->field(QLatin1String("cdate")).isEmpty()) {
+      entry->setField(QLatin1String("cdate"), today);
     }
-    if(hasField(QLatin1String("mdate")) && entry->field(QLatin1String("mdate")).isEmpty()) {
-      entry->setField(QLatin1String("mdate"), QDate::currentDate().toString(Qt::ISODate));
+    if(hasMDate && entry->field(QLatin1String("mdate")).isEmpty()) {
+      entry->setField(QLatin1String("mdate"), today);
     }
   }
+  foreach(EntryPtr entry, entries_) {
+    entryValueModified(entry.data(), QString());
+  }
   if(m_trackGroups) {
     populateCurrentDicts(entries_, fieldNames());
+    emitGroupsModified();
   }
 }
 
 void Collection::removeEntriesFromDicts(const Tellico::Data::EntryList& entries_, const QStringList& fields_) {
-  QSet<EntryGroup*> modifiedGroups;
   foreach(EntryPtr entry, entries_) {
     // need a copy of the vector since it gets changed
     QList<EntryGroup*> groups = entry->groups();
@@ -494,23 +532,26 @@ void Collection::removeEntriesFromDicts(const Tellico::Data::EntryList& entries_
         continue;
       }
       if(entry->removeFromGroup(group)) {
-        modifiedGroups.insert(group);
+        m_modifiedGroups.insert(group);
       }
-      if(group->isEmpty() && !m_groupsToDelete.contains(group)) {
-        m_groupsToDelete.push_back(group);
+      if(group->isEmpty()) {
+        m_groupsToDelete.insert(group);
       }
     }
   }
-  if(!modifiedGroups.isEmpty()) {
-    emit signalGroupsModified(CollPtr(this), modifiedGroups.toList());
-  }
 }
 
 // this function gets called whenever an entry is modified. Its purpose is to keep the
-// groupDicts current. It first removes the entry from every group to which it belongs,
-// then it repopulates the dicts with the entry's fields
+// groupDicts current. For every populated dict that depends on the modified fields, the
+// entry's current group names are compared to the groups it already belongs to, and only
+// the memberships that changed are added or removed. Dicts that haven't been populated
+// yet are skipped, since they get built on demand
 void Collection::updateDicts(const Tellico::Data::EntryList& entries_, const QStringList& fields_) {
-  if(entries_.isEmpty() || !m_trackGroups) {
+  if(entries_.isEmpty()) {
+    return;
+  }
+  // the value indexes are kept current by entryValueModified()
+  if(!m_trackGroups) {
     return;
   }
   QStringList modifiedFields = fields_;
@@ -518,8 +559,18 @@ void Collection::updateDicts(const Tellico::Data::EntryList& entries_, const QSt
 //    myDebug() << "updating all fields";
     modifiedFields = fieldNames();
   }
-  removeEntriesFromDicts(entries_, modifiedFields);
-  populateCurrentDicts(entries_, modifiedFields);
+
+  QHash<QString, EntryGroupDict*>::const_iterator dictIt = m_entryGroupDicts.constBegin();
+  for( ; dictIt != m_entryGroupDicts.constEnd(); ++dictIt) {
+    if(dictIt.value()->isEmpty() || !dictDependsOnFields(dictIt.key(), modifiedFields)) {
+      continue;
+    }
+    const bool isBool = hasField(dictIt.key()) && fieldByName(dictIt.key())->type() == Field::Bool;
+    foreach(EntryPtr entry, entries_) {
+      updateEntryGroups(entry, dictIt.value(), dictIt.key(), isBool);
+    }
+  }
+  emitGroupsModified();
   cleanGroups();
 }
 
@@ -529,11 +580,33 @@ bool Collection::removeEntries(const Tellico::Data::EntryList& vec_) {
   }
 
   removeEntriesFromDicts(vec_, fieldNames());
+  emitGroupsModified();
   bool success = true;
+  // removing each entry from the list would be quadratic for large removals, like undoing
+  // an append, so the list is filtered in a single pass instead
+  QSet<Entry*> removed;
+  removed.reserve(vec_.count());
   foreach(EntryPtr entry, vec_) {
-    m_entryById.remove(entry->id());
-    m_entries.removeAll(entry);
+    foreach(ValueIndex* index, m_valueIndexes) {
+      index->removeEntry(entry->id());
+    }
+    if(m_fullTextIndex) {
+      m_fullTextIndex->removeEntry(entry->id());
+    }
+    m_modifiedEntryIds.remove(entry->id());
+    if(m_entryById.value(entry->id()) == entry.data()) {
+      m_entryById.remove(entry->id());
+    }
+    removed.insert(entry.data());
   }
+  EntryList remaining;
+  remaining.reserve(m_entries.count());
+  foreach(EntryPtr entry, m_entries) {
+    if(!removed.contains(entry.data())) {
+      remaining.append(entry);
+    }
+  }
+  m_entries.swap(remaining);
   cleanGroups();
   return success;
 }
@@ -590,16 +663,143 @@ QString Collection::fieldTitleByName(const QString& name_) const {
 }
 
 QStringList Collection::valuesByFieldName(const QString& name_) const {
-  if(name_.isEmpty()) {
-    return QStringList();
+  ValueIndex* index = valueIndex(name_);
+  return index ? index->values() : QStringList();
+}
+
+QHash<QString, int> Collection::valueCountsByFieldName(const QString& name_) const {
+  ValueIndex* index = valueIndex(name_);
+  return index ? index->valueCounts() : QHash<QString, int>();
+}
+
+const Tellico::Data::FullTextIndex* Collection::fullTextIndex() const {
+  updateValueIndexes();
+  if(!m_fullTextIndex) {
+    m_fullTextIndex = new FullTextIndex();
+    foreach(EntryPtr entry, m_entries) {
+      m_fullTextIndex->addEntry(entry->id(), entryText(entry));
+    }
   }
+  return m_fullTextIndex;
+}
 
-  StringSet values;
-  foreach(EntryPtr entry, m_entries) {
-    values.add(FieldFormat::splitValue(entry->field(name_)));
-  } // end entry loop
+Tellico::Data::ValueIndex* Collection::valueIndex(const QString& fieldName_) const {
+  if(fieldName_.isEmpty() || !hasField(fieldName_)) {
+    return nullptr;
+  }
+  updateValueIndexes();
+  ValueIndex* index = m_valueIndexes.value(fieldName_);
+  if(!index) {
+    index = new ValueIndex();
+    foreach(EntryPtr entry, m_entries) {
+      index->addEntry(entry->id(), entry->field(fieldName_));
+    }
+    m_valueIndexes.insert(fieldName_, index);
+  }
+  return index;
+}
 
-  return values.toList();
+void Collection::entryValueModified(Tellico::Data::Entry* entry_, const QString& fieldName_) {
+  // an index which hasn't been built yet gets the current values anyway, and entries
+  // which aren't in the collection yet get indexed when they are added
+  if((m_valueIndexes.isEmpty() && !m_fullTextIndex) || m_entryById.value(entry_->id()) != entry_) {
+    return;
+  }
+  m_modifiedEntryIds.insert(entry_->id());
+  if(fieldName_.isEmpty()) {
+    m_allFieldsModified = true;
+  } else {
+    m_modifiedFieldNames.insert(fieldName_);
+  }
+}
+
+void Collection::updateValueIndexes() const {
+  if(m_modifiedEntryIds.isEmpty()) {
+    return;
+  }
+  EntryList entries;
+  entries.reserve(m_modifiedEntryIds.count());
+  foreach(ID id, m_modifiedEntryIds) {
+    Entry* entry = m_entryById.value(id);
+    if(entry) {
+      entries.append(EntryPtr(entry));
+    }
+  }
+  if(m_fullTextIndex) {
+    // a modified field might change a derived or formatted value, so always update all the text
+    foreach(EntryPtr entry, entries) {
+      m_fullTextIndex->updateEntry(entry->id(), entryText(entry));
+    }
+  }
+  QHash<QString, ValueIndex*>::const_iterator it = m_valueIndexes.constBegin();
+  for( ; it != m_valueIndexes.constEnd(); ++it) {
+    // derived values could depend on any of the modified fields
+    FieldPtr field = fieldByName(it.key());
+    if(!m_allFieldsModified && !m_modifiedFieldNames.contains(it.key()) && !(field && field->hasFlag(Field::Derived))) {
+      continue;
+    }
+    foreach(EntryPtr entry, entries) {
+      it.value()->updateEntry(entry->id(), entry->field(it.key()));
+    }
+  }
+  m_modifiedEntryIds.clear();
+  m_modifiedFieldNames.clear();
+  m_allFieldsModified = false;
+}
+
+void Collection::invalidateValueIndexes() {
+  qDeleteAll(m_valueIndexes);
+  m_valueIndexes.clear();
+  delete m_fullTextIndex;
+  m_fullTextIndex = nullptr;
+  m_modifiedEntryIds.clear();
+  m_modifiedFieldNames.clear();
+  m_allFieldsModified = false;
+}
+
+// all the text which a filter might match, every value and every formatted value
+QStringList Collection::entryText(Tellico::Data::EntryPtr entry_) const {
+  QStringList text = entry_->fieldValues();
+  foreach(FieldPtr field, m_fields) {
+    if(field->hasFlag(Field::Derived)) {
+      text += entry_->field(field);
+    }
+    if(field->formatType() != FieldFormat::FormatNone) {
+      text += entry_->formattedField(field);
+    }
+  }
+  return text;
+}
+
+int Collection::addFieldSlot(const QString& name_) {
+  QHash<QString, int>::const_iterator it = m_fieldSlots.constFind(name_);
+  if(it != m_fieldSlots.constEnd()) {
+    return it.value();
+  }
+  const int slot = m_fieldSlotNames.count();
+  m_fieldSlots.insert(name_, slot);
+  m_fieldSlotNames << name_;
+  return slot;
+}
+
+QString Collection::shareValue(const QString& value_) {
+  QSet<QString>::const_iterator it = m_valuePool.constFind(value_);
+  if(it != m_valuePool.constEnd()) {
+    return *it;
+  }
+  // values which are no longer used by any entry are only referenced by the pool
+  // so sweep them out once in a while, waiting twice as long after each sweep
+  if(m_valuePool.count() >= m_valuePoolSweepSize) {
+    QMutableSetIterator<QString> poolIt(m_valuePool);
+    while(poolIt.hasNext()) {
+      if(poolIt.next().isDetached()) {
+        poolIt.remove();
+      }
+    }
+    m_valuePoolSweepSize = qMax(MIN_VALUE_POOL_SWEEP_SIZE, 2*m_valuePool.count());
+  }
+  m_valuePool.insert(value_);
+  return value_;
 }
 
 Tellico::Data::FieldPtr Collection::fieldByName(const QString& name_) const {
@@ -639,11 +839,12 @@ Tellico::Data::EntryGroupDict* Collection::entryGroupDictByName(const QString& n
   }
   EntryGroupDict* dict = m_entryGroupDicts.value(name_);
   if(dict && dict->isEmpty()) {
-    const bool b = signalsBlocked();
-    // block signals so all the group created/modified signals don't fire
-    blockSignals(true);
+    // the group created/modified signals shouldn't fire when populating on demand
+    // but keep any groups from a pending update
+    QSet<EntryGroup*> pendingGroups;
+    pendingGroups.swap(m_modifiedGroups);
     populateDict(dict, name_, m_entries);
-    blockSignals(b);
+    m_modifiedGroups.swap(pendingGroups);
   }
   return dict;
 }
@@ -653,33 +854,87 @@ void Collection::populateDict(Tellico::Data::EntryGroupDict* dict_, const QStrin
   Q_ASSERT(dict_);
   const bool isBool = hasField(fieldName_) && fieldByName(fieldName_)->type() == Field::Bool;
 
-  QSet<EntryGroup*> modifiedGroups;
   foreach(EntryPtr entry, entries_) {
-    const QStringList groups = entryGroupNamesByField(entry, fieldName_);
-    foreach(QString groupTitle, groups) { // krazy:exclude=foreach
-      // find the group for this group name
-      // bool fields use the field title
-      if(isBool && !groupTitle.isEmpty()) {
-        groupTitle = fieldTitleByName(fieldName_);
-      }
-      EntryGroup* group = dict_->value(groupTitle);
-      // if the group doesn't exist, create it
-      if(!group) {
-        group = new EntryGroup(groupTitle, fieldName_);
-        dict_->insert(groupTitle, group);
-      } else if(group->isEmpty()) {
-        // if it's empty, then it was previously added to the vector of groups to delete
-        // remove it from that vector now that we're adding to it
-        m_groupsToDelete.removeOne(group);
+    updateEntryGroups(entry, dict_, fieldName_, isBool);
+  } // end entry loop
+}
+
+void Collection::updateEntryGroups(Tellico::Data::EntryPtr entry_, Tellico::Data::EntryGroupDict* dict_,
+                                   const QString& fieldName_, bool isBool_) {
+  QStringList groupTitles = entryGroupNamesByField(entry_, fieldName_);
+  // bool fields use the field title
+  if(isBool_) {
+    for(int i = 0; i < groupTitles.count(); ++i) {
+      if(!groupTitles.at(i).isEmpty()) {
+        groupTitles[i] = fieldTitleByName(fieldName_);
       }
-      if(entry->addToGroup(group)) {
-        modifiedGroups.insert(group);
+    }
+  }
+
+  // first, remove the entry from any group in the dict that it no longer belongs to
+  // need a copy of the list since it gets changed
+  const QList<EntryGroup*> groups = entry_->groups();
+  foreach(EntryGroup* group, groups) {
+    if(group->fieldName() != fieldName_) {
+      continue;
+    }
+    // groups that the entry still belongs to are left alone
+    if(groupTitles.removeAll(group->groupName()) > 0) {
+      continue;
+    }
+    if(entry_->removeFromGroup(group)) {
+      m_modifiedGroups.insert(group);
+    }
+    if(group->isEmpty()) {
+      m_groupsToDelete.insert(group);
+    }
+  }
+
+  // whatever is left is a new group for the entry
+  foreach(const QString& groupTitle, groupTitles) {
+    // find the group for this group name
+    EntryGroup* group = dict_->value(groupTitle);
+    // if the group doesn't exist, create it
+    if(!group) {
+      group = new EntryGroup(groupTitle, fieldName_);
+      dict_->insert(groupTitle, group);
+    } else if(group->isEmpty()) {
+      // if it's empty, then it was previously added to the set of groups to delete
+      // remove it from that set now that we're adding to it
+      m_groupsToDelete.remove(group);
+    }
+    if(entry_->addToGroup(group)) {
+      m_modifiedGroups.insert(group);
+    }
+  } // end group loop
+}
+
+// a dict depends on a field if it groups by that field, or if it's the people
+// pseudo-group and the field is a person field. Derived values might depend on anything
+bool Collection::dictDependsOnFields(const QString& dictName_, const QStringList& fields_) const {
+  if(fields_.contains(dictName_)) {
+    return true;
+  }
+  if(dictName_ == s_peopleGroupName) {
+    foreach(FieldPtr field, m_peopleFields) {
+      if(fields_.contains(field->name())) {
+        return true;
       }
-    } // end group loop
-  } // end entry loop
-  if(!modifiedGroups.isEmpty()) {
-    emit signalGroupsModified(CollPtr(this), modifiedGroups.toList());
+    }
+    return false;
   }
+  FieldPtr field = fieldByName(dictName_);
+  return field && field->hasFlag(Field::Derived);
+}
+
+void Collection::emitGroupsModified() {
+  if(m_modifiedGroups.isEmpty()) {
+    return;
+  }
+  // emit a single signal for all the groups modified by a single operation
+  const QList<EntryGroup*> groups = m_modifiedGroups.toList();
+  m_modifiedGroups.clear();
+  emit signalGroupsModified(CollPtr(this), groups);
 }
 
 void Collection::populateCurrentDicts(const Tellico::Data::EntryList& entries_, const QStringList& fields_) {
@@ -759,6 +1014,29 @@ void Collection::invalidateGroups() {
     entry->clearGroups();
   }
   blockSignals(false);
+  m_groupsToDelete.clear();
+  m_modifiedGroups.clear();
+}
+
+void Collection::invalidateGroups(const QStringList& fieldNames_) {
+  QHash<QString, EntryGroupDict*>::const_iterator dictIt = m_entryGroupDicts.constBegin();
+  for( ; dictIt != m_entryGroupDicts.constEnd(); ++dictIt) {
+    if(dictIt.value()->isEmpty() || !dictDependsOnFields(dictIt.key(), fieldNames_)) {
+      continue;
+    }
+    // only the groups for this dict are cleared from the entries
+    // the other dicts stay current
+    foreach(EntryPtr entry, m_entries) {
+      entry->clearGroups(dictIt.key());
+    }
+    foreach(EntryGroup* group, *dictIt.value()) {
+      m_groupsToDelete.remove(group);
+      m_modifiedGroups.remove(group);
+    }
+    qDeleteAll(*dictIt.value());
+    dictIt.value()->clear();
+    // don't delete the dict, just clear it
+  }
 }
 
 Tellico::Data::EntryPtr Collection::entryById(Data::ID id_) {
@@ -821,6 +1099,10 @@ void Collection::clear() {
   m_fieldByName.clear();
   m_fieldByTitle.clear();
   m_defaultGroupField.clear();
+  m_derivedFieldsUsing.clear();
+  m_derivedTemplates.clear();
+  m_derivedFieldsUsingFound = false;
+  ++m_fieldGeneration;
 
   m_entries.clear();
   m_entryById.clear();
@@ -831,13 +1113,81 @@ void Collection::clear() {
   m_entryGroupDicts.clear();
   m_entryGroups.clear();
   m_groupsToDelete.clear();
+  m_modifiedGroups.clear();
+  invalidateValueIndexes();
+  // the field slots are kept, in case any entries are still around
+  m_valuePool.clear();
+  m_valuePoolSweepSize = MIN_VALUE_POOL_SWEEP_SIZE;
   m_filters.clear();
   m_borrowers.clear();
 }
 
+QStringList Collection::derivedFieldsUsing(const QString& fieldName_) const {
+  // a template might have been changed directly, rather than through modifyField()
+  for(int i = 0; m_derivedFieldsUsingFound && i < m_derivedTemplates.count(); ++i) {
+    if(m_derivedTemplates.at(i).first->property(QLatin1String("template")) != m_derivedTemplates.at(i).second) {
+      m_derivedFieldsUsing.clear();
+      m_derivedFieldsUsingFound = false;
+    }
+  }
+  if(!m_derivedFieldsUsingFound) {
+    m_derivedTemplates.clear();
+    // first, the derived fields which use each field directly, by name or by title
+    QHash<QString, QStringList> directUses;
+    foreach(FieldPtr field, m_fields) {
+      if(!field->hasFlag(Field::Derived)) {
+        continue;
+      }
+      m_derivedTemplates << qMakePair(field, field->property(QLatin1String("template")));
+      foreach(const QString& key, field->derivedValue()->templateFields()) {
+        FieldPtr keyField = fieldByName(key);
+        if(!keyField) {
+          keyField = fieldByTitle(key);
+        }
+        if(keyField && !directUses[keyField->name()].contains(field->name())) {
+          directUses[keyField->name()] << field->name();
+        }
+      }
+    }
+    // then follow chains of derived fields
+    for(QHash<QString, QStringList>::ConstIterator it = directUses.constBegin(); it != directUses.constEnd(); ++it) {
+      QStringList uses = it.value();
+      for(int i = 0; i < uses.count(); ++i) {
+        foreach(const QString& name, directUses.value(uses.at(i))) {
+          if(!uses.contains(name)) {
+            uses << name;
+          }
+        }
+      }
+      m_derivedFieldsUsing.insert(it.key(), uses);
+    }
+    m_derivedFieldsUsingFound = true;
+  }
+  return m_derivedFieldsUsing.value(fieldName_);
+}
+
+void Collection::invalidateDerivedValues() {
+  m_derivedFieldsUsing.clear();
+  m_derivedTemplates.clear();
+  m_derivedFieldsUsingFound = false;
+  bool hasDerived = false;
+  foreach(FieldPtr field, m_fields) {
+    if(field->hasFlag(Field::Derived)) {
+      hasDerived = true;
+      break;
+    }
+  }
+  if(!hasDerived) {
+    return;
+  }
+  foreach(EntryPtr entry, m_entries) {
+    entry->invalidateDerivedValues();
+  }
+}
+
 void Collection::cleanGroups() {
   foreach(EntryGroup* group, m_groupsToDelete) {
-    EntryGroupDict* dict = entryGroupDictByName(group->fieldName());
+    EntryGroupDict* dict = m_entryGroupDicts.value(group->fieldName());
     if(!dict) {
       continue;
     }
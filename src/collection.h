@@ -33,12 +33,15 @@
 
 #include <QStringList>
 #include <QHash>
+#include <QSet>
 #include <QObject>
 
 namespace Tellico {
   namespace Data {
     class EntryGroup;
     typedef QHash<QString, EntryGroup*> EntryGroupDict;
+    class ValueIndex;
+    class FullTextIndex;
 
 /**
  * The Collection class is the primary data object, holding a
@@ -252,13 +255,28 @@ public:
   /**
    * Returns a list of the values of a given field for every entry
    * in the collection. The values in the list are not repeated. Attribute
-   * values which contain ";" are split into separate values. Since this method
-   * iterates over all the entries, for large collections, it is expensive.
+   * values which contain ";" are split into separate values. The values are indexed
+   * the first time a field is requested and the index is kept current as entries
+   * are added, modified, or removed.
    *
    * @param name The name of the field
    * @return The list of values
    */
   QStringList valuesByFieldName(const QString& name) const;
+  /**
+   * Returns the values of a given field, mapped to the number of entries
+   * which use each value.
+   *
+   * @param name The name of the field
+   * @return The value counts
+   */
+  QHash<QString, int> valueCountsByFieldName(const QString& name) const;
+  /**
+   * Returns the full-text index of every value and formatted value of the entries. The
+   * index is built the first time it is requested and kept current as entries are added,
+   * modified, or removed. The pointer is only valid until the fields are changed.
+   */
+  const FullTextIndex* fullTextIndex() const;
   /**
    * Returns a list of all the fields in a given category.
    *
@@ -286,6 +304,48 @@ public:
    * Returns @p true if the collection contains a field named @ref name;
    */
   bool hasField(const QString& name) const;
+  /**
+   * Returns the position of a field's value in the entries, or -1 if there is none.
+   * Each name gets a slot the first time a value is set, and a slot is never reused,
+   * even after the field is removed. Only entries should need this.
+   *
+   * @param name The field name
+   */
+  int fieldSlot(const QString& name) const { return m_fieldSlots.value(name, -1); }
+  /**
+   * Returns the slot for a field name, adding a new one if needed.
+   */
+  int addFieldSlot(const QString& name);
+  QString fieldSlotName(int slot) const { return m_fieldSlotNames.value(slot); }
+  /**
+   * Returns a shared copy of a value, so that entries with the same value
+   * don't each keep their own copy. Values no longer used by any entry are
+   * dropped from the pool now and then. Only entries should need this, and only
+   * from the GUI thread.
+   */
+  QString shareValue(const QString& value);
+  /**
+   * Returns the names of the derived fields whose values depend on a field, either
+   * directly or through other derived fields. The dependencies are found once, and
+   * found again after any field is added, modified or removed, or a template is changed.
+   *
+   * @param fieldName The field name
+   */
+  QStringList derivedFieldsUsing(const QString& fieldName) const;
+  /**
+   * Returns a number which changes whenever a field is added, merged, modified or removed,
+   * so anything looking up fields ahead of time knows when to look them up again.
+   */
+  int fieldGeneration() const { return m_fieldGeneration; }
+  /**
+   * Marks a value of an entry as modified, so the value indexes get updated before they are
+   * used next. Entry::setField() calls this for every value, so any way of changing a value
+   * keeps the indexes current. Only entries should need this.
+   *
+   * @param entry The modified entry
+   * @param fieldName The name of the modified field, or empty for every field
+   */
+  void entryValueModified(Entry* entry, const QString& fieldName);
   /**
    * Returns a list of all the possible entry groups. This value is cached rather
    * than generated with each call, so the method should be fairly fast.
@@ -305,6 +365,13 @@ public:
    * Invalidates all group names in the collection.
    */
   void invalidateGroups();
+  /**
+   * Invalidates the groups for a list of fields. The dicts are emptied and get
+   * rebuilt the next time they are requested.
+   *
+   * @param fieldNames The names of the grouping fields
+   */
+  void invalidateGroups(const QStringList& fieldNames);
   /**
    * Returns true if the collection contains at least one Image field.
    *
@@ -350,7 +417,15 @@ private:
   void removeEntriesFromDicts(const EntryList& entries, const QStringList& fields);
   void populateDict(EntryGroupDict* dict, const QString& fieldName, const EntryList& entries);
   void populateCurrentDicts(const EntryList& entries, const QStringList& fields);
+  void updateEntryGroups(EntryPtr entry, EntryGroupDict* dict, const QString& fieldName, bool isBool);
+  bool dictDependsOnFields(const QString& dictName, const QStringList& fields) const;
+  void emitGroupsModified();
+  void invalidateDerivedValues();
   void cleanGroups();
+  ValueIndex* valueIndex(const QString& fieldName) const;
+  void updateValueIndexes() const;
+  void invalidateValueIndexes();
+  QStringList entryText(EntryPtr entry) const;
 
   /*
    * Gets the preferred ID of the collection. Currently, it just gets incremented as
@@ -378,7 +453,26 @@ private:
 
   QHash<QString, EntryGroupDict*> m_entryGroupDicts;
   QStringList m_entryGroups;
-  QList<EntryGroup*> m_groupsToDelete;
+  QSet<EntryGroup*> m_groupsToDelete;
+  // groups which have been modified but not yet signaled
+  QSet<EntryGroup*> m_modifiedGroups;
+  // built on demand, so only fields used for completion get indexed
+  mutable QHash<QString, ValueIndex*> m_valueIndexes;
+  // built on demand, for the quick filter
+  mutable FullTextIndex* m_fullTextIndex;
+  // entries with values modified since the indexes were last updated
+  mutable QSet<ID> m_modifiedEntryIds;
+  mutable QSet<QString> m_modifiedFieldNames;
+  mutable bool m_allFieldsModified;
+  QHash<QString, int> m_fieldSlots;
+  QStringList m_fieldSlotNames;
+  QSet<QString> m_valuePool;
+  int m_valuePoolSweepSize;
+  // for each field, the derived fields which depend on it, along with the templates used to find them
+  mutable QHash<QString, QStringList> m_derivedFieldsUsing;
+  mutable QList<QPair<FieldPtr, QString> > m_derivedTemplates;
+  mutable bool m_derivedFieldsUsingFound;
+  int m_fieldGeneration;
 
   FilterList m_filters;
   BorrowerList m_borrowers;
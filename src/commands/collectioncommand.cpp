@@ -38,6 +38,7 @@ CollectionCommand::CollectionCommand(Mode mode_, Tellico::Data::CollPtr origColl
     , m_mode(mode_)
     , m_origColl(origColl_)
     , m_newColl(newColl_)
+    , m_firstEntryId(-1)
     , m_cleanup(DoNothing)
 {
 #ifndef NDEBUG
@@ -80,7 +81,7 @@ void CollectionCommand::redo() {
   switch(m_mode) {
     case Append:
       copyFields();
-      Data::Document::self()->appendCollection(m_newColl);
+      m_firstEntryId = Data::Document::self()->appendCollection(m_newColl);
       Controller::self()->slotCollectionModified(m_origColl);
       break;
 
@@ -108,7 +109,7 @@ void CollectionCommand::undo() {
 
   switch(m_mode) {
     case Append:
-      Data::Document::self()->unAppendCollection(m_newColl, m_origFields);
+      Data::Document::self()->unAppendCollection(m_newColl, m_origFields, m_firstEntryId);
       Controller::self()->slotCollectionModified(m_origColl);
       break;
 
@@ -60,6 +60,8 @@ private:
   QUrl m_origURL;
   Data::FieldList m_origFields;
   Data::MergePair m_mergePair;
+  // the appended entries are moved, not copied, and have consecutive ids
+  Data::ID m_firstEntryId;
   // for the Replace case, the collection that got replaced needs to be cleared
   enum CleanupMode {
     DoNothing, ClearOriginal, ClearNew
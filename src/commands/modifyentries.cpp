@@ -25,6 +25,7 @@
 
 #include "modifyentries.h"
 #include "../collection.h"
+#include "../field.h"
 #include "../controller.h"
 #include "../tellico_debug.h"
 
@@ -39,6 +40,7 @@ ModifyEntries::ModifyEntries(Tellico::Data::CollPtr coll_, const Tellico::Data::
     , m_oldEntries(oldEntries_)
     , m_entries(newEntries_)
     , m_modifiedFields(modifiedFields_)
+    , m_byteCount(0)
     , m_needToSwap(false)
 {
 #ifndef NDEBUG
@@ -59,6 +61,7 @@ ModifyEntries::ModifyEntries(QUndoCommand* parent, Tellico::Data::CollPtr coll_,
     , m_oldEntries(oldEntries_)
     , m_entries(newEntries_)
     , m_modifiedFields(modifiedFields_)
+    , m_byteCount(0)
     , m_needToSwap(false)
 {
 #ifndef NDEBUG
@@ -77,8 +80,11 @@ void ModifyEntries::redo() {
     return;
   }
   if(m_needToSwap) {
-    swapValues();
+    applyDeltas(false);
     m_needToSwap = false;
+  } else if(!m_oldEntries.isEmpty()) {
+    // the entries are modified before the command is first done
+    computeDeltas();
   }
   // loans expose a field named "loaned", and the user might modify that without
   // checking in the loan, so verify that. Heavy-handed, yes...
@@ -101,23 +107,78 @@ void ModifyEntries::undo() {
   if(!m_coll || m_entries.isEmpty()) {
     return;
   }
-  swapValues();
+  if(!m_oldEntries.isEmpty()) {
+    computeDeltas();
+  }
+  applyDeltas(true);
   m_needToSwap = true;
   m_coll->updateDicts(m_entries, m_modifiedFields);
   Controller::self()->modifiedEntries(m_entries);
   //TODO: need to tell edit dialog that it's not modified
 }
 
-void ModifyEntries::swapValues() {
+qint64 ModifyEntries::byteCount(const QUndoCommand* command_) {
+  if(!command_) {
+    return 0;
+  }
+  qint64 count = 0;
+  const ModifyEntries* cmd = dynamic_cast<const ModifyEntries*>(command_);
+  if(cmd) {
+    count += cmd->byteCount();
+  }
+  for(int i = 0; i < command_->childCount(); ++i) {
+    count += byteCount(command_->child(i));
+  }
+  return count;
+}
+
+void ModifyEntries::computeDeltas() {
+  // derived values are never stored, and the modified date gets reset by Entry::setField()
+  // so it has to be saved for every changed entry and restored last
+  const QString mdate = QLatin1String("mdate");
+  const bool hasModifiedDate = m_coll->hasField(mdate);
+  QStringList fieldNames;
+  foreach(Data::FieldPtr field, m_coll->fields()) {
+    if(!field->hasFlag(Data::Field::Derived) && field->name() != mdate) {
+      fieldNames << field->name();
+    }
+  }
+
+  const int count = qMin(m_entries.count(), m_oldEntries.count());
+  for(int i = 0; i < count; ++i) {
+    Data::EntryPtr oldEntry = m_oldEntries.at(i);
+    Data::EntryPtr newEntry = m_entries.at(i);
+    const int deltaCount = m_deltas.count();
+    foreach(const QString& fieldName, fieldNames) {
+      const QString oldValue = oldEntry->field(fieldName);
+      const QString newValue = newEntry->field(fieldName);
+      if(oldValue != newValue) {
+        FieldDelta delta = { i, fieldName, oldValue, newValue };
+        m_deltas.append(delta);
+      }
+    }
+    if(hasModifiedDate && m_deltas.count() > deltaCount) {
+      FieldDelta delta = { i, mdate, oldEntry->field(mdate), newEntry->field(mdate) };
+      m_deltas.append(delta);
+    }
+  }
+
+  m_byteCount = 0;
+  foreach(const FieldDelta& delta, m_deltas) {
+    // the caller might not know every field that changed, as when merging entries
+    if(!m_modifiedFields.isEmpty() && !m_modifiedFields.contains(delta.field)) {
+      m_modifiedFields << delta.field;
+    }
+    // the field name is shared with the entry, so just count the values
+    m_byteCount += sizeof(FieldDelta) + (delta.oldValue.size() + delta.newValue.size()) * sizeof(QChar);
+  }
+  m_oldEntries.clear();
+}
+
+void ModifyEntries::applyDeltas(bool undo_) {
   // since things like the detailedlistview and the entryiconview hold pointers to the entries
-  // can't just call Controller::modifiedEntry() on the old pointers
-  for(int i = 0; i < m_entries.count(); ++i) {
-    // need to swap entry values, not just pointers
-    // the id gets reset when copying, so need to keep it
-    const Data::ID id = m_entries[i]->id();
-    Data::Entry tmp(*m_entries[i]); // tmp id becomes -1
-    *m_entries[i] = *m_oldEntries[i]; // id becomes -1
-    m_entries[i]->setId(id); // id becomes what was originally
-    *m_oldEntries[i] = tmp; // id becomes -1
+  // the values have to be changed in place
+  foreach(const FieldDelta& delta, m_deltas) {
+    m_entries.at(delta.entry)->setField(delta.field, undo_ ? delta.oldValue : delta.newValue);
   }
 }
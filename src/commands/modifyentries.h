@@ -28,11 +28,16 @@
 #include "../datavectors.h"
 
 #include <QUndoCommand>
+#include <QVector>
 
 namespace Tellico {
   namespace Command {
 
 /**
+ * The old entries are only needed until the command is first done. At that point,
+ * the values which differ from the modified entries are kept and the old entries
+ * are released, so the undo history doesn't hold full copies of every entry.
+ *
  * @author Robby Stephenson
  */
 class ModifyEntries : public QUndoCommand {
@@ -46,13 +51,33 @@ public:
   virtual void redo() Q_DECL_OVERRIDE;
   virtual void undo() Q_DECL_OVERRIDE;
 
+  /**
+   * Returns the approximate memory used by the saved values, in bytes
+   */
+  qint64 byteCount() const { return m_byteCount; }
+  /**
+   * Returns the total approximate memory used by any ModifyEntries commands
+   * within @p command, including the command itself
+   */
+  static qint64 byteCount(const QUndoCommand* command);
+
 private:
-  void swapValues();
+  struct FieldDelta {
+    int entry;
+    QString field;
+    QString oldValue;
+    QString newValue;
+  };
+
+  void computeDeltas();
+  void applyDeltas(bool undo);
 
   Data::CollPtr m_coll;
   Data::EntryList m_oldEntries;
   Data::EntryList m_entries;
   QStringList m_modifiedFields;
+  QVector<FieldDelta> m_deltas;
+  qint64 m_byteCount;
   bool m_needToSwap : 1;
 };
 
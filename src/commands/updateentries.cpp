@@ -63,25 +63,26 @@ public:
     : QUndoCommand(updater)
     , m_currEntry(currEntry_)
     , m_newEntry(newEntry_)
-    , m_orphanEntry(new Data::Entry(*currEntry_))
     , m_overWrite(overWrite_) {
-    // we merge the entries here instead of in redo() because this
-    // command is never called without also calling ModifyEntries()
-    // which takes care of copying the entry values
-//    Data::Document::mergeEntry(currEntry_, newEntry_, overWrite_);
   }
 
   virtual void redo() Q_DECL_OVERRIDE {
+    // this command is never called without also calling ModifyEntries()
+    // which keeps the changed values after the first merge, so the entries
+    // don't need to be held any longer than that
+    if(!m_newEntry) {
+      return;
+    }
     OverWriteResolver res(m_overWrite);
     Data::Document::mergeEntry(m_currEntry, m_newEntry, &res);
+    m_currEntry.reset();
+    m_newEntry.reset();
   }
   virtual void undo() Q_DECL_OVERRIDE {} // does nothing
-  Data::EntryPtr orphanEntry() const { return m_orphanEntry; }
 
 private:
   Data::EntryPtr m_currEntry;
   Data::EntryPtr m_newEntry;
-  Data::EntryPtr m_orphanEntry;
   bool m_overWrite;
 };
   }
@@ -126,13 +127,17 @@ void UpdateEntries::redo() {
     // MergeEntries copies values from m_newEntry into m_oldEntry
     // m_oldEntry is in the current collection
     // m_newEntry isn't...
-    MergeEntries* cmd = new MergeEntries(this, m_oldEntry, m_newEntry, m_overWrite);
-    // cmd->orphanEntry() returns a copy of m_oldEntry before values were merged
+    new MergeEntries(this, m_oldEntry, m_newEntry, m_overWrite);
+    // the orphan entry is a copy of m_oldEntry before values were merged
     // m_oldEntry has new values
     // in the ModifyEntries command, the second entry should be owned by the current
     // collection and contain the updated values
-    // the first one is not owned by current collection
-    new ModifyEntries(this, m_coll, Data::EntryList() << cmd->orphanEntry(), Data::EntryList() << m_oldEntry, updatedFields);
+    // the first one is not owned by current collection, and is released once
+    // ModifyEntries has compared the two
+    Data::EntryPtr orphanEntry(new Data::Entry(*m_oldEntry));
+    new ModifyEntries(this, m_coll, Data::EntryList() << orphanEntry, Data::EntryList() << m_oldEntry, updatedFields);
+    // nothing else needs the new entry once it has been merged
+    m_newEntry.reset();
   }
   // calls redo() on all child command
   QUndoCommand::redo();
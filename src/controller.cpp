@@ -216,7 +216,7 @@ void Controller::modifiedEntries(Tellico::Data::EntryList entries_) {
   foreach(Observer* obs, m_observers) {
     obs->modifyEntries(entries_);
   }
-  m_mainWindow->m_entryView->slotRefresh(); // special case
+  m_mainWindow->m_entryView->refreshEntries(entries_); // special case
   m_mainWindow->slotQueueFilter();
   blockAllSignals(false);
 }
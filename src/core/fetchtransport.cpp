@@ -0,0 +1,404 @@
+/***************************************************************************
+    Copyright (C) 2019 Robby Stephenson <robby@periapsis.org>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "fetchtransport.h"
+#include "../tellico_debug.h"
+
+#include <KIO/StoredTransferJob>
+#include <KIO/JobUiDelegate>
+#include <KJobWidgets>
+#include <KLocalizedString>
+#include <KSharedConfig>
+#include <KConfigGroup>
+
+#include <QTimer>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDateTime>
+#include <QStandardPaths>
+#include <QCryptographicHash>
+
+namespace {
+  // responses are kept for a day, unless the config says otherwise
+  static const int FETCH_CACHE_TTL = 24 * 60 * 60;
+  static const char* FETCH_CACHE_GROUP = "HTTP Cache";
+  static const char* FETCH_CACHE_TTL_KEY = "Time To Live";
+  // in megabytes
+  static const int FETCH_CACHE_SIZE = 50;
+  static const char* FETCH_CACHE_SIZE_KEY = "Maximum Size";
+
+  bool isCacheable(const QUrl& url_) {
+    return url_.scheme() == QLatin1String("http") || url_.scheme() == QLatin1String("https");
+  }
+}
+
+using Tellico::FetchTransferJob;
+using Tellico::FetchTransport;
+
+FetchTransferJob::FetchTransferJob(const QUrl& url_, KIO::JobFlags flags_) : KJob()
+    , m_url(url_), m_flags(flags_), m_started(false), m_cached(false) {
+  // the fetchers show errors through the ui delegate
+  setUiDelegate(new KIO::JobUiDelegate());
+}
+
+FetchTransferJob::~FetchTransferJob() {
+}
+
+void FetchTransferJob::start() {
+  // the transport starts the job, but KJob::exec() calls start() again
+  if(m_started) {
+    return;
+  }
+  m_started = true;
+  // wait for the event loop so that meta data can still be added
+  QTimer::singleShot(0, this, SLOT(slotStart()));
+}
+
+QString FetchTransferJob::errorString() const {
+  // the error text is the full error string from the transfer job
+  return errorText();
+}
+
+void FetchTransferJob::addMetaData(const QString& key_, const QString& value_) {
+  m_metaData.insert(key_, value_);
+}
+
+bool FetchTransferJob::doKill() {
+  FetchTransport::self()->cancelJob(this);
+  return true;
+}
+
+void FetchTransferJob::slotStart() {
+  FetchTransport::self()->startJob(this);
+}
+
+void FetchTransferJob::finish(const QByteArray& data_, const QUrl& redirection_,
+                              int error_, const QString& errorText_, bool cached_) {
+  m_data = data_;
+  m_cached = cached_;
+  if(redirection_.isValid()) {
+    emit redirection(this, redirection_);
+  }
+  if(error_) {
+    setError(error_);
+    setErrorText(errorText_);
+  }
+  emitResult();
+}
+
+FetchTransport* FetchTransport::self() {
+  static FetchTransport transport;
+  return &transport;
+}
+
+FetchTransport::FetchTransport() : QObject(), m_mode(Normal), m_defaultTimeToLive(FETCH_CACHE_TTL)
+    , m_maxCacheSize(0), m_cacheSize(0) {
+  KConfigGroup config(KSharedConfig::openConfig(), QLatin1String(FETCH_CACHE_GROUP));
+  m_maxCacheSize = qint64(config.readEntry(FETCH_CACHE_SIZE_KEY, FETCH_CACHE_SIZE)) * 1024 * 1024;
+  const QString ttlKey = QLatin1Char(' ') + QLatin1String(FETCH_CACHE_TTL_KEY);
+  m_defaultTimeToLive = config.readEntry(QLatin1String("Default") + ttlKey, FETCH_CACHE_TTL);
+  // the per-host entries look like "www.example.com Time To Live"
+  foreach(const QString& key, config.keyList()) {
+    if(key.endsWith(ttlKey) && !key.startsWith(QLatin1String("Default"))) {
+      m_timeToLive.insert(key.left(key.length() - ttlKey.length()), config.readEntry(key, m_defaultTimeToLive));
+    }
+  }
+
+  setCacheDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QLatin1String("/http/"));
+
+  const QString replayDir = QString::fromLocal8Bit(qgetenv("TELLICO_FETCH_REPLAY"));
+  const QString recordDir = QString::fromLocal8Bit(qgetenv("TELLICO_FETCH_RECORD"));
+  if(!replayDir.isEmpty()) {
+    setMode(Replay, replayDir);
+  } else if(!recordDir.isEmpty()) {
+    setMode(Record, recordDir);
+  } else {
+    pruneCache();
+  }
+}
+
+FetchTransport::~FetchTransport() {
+  // any remaining transfer jobs belong to KIO by now
+  qDeleteAll(m_transfers);
+}
+
+FetchTransferJob* FetchTransport::get(const QUrl& url_, KIO::JobFlags flags_) {
+  FetchTransferJob* job = new FetchTransferJob(url_, flags_);
+  job->start();
+  return job;
+}
+
+QByteArray FetchTransport::cacheKey(const QUrl& url_, const KIO::MetaData& metaData_) {
+  QCryptographicHash hash(QCryptographicHash::Sha1);
+  hash.addData(url_.toEncoded());
+  // meta data such as custom headers may change the response
+  for(KIO::MetaData::ConstIterator it = metaData_.constBegin(); it != metaData_.constEnd(); ++it) {
+    hash.addData("\n", 1);
+    hash.addData(it.key().toUtf8());
+    hash.addData("=", 1);
+    hash.addData(it.value().toUtf8());
+  }
+  return hash.result().toHex();
+}
+
+void FetchTransport::setMode(Mode mode_, const QString& dir_) {
+  m_mode = mode_;
+  m_modeDir = dir_;
+  if(!m_modeDir.isEmpty() && !m_modeDir.endsWith(QLatin1Char('/'))) {
+    m_modeDir += QLatin1Char('/');
+  }
+  if(m_mode == Record) {
+    QDir().mkpath(m_modeDir);
+  }
+}
+
+void FetchTransport::setCacheDir(const QString& dir_) {
+  m_cacheDir = dir_;
+  if(!m_cacheDir.endsWith(QLatin1Char('/'))) {
+    m_cacheDir += QLatin1Char('/');
+  }
+}
+
+int FetchTransport::timeToLive(const QString& host_) const {
+  return m_timeToLive.value(host_, m_defaultTimeToLive);
+}
+
+void FetchTransport::setTimeToLive(const QString& host_, int seconds_) {
+  m_timeToLive.insert(host_, seconds_);
+}
+
+void FetchTransport::setDefaultTimeToLive(int seconds_) {
+  m_defaultTimeToLive = seconds_;
+}
+
+void FetchTransport::setMaximumCacheSize(qint64 bytes_) {
+  m_maxCacheSize = bytes_;
+}
+
+void FetchTransport::clear() {
+  QDir(m_cacheDir).removeRecursively();
+}
+
+void FetchTransport::startJob(FetchTransferJob* job_) {
+  const QUrl url = job_->url();
+  const QByteArray key = cacheKey(url, job_->m_metaData);
+  QByteArray data;
+  QUrl redirection;
+
+  if(m_mode == Replay && isCacheable(url)) {
+    if(readEntry(m_modeDir, key, 0, data, redirection)) {
+      job_->finish(data, redirection, 0, QString(), true);
+    } else {
+      myLog() << "no recorded response for" << url.toDisplayString();
+      job_->finish(QByteArray(), QUrl(), KIO::ERR_DOES_NOT_EXIST,
+                   i18n("No response has been recorded for %1.", url.toDisplayString()), true);
+    }
+    return;
+  }
+
+  const int ttl = isCacheable(url) ? timeToLive(url.host()) : 0;
+  if(ttl > 0 && readEntry(m_cacheDir, key, ttl, data, redirection)) {
+    if(m_mode == Record) {
+      writeEntry(m_modeDir, key, data, redirection);
+    }
+    job_->finish(data, redirection, 0, QString(), true);
+    return;
+  }
+
+  // share the transfer with an identical request that is still running
+  Transfer* transfer = m_transfers.value(key);
+  if(transfer) {
+    transfer->requests.append(job_);
+    return;
+  }
+
+  transfer = new Transfer;
+  transfer->job = KIO::storedGet(url, KIO::NoReload, job_->m_flags);
+  transfer->job->addMetaData(job_->m_metaData);
+  KJobWidgets::setWindow(transfer->job, KJobWidgets::window(job_));
+  transfer->requests.append(job_);
+  transfer->timeToLive = ttl;
+  m_transfers.insert(key, transfer);
+  m_transferKeys.insert(transfer->job, key);
+
+  connect(transfer->job, SIGNAL(result(KJob*)),
+          SLOT(slotResult(KJob*)));
+  connect(transfer->job, SIGNAL(redirection(KIO::Job*, const QUrl&)),
+          SLOT(slotRedirection(KIO::Job*, const QUrl&)));
+}
+
+void FetchTransport::cancelJob(FetchTransferJob* job_) {
+  QMutableHashIterator<QByteArray, Transfer*> it(m_transfers);
+  while(it.hasNext()) {
+    Transfer* transfer = it.next().value();
+    if(transfer->requests.removeAll(job_) == 0) {
+      continue;
+    }
+    bool active = false;
+    foreach(QPointer<FetchTransferJob> request, transfer->requests) {
+      if(request) {
+        active = true;
+        break;
+      }
+    }
+    // only kill the transfer when nobody else is waiting for it
+    if(!active) {
+      m_transferKeys.remove(transfer->job);
+      transfer->job->kill();
+      it.remove();
+      delete transfer;
+    }
+    return;
+  }
+}
+
+void FetchTransport::slotRedirection(KIO::Job* job_, const QUrl& url_) {
+  Transfer* transfer = m_transfers.value(m_transferKeys.value(job_));
+  if(transfer) {
+    transfer->redirection = url_;
+  }
+}
+
+void FetchTransport::slotResult(KJob* job_) {
+  const QByteArray key = m_transferKeys.take(job_);
+  Transfer* transfer = m_transfers.take(key);
+  if(!transfer) {
+    return;
+  }
+
+  const QByteArray data = transfer->job->data();
+  const int error = transfer->job->error();
+  const QString errorText = error ? transfer->job->errorString() : QString();
+  // KIO delivers the body of an HTTP error, like a rate limit, as if it were data, but it
+  // shouldn't be served again for the whole time-to-live
+  if(!error && !data.isEmpty() && !transfer->job->isErrorPage()) {
+    if(transfer->timeToLive > 0) {
+      writeEntry(m_cacheDir, key, data, transfer->redirection);
+      m_cacheSize += data.size();
+      if(m_cacheSize > m_maxCacheSize) {
+        pruneCache();
+      }
+    }
+    if(m_mode == Record) {
+      writeEntry(m_modeDir, key, data, transfer->redirection);
+    }
+  }
+
+  foreach(QPointer<FetchTransferJob> request, transfer->requests) {
+    if(request) {
+      request->finish(data, transfer->redirection, error, errorText, false);
+    }
+  }
+  delete transfer;
+}
+
+bool FetchTransport::readEntry(const QString& dir_, const QByteArray& key_, int timeToLive_,
+                               QByteArray& data_, QUrl& redirection_) const {
+  const QString fileName = dir_ + QLatin1String(key_);
+  QFileInfo info(fileName);
+  if(!info.exists()) {
+    return false;
+  }
+  // a zero time-to-live means the entry never expires
+  if(timeToLive_ > 0 && info.lastModified().secsTo(QDateTime::currentDateTime()) > timeToLive_) {
+    QFile::remove(fileName);
+    QFile::remove(fileName + QLatin1String(".url"));
+    return false;
+  }
+  QFile file(fileName);
+  if(!file.open(QIODevice::ReadOnly)) {
+    return false;
+  }
+  data_ = file.readAll();
+
+  QFile urlFile(fileName + QLatin1String(".url"));
+  if(urlFile.open(QIODevice::ReadOnly)) {
+    redirection_ = QUrl::fromEncoded(urlFile.readAll().trimmed());
+  }
+  return true;
+}
+
+void FetchTransport::writeEntry(const QString& dir_, const QByteArray& key_,
+                                const QByteArray& data_, const QUrl& redirection_) const {
+  if(!QDir().mkpath(dir_)) {
+    myWarning() << "unable to create" << dir_;
+    return;
+  }
+  const QString fileName = dir_ + QLatin1String(key_);
+  QSaveFile file(fileName);
+  if(!file.open(QIODevice::WriteOnly) || file.write(data_) != data_.size() || !file.commit()) {
+    myWarning() << "unable to write" << fileName;
+    return;
+  }
+  // the redirection is kept alongside, since some fetchers need the final url
+  if(redirection_.isValid()) {
+    QSaveFile urlFile(fileName + QLatin1String(".url"));
+    if(urlFile.open(QIODevice::WriteOnly)) {
+      urlFile.write(redirection_.toEncoded());
+      urlFile.commit();
+    }
+  } else {
+    QFile::remove(fileName + QLatin1String(".url"));
+  }
+}
+
+void FetchTransport::pruneCache() {
+  // nothing older than the longest time-to-live can be used again
+  int maxAge = m_defaultTimeToLive;
+  foreach(int ttl, m_timeToLive) {
+    maxAge = qMax(maxAge, ttl);
+  }
+  const QDateTime cutoff = QDateTime::currentDateTime().addSecs(-maxAge);
+  const QString urlSuffix = QLatin1String(".url");
+  // oldest first
+  const QFileInfoList files = QDir(m_cacheDir).entryInfoList(QDir::Files, QDir::Time | QDir::Reversed);
+  QStringList kept;
+  QList<qint64> keptSizes;
+  qint64 total = 0;
+  foreach(const QFileInfo& info, files) {
+    // the redirection files go along with the response
+    if(info.fileName().endsWith(urlSuffix)) {
+      continue;
+    }
+    const QString urlFile = info.filePath() + urlSuffix;
+    if(info.lastModified() < cutoff) {
+      QFile::remove(info.filePath());
+      QFile::remove(urlFile);
+      continue;
+    }
+    const qint64 size = info.size() + QFileInfo(urlFile).size();
+    kept << info.filePath();
+    keptSizes << size;
+    total += size;
+  }
+  for(int i = 0; i < kept.count() && total > m_maxCacheSize; ++i) {
+    QFile::remove(kept.at(i));
+    QFile::remove(kept.at(i) + urlSuffix);
+    total -= keptSizes.at(i);
+  }
+  m_cacheSize = total;
+}
@@ -0,0 +1,183 @@
+/***************************************************************************
+    Copyright (C) 2019 Robby Stephenson <robby@periapsis.org>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef TELLICO_FETCHTRANSPORT_H
+#define TELLICO_FETCHTRANSPORT_H
+
+#include <KJob>
+#include <KIO/Job>
+#include <KIO/MetaData>
+
+#include <QUrl>
+#include <QHash>
+#include <QPointer>
+
+namespace KIO {
+  class StoredTransferJob;
+}
+
+namespace Tellico {
+
+/**
+ * A single GET request made through the @ref FetchTransport. The job offers the
+ * parts of KIO::StoredTransferJob that the fetchers use, and the data may come
+ * from the network, the response cache, or a replay directory.
+ *
+ * The job starts itself once control returns to the event loop, so meta data
+ * can still be added after it is created.
+ */
+class FetchTransferJob : public KJob {
+Q_OBJECT
+
+friend class FetchTransport;
+
+public:
+  virtual ~FetchTransferJob();
+
+  virtual void start() Q_DECL_OVERRIDE;
+  virtual QString errorString() const Q_DECL_OVERRIDE;
+
+  QUrl url() const { return m_url; }
+  const QByteArray& data() const { return m_data; }
+  /**
+   * Returns true if the data was read from the cache or a replay directory
+   */
+  bool isCached() const { return m_cached; }
+  void addMetaData(const QString& key, const QString& value);
+
+Q_SIGNALS:
+  void redirection(KJob* job, const QUrl& url);
+
+protected:
+  virtual bool doKill() Q_DECL_OVERRIDE;
+
+private Q_SLOTS:
+  void slotStart();
+
+private:
+  FetchTransferJob(const QUrl& url, KIO::JobFlags flags);
+  void finish(const QByteArray& data, const QUrl& redirection,
+              int error, const QString& errorText, bool cached);
+
+  QUrl m_url;
+  KIO::JobFlags m_flags;
+  KIO::MetaData m_metaData;
+  QByteArray m_data;
+  bool m_started;
+  bool m_cached;
+};
+
+/**
+ * The FetchTransport is the shared layer through which the fetchers and image jobs
+ * download data. Successful responses are kept in an on-disk cache, keyed by the hash
+ * of the request, for a time-to-live which can be set per host. The oldest responses
+ * are removed once the cache grows past its maximum size, and HTTP error pages are never
+ * cached. Identical requests which are in flight at the same time share a single transfer.
+ *
+ * In replay mode, no network access is made, and every response is read from a
+ * directory of recorded responses. In record mode, every response is also written
+ * to that directory. The modes may be set with the TELLICO_FETCH_REPLAY and
+ * TELLICO_FETCH_RECORD environment variables, pointing to the directory.
+ */
+class FetchTransport : public QObject {
+Q_OBJECT
+
+friend class FetchTransferJob;
+
+public:
+  enum Mode { Normal, Record, Replay };
+
+  ~FetchTransport();
+
+  static FetchTransport* self();
+  /**
+   * Returns a new job for the url. Only the progress flags are used, the
+   * cache replaces the reload policy of KIO.
+   */
+  static FetchTransferJob* get(const QUrl& url, KIO::JobFlags flags = KIO::HideProgressInfo);
+  /**
+   * The key is the hex-encoded hash of the url and any meta data
+   */
+  static QByteArray cacheKey(const QUrl& url, const KIO::MetaData& metaData = KIO::MetaData());
+
+  Mode mode() const { return m_mode; }
+  void setMode(Mode mode, const QString& dir = QString());
+  QString cacheDir() const { return m_cacheDir; }
+  void setCacheDir(const QString& dir);
+  /**
+   * Returns the number of seconds a response from the host is cached. Zero means
+   * the responses are not cached.
+   */
+  int timeToLive(const QString& host) const;
+  void setTimeToLive(const QString& host, int seconds);
+  void setDefaultTimeToLive(int seconds);
+  qint64 maximumCacheSize() const { return m_maxCacheSize; }
+  /**
+   * Sets the maximum size of the cache in bytes. Once it's bigger, the oldest responses are removed.
+   */
+  void setMaximumCacheSize(qint64 bytes);
+  /**
+   * Removes every entry in the cache
+   */
+  void clear();
+  /**
+   * Removes the expired responses from the cache, then the oldest ones, until it fits the maximum size
+   */
+  void pruneCache();
+
+private Q_SLOTS:
+  void slotResult(KJob* job);
+  void slotRedirection(KIO::Job* job, const QUrl& url);
+
+private:
+  struct Transfer {
+    KIO::StoredTransferJob* job;
+    QList< QPointer<FetchTransferJob> > requests;
+    QUrl redirection;
+    int timeToLive;
+  };
+
+  FetchTransport();
+  void startJob(FetchTransferJob* job);
+  void cancelJob(FetchTransferJob* job);
+  bool readEntry(const QString& dir, const QByteArray& key, int timeToLive,
+                 QByteArray& data, QUrl& redirection) const;
+  void writeEntry(const QString& dir, const QByteArray& key,
+                  const QByteArray& data, const QUrl& redirection) const;
+
+  Mode m_mode;
+  QString m_modeDir;
+  QString m_cacheDir;
+  int m_defaultTimeToLive;
+  QHash<QString, int> m_timeToLive;
+  qint64 m_maxCacheSize;
+  // only an estimate between calls to pruneCache()
+  qint64 m_cacheSize;
+  QHash<QByteArray, Transfer*> m_transfers;
+  QHash<KJob*, QByteArray> m_transferKeys;
+};
+
+} // end namespace
+
+#endif
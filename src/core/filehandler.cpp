@@ -322,6 +322,49 @@ bool FileHandler::writeDataURL(const QUrl& url_, const QByteArray& data_, bool f
   return success;
 }
 
+bool FileHandler::writeDeviceURL(const QUrl& url_, DeviceWriter& writer_, bool force_, bool quiet_) {
+  if(!force_ && !queryExists(url_)) {
+    return false;
+  }
+
+  if(url_.isLocalFile()) {
+    QSaveFile f(url_.toLocalFile());
+    f.open(QIODevice::WriteOnly);
+    if(f.error() != QFile::NoError) {
+      if(!quiet_) {
+        GUI::Proxy::sorry(i18n(errorWrite, url_.fileName()));
+      }
+      return false;
+    }
+    return FileHandler::writeDeviceFile(f, writer_);
+  }
+
+  // save to remote file
+  QTemporaryFile tempfile;
+  tempfile.open();
+  QSaveFile f(tempfile.fileName());
+  f.open(QIODevice::WriteOnly);
+  if(f.error() != QFile::NoError) {
+    if(!quiet_) {
+      GUI::Proxy::sorry(i18n(errorWrite, url_.fileName()));
+    }
+    return false;
+  }
+
+  bool success = FileHandler::writeDeviceFile(f, writer_);
+  if(success) {
+    KIO::Job* job = KIO::file_copy(QUrl::fromLocalFile(tempfile.fileName()), url_, -1, KIO::Overwrite);
+    KJobWidgets::setWindow(job, GUI::Proxy::widget());
+    success = job->exec();
+    if(!success && !quiet_) {
+      GUI::Proxy::sorry(i18n(errorUpload, url_.fileName()));
+    }
+  }
+  tempfile.remove();
+
+  return success;
+}
+
 bool FileHandler::writeDataFile(QSaveFile& file_, const QByteArray& data_) {
 //  myDebug() << "Writing to" << file_.fileName();
   QDataStream s(&file_);
@@ -335,3 +378,18 @@ bool FileHandler::writeDataFile(QSaveFile& file_, const QByteArray& data_) {
 #endif
   return success;
 }
+
+bool FileHandler::writeDeviceFile(QSaveFile& file_, DeviceWriter& writer_) {
+  if(!writer_.write(&file_)) {
+    file_.cancelWriting();
+    return false;
+  }
+  file_.flush();
+  const bool success = file_.commit();
+#ifndef NDEBUG
+  if(!success) {
+    myDebug() << "error = " << file_.error();
+  }
+#endif
+  return success;
+}
@@ -77,6 +77,16 @@ public:
   };
   friend class FileRef;
 
+  /**
+   * An interface for writing output directly to a device, without
+   * first building the whole output in memory.
+   */
+  class DeviceWriter {
+  public:
+    virtual ~DeviceWriter() {}
+    virtual bool write(QIODevice* device) = 0;
+  };
+
   /**
    * Creates a FileRef for a given url. It's not meant to be used by methods in the class,
    * Rather by a class wanting direct access to a file. The caller takes ownership of the pointer.
@@ -143,6 +153,17 @@ public:
    * @return A boolean indicating success
    */
   static bool writeDataURL(const QUrl& url, const QByteArray& data, bool force=false, bool quiet=false);
+  /**
+   * Writes output from a DeviceWriter to a url. If the file already exists, a "~" is appended
+   * and the existing file is moved. If the file is remote, a temporary file is written and
+   * then uploaded.
+   *
+   * @param url The url
+   * @param writer The writer
+   * @param force Whether to force the write
+   * @return A boolean indicating success
+   */
+  static bool writeDeviceURL(const QUrl& url, DeviceWriter& writer, bool force=false, bool quiet=false);
   /**
    * Checks to see if a URL exists already, and if so, queries the user.
    *
@@ -156,8 +177,6 @@ public:
    * Returns true on success
    */
   static bool writeBackupFile(const QUrl& url);
-
-private:
   /**
    * Writes the contents of a string to a file.
    *
@@ -167,6 +186,8 @@ private:
    * @return A boolean indicating success
    */
   static bool writeTextFile(QSaveFile& file, const QString& text, bool encodeUTF8);
+
+private:
   /**
    * Writes data to a file.
    *
@@ -175,6 +196,14 @@ private:
    * @return A boolean indicating success
    */
   static bool writeDataFile(QSaveFile& file, const QByteArray& data);
+  /**
+   * Writes output from a DeviceWriter to a file.
+   *
+   * @param file The file object
+   * @param writer The writer
+   * @return A boolean indicating success
+   */
+  static bool writeDeviceFile(QSaveFile& file, DeviceWriter& writer);
 };
 
 } // end namespace
@@ -24,29 +24,111 @@
 
 #include "derivedvalue.h"
 #include "collection.h"
+#include "field.h"
 #include "fieldformat.h"
 #include "utils/stringset.h"
 #include "tellico_debug.h"
 
 #include <QStack>
+#include <QRegExp>
 
 using namespace Tellico::Data;
 using Tellico::Data::DerivedValue;
 
-DerivedValue::DerivedValue(const QString& valueTemplate_) : m_valueTemplate(valueTemplate_)
-    , m_keyRx(QLatin1String("^([^:]+):?(-?\\d*)/?(.*)$")) {
-  m_keyRx.setMinimal(true);
+DerivedValue::DerivedValue(const QString& valueTemplate_) : m_valueTemplate(valueTemplate_) {
+  compile();
 }
 
-DerivedValue::DerivedValue(FieldPtr field_) : m_keyRx(QLatin1String("^([^:]+):?(-?\\d*)/?(.*)$")) {
+DerivedValue::DerivedValue(FieldPtr field_) {
   Q_ASSERT(field_);
   if(!field_->hasFlag(Field::Derived)) {
     myWarning() << "using DerivedValue for non-derived field";
+    compile();
   } else {
-    m_valueTemplate = field_->property(QLatin1String("template"));
+    // the field keeps the compiled template, so only the tokens get copied
+    *this = *field_->derivedValue();
     m_fieldName = field_->name();
   }
-  m_keyRx.setMinimal(true);
+}
+
+void DerivedValue::compile() {
+  const Program program = compileTemplate(m_valueTemplate);
+  m_tokens = program.tokens;
+  m_templateFields = program.templateFields;
+}
+
+DerivedValue::Program DerivedValue::compileTemplate(const QString& valueTemplate_) {
+  Program program;
+  // field name, followed by optional colon, optional value index (negative), and words after slash
+  QRegExp keyRx(QLatin1String("^([^:]+):?(-?\\d*)/?(.*)$"));
+  keyRx.setMinimal(true);
+
+  Token textToken;
+  textToken.isKey = false;
+  textToken.isValid = true;
+  textToken.pos = 0;
+  textToken.toUpper = false;
+  textToken.toLower = false;
+
+  int endPos;
+  int curPos = 0;
+  int pctPos = valueTemplate_.indexOf(QLatin1Char('%'), curPos);
+  while(pctPos != -1 && pctPos+1 < valueTemplate_.length()) {
+    if(valueTemplate_.at(pctPos+1) == QLatin1Char('{')) {
+      endPos = valueTemplate_.indexOf(QLatin1Char('}'), pctPos+2);
+      if(endPos > -1) {
+        textToken.text += valueTemplate_.midRef(curPos, pctPos-curPos);
+        if(!textToken.text.isEmpty()) {
+          program.tokens.append(textToken);
+          textToken.text.clear();
+        }
+        Token keyToken = textToken;
+        keyToken.isKey = true;
+        keyToken.text = valueTemplate_.mid(pctPos+2, endPos-pctPos-2);
+        keyToken.isValid = keyRx.indexIn(keyToken.text) > -1;
+        if(keyToken.isValid) {
+          keyToken.fieldName = keyRx.cap(1);
+          keyToken.pos = keyRx.cap(2).toInt();
+          const QString func = keyRx.cap(3);
+          keyToken.toUpper = func.contains(QLatin1Char('u'));
+          keyToken.toLower = func.contains(QLatin1Char('l'));
+        } else {
+          myDebug() << "unmatched regexp for" << keyToken.text;
+        }
+        program.tokens.append(keyToken);
+        curPos = endPos+1;
+      } else {
+        break;
+      }
+    } else {
+      textToken.text += valueTemplate_.midRef(curPos, pctPos-curPos+1);
+      curPos = pctPos+1;
+    }
+    pctPos = valueTemplate_.indexOf(QLatin1Char('%'), curPos);
+  }
+  textToken.text += valueTemplate_.midRef(curPos, valueTemplate_.length()-curPos);
+  if(!textToken.text.isEmpty()) {
+    program.tokens.append(textToken);
+  }
+
+  // format is something like "%{year} %{author}"
+  QRegExp rx(QLatin1String("%\\{([^:]+):?.*\\}"));
+  rx.setMinimal(true);
+  for(int pos = rx.indexIn(valueTemplate_); pos > -1; pos = rx.indexIn(valueTemplate_, pos+rx.matchedLength())) {
+    program.templateFields << rx.cap(1);
+  }
+  return program;
+}
+
+// Field::derivedValue() is defined here, so the field class doesn't depend on the derived value code
+const DerivedValue* Field::derivedValue() const {
+  if(!hasFlag(Derived)) {
+    return nullptr;
+  }
+  if(!m_derivedValue) {
+    m_derivedValue = QSharedPointer<const DerivedValue>(new DerivedValue(property(QLatin1String("template"))));
+  }
+  return m_derivedValue.data();
 }
 
 bool DerivedValue::isRecursive(Collection* coll_) const {
@@ -57,7 +139,7 @@ bool DerivedValue::isRecursive(Collection* coll_) const {
   }
 
   QStack<QString> fieldsToCheck;
-  foreach(const QString& key, templateFields()) {
+  foreach(const QString& key, m_templateFields) {
     fieldsToCheck.push(key);
   }
   while(!fieldsToCheck.isEmpty()) {
@@ -77,8 +159,8 @@ bool DerivedValue::isRecursive(Collection* coll_) const {
       fieldNamesFound.add(f->name());
     }
     if(f->hasFlag(Field::Derived)) {
-      DerivedValue dv(f);
-      foreach(const QString& key, dv.templateFields()) {
+      // the compiled template already has the list of fields
+      foreach(const QString& key, f->derivedValue()->templateFields()) {
         fieldsToCheck.push(key);
       }
     }
@@ -94,68 +176,39 @@ QString DerivedValue::value(EntryPtr entry_, bool formatted_) const {
   }
 
   QString result;
-
-  int endPos;
-  int curPos = 0;
-  int pctPos = m_valueTemplate.indexOf(QLatin1Char('%'), curPos);
-  while(pctPos != -1 && pctPos+1 < m_valueTemplate.length()) {
-    if(m_valueTemplate.at(pctPos+1) == QLatin1Char('{')) {
-      endPos = m_valueTemplate.indexOf(QLatin1Char('}'), pctPos+2);
-      if(endPos > -1) {
-        result += m_valueTemplate.midRef(curPos, pctPos-curPos)
-                + templateKeyValue(entry_, m_valueTemplate.mid(pctPos+2, endPos-pctPos-2), formatted_);
-        curPos = endPos+1;
-      } else {
-        break;
-      }
+  foreach(const Token& token, m_tokens) {
+    if(token.isKey) {
+      result += templateKeyValue(entry_, token, formatted_);
     } else {
-      result += m_valueTemplate.midRef(curPos, pctPos-curPos+1);
-      curPos = pctPos+1;
+      result += token.text;
     }
-    pctPos = m_valueTemplate.indexOf(QLatin1Char('%'), curPos);
   }
-  result += m_valueTemplate.midRef(curPos, m_valueTemplate.length()-curPos);
 //  myDebug() << "format_ << " = " << result;
   // sometimes field value might empty, resulting in multiple consecutive white spaces
   // so let's simplify that...
   return result.simplified();
 }
 
-// format is something like "%{year} %{author}"
-QStringList DerivedValue::templateFields() const {
-  QRegExp rx(QLatin1String("%\\{([^:]+):?.*\\}"));
-  rx.setMinimal(true);
-
-  QStringList list;
-  for(int pos = rx.indexIn(m_valueTemplate); pos > -1; pos = rx.indexIn(m_valueTemplate, pos+rx.matchedLength())) {
-    list << rx.cap(1);
+QString DerivedValue::templateKeyValue(EntryPtr entry_, const Token& token_, bool formatted_) const {
+  if(!token_.isValid) {
+    return QLatin1String("%{") + token_.text + QLatin1Char('}');
   }
-  return list;
-}
 
-QString DerivedValue::templateKeyValue(EntryPtr entry_, const QString& key_, bool formatted_) const {
-  if(m_keyRx.indexIn(key_) == -1) {
-    myDebug() << "unmatched regexp for" << key_;
-    return QLatin1String("%{") + key_ + QLatin1Char('}');
-  }
-
-  const QString fieldName = m_keyRx.cap(1);
-  FieldPtr field = entry_->collection()->fieldByName(fieldName);
+  FieldPtr field = entry_->collection()->fieldByName(token_.fieldName);
   if(!field) {
     // allow the user to also use field titles
-    field = entry_->collection()->fieldByTitle(fieldName);
+    field = entry_->collection()->fieldByTitle(token_.fieldName);
   }
   if(!field) {
-    if(fieldName == QLatin1String("@id") ||
-       fieldName == QLatin1String("id")) {
+    if(token_.fieldName == QLatin1String("@id") ||
+       token_.fieldName == QLatin1String("id")) {
       // '@id' is the best way to use it, but formerly, we allowed just 'id'
       return QString::number(entry_->id());
     } else {
-      return QLatin1String("%{") + key_ + QLatin1Char('}');
+      return QLatin1String("%{") + token_.text + QLatin1Char('}');
     }
   }
-  // field name, followed by optional colon, optional value index (negative), and words after slash
-  int pos = m_keyRx.cap(2).toInt();
+  int pos = token_.pos;
   QString result;
   if(pos == 0) {
     // insert field value
@@ -187,11 +240,10 @@ QString DerivedValue::templateKeyValue(EntryPtr entry_, const QString& key_, boo
     result = values.value(pos);
   }
 
-  const QString func = m_keyRx.cap(3);
-  if(func.contains(QLatin1Char('u'))) {
+  if(token_.toUpper) {
     result = result.toUpper();
   }
-  if(func.contains(QLatin1Char('l'))) {
+  if(token_.toLower) {
     result = result.toLower();
   }
 
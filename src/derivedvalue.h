@@ -28,11 +28,17 @@
 #include "datavectors.h"
 #include "entry.h"
 
-#include <QRegExp>
+#include <QVector>
+#include <QStringList>
 
 namespace Tellico {
   namespace Data {
 
+/**
+ * The template is compiled into a list of tokens when the DerivedValue is created.
+ * A derived field keeps its compiled template, see @ref Field::derivedValue(),
+ * so creating a DerivedValue for a field only copies the tokens.
+ */
 class DerivedValue {
 public:
   DerivedValue(const QString& valueTemplate);
@@ -44,14 +50,36 @@ public:
   bool isRecursive(Collection* coll) const;
 
   QString value(EntryPtr entry, bool formatted) const;
+  /**
+   * Returns the names, or titles, of the fields used in the template.
+   */
+  QStringList templateFields() const { return m_templateFields; }
 
 private:
-  QStringList templateFields() const;
-  QString templateKeyValue(EntryPtr entry, const QString& key, bool formatted) const;
+  // a template is compiled into a list of tokens, each either
+  // literal text or a key which gets replaced by a field value
+  struct Token {
+    bool isKey;
+    bool isValid;
+    QString text; // the literal text or the full key
+    QString fieldName;
+    int pos;
+    bool toUpper;
+    bool toLower;
+  };
+  struct Program {
+    QVector<Token> tokens;
+    QStringList templateFields;
+  };
+
+  void compile();
+  static Program compileTemplate(const QString& valueTemplate);
+  QString templateKeyValue(EntryPtr entry, const Token& token, bool formatted) const;
 
   QString m_fieldName;
   QString m_valueTemplate;
-  mutable QRegExp m_keyRx;
+  QVector<Token> m_tokens;
+  QStringList m_templateFields;
 };
 
   } // end namespace
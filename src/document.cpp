@@ -36,6 +36,7 @@
 #include "images/imagedirectory.h"
 #include "images/image.h"
 #include "images/imageinfo.h"
+#include "images/imageloader.h"
 #include "utils/stringset.h"
 #include "progressmanager.h"
 #include "config/tellico_config.h"
@@ -47,6 +48,7 @@
 #include <KLocalizedString>
 
 #include <QRegExp>
+#include <QMultiHash>
 #include <QTimer>
 #include <QApplication>
 
@@ -200,6 +202,10 @@ bool Document::saveDocument(const QUrl& url_, bool force_) {
 
   // in case we're still loading images, give that a chance to cancel
   m_cancelImageWriting = true;
+  if(m_imageLoader) {
+    m_imageLoader->stop();
+    slotAllImagesLoaded();
+  }
   qApp->processEvents();
 
   ProgressItem& item = ProgressManager::self()->newProgressItem(this, i18n("Saving file..."), false);
@@ -277,8 +283,28 @@ void Document::deleteContents() {
   m_cancelImageWriting = true;
 }
 
-void Document::appendCollection(Tellico::Data::CollPtr coll_) {
-  appendCollection(m_coll, coll_);
+Tellico::Data::ID Document::appendCollection(Tellico::Data::CollPtr coll_) {
+  if(!coll_) {
+    return -1;
+  }
+
+  m_coll->blockSignals(true);
+
+  foreach(FieldPtr field, coll_->fields()) {
+    m_coll->mergeField(field);
+  }
+
+  // the appended collection only exists for the undo command, so rather than copying
+  // every entry, the entries are moved. Clearing the ids means they get consecutive new ones,
+  // so undoing only needs the first id
+  Data::EntryList entries = coll_->entries();
+  foreach(EntryPtr entry, entries) {
+    entry->setId(-1);
+  }
+  m_coll->addEntries(entries);
+  // TODO: merge filters and loans
+  m_coll->blockSignals(false);
+  return entries.isEmpty() ? -1 : entries.first()->id();
 }
 
 void Document::appendCollection(Tellico::Data::CollPtr coll1_, Tellico::Data::CollPtr coll2_) {
@@ -324,8 +350,22 @@ Tellico::Data::MergePair Document::mergeCollection(Tellico::Data::CollPtr coll1_
   std::sort(currEntries.begin(), currEntries.end(), Data::EntryCmp(QLatin1String("title")));
   std::sort(newEntries.begin(), newEntries.end(), Data::EntryCmp(QLatin1String("title")));
 
+  // comparing every new entry against every current entry is way too slow for large collections
+  // so index the current entries by identifiers, title, and names, and only compare against the hits
+  // along with the entries which have no key at all
+  QMultiHash<QString, int> matchIndex;
+  QList<int> unkeyed;
+  for(int i = 0; i < currEntries.count(); ++i) {
+    const QStringList keys = EntryComparison::matchKeys(currEntries.at(i));
+    if(keys.isEmpty()) {
+      unkeyed << i;
+    }
+    foreach(const QString& key, keys) {
+      matchIndex.insert(key, i);
+    }
+  }
+
   const int currTotal = currEntries.count();
-  int lastMatchId = 0;
   bool checkSameId = false; // if the matching entries have the same id, then check that first for later comparisons
   foreach(EntryPtr newEntry, newEntries) {
     int bestMatch = 0;
@@ -340,19 +380,32 @@ Tellico::Data::MergePair Document::mergeCollection(Tellico::Data::CollPtr coll1_
       }
     }
     if(!matchEntry) {
-      // alternative is to loop over them all
-      for(int i = 0; i < currTotal; ++i) {
-        // since we're sorted by title, track the index of the previous match and starts comparison there
-        currEntry = currEntries.at((i+lastMatchId) % currTotal);
+      const QStringList keys = EntryComparison::matchKeys(newEntry);
+      QList<int> candidates;
+      if(keys.isEmpty()) {
+        // a new entry without any key has to be compared against everything
+        candidates.reserve(currTotal);
+        for(int i = 0; i < currTotal; ++i) {
+          candidates << i;
+        }
+      } else {
+        candidates = unkeyed;
+        foreach(const QString& key, keys) {
+          candidates += matchIndex.values(key);
+        }
+        // the candidates are sorted by index to keep the same preference as a linear search
+        std::sort(candidates.begin(), candidates.end());
+        candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+      }
+      foreach(int idx, candidates) {
+        currEntry = currEntries.at(idx);
         int match = currEntry->collection()->sameEntry(currEntry, newEntry);
         if(match >= EntryComparison::ENTRY_PERFECT_MATCH) {
           matchEntry = currEntry;
-          lastMatchId = (i+lastMatchId) % currTotal;
           break;
         } else if(match >= EntryComparison::ENTRY_GOOD_MATCH && match > bestMatch) {
           bestMatch = match;
           matchEntry = currEntry;
-          lastMatchId = (i+lastMatchId) % currTotal;
           // don't break, keep looking for better one
         }
       }
@@ -391,7 +444,7 @@ void Document::replaceCollection(Tellico::Data::CollPtr coll_) {
   // CollectionCommand takes care of calling Controller signals
 }
 
-void Document::unAppendCollection(Tellico::Data::CollPtr coll_, Tellico::Data::FieldList origFields_) {
+void Document::unAppendCollection(Tellico::Data::CollPtr coll_, Tellico::Data::FieldList origFields_, Tellico::Data::ID firstId_) {
   if(!coll_) {
     return;
   }
@@ -404,12 +457,19 @@ void Document::unAppendCollection(Tellico::Data::CollPtr coll_, Tellico::Data::F
     origFieldNames.add(field->name());
   }
 
-  EntryList entries = coll_->entries();
+  EntryList entries;
+  const ID lastId = firstId_ + coll_->entryCount();
+  for(ID id = firstId_; id < lastId; ++id) {
+    EntryPtr entry = m_coll->entryById(id);
+    if(entry) {
+      entries << entry;
+    }
+  }
+  m_coll->removeEntries(entries);
+  // hand the entries back, in case the append gets redone
   foreach(EntryPtr entry, entries) {
-    // probably don't need to do this, but on the safe side...
     entry->setCollection(coll_);
   }
-  m_coll->removeEntries(entries);
 
   // since Collection::removeField() iterates over all entries to reset the value of the field
   // don't removeField() until after removeEntry() is done
@@ -480,8 +540,10 @@ bool Document::loadAllImagesNow() const {
 Tellico::Data::EntryList Document::filteredEntries(Tellico::FilterPtr filter_) const {
   Data::EntryList matches;
   Data::EntryList entries = m_coll->entries();
+  // compile the filter once for all the entries
+  const FilterPlan plan(filter_);
   foreach(EntryPtr entry, entries) {
-    if(filter_->matches(entry)) {
+    if(plan.matches(entry)) {
       matches.append(entry);
     }
   }
@@ -527,33 +589,14 @@ void Document::renameCollection(const QString& newTitle_) {
 // by loading every image, it gets pulled out of the zip file and
 // copied to disk. Then the zip file can be closed and not retained in memory
 void Document::slotLoadAllImages() {
-  QString id;
-  StringSet images;
-  foreach(EntryPtr entry, m_coll->entries()) {
-    foreach(FieldPtr field, m_coll->imageFields()) {
-      id = entry->field(field);
-      if(id.isEmpty() || images.has(id)) {
-        continue;
-      }
-      // this is the early loading, so just by calling imageById()
-      // the image gets sucked from the zip file and written to disk
-      // by ImageFactory::imageById()
-      // TODO:: does this need to check against images with link only?
-      if(ImageFactory::imageById(id).isNull()) {
-        myDebug() << "Null image for entry:" << entry->title() << id;
-      }
-      images.add(id);
-      if(m_cancelImageWriting) {
-        break;
-      }
-    }
-    if(m_cancelImageWriting) {
-      break;
-    }
-    // stay responsive, do this in the background
-    qApp->processEvents();
-  }
+  // this is the early loading, so the images get sucked from the zip file
+  // and written to disk, where ImageFactory::imageById() will find them.
+  // Reading and decoding the images happens on background threads to stay responsive
+  m_imageLoader = ImageFactory::loadZipImages(&m_cancelImageWriting);
+  connect(m_imageLoader, SIGNAL(finished()), SLOT(slotAllImagesLoaded()));
+}
 
+void Document::slotAllImagesLoaded() {
   if(m_cancelImageWriting) {
     myLog() << "slotLoadAllImages() - cancel image writing";
   } else {
@@ -561,6 +604,10 @@ void Document::slotLoadAllImages() {
   }
 
   m_cancelImageWriting = false;
+  if(m_imageLoader) {
+    m_imageLoader->deleteLater();
+    m_imageLoader = nullptr;
+  }
   if(m_importer) {
     m_importer->deleteLater();
     m_importer = nullptr;
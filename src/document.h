@@ -31,8 +31,10 @@
 #include <QObject>
 #include <QPointer>
 #include <QUrl>
+#include <QAtomicInt>
 
 namespace Tellico {
+  class ImageLoader;
   namespace Import {
     class TellicoImporter;
     class TellicoSaxImporter;
@@ -139,9 +141,13 @@ public:
    * in the appended collection not in the current one are added. Entries in the appended collection
    * are added to the current one.
    *
+   * Unlike the static version, the entries are moved into the current collection rather than
+   * copied, and they are given consecutive ids so the append can be undone by id.
+   *
    * @param coll A pointer to the appended collection.
+   * @return The id of the first appended entry
    */
-  void appendCollection(CollPtr coll);
+  ID appendCollection(CollPtr coll);
   static void appendCollection(CollPtr targetColl, CollPtr sourceColl);
   /**
    * Merges another collection into this one. The collections must be the same type. Fields in the
@@ -160,7 +166,11 @@ public:
    * @param coll A Pointer to the new collection, the document takes ownership.
    */
   void replaceCollection(CollPtr coll);
-  void unAppendCollection(CollPtr coll, FieldList origFields);
+  /**
+   * Removes the entries added by @ref appendCollection, which are the ones with ids starting at
+   * @p firstId. The entries are given back to the appended collection.
+   */
+  void unAppendCollection(CollPtr coll, FieldList origFields, ID firstId);
   void unMergeCollection(CollPtr coll, FieldList origFields_, MergePair entryPair);
   bool loadAllImagesNow() const;
   bool allImagesOnDisk() const { return m_allImagesOnDisk; }
@@ -220,6 +230,7 @@ private Q_SLOTS:
    * images to temp dir initially
    */
   void slotLoadAllImages();
+  void slotAllImagesLoaded();
 
 private:
   static Document* s_self;
@@ -243,7 +254,9 @@ private:
   QUrl m_url;
   bool m_validFile;
   QPointer<Import::TellicoImporter> m_importer;
-  bool m_cancelImageWriting;
+  QPointer<ImageLoader> m_imageLoader;
+  // read by the image loading threads
+  QAtomicInt m_cancelImageWriting;
   int m_fileFormat;
   bool m_allImagesOnDisk;
 };
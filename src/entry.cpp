@@ -34,6 +34,8 @@
 #include <KLocalizedString>
 
 #include <QRegExp>
+#include <QCoreApplication>
+#include <QThread>
 
 using namespace Tellico;
 using namespace Tellico::Data;
@@ -71,12 +73,19 @@ Entry& Entry::operator=(const Entry& other_) {
   m_id = other_.m_id;
   m_fieldValues = other_.m_fieldValues;
   m_formattedFields = other_.m_formattedFields;
+  invalidateDerivedValues();
   return *this;
 }
 
 Entry::~Entry() {
 }
 
+void Entry::setId(Tellico::Data::ID id_) {
+  m_id = id_;
+  // a derived value might include the id
+  invalidateDerivedValues();
+}
+
 Tellico::Data::CollPtr Entry::collection() const {
   return m_coll;
 }
@@ -91,8 +100,29 @@ void Entry::setCollection(Tellico::Data::CollPtr coll_) {
   const bool addEntryType = m_coll->type() == Collection::Book &&
                             coll_->type() == Collection::Bibtex &&
                             !m_coll->hasField(QLatin1String("entry-type"));
+  // the slots are different in the new collection, so move the values over
+  // values for fields the new collection doesn't have are kept, in case the field gets added later
+  if(m_coll && !m_fieldValues.isEmpty()) {
+    QVector<QString> oldValues;
+    oldValues.swap(m_fieldValues);
+    for(int i = 0; i < oldValues.count(); ++i) {
+      if(oldValues.at(i).isEmpty()) {
+        continue;
+      }
+      const int slot = coll_->addFieldSlot(m_coll->fieldSlotName(i));
+      if(slot >= m_fieldValues.count()) {
+        m_fieldValues.resize(slot + 1);
+      }
+      m_fieldValues[slot] = oldValues.at(i);
+    }
+  }
+  // the formatting may be different, too
+  m_formattedFields.clear();
+  m_sortKeys.clear();
   m_coll = coll_;
   m_id = -1;
+  // the new collection may have different derived fields
+  invalidateDerivedValues();
   // set this after changing the m_coll pointer since setField() checks field validity
   if(addEntryType) {
     setField(QLatin1String("entry-type"), QLatin1String("book"));
@@ -113,14 +143,11 @@ QString Entry::field(Tellico::Data::FieldPtr field_) const {
   }
 
   if(field_->hasFlag(Field::Derived)) {
-    DerivedValue dv(field_);
-    return dv.value(EntryPtr(const_cast<Entry*>(this)), false);
+    return derivedValue(field_, false);
   }
 
-  if(m_fieldValues.contains(field_->name())) {
-    return m_fieldValues.value(field_->name());
-  }
-  return QString();
+  const int slot = m_coll->fieldSlot(field_->name());
+  return slot > -1 && slot < m_fieldValues.count() ? m_fieldValues.at(slot) : QString();
 }
 
 QString Entry::formattedField(const QString& fieldName_, FieldFormat::Request request_) const {
@@ -139,9 +166,8 @@ QString Entry::formattedField(Tellico::Data::FieldPtr field_, FieldFormat::Reque
 
   const FieldFormat::Type flag = field_->formatType();
   if(field_->hasFlag(Field::Derived)) {
-    DerivedValue dv(field_);
     // format sub fields and whole string
-    return FieldFormat::format(dv.value(EntryPtr(const_cast<Entry*>(this)), true), flag, request_);
+    return FieldFormat::format(derivedValue(field_, true), flag, request_);
   }
 
   // if auto format is not set or FormatNone, then just return the value
@@ -149,7 +175,8 @@ QString Entry::formattedField(Tellico::Data::FieldPtr field_, FieldFormat::Reque
     return m_coll->prepareText(field(field_));
   }
 
-  if(!m_formattedFields.contains(field_->name())) {
+  const int slot = m_coll->fieldSlot(field_->name());
+  if(slot < 0 || slot >= m_formattedFields.count() || m_formattedFields.at(slot).isEmpty()) {
     QString formattedValue;
     if(field_->type() == Field::Table) {
       QStringList rows;
@@ -179,13 +206,16 @@ QString Entry::formattedField(Tellico::Data::FieldPtr field_, FieldFormat::Reque
       }
       formattedValue = formattedValues.join(FieldFormat::delimiterString());
     }
-    if(!formattedValue.isEmpty()) {
-      m_formattedFields.insert(field_->name(), formattedValue);
+    if(!formattedValue.isEmpty() && slot > -1) {
+      if(slot >= m_formattedFields.count()) {
+        m_formattedFields.resize(slot + 1);
+      }
+      m_formattedFields[slot] = formattedValue;
     }
     return formattedValue;
   }
   // otherwise, just look it up
-  return m_formattedFields.value(field_->name());
+  return m_formattedFields.at(slot);
 }
 
 bool Entry::setField(Tellico::Data::FieldPtr field_, const QString& value_) {
@@ -193,6 +223,8 @@ bool Entry::setField(Tellico::Data::FieldPtr field_, const QString& value_) {
 }
 
 bool Entry::setField(const QString& name_, const QString& value_) {
+  // the values are shared through the collection, which is not thread-safe
+  Q_ASSERT(!QCoreApplication::instance() || QThread::currentThread() == QCoreApplication::instance()->thread());
   if(name_.isEmpty()) {
     myWarning() << "empty field name for value:" << value_;
     return false;
@@ -220,11 +252,13 @@ bool Entry::setField(const QString& name_, const QString& value_) {
 }
 
 bool Entry::setFieldImpl(const QString& name_, const QString& value_) {
-  // an empty value means remove the field
+  // an empty value means remove the field, and there's nothing to remove without a slot
   if(value_.isEmpty()) {
-    if(m_fieldValues.contains(name_)) {
-      m_fieldValues.remove(name_);
+    const int slot = m_coll->fieldSlot(name_);
+    if(slot > -1 && slot < m_fieldValues.count() && !m_fieldValues.at(slot).isEmpty()) {
+      m_fieldValues[slot].clear();
       invalidateFormattedFieldValue(name_);
+      m_coll->entryValueModified(this, name_);
     }
     return true;
   }
@@ -239,20 +273,19 @@ bool Entry::setFieldImpl(const QString& name_, const QString& value_) {
     return false;
   }
 
-  // the string store is probable only useful for fields with auto-completion or choice/number/bool
-  bool shareType = f->type() == Field::Choice ||
-                   f->type() == Field::Bool ||
-                   f->type() == Field::Image ||
-                   f->type() == Field::Rating ||
-                   f->type() == Field::Number;
-  if(!(f->hasFlag(Field::AllowMultiple)) &&
-     (shareType ||
-      (f->type() == Field::Line && (f->flags() & Field::AllowCompletion)))) {
-    m_fieldValues.insert(Tellico::shareString(name_), Tellico::shareString(value_));
-  } else {
-    m_fieldValues.insert(Tellico::shareString(name_), value_);
+  // sharing values is only useful for fields where values are likely to repeat
+  // like choices and grouped fields, such as the author or the genre
+  const bool shareType = f->type() == Field::Choice ||
+                         f->type() == Field::Bool ||
+                         f->type() == Field::Rating ||
+                         f->hasFlag(Field::AllowGrouped);
+  const int slot = m_coll->addFieldSlot(name_);
+  if(slot >= m_fieldValues.count()) {
+    m_fieldValues.resize(slot + 1);
   }
+  m_fieldValues[slot] = shareType && f->type() != Field::Para ? m_coll->shareValue(value_) : value_;
   invalidateFormattedFieldValue(name_);
+  m_coll->entryValueModified(this, name_);
   return true;
 }
 
@@ -281,6 +314,15 @@ void Entry::clearGroups() {
   m_groups.clear();
 }
 
+void Entry::clearGroups(const QString& fieldName_) {
+  QMutableListIterator<EntryGroup*> it(m_groups);
+  while(it.hasNext()) {
+    if(it.next()->fieldName() == fieldName_) {
+      it.remove();
+    }
+  }
+}
+
 // this function gets called before m_groups is updated. In fact, it is used to
 // update that list. This is the function that actually parses the field values
 // and returns the list of the group names.
@@ -315,6 +357,26 @@ QStringList Entry::groupNamesByFieldName(const QString& fieldName_) const {
   return groups.isEmpty() ? QStringList(QString()) : groups.toList();
 }
 
+QStringList Entry::fieldValues() const {
+  QStringList values;
+  foreach(const QString& value, m_fieldValues) {
+    if(!value.isEmpty()) {
+      values += value;
+    }
+  }
+  return values;
+}
+
+QStringList Entry::formattedFieldValues() const {
+  QStringList values;
+  foreach(const QString& value, m_formattedFields) {
+    if(!value.isEmpty()) {
+      values += value;
+    }
+  }
+  return values;
+}
+
 bool Entry::isOwned() {
   return (m_coll && m_id > -1 && m_coll->entryCount() > 0 && m_coll->entries().contains(EntryPtr(this)));
 }
@@ -323,7 +385,48 @@ bool Entry::isOwned() {
 void Entry::invalidateFormattedFieldValue(const QString& name_) {
   if(name_.isEmpty()) {
     m_formattedFields.clear();
-  } else if(!m_formattedFields.isEmpty() && m_formattedFields.contains(name_)) {
-    m_formattedFields.remove(name_);
+    m_sortKeys.clear();
+  } else {
+    const int slot = m_coll ? m_coll->fieldSlot(name_) : -1;
+    if(slot > -1 && slot < m_formattedFields.count()) {
+      m_formattedFields[slot].clear();
+    }
+    if(!m_sortKeys.isEmpty()) {
+      m_sortKeys.remove(name_);
+    }
+  }
+  invalidateDerivedValues(name_);
+}
+
+QString Entry::derivedValue(Tellico::Data::FieldPtr field_, bool formatted_) const {
+  DerivedCache& cache = formatted_ ? m_formattedDerivedValues : m_derivedValues;
+  // the cached value is only good if the template hasn't been changed since
+  const QString valueTemplate = field_->property(QLatin1String("template"));
+  DerivedCache::ConstIterator it = cache.constFind(field_->name());
+  if(it != cache.constEnd() && it.value().first == valueTemplate) {
+    return it.value().second;
+  }
+  const QString value = field_->derivedValue()->value(EntryPtr(const_cast<Entry*>(this)), formatted_);
+  cache.insert(field_->name(), qMakePair(valueTemplate, value));
+  return value;
+}
+
+// an empty string means invalidate all
+void Entry::invalidateDerivedValues(const QString& name_) {
+  if(m_derivedValues.isEmpty() && m_formattedDerivedValues.isEmpty()) {
+    return;
+  }
+  if(name_.isEmpty() || !m_coll) {
+    m_derivedValues.clear();
+    m_formattedDerivedValues.clear();
+    return;
+  }
+
+  m_derivedValues.remove(name_);
+  m_formattedDerivedValues.remove(name_);
+  // the collection already knows which derived fields depend on the field, even through other derived fields
+  foreach(const QString& fieldName, m_coll->derivedFieldsUsing(name_)) {
+    m_derivedValues.remove(fieldName);
+    m_formattedDerivedValues.remove(fieldName);
   }
 }
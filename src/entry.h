@@ -30,6 +30,8 @@
 
 #include <QStringList>
 #include <QHash>
+#include <QVector>
+#include <QVariant>
 
 #include <functional>
 
@@ -100,6 +102,10 @@ public:
    * Sets the value of an field for the entry. The method first verifies that
    * the value is allowed for that particular key.
    *
+   * Setting a value updates hashes shared by the whole collection, like the field slots,
+   * the shared values, and the modified values for the indexes, so values may only be
+   * set from the GUI thread.
+   *
    * @param fieldName The name of the field
    * @param value The value of the field
    * @return A boolean indicating whether or not the field was successfully set
@@ -122,7 +128,7 @@ public:
    * @return The id
    */
   ID id() const { return m_id; }
-  void setId(ID id) { m_id = id; }
+  void setId(ID id);
   /**
    * Adds the entry to a group. The group list within the entry is updated
    * and the entry is added to the group.
@@ -141,6 +147,13 @@ public:
    */
   bool removeFromGroup(EntryGroup* group);
   void clearGroups();
+  /**
+   * Clears the entry's list of groups for a single field. The groups themselves
+   * are not modified, so this is only useful when they are about to be deleted.
+   *
+   * @param fieldName The name of the grouping field
+   */
+  void clearGroups(const QString& fieldName);
   /**
    * Returns a list of the groups to which the entry belongs
    *
@@ -160,13 +173,13 @@ public:
    *
    * @return The list of field values
    */
-  QStringList fieldValues() const { return m_fieldValues.values(); }
+  QStringList fieldValues() const;
   /**
    * Returns a list of all the formatted field values contained in the entry.
    *
    * @return The list of field values
    */
-  QStringList formattedFieldValues() const { return m_formattedFields.values(); }
+  QStringList formattedFieldValues() const;
   /**
    * Returns a boolean indicating if the entry's parent collection recognizes
    * it existence, that is, the parent collection has this entry in its list.
@@ -181,6 +194,21 @@ public:
    * @param name The name of the field that changed. an empty string means invalidate all fields.
    */
   void invalidateFormattedFieldValue(const QString& name=QString());
+  /**
+   * Removes the cached values of any derived field that depends on a field. Derived
+   * fields which depend on those derived fields are removed, too.
+   *
+   * @param name The name of the field that changed. an empty string means invalidate all fields.
+   */
+  void invalidateDerivedValues(const QString& name=QString());
+  /**
+   * Returns the cached key used for sorting by a field, or an invalid value if
+   * none has been set. The key gets cleared along with the formatted value.
+   *
+   * @param fieldName The name of the field
+   */
+  QVariant sortKey(const QString& fieldName) const { return m_sortKeys.value(fieldName); }
+  void setSortKey(const QString& fieldName, const QVariant& key) { m_sortKeys.insert(fieldName, key); }
 
 private:
   // not used
@@ -189,11 +217,20 @@ private:
   bool operator==(const Entry& other) const;
 
   bool setFieldImpl(const QString& fieldName, const QString& value);
+  QString derivedValue(FieldPtr field, bool formatted) const;
 
   CollPtr m_coll;
   ID m_id;
-  QHash<QString, QString> m_fieldValues;
-  mutable QHash<QString, QString> m_formattedFields;
+  // the values are stored by the field's slot in the collection, rather than by name
+  // an empty string means no value
+  QVector<QString> m_fieldValues;
+  mutable QVector<QString> m_formattedFields;
+  // the cached values of derived fields, both as-is and with formatted source values,
+  // along with the template used to create them
+  typedef QHash<QString, QPair<QString, QString> > DerivedCache;
+  mutable DerivedCache m_derivedValues;
+  mutable DerivedCache m_formattedDerivedValues;
+  QHash<QString, QVariant> m_sortKeys;
   QList<EntryGroup*> m_groups;
 };
 
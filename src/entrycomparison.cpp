@@ -32,6 +32,13 @@
 
 using Tellico::EntryComparison;
 
+namespace {
+  // the fields which can make a good match without the title, like a book by the same author
+  static const char* const MATCH_KEY_NAME_FIELDS[] = { "author", "artist", "writer", "director", "series" };
+  // only the first few values of a field are used, to keep the number of keys bounded
+  static const int MAX_MATCH_KEY_NAMES = 5;
+}
+
 QUrl EntryComparison::s_documentUrl;
 
 void EntryComparison::setDocumentUrl(const QUrl& url_) {
@@ -142,3 +149,79 @@ int EntryComparison::score(Tellico::Data::EntryPtr e1, Tellico::Data::EntryPtr e
   }
   return 0;
 }
+
+QStringList EntryComparison::matchKeys(Tellico::Data::EntryPtr entry_) {
+  QStringList keys;
+  if(!entry_ || !entry_->collection()) {
+    return keys;
+  }
+  const Data::Collection* coll = entry_->collection().data();
+  // the normalization here has to match what score() does, so that entries with the
+  // same key are the ones that score() would consider to be equal
+  QString value = entry_->field(QLatin1String("isbn")).toLower();
+  if(!value.isEmpty()) {
+    keys << QLatin1String("isbn:") + ISBNValidator::isbn10(value);
+  }
+  value = entry_->field(QLatin1String("lccn")).toLower();
+  if(!value.isEmpty()) {
+    keys << QLatin1String("lccn:") + LCCNValidator::formalize(value);
+  }
+  value = entry_->field(QLatin1String("doi")).toLower();
+  if(!value.isEmpty()) {
+    keys << QLatin1String("doi:") + value;
+  }
+  value = entry_->field(QLatin1String("pmid")).toLower();
+  if(!value.isEmpty()) {
+    keys << QLatin1String("pmid:") + value;
+  }
+  value = entry_->field(QLatin1String("arxiv")).toLower();
+  if(!value.isEmpty()) {
+    value.remove(QRegExp(QLatin1String("^arxiv:")));
+    value.remove(QRegExp(QLatin1String("v\\d+$")));
+    keys << QLatin1String("arxiv:") + value;
+  }
+  value = entry_->field(QLatin1String("imdb")).toLower();
+  if(!value.isEmpty()) {
+    QUrl u = QUrl::fromUserInput(value);
+    u.setHost(QString());
+    keys << QLatin1String("imdb:") + u.toString();
+  }
+  if(coll->type() == Data::Collection::File) {
+    value = entry_->field(QLatin1String("url")).toLower();
+    if(!value.isEmpty()) {
+      // resolving an absolute url leaves it unchanged, so this covers both cases in score()
+      keys << QLatin1String("url:") + s_documentUrl.resolved(QUrl(value)).toString();
+    }
+  }
+  // the title key strips everything that score() might ignore in a title comparison
+  value = entry_->field(QLatin1String("title")).toLower();
+  if(!value.isEmpty()) {
+    value.remove(QRegExp(QLatin1String("\\s*\\(.*\\)\\s*")));
+    FieldFormat::stripArticles(value);
+    value.remove(QRegExp(QLatin1String("[^\\s\\w]")));
+    value = value.simplified();
+    if(!value.isEmpty()) {
+      keys << QLatin1String("title:") + value;
+    }
+  }
+  // the secondary keys are the names, compared the same way as score() does for multiple values
+  for(const char* name : MATCH_KEY_NAME_FIELDS) {
+    Data::FieldPtr field = coll->fieldByName(QLatin1String(name));
+    if(!field) {
+      continue;
+    }
+    const QString fieldValue = field->formatType() == FieldFormat::FormatName
+                             ? entry_->formattedField(field, FieldFormat::ForceFormat)
+                             : entry_->field(field);
+    const QStringList values = FieldFormat::splitValue(fieldValue);
+    for(int i = 0; i < values.count() && i < MAX_MATCH_KEY_NAMES; ++i) {
+      value = values.at(i).toLower();
+      value.remove(QRegExp(QLatin1String("[^\\s\\w]")));
+      value = value.simplified();
+      if(!value.isEmpty()) {
+        keys << QLatin1String(name) + QLatin1Char(':') + value;
+      }
+    }
+  }
+  return keys;
+}
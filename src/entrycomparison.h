@@ -28,6 +28,7 @@
 #include "datavectors.h"
 
 #include <QUrl>
+#include <QStringList>
 
 namespace Tellico {
 
@@ -43,6 +44,15 @@ public:
   static int score(Data::EntryPtr entry1, Data::EntryPtr entry2, Data::FieldPtr field);
   static int score(Data::EntryPtr entry1, Data::EntryPtr entry2, const QString& field, const Data::Collection* coll);
 
+  /**
+   * Returns a list of normalized keys for an entry, built from identifier fields like
+   * isbn or imdb, from the title, and from the first few names in fields like author
+   * or artist. The keys cover the ways the collection types match entries in
+   * Collection::sameEntry(), so merging only compares the entries which share a key,
+   * along with the ones which have no key at all.
+   */
+  static QStringList matchKeys(Data::EntryPtr entry);
+
   // these are the values that should be compared against
   // the result from Collection::sameEntry()
   enum MatchValues {
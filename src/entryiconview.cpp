@@ -32,6 +32,7 @@
 #include "document.h"
 #include "utils/tellico_utils.h"
 #include "models/entrymodel.h"
+#include "models/entryiconmodel.h"
 #include "models/entrysortmodel.h"
 #include "tellico_kernel.h"
 #include "tellico_debug.h"
@@ -75,12 +76,20 @@ void EntryIconView::setModel(QAbstractItemModel* model_) {
     return;
   }
   connect(model_, &QAbstractItemModel::columnsInserted, this, &EntryIconView::updateModelColumn);
+  EntryIconModel* iconModel = qobject_cast<EntryIconModel*>(model_);
+  if(iconModel) {
+    iconModel->setIconSize(m_maxAllowedIconWidth);
+  }
 }
 
 void EntryIconView::setMaxAllowedIconWidth(int width_) {
   m_maxAllowedIconWidth = qBound(MIN_ENTRY_ICON_SIZE, width_, MAX_ENTRY_ICON_SIZE);
   QSize iconSize(m_maxAllowedIconWidth, m_maxAllowedIconWidth);
   setIconSize(iconSize);
+  EntryIconModel* iconModel = qobject_cast<EntryIconModel*>(model());
+  if(iconModel) {
+    iconModel->setIconSize(m_maxAllowedIconWidth);
+  }
 
   QSize gridSize(m_maxAllowedIconWidth + 2*ENTRY_ICON_SIZE_PAD,
                  m_maxAllowedIconWidth + 3*(fontMetrics().lineSpacing() + ENTRY_ICON_SIZE_PAD));
@@ -37,59 +37,94 @@
 #include <KLocalizedString>
 
 #include <QTimer>
-#include <QApplication>
 
 namespace {
-  static const int CHECK_COLLECTION_IMAGES_STEP_SIZE = 10;
+  // the most requests that may be running at one time, across all sources
+  static const int UPDATE_MAX_REQUESTS = 8;
+  // the most requests that may be running at one time for a single source
+  static const int UPDATE_MAX_SOURCE_REQUESTS = 2;
+  // minimum time between starting requests to the same source, in milliseconds
+  static const int UPDATE_SOURCE_INTERVAL = 500;
+  // number of matched entries to collect before updating the collection
+  static const int UPDATE_BATCH_SIZE = 10;
 }
 
 using Tellico::EntryUpdater;
 
-// for each entry, we loop over all available fetchers
-// then we loop over all entries
+// every entry is searched in every fetcher, but several of those
+// searches may be running at the same time
 EntryUpdater::EntryUpdater(Tellico::Data::CollPtr coll_, Tellico::Data::EntryList entries_, QObject* parent_)
     : QObject(parent_)
     , m_coll(coll_)
     , m_entriesToUpdate(entries_)
-    , m_cancelled(false) {
+    , m_startTimer(nullptr)
+    , m_cancelled(false)
+    , m_processing(false)
+    , m_cleanedUp(false) {
   // for now, we're assuming all entries are same collection type
-  m_fetchers = Fetch::Manager::self()->createUpdateFetchers(m_coll->type());
-  foreach(Fetch::Fetcher::Ptr fetcher, m_fetchers) {
-    connect(fetcher.data(), SIGNAL(signalResultFound(Tellico::Fetch::FetchResult*)),
-            SLOT(slotResult(Tellico::Fetch::FetchResult*)));
-    connect(fetcher.data(), SIGNAL(signalDone(Tellico::Fetch::Fetcher*)),
-            SLOT(slotDone()));
+  // each fetcher only handles one request at a time, so create a set for each concurrent request
+  const int count = m_entriesToUpdate.count() > 1 ? UPDATE_MAX_SOURCE_REQUESTS : 1;
+  QList<Fetch::FetcherVec> fetchers;
+  for(int i = 0; i < count; ++i) {
+    fetchers << Fetch::Manager::self()->createUpdateFetchers(m_coll->type());
   }
-  init();
+  init(fetchers);
 }
 
 EntryUpdater::EntryUpdater(const QString& source_, Tellico::Data::CollPtr coll_, Tellico::Data::EntryList entries_, QObject* parent_)
     : QObject(parent_)
     , m_coll(coll_)
     , m_entriesToUpdate(entries_)
-    , m_cancelled(false) {
+    , m_startTimer(nullptr)
+    , m_cancelled(false)
+    , m_processing(false)
+    , m_cleanedUp(false) {
   // for now, we're assuming all entries are same collection type
-  Fetch::Fetcher::Ptr f = Fetch::Manager::self()->createUpdateFetcher(m_coll->type(), source_);
-  if(f) {
-    m_fetchers.append(f);
-    connect(f.data(), SIGNAL(signalResultFound(Tellico::Fetch::FetchResult*)),
-            SLOT(slotResult(Tellico::Fetch::FetchResult*)));
-    connect(f.data(), SIGNAL(signalDone(Tellico::Fetch::Fetcher*)),
-            SLOT(slotDone()));
+  const int count = m_entriesToUpdate.count() > 1 ? UPDATE_MAX_SOURCE_REQUESTS : 1;
+  QList<Fetch::FetcherVec> fetchers;
+  for(int i = 0; i < count; ++i) {
+    Fetch::Fetcher::Ptr f = Fetch::Manager::self()->createUpdateFetcher(m_coll->type(), source_);
+    if(f) {
+      fetchers << (Fetch::FetcherVec() << f);
+    }
   }
-  init();
+  init(fetchers);
 }
 
 EntryUpdater::~EntryUpdater() {
-  foreach(const UpdateResult& res, m_results) {
-    delete res.first;
+  QList<UpdateTask*> tasks = m_runningTasks.values() + m_finishedTasks;
+  foreach(UpdateTask* task, tasks) {
+    foreach(const UpdateResult& res, task->results) {
+      delete res.first;
+    }
   }
-  m_results.clear();
+  qDeleteAll(tasks);
+  m_runningTasks.clear();
+  m_finishedTasks.clear();
 }
 
-void EntryUpdater::init() {
-  m_fetchIndex = 0;
+void EntryUpdater::init(const QList<Fetch::FetcherVec>& fetchers_) {
+  if(!fetchers_.isEmpty()) {
+    const int nSources = fetchers_.first().count();
+    m_sources.resize(nSources);
+    foreach(const Fetch::FetcherVec& fetchers, fetchers_) {
+      // every set should have the same sources in the same order
+      if(fetchers.count() != nSources) {
+        myDebug() << "mismatched fetcher count";
+        continue;
+      }
+      for(int i = 0; i < nSources; ++i) {
+        addFetcher(i, fetchers.at(i));
+      }
+    }
+  }
+
   m_origEntryCount = m_entriesToUpdate.count();
+  m_tasksDone = 0;
+  m_startTimer = new QTimer(this);
+  m_startTimer->setSingleShot(true);
+  connect(m_startTimer, SIGNAL(timeout()), SLOT(slotStartNext()));
+
   QString label;
   if(m_entriesToUpdate.count() == 1) {
     label = i18n("Updating %1...", m_entriesToUpdate.front()->title());
@@ -98,89 +133,161 @@ void EntryUpdater::init() {
   }
   Kernel::self()->beginCommandGroup(i18n("Update Entries"));
   ProgressItem& item = ProgressManager::self()->newProgressItem(this, label, true /*canCancel*/);
-  item.setTotalSteps(m_fetchers.count() * m_origEntryCount);
+  item.setTotalSteps(m_sources.count() * m_origEntryCount);
   connect(&item, SIGNAL(signalCancelled(ProgressItem*)), SLOT(slotCancel()));
 
   // done if no fetchers available
-  if(m_fetchers.isEmpty()) {
+  if(m_sources.isEmpty() || m_entriesToUpdate.isEmpty()) {
     QTimer::singleShot(500, this, SLOT(slotCleanup()));
   } else {
     slotStartNext(); // starts fetching
   }
 }
 
+void EntryUpdater::addFetcher(int source_, Tellico::Fetch::Fetcher::Ptr fetcher_) {
+  m_sources[source_].fetchers.append(fetcher_);
+  m_sources[source_].idleFetchers.append(fetcher_);
+  connect(fetcher_.data(), SIGNAL(signalResultFound(Tellico::Fetch::FetchResult*)),
+          SLOT(slotResult(Tellico::Fetch::FetchResult*)));
+  connect(fetcher_.data(), SIGNAL(signalDone(Tellico::Fetch::Fetcher*)),
+          SLOT(slotDone(Tellico::Fetch::Fetcher*)));
+}
+
 void EntryUpdater::slotStartNext() {
-  StatusBar::self()->setStatus(i18n("Updating <b>%1</b>...", m_entriesToUpdate.front()->title()));
-  ProgressManager::self()->setProgress(this, m_fetchers.count() * (m_origEntryCount - m_entriesToUpdate.count()) + m_fetchIndex);
+  if(m_cancelled) {
+    return;
+  }
 
-  Fetch::Fetcher::Ptr f = m_fetchers[m_fetchIndex];
-//  myDebug() << "starting " << f->source();
-  f->startUpdate(m_entriesToUpdate.front());
+  // time until a source that is waiting on its rate limit can be used again
+  int wait = -1;
+  for(int i = 0; i < m_sources.count() && m_runningTasks.count() < UPDATE_MAX_REQUESTS; ++i) {
+    Source& source = m_sources[i];
+    if(source.idleFetchers.isEmpty() || source.nextEntry >= m_entriesToUpdate.count()) {
+      continue;
+    }
+    if(source.lastStart.isValid() && source.lastStart.elapsed() < UPDATE_SOURCE_INTERVAL) {
+      const int remaining = UPDATE_SOURCE_INTERVAL - static_cast<int>(source.lastStart.elapsed());
+      wait = wait < 0 ? remaining : qMin(wait, remaining);
+      continue;
+    }
+
+    UpdateTask* task = new UpdateTask;
+    task->source = i;
+    task->entry = m_entriesToUpdate.at(source.nextEntry++);
+    task->fetcher = source.idleFetchers.takeFirst();
+    source.lastStart.start();
+    m_runningTasks.insert(task->fetcher.data(), task);
+
+    StatusBar::self()->setStatus(i18n("Updating <b>%1</b>...", task->entry->title()));
+//    myDebug() << "starting " << task->fetcher->source();
+    // the fetcher might be done right away, slotDone() takes care of that
+    task->fetcher->startUpdate(task->entry);
+  }
+
+  if(wait > -1 && !m_startTimer->isActive()) {
+    m_startTimer->start(wait);
+  }
 }
 
-void EntryUpdater::slotDone() {
-  if(m_cancelled) {
-    //    myLog() << "already cancelled";
-    QTimer::singleShot(500, this, SLOT(slotCleanup()));
+void EntryUpdater::slotDone(Tellico::Fetch::Fetcher* fetcher_) {
+  UpdateTask* task = m_runningTasks.take(fetcher_);
+  if(!task) {
+    return;
+  }
+  m_finishedTasks.append(task);
+  // handle the results outside of the fetcher's signal
+  QMetaObject::invokeMethod(this, "slotProcessFinished", Qt::QueuedConnection);
+}
+
+void EntryUpdater::slotProcessFinished() {
+  // asking the user about a match runs an event loop, so other
+  // tasks can finish in the meantime. The outer call handles them
+  if(m_processing || m_cleanedUp) {
     return;
   }
+  m_processing = true;
+  while(!m_finishedTasks.isEmpty()) {
+    UpdateTask* task = m_finishedTasks.takeFirst();
+    if(!m_cancelled) {
+      handleResults(task);
+    }
+    foreach(const UpdateResult& res, task->results) {
+      delete res.first;
+    }
+    // the fetcher can't be used again until the results are done since the
+    // fetched entries belong to it
+    m_sources[task->source].idleFetchers.append(task->fetcher);
+    delete task;
+    ++m_tasksDone;
+  }
+  m_processing = false;
 
-  if(!m_results.isEmpty()) {
-    handleResults();
+  ProgressManager::self()->setProgress(this, m_tasksDone);
+  if(m_pendingUpdates.count() >= UPDATE_BATCH_SIZE) {
+    applyPendingUpdates();
+  }
+
+  if(isFinished()) {
+    applyPendingUpdates();
+    QTimer::singleShot(500, this, SLOT(slotCleanup()));
+  } else {
+    slotStartNext();
   }
+}
 
-  m_results.clear();
-  ++m_fetchIndex;
-//  myDebug() << m_fetchIndex;
-  if(m_fetchIndex == m_fetchers.count()) {
-    m_fetchIndex = 0;
-    // we've gone through the loop for the first entry in the vector
-    // pop it and move on
-    m_entriesToUpdate.removeAll(m_entriesToUpdate.front());
-    // if there are no more entries, and this is the last fetcher, time to delete
-    if(m_entriesToUpdate.isEmpty()) {
-      QTimer::singleShot(500, this, SLOT(slotCleanup()));
-      return;
+bool EntryUpdater::isFinished() const {
+  if(!m_runningTasks.isEmpty() || !m_finishedTasks.isEmpty()) {
+    return false;
+  }
+  if(m_cancelled) {
+    return true;
+  }
+  foreach(const Source& source, m_sources) {
+    if(source.nextEntry < m_entriesToUpdate.count()) {
+      return false;
     }
   }
-  qApp->processEvents();
-  // so the entry updater can clean up a bit
-  QTimer::singleShot(500, this, SLOT(slotStartNext()));
+  return true;
 }
 
 void EntryUpdater::slotResult(Tellico::Fetch::FetchResult* result_) {
   if(!result_ || m_cancelled || !result_->fetcher->isSearching()) {
     return;
   }
+  UpdateTask* task = m_runningTasks.value(result_->fetcher.data());
+  if(!task) {
+    return;
+  }
 
 //  myDebug() << result_->title << " [" << result_->fetcher->source() << "]";
-  m_results.append(UpdateResult(result_, m_fetchers[m_fetchIndex]->updateOverwrite()));
+  task->results.append(UpdateResult(result_, result_->fetcher->updateOverwrite()));
   Data::EntryPtr e = result_->fetchEntry();
-  if(e && !m_entriesToUpdate.isEmpty()) {
-    m_fetchedEntries.append(e);
-    const int match = m_coll->sameEntry(m_entriesToUpdate.front(), e);
+  if(e) {
+    const int match = m_coll->sameEntry(task->entry, e);
     if(match > EntryComparison::ENTRY_PERFECT_MATCH) {
       result_->fetcher->stop();
     }
   }
-  qApp->processEvents();
 }
 
 void EntryUpdater::slotCancel() {
   m_cancelled = true;
-  Fetch::Fetcher::Ptr f = m_fetchers[m_fetchIndex];
-  if(f) {
-    f->stop(); // ends up calling slotDone();
-  } else {
-    slotDone();
+  m_startTimer->stop();
+  foreach(Fetch::Fetcher* fetcher, m_runningTasks.keys()) {
+    fetcher->stop(); // ends up calling slotDone();
+    // in case the fetcher wasn't actually searching
+    if(m_runningTasks.contains(fetcher)) {
+      slotDone(fetcher);
+    }
   }
+  QMetaObject::invokeMethod(this, "slotProcessFinished", Qt::QueuedConnection);
 }
 
-void EntryUpdater::handleResults() {
-  Data::EntryPtr entry = m_entriesToUpdate.front();
+void EntryUpdater::handleResults(UpdateTask* task_) {
+  Data::EntryPtr entry = task_->entry;
   int best = 0;
   ResultList matches;
-  foreach(const UpdateResult& res, m_results) {
+  foreach(const UpdateResult& res, task_->results) {
     Data::EntryPtr e = res.first->fetchEntry();
     if(!e) {
       continue;
@@ -220,17 +327,16 @@ void EntryUpdater::handleResults() {
   if(matches.count() == 1) {
     match = matches.front();
   } else if(matches.count() > 1) {
-    match = askUser(matches);
+    match = askUser(task_, matches);
   }
   // askUser() could come back with nil
   if(match.first) {
-    mergeCurrent(match.first->fetchEntry(), match.second);
+    mergeCurrent(entry, match.first->fetchEntry(), match.second);
   }
 }
 
-Tellico::EntryUpdater::UpdateResult EntryUpdater::askUser(const ResultList& results) {
-  EntryMatchDialog dlg(Kernel::self()->widget(), m_entriesToUpdate.front(),
-                       m_fetchers[m_fetchIndex], results);
+Tellico::EntryUpdater::UpdateResult EntryUpdater::askUser(UpdateTask* task_, const ResultList& results) {
+  EntryMatchDialog dlg(Kernel::self()->widget(), task_->entry, task_->fetcher, results);
 
   if(dlg.exec() != QDialog::Accepted) {
     return UpdateResult(nullptr, false);
@@ -238,26 +344,44 @@ Tellico::EntryUpdater::UpdateResult EntryUpdater::askUser(const ResultList& resu
   return dlg.updateResult();
 }
 
-void EntryUpdater::mergeCurrent(Tellico::Data::EntryPtr entry_, bool overWrite_) {
-  Data::EntryPtr currEntry = m_entriesToUpdate.front();
+void EntryUpdater::mergeCurrent(Tellico::Data::EntryPtr currEntry_, Tellico::Data::EntryPtr entry_, bool overWrite_) {
   if(entry_) {
     m_matchedEntries.append(entry_);
-    Kernel::self()->updateEntry(currEntry, entry_, overWrite_);
-    if(m_entriesToUpdate.count() % CHECK_COLLECTION_IMAGES_STEP_SIZE == 1) {
-      // I don't want to remove any images in the entries that are getting
-      // updated since they'll reference them later and the command isn't
-      // executed until the command history group is finished
-      // so remove pointers to matched entries
-      Data::EntryList nonUpdatedEntries = m_fetchedEntries;
-      foreach(Data::EntryPtr match, m_matchedEntries) {
-        nonUpdatedEntries.removeAll(match);
-      }
-      Data::Document::self()->removeImagesNotInCollection(nonUpdatedEntries, m_matchedEntries);
-    }
+    PendingUpdate update;
+    update.currEntry = currEntry_;
+    update.newEntry = entry_;
+    update.overWrite = overWrite_;
+    m_pendingUpdates.append(update);
   }
 }
 
+void EntryUpdater::applyPendingUpdates() {
+  // only the entries fetched since the last batch get checked, so each one is only handled once
+  Data::EntryList nonUpdatedEntries;
+  nonUpdatedEntries.swap(m_fetchedEntries);
+  // all the updates go into the same command group, started in init()
+  foreach(const PendingUpdate& update, m_pendingUpdates) {
+    Kernel::self()->updateEntry(update.currEntry, update.newEntry, update.overWrite);
+    nonUpdatedEntries.removeAll(update.newEntry);
+  }
+  m_pendingUpdates.clear();
+  if(nonUpdatedEntries.isEmpty()) {
+    return;
+  }
+
+  // I don't want to remove any images in the entries that are getting
+  // updated since they'll reference them later and the command isn't
+  // executed until the command history group is finished
+  // so keep the images of every matched entry, even from earlier batches.
+  // Only entries from tasks which are completely handled are in the fetched list
+  Data::Document::self()->removeImagesNotInCollection(nonUpdatedEntries, m_matchedEntries);
+}
+
 void EntryUpdater::slotCleanup() {
+  if(m_cleanedUp) {
+    return;
+  }
+  m_cleanedUp = true;
   StatusBar::self()->clearStatus();
   ProgressManager::self()->setDone(this);
   Kernel::self()->endCommandGroup();
@@ -29,10 +29,21 @@
 #include "fetch/fetchmanager.h"
 
 #include <QPair>
+#include <QHash>
+#include <QVector>
+#include <QElapsedTimer>
+
+class QTimer;
 
 namespace Tellico {
 
 /**
+ * Updates entries by searching the update fetchers for each of them.
+ *
+ * Requests are pipelined, several entries are searched at once and each source
+ * may have more than one request in flight, within a per-source limit and rate.
+ * Matched entries are applied in batches, all inside a single command group.
+ *
  * @author Robby Stephenson
  */
 class EntryUpdater : public QObject {
@@ -51,24 +62,54 @@ public Q_SLOTS:
 
 private Q_SLOTS:
   void slotStartNext();
-  void slotDone();
+  void slotDone(Tellico::Fetch::Fetcher* fetcher);
+  void slotProcessFinished();
   void slotCleanup();
 
 private:
-  void init();
-  void handleResults();
-  UpdateResult askUser(const ResultList& results);
-  void mergeCurrent(Data::EntryPtr entry, bool overwrite);
+  // a single search of one source for one entry
+  struct UpdateTask {
+    int source;
+    Data::EntryPtr entry;
+    Fetch::Fetcher::Ptr fetcher;
+    ResultList results;
+  };
+  // all the fetchers for one data source, each can run one request at a time
+  struct Source {
+    Source() : nextEntry(0) {}
+    Fetch::FetcherVec fetchers;
+    Fetch::FetcherVec idleFetchers;
+    int nextEntry;
+    QElapsedTimer lastStart;
+  };
+  struct PendingUpdate {
+    Data::EntryPtr currEntry;
+    Data::EntryPtr newEntry;
+    bool overWrite;
+  };
+
+  void init(const QList<Fetch::FetcherVec>& fetchers);
+  void addFetcher(int source, Fetch::Fetcher::Ptr fetcher);
+  void handleResults(UpdateTask* task);
+  UpdateResult askUser(UpdateTask* task, const ResultList& results);
+  void mergeCurrent(Data::EntryPtr currEntry, Data::EntryPtr entry, bool overwrite);
+  void applyPendingUpdates();
+  bool isFinished() const;
 
   Data::CollPtr m_coll;
   Data::EntryList m_entriesToUpdate;
   Data::EntryList m_fetchedEntries;
   Data::EntryList m_matchedEntries;
-  Fetch::FetcherVec m_fetchers;
-  int m_fetchIndex;
+  QVector<Source> m_sources;
+  QHash<Fetch::Fetcher*, UpdateTask*> m_runningTasks;
+  QList<UpdateTask*> m_finishedTasks;
+  QList<PendingUpdate> m_pendingUpdates;
+  QTimer* m_startTimer;
   int m_origEntryCount;
-  ResultList m_results;
-  bool m_cancelled;
+  int m_tasksDone;
+  bool m_cancelled : 1;
+  bool m_processing : 1;
+  bool m_cleanedUp : 1;
 };
 
 } // end namespace
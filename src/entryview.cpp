@@ -47,14 +47,57 @@
 #include <QFile>
 #include <QTextStream>
 #include <QClipboard>
-#include <QDomDocument>
 #include <QTemporaryFile>
 #include <QApplication>
 #include <QDesktopServices>
+#include <QTimer>
+#include <QRunnable>
+
+#include <algorithm>
+
+extern "C" {
+#include <libxml/tree.h>
+}
+
+namespace {
+  // the cache cost is the length of the html, so this is about 8 MB of text
+  static const int ENTRYVIEW_HTML_CACHE_SIZE = 4 * 1024 * 1024;
+  // delay before rendering the adjacent entries, so that rapid selection changes are skipped
+  static const int ENTRYVIEW_PREFETCH_DELAY = 200; // ms
+}
 
 using Tellico::EntryView;
 using Tellico::EntryViewWidget;
 
+// runs the XSLT transformation of an entry's XML in the background, then hands the html back to the view
+class EntryView::PrefetchTask : public QRunnable {
+public:
+  PrefetchTask(EntryView* view_, XSLTHandler* handler_, const QString& key_, xmlDocPtr xml_, int generation_)
+      : QRunnable(), m_view(view_), m_handler(handler_), m_key(key_), m_xml(xml_), m_generation(generation_) {}
+  // the task might be removed from the pool without running
+  ~PrefetchTask() {
+    xmlFreeDoc(m_xml);
+  }
+
+  void run() Q_DECL_OVERRIDE {
+    // the handler takes ownership of the document
+    xmlDocPtr xml = m_xml;
+    m_xml = nullptr;
+    const QString html = m_handler->applyStylesheet(xml);
+    QMetaObject::invokeMethod(m_view, "slotPrefetchDone", Qt::QueuedConnection,
+                              Q_ARG(QString, m_key),
+                              Q_ARG(QString, html),
+                              Q_ARG(int, m_generation));
+  }
+
+private:
+  EntryView* m_view;
+  XSLTHandler* m_handler;
+  QString m_key;
+  xmlDocPtr m_xml;
+  int m_generation;
+};
+
 EntryViewWidget::EntryViewWidget(EntryView* part, QWidget* parent)
     : KHTMLView(part, parent) {}
 
@@ -75,7 +118,9 @@ void EntryViewWidget::changeEvent(QEvent* event_) {
 }
 
 EntryView::EntryView(QWidget* parent_) : KHTMLPart(new EntryViewWidget(this, parent_), parent_),
-    m_handler(nullptr), m_tempFile(nullptr), m_useGradientImages(true), m_checkCommonFile(true) {
+    m_handler(nullptr), m_tempFile(nullptr), m_useGradientImages(true), m_checkCommonFile(true),
+    m_useHtmlCache(false), m_htmlCache(ENTRYVIEW_HTML_CACHE_SIZE), m_cacheGeneration(0),
+    m_prefetchTimer(new QTimer(this)), m_prefetchHandler(nullptr) {
   setJScriptEnabled(false);
   setJavaEnabled(false);
   setMetaRefreshEnabled(false);
@@ -88,9 +133,21 @@ EntryView::EntryView(QWidget* parent_) : KHTMLPart(new EntryViewWidget(this, par
 
   connect(browserExtension(), SIGNAL(openUrlRequestDelayed(const QUrl&, const KParts::OpenUrlArguments&, const KParts::BrowserArguments&)),
           SLOT(slotOpenURL(const QUrl&)));
+
+  // the prefetch handler is not thread-safe, so only one transformation can run at a time
+  m_prefetchPool.setMaxThreadCount(1);
+  m_prefetchTimer->setSingleShot(true);
+  m_prefetchTimer->setInterval(ENTRYVIEW_PREFETCH_DELAY);
+  connect(m_prefetchTimer, SIGNAL(timeout()), SLOT(slotStartPrefetch()));
+  // verifying images changes the html, so anything cached might be missing a newly loaded image
+  connect(ImageFactory::self(), SIGNAL(imageAvailable(const QString&)), SLOT(slotClearHtmlCache()));
 }
 
 EntryView::~EntryView() {
+  m_prefetchPool.clear();
+  m_prefetchPool.waitForDone();
+  delete m_prefetchHandler;
+  m_prefetchHandler = nullptr;
   delete m_handler;
   m_handler = nullptr;
   delete m_tempFile;
@@ -143,33 +200,22 @@ void EntryView::showEntry(Tellico::Data::EntryPtr entry_) {
   QUrl u = QUrl::fromLocalFile(m_xsltFile);
   begin(u);
 
-  Export::TellicoXMLExporter exporter(entry_->collection());
-  exporter.setEntries(Data::EntryList() << entry_);
-  long opt = exporter.options();
-  // verify images for the view
-  opt |= Export::ExportVerifyImages;
-  // on second thought, don't auto-format everything, just clean it
-//  if(Data::Field::autoFormat()) {
-//    opt = Export::ExportFormatted;
-//  }
-  if(entry_->collection()->type() == Data::Collection::Bibtex) {
-    opt |= Export::ExportClean;
-  }
-  exporter.setOptions(opt);
-  QDomDocument dom = exporter.exportXML();
-
-//  myDebug() << dom.toString();
+  QString html;
+  const QString key = m_useHtmlCache ? cacheKey(entry_) : QString();
+  const QString* cachedHtml = key.isEmpty() ? nullptr : m_htmlCache.object(key);
+  if(cachedHtml) {
+    html = *cachedHtml;
+  } else {
+    xmlDocPtr xml = entryXML(entry_);
 #if 0
-  myWarning() << "turn me off!";
-  QFile f1(QLatin1String("/tmp/test.xml"));
-  if(f1.open(QIODevice::WriteOnly)) {
-    QTextStream t(&f1);
-    t << dom.toString();
-  }
-  f1.close();
+    myWarning() << "turn me off!";
+    xmlSaveFile("/tmp/test.xml", xml);
 #endif
-
-  QString html = m_handler->applyStylesheet(dom.toString());
+    html = m_handler->applyStylesheet(xml);
+    if(!key.isEmpty()) {
+      m_htmlCache.insert(key, new QString(html), html.size());
+    }
+  }
   // write out image files
   Data::FieldList fields = entry_->collection()->imageFields();
   foreach(Data::FieldPtr field, fields) {
@@ -291,6 +337,7 @@ void EntryView::setXSLTFile(const QString& file_) {
   }
 
   m_handler->addStringParam("datadir", QFile::encodeName(Tellico::installationDir()));
+  updateTemplateKey();
 
   // if we don't have to reload the images, then just show the entry and we're done
   if(reloadImages) {
@@ -302,11 +349,139 @@ void EntryView::setXSLTFile(const QString& file_) {
 }
 
 void EntryView::slotRefresh() {
+  slotClearHtmlCache();
   setXSLTFile(m_xsltFile);
   showEntry(m_entry);
   view()->repaint();
 }
 
+void EntryView::refreshEntries(const Tellico::Data::EntryList& entries_) {
+  bool showsEntry = false;
+  foreach(Data::EntryPtr entry, entries_) {
+    m_htmlCache.remove(cacheKey(entry));
+    if(entry == m_entry) {
+      showsEntry = true;
+    }
+  }
+  // any prefetch still running might be for one of the modified entries
+  ++m_cacheGeneration;
+  if(showsEntry) {
+    setXSLTFile(m_xsltFile);
+    showEntry(m_entry);
+    view()->repaint();
+  }
+}
+
+void EntryView::setUseHtmlCache(bool b_) {
+  m_useHtmlCache = b_;
+  if(!m_useHtmlCache) {
+    m_prefetchTimer->stop();
+    m_prefetchEntries.clear();
+    slotClearHtmlCache();
+  }
+}
+
+void EntryView::prefetchEntries(Tellico::Data::EntryList entries_) {
+  if(!m_useHtmlCache) {
+    return;
+  }
+  m_prefetchEntries = entries_;
+  m_prefetchTimer->start();
+}
+
+void EntryView::slotStartPrefetch() {
+  if(!m_handler || !m_handler->isValid()) {
+    return;
+  }
+  // drop anything queued for a previous selection
+  m_prefetchPool.clear();
+
+  if(!m_prefetchHandler) {
+    m_prefetchHandler = new XSLTHandler(QFile::encodeName(m_xsltFile));
+    if(!m_prefetchHandler->isValid()) {
+      delete m_prefetchHandler;
+      m_prefetchHandler = nullptr;
+      return;
+    }
+    QHashIterator<QByteArray, QByteArray> it(m_handler->params());
+    while(it.hasNext()) {
+      it.next();
+      m_prefetchHandler->addParam(it.key(), it.value());
+    }
+  }
+
+  foreach(Data::EntryPtr entry, m_prefetchEntries) {
+    const QString key = cacheKey(entry);
+    if(key.isEmpty() || m_htmlCache.contains(key)) {
+      continue;
+    }
+    // the exporter and the image factory are not thread-safe, so the xml is created here
+    // and only the transformation runs in the background
+    m_prefetchPool.start(new PrefetchTask(this, m_prefetchHandler, key, entryXML(entry), m_cacheGeneration));
+  }
+  m_prefetchEntries.clear();
+}
+
+void EntryView::slotPrefetchDone(const QString& key_, const QString& html_, int generation_) {
+  // if the template or the entry changed while rendering, the html is stale
+  if(generation_ != m_cacheGeneration || !m_useHtmlCache) {
+    return;
+  }
+  m_htmlCache.insert(key_, new QString(html_), html_.size());
+}
+
+void EntryView::slotClearHtmlCache() {
+  m_htmlCache.clear();
+  ++m_cacheGeneration;
+}
+
+void EntryView::updateTemplateKey() {
+  QByteArray key = QFile::encodeName(m_xsltFile);
+  if(m_handler) {
+    const QHash<QByteArray, QByteArray>& params = m_handler->params();
+    QList<QByteArray> names = params.keys();
+    std::sort(names.begin(), names.end());
+    foreach(const QByteArray& name, names) {
+      key += '\n' + name + '=' + params.value(name);
+    }
+  }
+  if(key == m_templateKey) {
+    return;
+  }
+  m_templateKey = key;
+  slotClearHtmlCache();
+  // the prefetch handler has the old parameters, wait for it to finish before removing it
+  m_prefetchPool.clear();
+  m_prefetchPool.waitForDone();
+  delete m_prefetchHandler;
+  m_prefetchHandler = nullptr;
+}
+
+_xmlDoc* EntryView::entryXML(Tellico::Data::EntryPtr entry_) {
+  Export::TellicoXMLExporter exporter(entry_->collection());
+  exporter.setEntries(Data::EntryList() << entry_);
+  long opt = exporter.options();
+  // verify images for the view
+  opt |= Export::ExportVerifyImages;
+  // on second thought, don't auto-format everything, just clean it
+//  if(Data::Field::autoFormat()) {
+//    opt = Export::ExportFormatted;
+//  }
+  if(entry_->collection()->type() == Data::Collection::Bibtex) {
+    opt |= Export::ExportClean;
+  }
+  exporter.setOptions(opt);
+  return exporter.exportXMLDoc();
+}
+
+QString EntryView::cacheKey(Tellico::Data::EntryPtr entry_) {
+  // entries without an id have not been added to a collection yet
+  if(!entry_ || !entry_->collection() || entry_->id() < 1) {
+    return QString();
+  }
+  return QString::number(entry_->collection()->id()) + QLatin1Char(':') + QString::number(entry_->id());
+}
+
 // do some contortions in case the url is relative
 // need to interpret it relative to document URL instead of xslt file
 // the current node under the mouse vould be the text node inside
@@ -356,6 +531,7 @@ void EntryView::addXSLTStringParam(const QByteArray& name_, const QByteArray& va
     return;
   }
   m_handler->addStringParam(name_, value_);
+  updateTemplateKey();
 }
 
 void EntryView::setXSLTOptions(const Tellico::StyleOptions& opt_) {
@@ -369,6 +545,7 @@ void EntryView::setXSLTOptions(const Tellico::StyleOptions& opt_) {
   m_handler->addStringParam("color1",   opt_.highlightedTextColor.name().toLatin1());
   m_handler->addStringParam("color2",   opt_.highlightedBaseColor.name().toLatin1());
   m_handler->addStringParam("imgdir",   QFile::encodeName(opt_.imgDir));
+  updateTemplateKey();
 }
 
 void EntryView::resetView() {
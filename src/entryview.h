@@ -31,8 +31,15 @@
 #include <KHTMLView>
 
 #include <QPointer>
+#include <QCache>
+#include <QThreadPool>
 
 class QTemporaryFile;
+class QTimer;
+
+extern "C" {
+  struct _xmlDoc;
+}
 
 namespace Tellico {
   class XSLTHandler;
@@ -78,7 +85,18 @@ public:
   void addXSLTStringParam(const QByteArray& name, const QByteArray& value);
   void setXSLTOptions(const StyleOptions& options);
   void setUseGradientImages(bool b) { m_useGradientImages = b; }
+  /**
+   * Enables caching the rendered HTML for each entry. The cache is only safe to use
+   * for entries which belong to the document collection, since any modification must be
+   * reported through @ref refreshEntries.
+   */
+  void setUseHtmlCache(bool b);
   void resetView();
+  /**
+   * Drops any cached HTML for the entries, and refreshes the view if the
+   * current entry is one of them.
+   */
+  void refreshEntries(const Data::EntryList& entries);
 
 Q_SIGNALS:
   void signalAction(const QUrl& url);
@@ -89,6 +107,11 @@ public Q_SLOTS:
    */
   void slotRefresh();
   void showEntries(Tellico::Data::EntryList entries);
+  /**
+   * Queues the entries to be rendered into the cache once the view is idle.
+   * Typically, these are the entries adjacent to the current one.
+   */
+  void prefetchEntries(Tellico::Data::EntryList entries);
 
 private Q_SLOTS:
   /**
@@ -98,9 +121,17 @@ private Q_SLOTS:
    */
   void slotOpenURL(const QUrl& url);
   void slotReloadEntry();
+  void slotStartPrefetch();
+  void slotPrefetchDone(const QString& key, const QString& html, int generation);
+  void slotClearHtmlCache();
 
 private:
+  class PrefetchTask;
+
   void resetColors();
+  void updateTemplateKey();
+  static _xmlDoc* entryXML(Data::EntryPtr entry);
+  static QString cacheKey(Data::EntryPtr entry);
 
   Data::EntryPtr m_entry;
   XSLTHandler* m_handler;
@@ -110,6 +141,16 @@ private:
   QTemporaryFile* m_tempFile;
   bool m_useGradientImages;
   bool m_checkCommonFile;
+
+  bool m_useHtmlCache;
+  QCache<QString, QString> m_htmlCache;
+  QByteArray m_templateKey;
+  int m_cacheGeneration;
+  Data::EntryList m_prefetchEntries;
+  QTimer* m_prefetchTimer;
+  // the prefetch handler is only used by the single prefetch thread
+  XSLTHandler* m_prefetchHandler;
+  QThreadPool m_prefetchPool;
 };
 
 // stupid naming on my part, I need to subclass the view to
@@ -31,6 +31,7 @@
 #include "../utils/guiproxy.h"
 #include "../utils/string_utils.h"
 #include "../core/filehandler.h"
+#include "../core/fetchtransport.h"
 #include "../tellico_debug.h"
 
 #include <KIO/Job>
@@ -134,7 +135,7 @@ void AbstractAllocineFetcher::search() {
   u.setQuery(query);
 //  myDebug() << u;
 
-  m_job = KIO::storedGet(u, KIO::NoReload, KIO::HideProgressInfo);
+  m_job = FetchTransport::get(u);
   // 10/8/17: UserAgent appears necessary to receive data
   m_job->addMetaData(QLatin1String("UserAgent"), QString::fromLatin1("Tellico/%1")
                                                                 .arg(QLatin1String(TELLICO_VERSION)));
@@ -191,7 +192,7 @@ Tellico::Data::EntryPtr AbstractAllocineFetcher::fetchEntryHook(uint uid_) {
 //  myDebug() << "url: " << u;
   // 10/8/17: UserAgent appears necessary to receive data
 //  QByteArray data = FileHandler::readDataFile(u, true);
-  KIO::StoredTransferJob* dataJob = KIO::storedGet(u, KIO::NoReload, KIO::HideProgressInfo);
+  FetchTransferJob* dataJob = FetchTransport::get(u);
   dataJob->addMetaData(QLatin1String("UserAgent"), QString::fromLatin1("Tellico/%1")
                                                                   .arg(QLatin1String(TELLICO_VERSION)));
   if(!dataJob->exec()) {
@@ -34,11 +34,9 @@
 class QSpinBox;
 
 class KJob;
-namespace KIO {
-  class StoredTransferJob;
-}
 
 namespace Tellico {
+  class FetchTransferJob;
 
   namespace Fetch {
 
@@ -87,7 +85,7 @@ private:
   void populateEntry(Data::EntryPtr entry, const QVariantMap& resultMap);
 
   QHash<int, Data::EntryPtr> m_entries;
-  QPointer<KIO::StoredTransferJob> m_job;
+  QPointer<FetchTransferJob> m_job;
 
   bool m_started;
   QString m_apiKey;
@@ -38,6 +38,7 @@
 #include "../utils/isbnvalidator.h"
 #include "../utils/datafileregistry.h"
 #include "../gui/combobox.h"
+#include "../core/fetchtransport.h"
 #include "../tellico_debug.h"
 
 #include <KLocalizedString>
@@ -382,7 +383,7 @@ void AmazonFetcher::doSearch() {
   QUrl newUrl = request.signedRequest(params);
 //  myDebug() << newUrl;
 
-  m_job = KIO::storedGet(newUrl, KIO::NoReload, KIO::HideProgressInfo);
+  m_job = FetchTransport::get(newUrl);
   KJobWidgets::setWindow(m_job, GUI::Proxy::widget());
   connect(m_job, SIGNAL(result(KJob*)),
           SLOT(slotComplete(KJob*)));
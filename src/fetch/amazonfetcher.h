@@ -39,11 +39,9 @@ class QCheckBox;
 class QLabel;
 
 class KJob;
-namespace KIO {
-  class StoredTransferJob;
-}
 
 namespace Tellico {
+  class FetchTransferJob;
 
   class XSLTHandler;
   namespace GUI {
@@ -142,7 +140,7 @@ private:
   int m_total;
   int m_numResults;
   QHash<int, Data::EntryPtr> m_entries; // they get modified after collection is created, so can't be const
-  QPointer<KIO::StoredTransferJob> m_job;
+  QPointer<FetchTransferJob> m_job;
 
   bool m_started;
 };
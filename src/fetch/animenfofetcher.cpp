@@ -31,6 +31,7 @@
 #include "../fieldformat.h"
 #include "../core/filehandler.h"
 #include "../images/imagefactory.h"
+#include "../core/fetchtransport.h"
 #include "../tellico_debug.h"
 
 #include <KLocalizedString>
@@ -111,7 +112,7 @@ void AnimeNfoFetcher::search() {
   u.setQuery(q);
 //  myDebug() << "url:" << u;
 
-  m_job = KIO::storedGet(u, KIO::NoReload, KIO::HideProgressInfo);
+  m_job = FetchTransport::get(u);
   KJobWidgets::setWindow(m_job, GUI::Proxy::widget());
   connect(m_job, SIGNAL(result(KJob*)),
           SLOT(slotComplete(KJob*)));
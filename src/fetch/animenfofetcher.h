@@ -32,11 +32,9 @@
 
 class QUrl;
 class KJob;
-namespace KIO {
-  class StoredTransferJob;
-}
 
 namespace Tellico {
+  class FetchTransferJob;
   namespace Fetch {
 
 /**
@@ -87,7 +85,7 @@ private:
 //  int m_total;
   QHash<int, Data::EntryPtr> m_entries;
   QHash<int, QUrl> m_matches;
-  QPointer<KIO::StoredTransferJob> m_job;
+  QPointer<FetchTransferJob> m_job;
 
   bool m_started;
 //  QStringList m_fields;
@@ -24,7 +24,7 @@
 
 #include "arxivfetcher.h"
 #include "../translators/xslthandler.h"
-#include "../translators/tellicoimporter.h"
+#include "../translators/tellicoxmlhandler.h"
 #include "../utils/guiproxy.h"
 #include "../utils/string_utils.h"
 #include "../utils/datafileregistry.h"
@@ -32,6 +32,7 @@
 #include "../entry.h"
 #include "../core/netaccess.h"
 #include "../images/imagefactory.h"
+#include "../core/fetchtransport.h"
 #include "../tellico_debug.h"
 
 #include <KLocalizedString>
@@ -96,7 +97,7 @@ void ArxivFetcher::doSearch() {
     return;
   }
 
-  m_job = KIO::storedGet(u, KIO::NoReload, KIO::HideProgressInfo);
+  m_job = FetchTransport::get(u);
   KJobWidgets::setWindow(m_job, GUI::Proxy::widget());
   connect(m_job, SIGNAL(result(KJob*)),
           SLOT(slotComplete(KJob*)));
@@ -167,9 +168,8 @@ void ArxivFetcher::slotComplete(KJob*) {
   }
 
   // assume result is always utf-8
-  QString str = m_xsltHandler->applyStylesheet(QString::fromUtf8(data.constData(), data.size()));
-  Import::TellicoImporter imp(str);
-  Data::CollPtr coll = imp.collection();
+  Data::CollPtr coll = Import::TellicoXMLHandler::transformCollection(m_xsltHandler,
+                                                                      QString::fromUtf8(data.constData(), data.size()));
 
   if(!coll) {
     myDebug() << "no valid result";
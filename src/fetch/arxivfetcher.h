@@ -32,11 +32,9 @@
 
 class QUrl;
 class KJob;
-namespace KIO {
-  class StoredTransferJob;
-}
 
 namespace Tellico {
+  class FetchTransferJob;
 
   class XSLTHandler;
 
@@ -92,7 +90,7 @@ private:
   int m_total;
 
   QHash<int, Data::EntryPtr> m_entries;
-  QPointer<KIO::StoredTransferJob> m_job;
+  QPointer<FetchTransferJob> m_job;
 
   bool m_started;
 };
@@ -31,6 +31,7 @@
 #include "../fieldformat.h"
 #include "../core/filehandler.h"
 #include "../images/imagefactory.h"
+#include "../core/fetchtransport.h"
 #include "../tellico_debug.h"
 
 #include <KLocalizedString>
@@ -88,7 +89,7 @@ void BedethequeFetcher::search() {
   if(request().key == Raw) {
     QUrl u(request().value);
     u.setHost(QLatin1String("m.bedetheque.com")); // use mobile site for easier parsing
-    m_job = KIO::storedGet(u, KIO::NoReload, KIO::HideProgressInfo);
+    m_job = FetchTransport::get(u);
     m_job->addMetaData(QLatin1String("referrer"), QString::fromLatin1(BD_BASE_URL));
     KJobWidgets::setWindow(m_job, GUI::Proxy::widget());
     // different slot here
@@ -130,7 +131,7 @@ void BedethequeFetcher::search() {
   u.setQuery(q);
 //  myDebug() << "url: " << u.url();
 
-  m_job = KIO::storedGet(u, KIO::NoReload, KIO::HideProgressInfo);
+  m_job = FetchTransport::get(u);
   m_job->addMetaData(QLatin1String("referrer"), QString::fromLatin1(BD_BASE_URL));
   KJobWidgets::setWindow(m_job, GUI::Proxy::widget());
   connect(m_job, SIGNAL(result(KJob*)), SLOT(slotComplete(KJob*)));
@@ -30,6 +30,7 @@
 #include "../entry.h"
 #include "../core/netaccess.h"
 #include "../core/filehandler.h"
+#include "../core/fetchtransport.h"
 #include "../tellico_debug.h"
 
 #include <KLocalizedString>
@@ -94,7 +95,7 @@ void BibsonomyFetcher::search() {
   q.addQueryItem(QLatin1String("items"), QString::number(BIBSONOMY_MAX_RESULTS));
   u.setQuery(q);
 
-  m_job = KIO::storedGet(u, KIO::NoReload, KIO::HideProgressInfo);
+  m_job = FetchTransport::get(u);
   KJobWidgets::setWindow(m_job, GUI::Proxy::widget());
   connect(m_job, SIGNAL(result(KJob*)),
           SLOT(slotComplete(KJob*)));
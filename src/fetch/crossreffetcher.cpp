@@ -24,7 +24,7 @@
 
 #include "crossreffetcher.h"
 #include "../translators/xslthandler.h"
-#include "../translators/tellicoimporter.h"
+#include "../translators/tellicoxmlhandler.h"
 #include "../utils/guiproxy.h"
 #include "../utils/string_utils.h"
 #include "../collection.h"
@@ -33,6 +33,7 @@
 #include "../images/imagefactory.h"
 #include "../utils/wallet.h"
 #include "../utils/datafileregistry.h"
+#include "../core/fetchtransport.h"
 #include "../tellico_debug.h"
 
 #include <KLocalizedString>
@@ -102,7 +103,7 @@ void CrossRefFetcher::search() {
     return;
   }
 
-  m_job = KIO::storedGet(u, KIO::NoReload, KIO::HideProgressInfo);
+  m_job = FetchTransport::get(u);
   KJobWidgets::setWindow(m_job, GUI::Proxy::widget());
   connect(m_job, SIGNAL(result(KJob*)),
           SLOT(slotComplete(KJob*)));
@@ -159,9 +160,8 @@ void CrossRefFetcher::slotComplete(KJob*) {
   }
 
   // assume result is always utf-8
-  QString str = m_xsltHandler->applyStylesheet(QString::fromUtf8(data.constData(), data.size()));
-  Import::TellicoImporter imp(str);
-  Data::CollPtr coll = imp.collection();
+  Data::CollPtr coll = Import::TellicoXMLHandler::transformCollection(m_xsltHandler,
+                                                                      QString::fromUtf8(data.constData(), data.size()));
 
   if(!coll) {
     myDebug() << "no valid result";
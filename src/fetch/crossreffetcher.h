@@ -35,11 +35,9 @@ class QUrl;
 class QLineEdit;
 
 class KJob;
-namespace KIO {
-  class StoredTransferJob;
-}
 
 namespace Tellico {
+  class FetchTransferJob;
 
   class XSLTHandler;
 
@@ -101,7 +99,7 @@ private:
   QString m_email;
 
   QHash<int, Data::EntryPtr> m_entries;
-  QPointer<KIO::StoredTransferJob> m_job;
+  QPointer<FetchTransferJob> m_job;
 
   bool m_started;
 };
@@ -30,6 +30,7 @@
 #include "../utils/guiproxy.h"
 #include "../utils/string_utils.h"
 #include "../core/filehandler.h"
+#include "../core/fetchtransport.h"
 #include "../tellico_debug.h"
 
 #include <KLocalizedString>
@@ -130,7 +131,7 @@ void DiscogsFetcher::search() {
 
 //  myDebug() << "url: " << u.url();
 
-  m_job = KIO::storedGet(u, KIO::NoReload, KIO::HideProgressInfo);
+  m_job = FetchTransport::get(u);
   m_job->addMetaData(QLatin1String("UserAgent"), QString::fromLatin1("Tellico/%1")
                                                                 .arg(QLatin1String(TELLICO_VERSION)));
   KJobWidgets::setWindow(m_job, GUI::Proxy::widget());
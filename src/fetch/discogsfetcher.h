@@ -34,11 +34,9 @@
 class QLineEdit;
 
 class KJob;
-namespace KIO {
-  class StoredTransferJob;
-}
 
 namespace Tellico {
+  class FetchTransferJob;
 
   namespace Fetch {
 
@@ -102,7 +100,7 @@ private:
   QString m_apiKey;
 
   QHash<int, Data::EntryPtr> m_entries;
-  QPointer<KIO::StoredTransferJob> m_job;
+  QPointer<FetchTransferJob> m_job;
 };
 
   } // end namespace
@@ -31,6 +31,7 @@
 #include "../utils/guiproxy.h"
 #include "../utils/isbnvalidator.h"
 #include "../utils/string_utils.h"
+#include "../core/fetchtransport.h"
 #include "../tellico_debug.h"
 
 #include <KLocalizedString>
@@ -38,7 +39,6 @@
 #include <KJob>
 #include <KJobUiDelegate>
 #include <KJobWidgets/KJobWidgets>
-#include <KIO/StoredTransferJob>
 
 #include <QLabel>
 #include <QFile>
@@ -134,7 +134,7 @@ void DoubanFetcher::search() {
   u.setQuery(q);
 //  myDebug() << "url:" << u.url();
 
-  m_job = KIO::storedGet(u, KIO::NoReload, KIO::HideProgressInfo);
+  m_job = FetchTransport::get(u);
   KJobWidgets::setWindow(m_job, GUI::Proxy::widget());
   if(request().key == ISBN) {
     connect(m_job, SIGNAL(result(KJob*)), SLOT(slotCompleteISBN(KJob*)));
@@ -156,7 +156,7 @@ void DoubanFetcher::stop() {
 }
 
 void DoubanFetcher::slotCompleteISBN(KJob* job_) {
-  KIO::StoredTransferJob* job = static_cast<KIO::StoredTransferJob*>(job_);
+  FetchTransferJob* job = static_cast<FetchTransferJob*>(job_);
 
   if(job->error()) {
     job->uiDelegate()->showErrorMessage();
@@ -192,7 +192,7 @@ void DoubanFetcher::slotCompleteISBN(KJob* job_) {
 }
 
 void DoubanFetcher::slotComplete(KJob* job_) {
-  KIO::StoredTransferJob* job = static_cast<KIO::StoredTransferJob*>(job_);
+  FetchTransferJob* job = static_cast<FetchTransferJob*>(job_);
 
   if(job->error()) {
     job->uiDelegate()->showErrorMessage();
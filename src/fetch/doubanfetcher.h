@@ -33,11 +33,9 @@
 #include <QVariantMap>
 
 class KJob;
-namespace KIO {
-  class StoredTransferJob;
-}
 
 namespace Tellico {
+  class FetchTransferJob;
   namespace Fetch {
 
 /**
@@ -99,7 +97,7 @@ private:
 
   QHash<int, QUrl> m_matches;
   QHash<int, Data::EntryPtr> m_entries;
-  QPointer<KIO::StoredTransferJob> m_job;
+  QPointer<FetchTransferJob> m_job;
 };
 
   } // end namespace
@@ -29,8 +29,9 @@
 #include "../fieldformat.h"
 #include "../core/filehandler.h"
 #include "../translators/xslthandler.h"
-#include "../translators/tellicoimporter.h"
+#include "../translators/tellicoxmlhandler.h"
 #include "../utils/datafileregistry.h"
+#include "../core/fetchtransport.h"
 #include "../tellico_debug.h"
 
 #include <KLocalizedString>
@@ -137,7 +138,7 @@ void EntrezFetcher::search() {
 
   m_step = Search;
 //  myLog() << "search url: " << u.url();
-  m_job = KIO::storedGet(u, KIO::NoReload, KIO::HideProgressInfo);
+  m_job = FetchTransport::get(u);
   KJobWidgets::setWindow(m_job, GUI::Proxy::widget());
   connect(m_job, SIGNAL(result(KJob*)),
           SLOT(slotComplete(KJob*)));
@@ -256,7 +257,7 @@ void EntrezFetcher::doSummary() {
 
   m_step = Summary;
 //  myLog() << "summary url:" << u.url();
-  m_job = KIO::storedGet(u, KIO::NoReload, KIO::HideProgressInfo);
+  m_job = FetchTransport::get(u);
   KJobWidgets::setWindow(m_job, GUI::Proxy::widget());
   connect(m_job, SIGNAL(result(KJob*)),
           SLOT(slotComplete(KJob*)));
@@ -359,9 +360,7 @@ Tellico::Data::EntryPtr EntrezFetcher::fetchEntryHook(uint uid_) {
   }
   f1.close();
 #endif
-  QString str = m_xsltHandler->applyStylesheet(xmlOutput);
-  Import::TellicoImporter imp(str);
-  Data::CollPtr coll = imp.collection();
+  Data::CollPtr coll = Import::TellicoXMLHandler::transformCollection(m_xsltHandler, xmlOutput);
   if(!coll) {
     myWarning() << "invalid collection";
     return Data::EntryPtr();
@@ -31,11 +31,9 @@
 #include <QPointer>
 
 class KJob;
-namespace KIO {
-  class StoredTransferJob;
-}
 
 namespace Tellico {
+  class FetchTransferJob;
 
   class XSLTHandler;
 
@@ -102,7 +100,7 @@ private:
 
   QHash<int, Data::EntryPtr> m_entries; // map from search result id to entry
   QHash<int, int> m_matches; // search result id to pubmed id
-  QPointer<KIO::StoredTransferJob> m_job;
+  QPointer<FetchTransferJob> m_job;
 
   QString m_queryKey;
   QString m_webEnv;
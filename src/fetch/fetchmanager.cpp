@@ -30,6 +30,7 @@
 #include "../entry.h"
 #include "../collection.h"
 #include "../document.h"
+#include "../entrycomparison.h"
 #include "../utils/string_utils.h"
 #include "../utils/tellico_utils.h"
 #include "../tellico_debug.h"
@@ -48,15 +49,23 @@
 #include <QFileInfo>
 #include <QDir>
 #include <QTemporaryFile>
+#include <QTimer>
 
 #define LOAD_ICON(name, group, size) \
   KIconLoader::global()->loadIcon(name, static_cast<KIconLoader::Group>(group), size_)
 
+namespace {
+  // time allowed for each source when searching all sources at once, in milliseconds
+  static const int FETCH_SEARCH_ALL_TIMEOUT = 30000;
+}
+
 using Tellico::Fetch::Manager;
 Manager* Manager::s_self = nullptr;
 
-Manager::Manager() : QObject(), m_currentFetcherIndex(-1), m_messager(new ManagerMessage()),
-                     m_count(0), m_loadDefaults(false) {
+Manager::Manager() : QObject(), m_searchTimer(new QTimer(this)), m_messager(new ManagerMessage()),
+                     m_loadDefaults(false), m_searchAll(false) {
+  m_searchTimer->setSingleShot(true);
+  connect(m_searchTimer, SIGNAL(timeout()), SLOT(slotSearchTimeout()));
   // must create static pointer first
   Q_ASSERT(!s_self);
   s_self = this;
@@ -155,6 +164,9 @@ Tellico::Fetch::KeyMap Manager::keyMap(const QString& source_) const {
 }
 
 void Manager::startSearch(const QString& source_, Tellico::Fetch::FetchKey key_, const QString& value_) {
+  m_currentFetchers.clear();
+  m_resultEntries.clear();
+  m_searchAll = false;
   if(value_.isEmpty()) {
     emit signalDone();
     return;
@@ -163,76 +175,164 @@ void Manager::startSearch(const QString& source_, Tellico::Fetch::FetchKey key_,
   FetchRequest request(Data::Document::self()->collection()->type(), key_, value_);
 
   // assume there's only one fetcher match
-  int i = 0;
-  m_currentFetcherIndex = -1;
   foreach(Fetcher::Ptr fetcher, m_fetchers) {
     if(source_ == fetcher->source()) {
-      ++m_count; // Fetcher::search() might emit done(), so increment before calling search()
-      connect(fetcher.data(), SIGNAL(signalResultFound(Tellico::Fetch::FetchResult*)),
-              SIGNAL(signalResultFound(Tellico::Fetch::FetchResult*)));
-      connect(fetcher.data(), SIGNAL(signalDone(Tellico::Fetch::Fetcher*)),
-              SLOT(slotFetcherDone(Tellico::Fetch::Fetcher*)));
-      fetcher->startSearch(request);
-      m_currentFetcherIndex = i;
+      m_currentFetchers.append(fetcher);
+      searchFetcher(fetcher, request);
       break;
     }
-    ++i;
+  }
+}
+
+void Manager::startSearchAll(Tellico::Fetch::FetchKey key_, const QString& value_) {
+  m_currentFetchers.clear();
+  m_resultEntries.clear();
+  m_searchAll = true;
+  if(value_.isEmpty()) {
+    emit signalDone();
+    return;
+  }
+
+  const int collType = Data::Document::self()->collection()->type();
+  FetchRequest request(collType, key_, value_);
+
+  foreach(Fetcher::Ptr fetcher, m_fetchers) {
+    if(fetcher->canFetch(collType) && fetcher->canSearch(key_)) {
+      m_currentFetchers.append(fetcher);
+      // add them all first, in case any search finishes immediately
+      m_activeFetchers.insert(fetcher.data());
+    }
+  }
+  if(m_currentFetchers.isEmpty()) {
+    emit signalDone();
+    return;
+  }
+
+  m_searchTimer->start(FETCH_SEARCH_ALL_TIMEOUT);
+  foreach(Fetcher::Ptr fetcher, m_currentFetchers) {
+    searchFetcher(fetcher, request);
   }
 }
 
 void Manager::continueSearch() {
-  if(m_currentFetcherIndex < 0 || m_currentFetcherIndex >= static_cast<int>(m_fetchers.count())) {
+  FetcherVec fetchers;
+  foreach(Fetcher::Ptr fetcher, m_currentFetchers) {
+    if(fetcher && fetcher->hasMoreResults()) {
+      fetchers.append(fetcher);
+      m_activeFetchers.insert(fetcher.data());
+    }
+  }
+  if(fetchers.isEmpty()) {
     myDebug() << "can't continue!";
     emit signalDone();
     return;
   }
-  Fetcher::Ptr fetcher = m_fetchers[m_currentFetcherIndex];
-  if(fetcher && fetcher->hasMoreResults()) {
-    ++m_count;
-    connect(fetcher.data(), SIGNAL(signalResultFound(Tellico::Fetch::FetchResult*)),
-            SIGNAL(signalResultFound(Tellico::Fetch::FetchResult*)));
-    connect(fetcher.data(), SIGNAL(signalDone(Tellico::Fetch::Fetcher*)),
-            SLOT(slotFetcherDone(Tellico::Fetch::Fetcher*)));
-    fetcher->continueSearch();
-  } else {
-    emit signalDone();
+
+  if(m_searchAll) {
+    m_searchTimer->start(FETCH_SEARCH_ALL_TIMEOUT);
+  }
+  foreach(Fetcher::Ptr fetcher, fetchers) {
+    continueFetcher(fetcher);
   }
 }
 
 bool Manager::hasMoreResults() const {
-  if(m_currentFetcherIndex < 0 || m_currentFetcherIndex >= static_cast<int>(m_fetchers.count())) {
-    return false;
+  foreach(Fetcher::Ptr fetcher, m_currentFetchers) {
+    if(fetcher && fetcher->hasMoreResults()) {
+      return true;
+    }
   }
-  Fetcher::Ptr fetcher = m_fetchers[m_currentFetcherIndex];
-  return fetcher && fetcher->hasMoreResults();
+  return false;
 }
 
 void Manager::stop() {
 //  DEBUG_LINE;
+  m_searchTimer->stop();
   foreach(Fetcher::Ptr fetcher, m_fetchers) {
     if(fetcher->isSearching()) {
       fetcher->stop();
       fetcher->saveConfig();
     }
   }
-#ifndef NDEBUG
-  if(m_count != 0) {
-    myDebug() << "count should be 0!";
+  // any fetcher which did not signal when stopped gets disconnected now
+  foreach(Fetcher* fetcher, m_activeFetchers) {
+    fetcher->disconnect(this);
   }
-#endif
-  m_count = 0;
+  m_activeFetchers.clear();
+}
+
+void Manager::searchFetcher(Fetcher::Ptr fetcher_, const FetchRequest& request_) {
+  // Fetcher::search() might emit done(), so track it before calling search()
+  m_activeFetchers.insert(fetcher_.data());
+  connectFetcher(fetcher_);
+  fetcher_->startSearch(request_);
+}
+
+void Manager::continueFetcher(Fetcher::Ptr fetcher_) {
+  m_activeFetchers.insert(fetcher_.data());
+  connectFetcher(fetcher_);
+  fetcher_->continueSearch();
+}
+
+void Manager::connectFetcher(Fetcher::Ptr fetcher_) {
+  connect(fetcher_.data(), SIGNAL(signalResultFound(Tellico::Fetch::FetchResult*)),
+          SLOT(slotResultFound(Tellico::Fetch::FetchResult*)), Qt::UniqueConnection);
+  connect(fetcher_.data(), SIGNAL(signalDone(Tellico::Fetch::Fetcher*)),
+          SLOT(slotFetcherDone(Tellico::Fetch::Fetcher*)), Qt::UniqueConnection);
+}
+
+void Manager::slotResultFound(Tellico::Fetch::FetchResult* result_) {
+  if(!m_searchAll || !result_->entry) {
+    emit signalResultFound(result_);
+    return;
+  }
+
+  Data::EntryPtr entry = result_->entry;
+  Data::CollPtr coll = entry->collection();
+  // only remove duplicates found by other sources, each source knows best about its own results
+  typedef QPair<Fetcher*, Data::EntryPtr> FetcherEntry;
+  foreach(const FetcherEntry& other, m_resultEntries) {
+    if(other.first != result_->fetcher.data() &&
+       coll->sameEntry(entry, other.second) >= EntryComparison::ENTRY_PERFECT_MATCH) {
+//      myDebug() << "duplicate result from" << result_->fetcher->source() << ":" << result_->title;
+      delete result_;
+      return;
+    }
+  }
+  m_resultEntries.append(qMakePair(result_->fetcher.data(), entry));
+  emit signalResultFound(result_);
 }
 
 void Manager::slotFetcherDone(Tellico::Fetch::Fetcher* fetcher_) {
-//  myDebug() << (fetcher_ ? fetcher_->source() : QString()) << ":" << m_count;
+//  myDebug() << (fetcher_ ? fetcher_->source() : QString()) << ":" << m_activeFetchers.count();
   fetcher_->disconnect(); // disconnect all signals
   fetcher_->saveConfig();
-  --m_count;
-  if(m_count <= 0) {
+  // a fetcher stopped after the search finished might still signal
+  if(!m_activeFetchers.remove(fetcher_)) {
+    return;
+  }
+  if(m_activeFetchers.isEmpty()) {
+    m_searchTimer->stop();
     emit signalDone();
   }
 }
 
+void Manager::slotSearchTimeout() {
+  if(m_activeFetchers.isEmpty()) {
+    return;
+  }
+  // copy the set since stopping a fetcher should end up calling slotFetcherDone()
+  foreach(Fetcher* fetcher, m_activeFetchers.values()) {
+    myDebug() << "search timed out for" << fetcher->source();
+    if(fetcher->isSearching()) {
+      fetcher->stop();
+    }
+    if(m_activeFetchers.contains(fetcher)) {
+      slotFetcherDone(fetcher);
+    }
+  }
+}
+
 bool Manager::canFetch() const {
   foreach(Fetcher::Ptr fetcher, m_fetchers) {
     if(fetcher->canFetch(Data::Document::self()->collection()->type())) {
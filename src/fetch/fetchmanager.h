@@ -33,9 +33,12 @@
 #include <QObject>
 #include <QMap>
 #include <QList>
+#include <QSet>
+#include <QPair>
 #include <QPixmap>
 
 class QUrl;
+class QTimer;
 
 namespace Tellico {
   namespace Fetch {
@@ -81,6 +84,12 @@ public:
 
   KeyMap keyMap(const QString& source = QString()) const;
   void startSearch(const QString& source, FetchKey key, const QString& value);
+  /**
+   * Searches every source for the current collection type which supports the key, all at once.
+   * Results are reported as they arrive, duplicates from different sources are dropped,
+   * and any source still searching when the deadline passes is stopped.
+   */
+  void startSearchAll(FetchKey key, const QString& value);
   void continueSearch();
   void stop();
   bool canFetch() const;
@@ -115,6 +124,8 @@ Q_SIGNALS:
 
 private Q_SLOTS:
   void slotFetcherDone(Tellico::Fetch::Fetcher* fetcher);
+  void slotResultFound(Tellico::Fetch::FetchResult* result);
+  void slotSearchTimeout();
 
 private:
   friend class ManagerMessage;
@@ -125,6 +136,9 @@ private:
   Fetcher::Ptr createFetcher(KSharedConfigPtr config, const QString& configGroup);
   FetcherVec defaultFetchers();
   void updateStatus(const QString& message);
+  void searchFetcher(Fetcher::Ptr fetcher, const FetchRequest& request);
+  void continueFetcher(Fetcher::Ptr fetcher);
+  void connectFetcher(Fetcher::Ptr fetcher);
 
   static bool bundledScriptHasExecPath(const QString& specFile, KConfigGroup& config);
 
@@ -132,14 +146,20 @@ private:
   FunctionRegistry functionRegistry;
 
   FetcherVec m_fetchers;
-  int m_currentFetcherIndex;
+  // the fetchers used in the most recent search, for continuing it
+  FetcherVec m_currentFetchers;
+  // the fetchers which have not yet signaled they are done
+  QSet<Fetcher*> m_activeFetchers;
+  // entries from results of the current search, used to remove duplicates between sources
+  QList<QPair<Fetcher*, Data::EntryPtr> > m_resultEntries;
+  QTimer* m_searchTimer;
   KeyMap m_keyMap;
   QHash<QString, Fetcher::Ptr> m_uuidHash;
 
   StringMap m_scriptMap;
   ManagerMessage* m_messager;
-  uint m_count;
   bool m_loadDefaults : 1;
+  bool m_searchAll : 1;
 };
 
   } // end namespace
@@ -47,6 +47,8 @@ public:
   QString title;
   QString desc;
   QString isbn;
+  // the preliminary entry from the search, if the result was created from one
+  Data::EntryPtr entry;
 
 private:
   static QString makeDescription(Data::EntryPtr entry);
@@ -29,6 +29,7 @@
 #include "../utils/string_utils.h"
 #include "../entry.h"
 #include "../core/filehandler.h"
+#include "../core/fetchtransport.h"
 #include "../tellico_debug.h"
 
 #include <KLocalizedString>
@@ -103,7 +104,7 @@ void FilmasterFetcher::search() {
 
 //  myDebug() << "url:" << u;
 
-  QPointer<KIO::StoredTransferJob> job = KIO::storedGet(u, KIO::NoReload, KIO::HideProgressInfo);
+  QPointer<FetchTransferJob> job = FetchTransport::get(u);
   KJobWidgets::setWindow(job, GUI::Proxy::widget());
   connect(job, SIGNAL(result(KJob*)), SLOT(slotComplete(KJob*)));
 }
@@ -156,7 +157,7 @@ Tellico::Fetch::FetchRequest FilmasterFetcher::updateRequest(Data::EntryPtr entr
 }
 
 void FilmasterFetcher::slotComplete(KJob* job_) {
-  KIO::StoredTransferJob* job = static_cast<KIO::StoredTransferJob*>(job_);
+  FetchTransferJob* job = static_cast<FetchTransferJob*>(job_);
 //  myDebug();
 
   if(job->error()) {
@@ -33,11 +33,9 @@
 #include <QVariantMap>
 
 class KJob;
-namespace KIO {
-  class StoredTransferJob;
-}
 
 namespace Tellico {
+  class FetchTransferJob;
   namespace Fetch {
 
 /**
@@ -92,7 +90,7 @@ private:
 
   void populateEntry(Data::EntryPtr entry, const QVariantMap& result);
 
-  QPointer<KIO::StoredTransferJob> m_job;
+  QPointer<FetchTransferJob> m_job;
   QHash<int, Data::EntryPtr> m_entries;
 
   bool m_started;
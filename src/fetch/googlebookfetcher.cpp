@@ -30,6 +30,7 @@
 #include "../utils/guiproxy.h"
 #include "../utils/string_utils.h"
 #include "../core/filehandler.h"
+#include "../core/fetchtransport.h"
 #include "../tellico_debug.h"
 
 #include <KLocalizedString>
@@ -146,13 +147,13 @@ void GoogleBookFetcher::doSearch(const QString& term_) {
   u.setQuery(q);
 //  myDebug() << "url:" << u;
 
-  QPointer<KIO::StoredTransferJob> job = KIO::storedGet(u, KIO::NoReload, KIO::HideProgressInfo);
+  QPointer<FetchTransferJob> job = FetchTransport::get(u);
   KJobWidgets::setWindow(job, GUI::Proxy::widget());
   connect(job, SIGNAL(result(KJob*)), SLOT(slotComplete(KJob*)));
   m_jobs << job;
 }
 
-void GoogleBookFetcher::endJob(KIO::StoredTransferJob* job_) {
+void GoogleBookFetcher::endJob(FetchTransferJob* job_) {
   m_jobs.removeOne(job_);
   if(m_jobs.isEmpty())  {
     stop();
@@ -163,7 +164,7 @@ void GoogleBookFetcher::stop() {
   if(!m_started) {
     return;
   }
-  foreach(QPointer<KIO::StoredTransferJob> job, m_jobs) {
+  foreach(QPointer<FetchTransferJob> job, m_jobs) {
     if(job) {
       job->kill();
     }
@@ -219,7 +220,7 @@ Tellico::Fetch::FetchRequest GoogleBookFetcher::updateRequest(Data::EntryPtr ent
 }
 
 void GoogleBookFetcher::slotComplete(KJob* job_) {
-  KIO::StoredTransferJob* job = static_cast<KIO::StoredTransferJob*>(job_);
+  FetchTransferJob* job = static_cast<FetchTransferJob*>(job_);
 //  myDebug();
 
   if(job->error()) {
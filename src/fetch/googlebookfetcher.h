@@ -33,13 +33,11 @@
 #include <QVariantMap>
 
 class KJob;
-namespace KIO {
-  class StoredTransferJob;
-}
 
 class QLineEdit;
 
 namespace Tellico {
+  class FetchTransferJob;
 
   namespace Fetch {
 
@@ -97,11 +95,11 @@ private:
   virtual void search() Q_DECL_OVERRIDE;
   virtual FetchRequest updateRequest(Data::EntryPtr entry) Q_DECL_OVERRIDE;
   void doSearch(const QString& term);
-  void endJob(KIO::StoredTransferJob* job);
+  void endJob(FetchTransferJob* job);
   void populateEntry(Data::EntryPtr entry, const QVariantMap& resultMap);
 
   QHash<int, Data::EntryPtr> m_entries;
-  QList< QPointer<KIO::StoredTransferJob> > m_jobs;
+  QList< QPointer<FetchTransferJob> > m_jobs;
 
   bool m_started;
 
@@ -28,6 +28,7 @@
 #include "../collections/bibtexcollection.h"
 #include "../entry.h"
 #include "../utils/guiproxy.h"
+#include "../core/fetchtransport.h"
 #include "../tellico_debug.h"
 
 #include <KLocalizedString>
@@ -125,7 +126,7 @@ void GoogleScholarFetcher::doSearch() {
   u.setQuery(q);
 //  myDebug() << "url: " << u.url();
 
-  m_job = KIO::storedGet(u, KIO::NoReload, KIO::HideProgressInfo);
+  m_job = FetchTransport::get(u);
   KJobWidgets::setWindow(m_job, GUI::Proxy::widget());
   connect(m_job, SIGNAL(result(KJob*)),
           SLOT(slotComplete(KJob*)));
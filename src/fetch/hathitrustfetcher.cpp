@@ -30,6 +30,7 @@
 #include "../utils/guiproxy.h"
 #include "../utils/string_utils.h"
 #include "../utils/datafileregistry.h"
+#include "../core/fetchtransport.h"
 #include "../tellico_debug.h"
 
 #include <KLocalizedString>
@@ -101,7 +102,7 @@ void HathiTrustFetcher::doSearch() {
 
 //  myDebug() << u;
 
-  m_job = KIO::storedGet(u, KIO::NoReload, KIO::HideProgressInfo);
+  m_job = FetchTransport::get(u);
   KJobWidgets::setWindow(m_job, GUI::Proxy::widget());
   connect(m_job, SIGNAL(result(KJob*)), SLOT(slotComplete(KJob*)));
 }
@@ -183,7 +184,7 @@ Tellico::Fetch::FetchRequest HathiTrustFetcher::updateRequest(Data::EntryPtr ent
 }
 
 void HathiTrustFetcher::slotComplete(KJob* job_) {
-  KIO::StoredTransferJob* job = static_cast<KIO::StoredTransferJob*>(job_);
+  FetchTransferJob* job = static_cast<FetchTransferJob*>(job_);
 
   if(!initMARC21Handler() || !initMODSHandler()) {
     // debug messages are taken care of in the specific methods
@@ -33,11 +33,9 @@
 #include <QVariantMap>
 
 class KJob;
-namespace KIO {
-  class StoredTransferJob;
-}
 
 namespace Tellico {
+  class FetchTransferJob;
 
   class XSLTHandler;
 
@@ -98,7 +96,7 @@ private:
   bool initMODSHandler();
 
   QHash<int, Data::EntryPtr> m_entries;
-  QPointer<KIO::StoredTransferJob> m_job;
+  QPointer<FetchTransferJob> m_job;
 
   bool m_started;
   XSLTHandler* m_MARC21XMLHandler;
@@ -31,6 +31,7 @@
 #include "../core/filehandler.h"
 #include "../images/imagefactory.h"
 #include "../utils/isbnvalidator.h"
+#include "../core/fetchtransport.h"
 #include "../tellico_debug.h"
 
 #include <KLocalizedString>
@@ -121,7 +122,7 @@ void IBSFetcher::search() {
   u.setQuery(q);
 //  myDebug() << "url: " << u.url();
 
-  m_job = KIO::storedGet(u, KIO::NoReload, KIO::HideProgressInfo);
+  m_job = FetchTransport::get(u);
   KJobWidgets::setWindow(m_job, GUI::Proxy::widget());
   connect(m_job, SIGNAL(result(KJob*)), SLOT(slotComplete(KJob*)));
 }
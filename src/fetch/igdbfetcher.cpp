@@ -28,6 +28,7 @@
 #include "../core/filehandler.h"
 #include "../utils/guiproxy.h"
 #include "../utils/string_utils.h"
+#include "../core/fetchtransport.h"
 #include "../tellico_debug.h"
 
 #include <KLocalizedString>
@@ -35,7 +36,6 @@
 #include <KJob>
 #include <KJobUiDelegate>
 #include <KJobWidgets/KJobWidgets>
-#include <KIO/StoredTransferJob>
 
 #include <QUrl>
 #include <QLabel>
@@ -199,7 +199,7 @@ Tellico::Fetch::FetchRequest IGDBFetcher::updateRequest(Data::EntryPtr entry_) {
 }
 
 void IGDBFetcher::slotComplete(KJob* job_) {
-  KIO::StoredTransferJob* job = static_cast<KIO::StoredTransferJob*>(job_);
+  FetchTransferJob* job = static_cast<FetchTransferJob*>(job_);
 
   if(job->error()) {
     job->uiDelegate()->showErrorMessage();
@@ -346,7 +346,7 @@ QString IGDBFetcher::companyName(const QString& companyId_) const {
 
   u.setQuery(q);
 
-  QPointer<KIO::StoredTransferJob> job = igdbJob(u, m_apiKey);
+  QPointer<FetchTransferJob> job = igdbJob(u, m_apiKey);
   if(!job->exec()) {
     myDebug() << job->errorString() << u;
     return QString();
@@ -621,8 +621,8 @@ QString IGDBFetcher::ConfigWidget::preferredName() const {
   return IGDBFetcher::defaultName();
 }
 
-QPointer<KIO::StoredTransferJob> IGDBFetcher::igdbJob(const QUrl& url_, const QString& apiKey_) {
-  QPointer<KIO::StoredTransferJob> job = KIO::storedGet(url_, KIO::NoReload, KIO::HideProgressInfo);
+QPointer<Tellico::FetchTransferJob> IGDBFetcher::igdbJob(const QUrl& url_, const QString& apiKey_) {
+  QPointer<FetchTransferJob> job = FetchTransport::get(url_);
   job->addMetaData(QLatin1String("customHTTPHeader"), QLatin1String("X-Mashape-Key: ") + apiKey_);
   job->addMetaData(QLatin1String("accept"), QLatin1String("application/json"));
   KJobWidgets::setWindow(job, GUI::Proxy::widget());
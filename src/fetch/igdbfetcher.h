@@ -34,11 +34,9 @@
 #include <QDate>
 
 class KJob;
-namespace KIO {
-  class StoredTransferJob;
-}
 
 namespace Tellico {
+  class FetchTransferJob;
   namespace Fetch {
 
 /**
@@ -92,13 +90,13 @@ private:
   void populateHashes();
   QString companyName(const QString& companyId) const;
 
-  static QPointer<KIO::StoredTransferJob> igdbJob(const QUrl& url, const QString& apiKey);
+  static QPointer<FetchTransferJob> igdbJob(const QUrl& url, const QString& apiKey);
 
   bool m_started;
 
   QString m_apiKey;
   QHash<int, Data::EntryPtr> m_entries;
-  QPointer<KIO::StoredTransferJob> m_job;
+  QPointer<FetchTransferJob> m_job;
 
   QHash<int, QString> m_genreHash;
   QHash<int, QString> m_platformHash;
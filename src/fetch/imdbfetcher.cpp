@@ -31,6 +31,7 @@
 #include "../core/filehandler.h"
 #include "../images/imagefactory.h"
 #include "../utils/string_utils.h"
+#include "../core/fetchtransport.h"
 #include "../tellico_debug.h"
 
 #include <KLocalizedString>
@@ -343,12 +344,12 @@ void IMDBFetcher::search() {
 
 //  myDebug() << m_url;
 
-  m_job = KIO::storedGet(m_url, KIO::NoReload, KIO::HideProgressInfo);
+  m_job = FetchTransport::get(m_url);
   KJobWidgets::setWindow(m_job, GUI::Proxy::widget());
   connect(m_job, SIGNAL(result(KJob*)),
           SLOT(slotComplete(KJob*)));
-  connect(m_job, SIGNAL(redirection(KIO::Job*, const QUrl&)),
-          SLOT(slotRedirection(KIO::Job*, const QUrl&)));
+  connect(m_job, SIGNAL(redirection(KJob*, const QUrl&)),
+          SLOT(slotRedirection(KJob*, const QUrl&)));
 }
 
 void IMDBFetcher::continueSearch() {
@@ -396,7 +397,7 @@ void IMDBFetcher::stop() {
   emit signalDone(this);
 }
 
-void IMDBFetcher::slotRedirection(KIO::Job*, const QUrl& toURL_) {
+void IMDBFetcher::slotRedirection(KJob*, const QUrl& toURL_) {
   m_url = toURL_;
   if(m_url.path().contains(QRegExp(QLatin1String("/tt\\d+/$"))))  {
     m_url.setPath(m_url.path() + QLatin1String("combined"));
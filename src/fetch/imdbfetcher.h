@@ -34,15 +34,12 @@
 class QSpinBox;
 
 class KJob;
-namespace KIO {
-  class Job;
-  class StoredTransferJob;
-}
 
 class QCheckBox;
 class QRegExpr;
 
 namespace Tellico {
+  class FetchTransferJob;
   namespace GUI {
     class ComboBox;
   }
@@ -121,7 +118,7 @@ public:
 
 private Q_SLOTS:
   void slotComplete(KJob* job);
-  void slotRedirection(KIO::Job* job, const QUrl& toURL);
+  void slotRedirection(KJob* job, const QUrl& toURL);
 
 private:
   virtual void search() Q_DECL_OVERRIDE;
@@ -158,7 +155,7 @@ private:
   // if a new search is started, m_matches is cleared
   // but we might still need to recover an entry by uid
   QHash<int, QUrl> m_allMatches;
-  QPointer<KIO::StoredTransferJob> m_job;
+  QPointer<FetchTransferJob> m_job;
 
   bool m_started;
   bool m_fetchImages;
@@ -30,6 +30,7 @@
 #include "../collection.h"
 #include "../entry.h"
 #include "../utils/datafileregistry.h"
+#include "../core/fetchtransport.h"
 #include "../tellico_debug.h"
 
 #include <KLocalizedString>
@@ -147,7 +148,7 @@ void ISBNdbFetcher::doSearch() {
 
   //  myDebug() << "url: " << u.url();
 
-  m_job = KIO::storedGet(u, KIO::NoReload, KIO::HideProgressInfo);
+  m_job = FetchTransport::get(u);
   KJobWidgets::setWindow(m_job, GUI::Proxy::widget());
   connect(m_job, SIGNAL(result(KJob*)),
           SLOT(slotComplete(KJob*)));
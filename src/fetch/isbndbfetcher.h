@@ -33,11 +33,9 @@
 class QLineEdit;
 
 class KJob;
-namespace KIO {
-  class StoredTransferJob;
-}
 
 namespace Tellico {
+  class FetchTransferJob;
   class XSLTHandler;
   namespace Fetch {
 
@@ -95,7 +93,7 @@ private:
   int m_countOffset;
 
   QHash<int, Data::EntryPtr> m_entries;
-  QPointer<KIO::StoredTransferJob> m_job;
+  QPointer<FetchTransferJob> m_job;
 
   bool m_started;
   QString m_apiKey;
@@ -32,11 +32,9 @@
 
 class QUrl;
 class KJob;
-namespace KIO {
-  class StoredTransferJob;
-}
 
 namespace Tellico {
+  class FetchTransferJob;
   namespace Fetch {
 
 /**
@@ -80,7 +78,7 @@ private:
 
   QHash<int, Data::EntryPtr> m_entries;
   QHash<int, QUrl> m_matches;
-  QPointer<KIO::StoredTransferJob> m_job;
+  QPointer<FetchTransferJob> m_job;
 
   bool m_started;
 };
@@ -27,6 +27,7 @@
 #include "../collections/bibtexcollection.h"
 #include "../utils/guiproxy.h"
 #include "../utils/string_utils.h"
+#include "../core/fetchtransport.h"
 #include "../tellico_debug.h"
 
 #include <KLocalizedString>
@@ -95,7 +96,7 @@ void MRLookupFetcher::search() {
   u.setQuery(q);
 
 //  myDebug() << u;
-  m_job = KIO::storedGet(u, KIO::NoReload, KIO::HideProgressInfo);
+  m_job = FetchTransport::get(u);
   KJobWidgets::setWindow(m_job, GUI::Proxy::widget());
   connect(m_job, SIGNAL(result(KJob*)), SLOT(slotComplete(KJob*)));
 }
@@ -125,7 +126,7 @@ Tellico::Fetch::FetchRequest MRLookupFetcher::updateRequest(Data::EntryPtr entry
 }
 
 void MRLookupFetcher::slotComplete(KJob* job_) {
-  KIO::StoredTransferJob* job = static_cast<KIO::StoredTransferJob*>(job_);
+  FetchTransferJob* job = static_cast<FetchTransferJob*>(job_);
 
   if(job->error()) {
     job->uiDelegate()->showErrorMessage();
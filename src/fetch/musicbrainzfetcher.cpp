@@ -31,6 +31,7 @@
 #include "../collection.h"
 #include "../entry.h"
 #include "../utils/datafileregistry.h"
+#include "../core/fetchtransport.h"
 #include "../tellico_debug.h"
 
 #include <KLocalizedString>
@@ -133,7 +134,7 @@ void MusicBrainzFetcher::doSearch() {
 //  myDebug() << "url: " << u.url();
 
   m_requestTime.start();
-  m_job = KIO::storedGet(u, KIO::NoReload, KIO::HideProgressInfo);
+  m_job = FetchTransport::get(u);
   KJobWidgets::setWindow(m_job, GUI::Proxy::widget());
   connect(m_job, SIGNAL(result(KJob*)),
           SLOT(slotComplete(KJob*)));
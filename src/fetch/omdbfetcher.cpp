@@ -28,6 +28,7 @@
 #include "../utils/guiproxy.h"
 #include "../core/filehandler.h"
 #include "../utils/string_utils.h"
+#include "../core/fetchtransport.h"
 #include "../tellico_debug.h"
 
 #include <KLocalizedString>
@@ -35,7 +36,6 @@
 #include <KJob>
 #include <KJobUiDelegate>
 #include <KJobWidgets/KJobWidgets>
-#include <KIO/StoredTransferJob>
 
 #include <QUrl>
 #include <QLabel>
@@ -120,7 +120,7 @@ void OMDBFetcher::continueSearch() {
   }
   u.setQuery(q);
 
-  m_job = KIO::storedGet(u, KIO::NoReload, KIO::HideProgressInfo);
+  m_job = FetchTransport::get(u);
   KJobWidgets::setWindow(m_job, GUI::Proxy::widget());
   connect(m_job, SIGNAL(result(KJob*)), SLOT(slotComplete(KJob*)));
 }
@@ -195,7 +195,7 @@ Tellico::Fetch::FetchRequest OMDBFetcher::updateRequest(Data::EntryPtr entry_) {
 }
 
 void OMDBFetcher::slotComplete(KJob* job_) {
-  KIO::StoredTransferJob* job = static_cast<KIO::StoredTransferJob*>(job_);
+  FetchTransferJob* job = static_cast<FetchTransferJob*>(job_);
 
   if(job->error()) {
     job->uiDelegate()->showErrorMessage();
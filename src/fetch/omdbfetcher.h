@@ -35,11 +35,9 @@
 class QLineEdit;
 
 class KJob;
-namespace KIO {
-  class StoredTransferJob;
-}
 
 namespace Tellico {
+  class FetchTransferJob;
 
   namespace GUI {
     class ComboBox;
@@ -107,7 +105,7 @@ private:
   QString m_apiKey;
 
   QHash<int, Data::EntryPtr> m_entries;
-  QPointer<KIO::StoredTransferJob> m_job;
+  QPointer<FetchTransferJob> m_job;
 };
 
   } // end namespace
@@ -30,6 +30,7 @@
 #include "../utils/string_utils.h"
 #include "../entry.h"
 #include "../core/filehandler.h"
+#include "../core/fetchtransport.h"
 #include "../tellico_debug.h"
 
 #include <KLocalizedString>
@@ -142,13 +143,13 @@ void OpenLibraryFetcher::doSearch(const QString& term_) {
   u.setQuery(q);
 //  myDebug() << "url:" << u;
 
-  QPointer<KIO::StoredTransferJob> job = KIO::storedGet(u, KIO::NoReload, KIO::HideProgressInfo);
+  QPointer<FetchTransferJob> job = FetchTransport::get(u);
   KJobWidgets::setWindow(job, GUI::Proxy::widget());
   connect(job, SIGNAL(result(KJob*)), SLOT(slotComplete(KJob*)));
   m_jobs << job;
 }
 
-void OpenLibraryFetcher::endJob(KIO::StoredTransferJob* job_) {
+void OpenLibraryFetcher::endJob(FetchTransferJob* job_) {
   m_jobs.removeAll(job_);
   if(m_jobs.isEmpty())  {
     stop();
@@ -159,7 +160,7 @@ void OpenLibraryFetcher::stop() {
   if(!m_started) {
     return;
   }
-  foreach(QPointer<KIO::StoredTransferJob> job, m_jobs) {
+  foreach(QPointer<FetchTransferJob> job, m_jobs) {
     if(job) {
       job->kill();
     }
@@ -208,7 +209,7 @@ Tellico::Fetch::FetchRequest OpenLibraryFetcher::updateRequest(Data::EntryPtr en
 }
 
 void OpenLibraryFetcher::slotComplete(KJob* job_) {
-  KIO::StoredTransferJob* job = static_cast<KIO::StoredTransferJob*>(job_);
+  FetchTransferJob* job = static_cast<FetchTransferJob*>(job_);
 //  myDebug();
 
   if(job->error()) {
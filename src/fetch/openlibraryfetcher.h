@@ -33,11 +33,9 @@
 #include <QVariantMap>
 
 class KJob;
-namespace KIO {
-  class StoredTransferJob;
-}
 
 namespace Tellico {
+  class FetchTransferJob;
   namespace Fetch {
 
 /**
@@ -92,10 +90,10 @@ private:
   virtual FetchRequest updateRequest(Data::EntryPtr entry) Q_DECL_OVERRIDE;
   void doSearch(const QString& term);
   QString getAuthorKeys(const QString& term);
-  void endJob(KIO::StoredTransferJob* job);
+  void endJob(FetchTransferJob* job);
 
   QHash<int, Data::EntryPtr> m_entries;
-  QList< QPointer<KIO::StoredTransferJob> > m_jobs;
+  QList< QPointer<FetchTransferJob> > m_jobs;
 
   bool m_started;
 };
@@ -34,11 +34,9 @@ class QSpinBox;
 
 class KComboBox;
 class KJob;
-namespace KIO {
-  class StoredTransferJob;
-}
 
 namespace Tellico {
+  class FetchTransferJob;
   class XSLTHandler;
   namespace GUI {
     class LineEdit;
@@ -107,7 +105,7 @@ private:
   StringMap m_queryMap;
 
   QHash<int, Data::EntryPtr> m_entries;
-  QPointer<KIO::StoredTransferJob> m_job;
+  QPointer<FetchTransferJob> m_job;
   XSLTHandler* m_MARCXMLHandler;
   XSLTHandler* m_MODSHandler;
   XSLTHandler* m_SRWHandler;
@@ -34,11 +34,9 @@
 #include <QDate>
 
 class KJob;
-namespace KIO {
-  class StoredTransferJob;
-}
 
 namespace Tellico {
+  class FetchTransferJob;
 
   namespace GUI {
     class ComboBox;
@@ -105,7 +103,7 @@ private:
   QString m_imageBase;
 
   QHash<int, Data::EntryPtr> m_entries;
-  QPointer<KIO::StoredTransferJob> m_job;
+  QPointer<FetchTransferJob> m_job;
 };
 
 class TheMovieDBFetcher::ConfigWidget : public Fetch::ConfigWidget {
@@ -33,11 +33,9 @@
 class QLineEdit;
 
 class KJob;
-namespace KIO {
-  class StoredTransferJob;
-}
 
 namespace Tellico {
+  class FetchTransferJob;
   class XSLTHandler;
   namespace Fetch {
 
@@ -94,7 +92,7 @@ private:
   int m_offset;
 
   QHash<int, Data::EntryPtr> m_entries;
-  QPointer<KIO::StoredTransferJob> m_job;
+  QPointer<FetchTransferJob> m_job;
 
   bool m_started;
   QString m_apiKey;
@@ -24,11 +24,12 @@
 
 #include "xmlfetcher.h"
 #include "../translators/xslthandler.h"
-#include "../translators/tellicoimporter.h"
+#include "../translators/tellicoxmlhandler.h"
 #include "../utils/guiproxy.h"
 #include "../utils/xmlhandler.h"
 #include "../utils/string_utils.h"
 #include "../utils/datafileregistry.h"
+#include "../core/fetchtransport.h"
 #include "../tellico_debug.h"
 
 #include <KIO/Job>
@@ -72,7 +73,7 @@ void XMLFetcher::doSearch() {
   }
 //  myDebug() << "url: " << u.url();
 
-  m_job = KIO::storedGet(u, KIO::NoReload, KIO::HideProgressInfo);
+  m_job = FetchTransport::get(u);
   KJobWidgets::setWindow(m_job, GUI::Proxy::widget());
   connect(m_job, SIGNAL(result(KJob*)), SLOT(slotComplete(KJob*)));
 }
@@ -128,21 +129,11 @@ void XMLFetcher::slotComplete(KJob* ) {
 
   parseData(data);
 
-  const QString str = m_xsltHandler->applyStylesheet(XMLHandler::readXMLData(data));
-#if 0
-  myWarning() << "Remove debug from xmlfetcher.cpp";
-  QFile f2(QLatin1String("/tmp/test-tellico.xml"));
-  if(f2.open(QIODevice::WriteOnly)) {
-    QTextStream t(&f2);
-    t.setCodec("utf-8");
-    t << str;
-  }
-  f2.close();
-#endif
-  Import::TellicoImporter imp(str);
+  // the result tree is read directly, no need to serialize it to text and parse it again
   // be quiet when loading images
-  imp.setOptions(imp.options() ^ Import::ImportShowImageErrors);
-  Data::CollPtr coll = imp.collection();
+  Data::CollPtr coll = Import::TellicoXMLHandler::transformCollection(m_xsltHandler,
+                                                                      XMLHandler::readXMLData(data),
+                                                                      false /* show image errors */);
   if(!coll) {
     myDebug() << "no collection pointer";
     stop();
@@ -33,12 +33,9 @@
 
 class QUrl;
 class KJob;
-namespace KIO {
-  class StoredTransferJob;
-}
 
 namespace Tellico {
-
+  class FetchTransferJob;
   class XSLTHandler;
 
   namespace Fetch {
@@ -85,7 +82,7 @@ private:
   QString m_xsltFilename;
   XSLTHandler* m_xsltHandler;
 
-  QPointer<KIO::StoredTransferJob> m_job;
+  QPointer<FetchTransferJob> m_job;
   QHash<int, Data::EntryPtr> m_entries;
 
   bool m_started;
@@ -35,8 +35,15 @@
 #include <KConfigGroup>
 
 #include <QFile>
+#include <QVector>
+#include <QElapsedTimer>
 #include <QApplication>
 
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
 #ifdef HAVE_YAZ
 extern "C" {
 #include <yaz/zoom.h>
@@ -49,22 +56,6 @@ namespace {
   static const size_t Z3950_DEFAULT_MAX_RECORDS = 20;
 
 #ifdef HAVE_YAZ
-  class QueryDestroyer {
-  public:
-    QueryDestroyer(ZOOM_query query_) : query(query_) {}
-    ~QueryDestroyer() { if(query) ZOOM_query_destroy(query); }
-  private:
-    ZOOM_query query;
-  };
-
-  class ResultDestroyer {
-  public:
-    ResultDestroyer(ZOOM_resultset result_) : result(result_) {}
-    ~ResultDestroyer() { if(result) ZOOM_resultset_destroy(result); }
-  private:
-    ZOOM_resultset result;
-  };
-
   class YazCloser {
   public:
     YazCloser(yaz_iconv_t iconv_) : iconv(iconv_), marc(nullptr) {}
@@ -80,36 +71,40 @@ namespace {
 #endif
 }
 
-using Tellico::Fetch::Z3950ResultFound;
 using Tellico::Fetch::Z3950Connection;
-
-Z3950ResultFound::Z3950ResultFound(const QString& s) : QEvent(uid())
-    , m_result(s) {
-  ++Z3950Connection::resultsLeft;
-}
-
-Z3950ResultFound::~Z3950ResultFound() {
-  --Z3950Connection::resultsLeft;
-}
+using Tellico::Fetch::Z3950ConnectionLoop;
 
 class Z3950Connection::Private {
 public:
 #ifdef HAVE_YAZ
-  Private() : conn_opt(nullptr), conn(nullptr) {}
+  Private() : conn_opt(nullptr), conn(nullptr), query(nullptr), resultSet(nullptr) {}
   ~Private() {
-    ZOOM_options_destroy(conn_opt);
-    ZOOM_connection_destroy(conn);
+    clearSearch();
+    clearConnection();
   };
 
+  void clearSearch() {
+    if(resultSet) ZOOM_resultset_destroy(resultSet);
+    resultSet = nullptr;
+    if(query) ZOOM_query_destroy(query);
+    query = nullptr;
+  }
+  void clearConnection() {
+    if(conn) ZOOM_connection_destroy(conn);
+    conn = nullptr;
+    if(conn_opt) ZOOM_options_destroy(conn_opt);
+    conn_opt = nullptr;
+  }
+
   ZOOM_options conn_opt;
   ZOOM_connection conn;
+  ZOOM_query query;
+  ZOOM_resultset resultSet;
 #else
   Private() {}
 #endif
 };
 
-int Z3950Connection::resultsLeft = 0;
-
 // since the character set goes into a yaz api call
 // I'm paranoid about user insertions, so just grab 64
 // characters at most
@@ -120,10 +115,11 @@ Z3950Connection::Z3950Connection(Tellico::Fetch::Z3950Fetcher* fetcher,
                                  const QString& sourceCharSet,
                                  const QString& syntax,
                                  const QString& esn)
-    : QThread()
-    , d(new Private())
+    : d(new Private())
     , m_connected(false)
-    , m_aborted(false)
+    , m_connecting(false)
+    , m_aborted(0)
+    , m_state(Idle)
     , m_fetcher(fetcher)
     , m_host(host)
     , m_port(port)
@@ -133,7 +129,9 @@ Z3950Connection::Z3950Connection(Tellico::Fetch::Z3950Fetcher* fetcher,
     , m_esn(esn)
     , m_start(0)
     , m_limit(Z3950_DEFAULT_MAX_RECORDS)
-    , m_hasMore(false) {
+    , m_hasMore(false)
+    , m_detectCharSet(m_sourceCharSet.isEmpty())
+    , m_settingsChanged(false) {
 }
 
 Z3950Connection::~Z3950Connection() {
@@ -156,179 +154,275 @@ void Z3950Connection::setUserPassword(const QString& user_, const QString& pword
   m_password = pword_;
 }
 
-void Z3950Connection::run() {
+void Z3950Connection::start() {
+  m_aborted = 0;
+  Z3950ConnectionLoop::self()->add(this);
+}
+
+void Z3950Connection::wait() {
+  Z3950ConnectionLoop::self()->waitForConnection(this);
+}
+
+void Z3950Connection::abort() {
+  m_aborted = 1;
+  Z3950ConnectionLoop::self()->wake();
+}
+
+bool Z3950Connection::begin() {
 //  myDebug() << m_fetcher->source();
-  m_aborted = false;
   m_hasMore = false;
-  resultsLeft = 0;
+  m_settingsChanged = false;
 #ifdef HAVE_YAZ
-
   if(!makeConnection()) {
-    done();
-    return;
+    return false;
   }
 
-  ZOOM_query query = ZOOM_query_create();
-  QueryDestroyer qd(query);
-
-  int errcode = ZOOM_query_prefix(query, toCString(m_pqn));
+  d->clearSearch();
+  d->query = ZOOM_query_create();
+  int errcode = ZOOM_query_prefix(d->query, toCString(m_pqn).constData());
   if(errcode != 0) {
     myDebug() << "query error: " << m_pqn;
     QString s = i18n("Query error!");
     s += QLatin1Char(' ') + m_pqn;
     done(s, MessageHandler::Error);
-    return;
+    return false;
   }
 
-  ZOOM_resultset resultSet = ZOOM_connection_search(d->conn, query);
-  ResultDestroyer rd(resultSet);
+  // the records are requested along with the search, all at once. If the syntax still needs to
+  // be detected, only the first record is requested, in the server's default syntax
+  ZOOM_connection_option_set(d->conn, "start", QByteArray::number(static_cast<int>(m_start)).constData());
+  if(m_syntax.isEmpty()) {
+    ZOOM_connection_option_set(d->conn, "count", "1");
+    ZOOM_connection_option_set(d->conn, "elementSetName", m_esn.toLatin1().constData());
+    m_probeSyntaxes.clear();
+    m_probeSyntax.clear();
+  } else {
+    ZOOM_connection_option_set(d->conn, "count", QByteArray::number(static_cast<int>(m_limit-m_start)).constData());
+    setRecordSyntax(m_syntax);
+  }
+  d->resultSet = ZOOM_connection_search(d->conn, d->query);
+  m_state = Searching;
+  return true;
+#else
+  done();
+  return false;
+#endif
+}
 
-  // check abort status
+bool Z3950Connection::handleEnd() {
+#ifdef HAVE_YAZ
   if(m_aborted) {
     done();
-    return;
+    return false;
   }
 
-  // I know the LOC wants the syntax = "xml" and esn = "mods"
-  // to get MODS data, that seems a bit odd...
-  // esn only makes sense for marc and grs-1
-  // if syntax is mods, set esn to mods too
-  QByteArray type = "raw";
-  if(m_syntax == QLatin1String("mods")) {
-    m_syntax = QLatin1String("xml");
-    ZOOM_resultset_option_set(resultSet, "elementSetName", "mods");
-    type = "xml";
-  } else {
-    ZOOM_resultset_option_set(resultSet, "elementSetName", m_esn.toLatin1().constData());
+  switch(m_state) {
+    case Searching:
+      if(!checkError()) {
+        return false;
+      }
+      m_connecting = false;
+      if(ZOOM_resultset_size(d->resultSet) == 0) {
+        done();
+        return false;
+      }
+      myLog() << "current syntax is " << m_syntax << " (" << ZOOM_resultset_size(d->resultSet) << " results)";
+      if(m_syntax.isEmpty()) {
+        // the first record was requested in the default syntax
+        m_state = Probing;
+        return handleEnd();
+      }
+      collectRecords();
+      return false;
+
+    case Probing:
+      {
+        if(!checkError()) {
+          return false;
+        }
+        // the first record is already in the cache, if the server returned it
+        ZOOM_record rec = ZOOM_resultset_record_immediate(d->resultSet, 0);
+        int len = 0;
+        const bool isXML = m_probeSyntax == QLatin1String("mods");
+        if(rec) {
+          ZOOM_record_get(rec, isXML ? "xml" : "raw", &len);
+        }
+        QString newSyntax;
+        if(len > 0 && m_probeSyntax.isEmpty()) {
+          newSyntax = QString::fromLatin1(ZOOM_record_get(rec, "syntax", &len)).toLower();
+          myLog() << "syntax guess is " << newSyntax;
+          if(newSyntax == QLatin1String("xml")) {
+            newSyntax = QLatin1String("mods");
+          } else if(newSyntax != QLatin1String("mods") &&
+                    newSyntax != QLatin1String("usmarc") &&
+                    newSyntax != QLatin1String("marc21") &&
+                    newSyntax != QLatin1String("unimarc") &&
+                    newSyntax != QLatin1String("ads")) {
+            // grs-1 is a last resort for us, so try to get a marc record first
+            newSyntax.clear();
+          }
+        } else if(len > 0) {
+          newSyntax = m_probeSyntax;
+        }
+        if(newSyntax.isEmpty()) {
+          if(m_probeSyntax.isEmpty()) {
+            m_probeSyntaxes << QLatin1String("mods")
+                            << QLatin1String("usmarc")
+                            << QLatin1String("marc21")
+                            << QLatin1String("unimarc")
+                            << QLatin1String("grs-1");
+          }
+          return probeNextSyntax();
+        }
+        myLog() << "final syntax is " << newSyntax;
+        m_syntax = newSyntax;
+        m_settingsChanged = true;
+        // now request the whole batch in the detected syntax
+        setRecordSyntax(m_syntax);
+        const size_t realLimit = qMin(ZOOM_resultset_size(d->resultSet), m_limit);
+        if(m_start < realLimit) {
+          ZOOM_resultset_records(d->resultSet, nullptr, m_start, realLimit - m_start);
+        }
+        m_state = Presenting;
+        return true;
+      }
+
+    case Presenting:
+      collectRecords();
+      return false;
+
+    case Idle:
+      break;
   }
-  ZOOM_resultset_option_set(resultSet, "start", QByteArray::number(static_cast<int>(m_start)).constData());
-  ZOOM_resultset_option_set(resultSet, "count", QByteArray::number(static_cast<int>(m_limit-m_start)).constData());
-  // search in default syntax, unless syntax is already set
-  if(!m_syntax.isEmpty()) {
-    ZOOM_resultset_option_set(resultSet, "preferredRecordSyntax", m_syntax.toLatin1().constData());
+#endif
+  return false;
+}
+
+void Z3950Connection::finish() {
+#ifdef HAVE_YAZ
+  d->clearSearch();
+  if(m_aborted) {
+    // a task might still be pending, so start over next time
+    d->clearConnection();
+    m_connected = false;
   }
+#endif
+  m_state = Idle;
+}
 
+bool Z3950Connection::checkError() {
+#ifdef HAVE_YAZ
   const char* errmsg;
   const char* addinfo;
-  errcode = ZOOM_connection_error(d->conn, &errmsg, &addinfo);
-  if(errcode != 0) {
-    m_connected = false;
-
-    QString s = i18n("Connection search error %1: %2", errcode, toString(errmsg));
-    if(!QByteArray(addinfo).isEmpty()) {
-      s += QLatin1String(" (") + toString(addinfo) + QLatin1Char(')');
-    }
-    myDebug() << QString::fromLatin1("[%1/%2]").arg(m_host, m_dbname) << s;
-    done(s, MessageHandler::Error);
-    return;
+  const int errcode = ZOOM_connection_error(d->conn, &errmsg, &addinfo);
+  if(errcode == 0) {
+    return true;
+  }
+  // the connection is only made once the first search is sent
+  QString s = m_connecting ? i18n("Connection error %1: %2", errcode, toString(errmsg))
+                           : i18n("Connection search error %1: %2", errcode, toString(errmsg));
+  if(!QByteArray(addinfo).isEmpty()) {
+    s += QLatin1String(" (") + toString(addinfo) + QLatin1Char(')');
   }
+  // the error strings belong to the connection, so only destroy it now
+  d->clearSearch();
+  d->clearConnection();
+  m_connected = false;
+  m_connecting = false;
+  myDebug() << QString::fromLatin1("[%1/%2]").arg(m_host, m_dbname) << s;
+  done(s, MessageHandler::Error);
+#endif
+  return false;
+}
 
-  const size_t numResults = ZOOM_resultset_size(resultSet);
+bool Z3950Connection::probeNextSyntax() {
+#ifdef HAVE_YAZ
+  if(m_probeSyntaxes.isEmpty()) {
+    myLog() << "giving up";
+    done(i18n("Record syntax error"), MessageHandler::Error);
+    return false;
+  }
+  m_probeSyntax = m_probeSyntaxes.takeFirst();
+  myLog() << "changing z39.50 syntax to" << m_probeSyntax;
+  setRecordSyntax(m_probeSyntax);
+  ZOOM_resultset_records(d->resultSet, nullptr, 0, 1);
+  m_state = Probing;
+  return true;
+#else
+  return false;
+#endif
+}
 
-  QString newSyntax = m_syntax;
-  if(numResults > 0) {
-    myLog() << "current syntax is " << m_syntax << " (" << numResults << " results)";
-    // so now we know that results exist, might have to check syntax
- 
-    if(m_syntax == QLatin1String("ads")) {
-      // ads syntax is really 1.2.840.10003.5.1000.147.1
-      // see http://adsabs.harvard.edu/abs_doc/ads_server.html
-      ZOOM_resultset_option_set(resultSet, "preferredRecordSyntax", "1.2.840.10003.5.1000.147.1");
-    }
+void Z3950Connection::setRecordSyntax(const QString& syntax_) {
+#ifdef HAVE_YAZ
+  // I know the LOC wants the syntax = "xml" and esn = "mods"
+  // to get MODS data, that seems a bit odd...
+  // esn only makes sense for marc and grs-1
+  QByteArray syntax = syntax_.toLatin1();
+  QByteArray esn = m_esn.toLatin1();
+  if(syntax_ == QLatin1String("mods")) {
+    syntax = "xml";
+    esn = "mods";
+  } else if(syntax_ == QLatin1String("ads")) {
+    // ads syntax is really 1.2.840.10003.5.1000.147.1
+    // see http://adsabs.harvard.edu/abs_doc/ads_server.html
+    syntax = "1.2.840.10003.5.1000.147.1";
+  }
+  // before the search, the options are set on the connection and the result set inherits them
+  if(d->resultSet) {
+    ZOOM_resultset_option_set(d->resultSet, "elementSetName", esn.constData());
+    ZOOM_resultset_option_set(d->resultSet, "preferredRecordSyntax", syntax.constData());
+  } else {
+    ZOOM_connection_option_set(d->conn, "elementSetName", esn.constData());
+    ZOOM_connection_option_set(d->conn, "preferredRecordSyntax", syntax.constData());
+  }
+#else
+  Q_UNUSED(syntax_);
+#endif
+}
 
-    int len;
-    ZOOM_record rec = ZOOM_resultset_record(resultSet, 0);
-    // want raw unless it's mods
-    ZOOM_record_get(rec, type.constData(), &len);
-    if(len > 0 && m_syntax.isEmpty()) {
-      newSyntax = QString::fromLatin1(ZOOM_record_get(rec, "syntax", &len)).toLower();
-      myLog() << "syntax guess is " << newSyntax;
-      if(newSyntax == QLatin1String("mods") || newSyntax == QLatin1String("xml")) {
-        m_syntax = QLatin1String("xml");
-        ZOOM_resultset_option_set(resultSet, "elementSetName", "mods");
-      } else if(newSyntax == QLatin1String("grs-1")) {
-        // if it's defaulting to grs-1, go ahead and change it to try to get a marc
-        // record since grs-1 is a last resort for us
-        newSyntax.clear();
-      }
-    }
-    if(newSyntax != QLatin1String("xml") &&
-       newSyntax != QLatin1String("usmarc") &&
-       newSyntax != QLatin1String("marc21") &&
-       newSyntax != QLatin1String("unimarc") &&
-       newSyntax != QLatin1String("grs-1") &&
-       newSyntax != QLatin1String("ads")) {
-      myLog() << "changing z39.50 syntax to MODS";
-      newSyntax = QLatin1String("xml");
-      ZOOM_resultset_option_set(resultSet, "elementSetName", "mods");
-      ZOOM_resultset_option_set(resultSet, "preferredRecordSyntax", newSyntax.toLatin1().constData());
-      rec = ZOOM_resultset_record(resultSet, 0);
-      ZOOM_record_get(rec, "xml", &len);
-      if(len == 0) {
-        // change set name back
-        ZOOM_resultset_option_set(resultSet, "elementSetName", m_esn.toLatin1().constData());
-        newSyntax = QLatin1String("usmarc"); // try usmarc
-        myLog() << "changing z39.50 syntax to USMARC";
-        ZOOM_resultset_option_set(resultSet, "preferredRecordSyntax", newSyntax.toLatin1().constData());
-        rec = ZOOM_resultset_record(resultSet, 0);
-        ZOOM_record_get(rec, "raw", &len);
-      }
-      if(len == 0) {
-        newSyntax = QLatin1String("marc21"); // try marc21
-        myLog() << "changing z39.50 syntax to MARC21";
-        ZOOM_resultset_option_set(resultSet, "preferredRecordSyntax", newSyntax.toLatin1().constData());
-        rec = ZOOM_resultset_record(resultSet, 0);
-        ZOOM_record_get(rec, "raw", &len);
-      }
-      if(len == 0) {
-        newSyntax = QLatin1String("unimarc"); // try unimarc
-        myLog() << "changing z39.50 syntax to UNIMARC";
-        ZOOM_resultset_option_set(resultSet, "preferredRecordSyntax", newSyntax.toLatin1().constData());
-        rec = ZOOM_resultset_record(resultSet, 0);
-        ZOOM_record_get(rec, "raw", &len);
-      }
-      if(len == 0) {
-        newSyntax = QLatin1String("grs-1"); // try grs-1
-        myLog() << "changing z39.50 syntax to GRS-1";
-        ZOOM_resultset_option_set(resultSet, "preferredRecordSyntax", newSyntax.toLatin1().constData());
-        rec = ZOOM_resultset_record(resultSet, 0);
-        ZOOM_record_get(rec, "raw", &len);
-      }
-      if(len == 0) {
-        myLog() << "giving up";
-        done(i18n("Record syntax error"), MessageHandler::Error);
-        return;
-      }
-      myLog() << "final syntax is " << newSyntax;
-    }
+void Z3950Connection::collectRecords() {
+#ifdef HAVE_YAZ
+  if(!checkError()) {
+    return;
   }
 
-  // go back to fooling ourselves and calling it mods
-  if(m_syntax == QLatin1String("xml")) {
-    m_syntax = QLatin1String("mods");
+  const size_t numResults = ZOOM_resultset_size(d->resultSet);
+  const size_t realLimit = qMin(numResults, m_limit);
+  QVector<ZOOM_record> records(m_start < realLimit ? realLimit - m_start : 0);
+  if(!records.isEmpty()) {
+    // the records have already been retrieved, all in one request
+    ZOOM_resultset_records(d->resultSet, records.data(), m_start, records.count());
   }
-  if(newSyntax == QLatin1String("xml")) {
-    newSyntax = QLatin1String("mods");
+
+  const bool isMARC = m_syntax == QLatin1String("usmarc") || m_syntax == QLatin1String("marc21");
+  if(m_detectCharSet && isMARC) {
+    foreach(ZOOM_record rec, records) {
+      if(rec) {
+        int len;
+        detectCharSet(QByteArray(ZOOM_record_get(rec, "raw", &len)));
+        break;
+      }
+    }
   }
   // save syntax change for next time
-  if(m_syntax != newSyntax) {
-    qApp->postEvent(m_fetcher.data(), new Z3950SyntaxChange(newSyntax));
-    m_syntax = newSyntax;
+  if(m_settingsChanged) {
+    post(new Z3950SyntaxChange(m_syntax, m_detectCharSet ? QString() : m_sourceCharSet));
+    m_settingsChanged = false;
   }
 
   if(m_sourceCharSet.isEmpty()) {
     m_sourceCharSet = QLatin1String("marc-8");
   }
 
-  const size_t realLimit = qMin(numResults, m_limit);
-
   bool showError = true;
-  for(size_t i = m_start; i < realLimit && !m_aborted; ++i) {
-//    myLog() << "grabbing index" << i;
-    ZOOM_record rec = ZOOM_resultset_record(resultSet, i);
+  for(int i = 0; i < records.count() && !m_aborted; ++i) {
+    ZOOM_record rec = records.at(i);
     if(!rec) {
-      myDebug() << "no record returned for index" << i;
-      errcode = ZOOM_connection_error(d->conn, &errmsg, &addinfo);
+      myDebug() << "no record returned for index" << (m_start + i);
+      const char* errmsg;
+      const char* addinfo;
+      const int errcode = ZOOM_connection_error(d->conn, &errmsg, &addinfo);
       if(errcode != 0) {
         QString s = i18n("Connection search error %1: %2", errcode, toString(errmsg));
         if(!QByteArray(addinfo).isEmpty()) {
@@ -339,6 +433,7 @@ void Z3950Connection::run() {
           showError = false;
           m_hasMore = true;
           done(s, MessageHandler::Error);
+          return;
         }
       }
       continue;
@@ -369,8 +464,7 @@ void Z3950Connection::run() {
 #endif
       data = toXML(ZOOM_record_get(rec, "raw", &len), m_sourceCharSet);
     }
-    Z3950ResultFound* ev = new Z3950ResultFound(data);
-    QApplication::postEvent(m_fetcher.data(), ev);
+    post(new Z3950ResultFound(data));
   }
 
   m_hasMore = m_limit < numResults;
@@ -382,6 +476,17 @@ void Z3950Connection::run() {
   done();
 }
 
+// MARC21 records mark Unicode in position 9 of the leader, otherwise they're MARC-8
+void Z3950Connection::detectCharSet(const QByteArray& marc_) {
+  if(marc_.length() < 24) {
+    return;
+  }
+  m_sourceCharSet = marc_.at(9) == 'a' ? QLatin1String("utf-8") : QLatin1String("marc-8");
+  myLog() << "character set guess is" << m_sourceCharSet;
+  m_detectCharSet = false;
+  m_settingsChanged = true;
+}
+
 bool Z3950Connection::makeConnection() {
   if(m_connected) {
     return true;
@@ -391,59 +496,45 @@ bool Z3950Connection::makeConnection() {
 #ifdef HAVE_YAZ
   d->conn_opt = ZOOM_options_create();
   ZOOM_options_set(d->conn_opt, "implementationName", "Tellico");
-  ZOOM_options_set(d->conn_opt, "databaseName",       toCString(m_dbname));
-  ZOOM_options_set(d->conn_opt, "user",               toCString(m_user));
-  ZOOM_options_set(d->conn_opt, "password",           toCString(m_password));
+  ZOOM_options_set(d->conn_opt, "databaseName",       toCString(m_dbname).constData());
+  ZOOM_options_set(d->conn_opt, "user",               toCString(m_user).constData());
+  ZOOM_options_set(d->conn_opt, "password",           toCString(m_password).constData());
+  // nothing blocks, the loop waits on every connection at once
+  ZOOM_options_set(d->conn_opt, "async", "1");
 
   d->conn = ZOOM_connection_create(d->conn_opt);
+  // any connection error shows up once the search is done
   ZOOM_connection_connect(d->conn, m_host.toLatin1().constData(), m_port);
-
-  int errcode;
-  const char* errmsg; // unused: carries same info as 'errcode'
-  const char* addinfo;
-  errcode = ZOOM_connection_error(d->conn, &errmsg, &addinfo);
-  if(errcode != 0) {
-    ZOOM_options_destroy(d->conn_opt);
-    ZOOM_connection_destroy(d->conn);
-    m_connected = false;
-
-    QString s = i18n("Connection error %1: %2", errcode, toString(errmsg));
-    if(!QByteArray(addinfo).isEmpty()) {
-      s += QLatin1String(" (") + toString(addinfo) + QLatin1Char(')');
-    }
-    myDebug() << QString::fromLatin1("[%1/%2]").arg(m_host, m_dbname) << s;
-    done(s, MessageHandler::Error);
-    return false;
-  }
+  m_connecting = true;
 #endif
   m_connected = true;
   return true;
 }
 
 void Z3950Connection::done() {
-  checkPendingEvents();
-  qApp->postEvent(m_fetcher.data(), new Z3950ConnectionDone(m_hasMore));
+  post(new Z3950ConnectionDone(m_hasMore));
 }
 
 void Z3950Connection::done(const QString& msg_, int type_) {
-  checkPendingEvents();
   if(m_aborted) {
-    qApp->postEvent(m_fetcher.data(), new Z3950ConnectionDone(m_hasMore));
+    post(new Z3950ConnectionDone(m_hasMore));
   } else {
-    qApp->postEvent(m_fetcher.data(), new Z3950ConnectionDone(m_hasMore, msg_, type_));
+    post(new Z3950ConnectionDone(m_hasMore, msg_, type_));
   }
 }
 
-void Z3950Connection::checkPendingEvents() {
-  // if there's still some pending result events, go ahead and just wait 1 second
-  if(resultsLeft > 0) {
-    sleep(1);
+void Z3950Connection::post(QEvent* event_) {
+  QMutexLocker locker(&m_fetcherMutex);
+  if(m_fetcher) {
+    qApp->postEvent(m_fetcher, event_);
+  } else {
+    delete event_;
   }
 }
 
 inline
-const char* Z3950Connection::toCString(const QString& text_) {
-  return iconvRun(text_.toUtf8(), QLatin1String("utf-8"), m_sourceCharSet).constData();
+QByteArray Z3950Connection::toCString(const QString& text_) {
+  return iconvRun(text_.toUtf8(), QLatin1String("utf-8"), m_sourceCharSet);
 }
 
 inline
@@ -571,3 +662,236 @@ QString Z3950Connection::toXML(const QByteArray& marc_, const QString& charSet_)
   return QString();
 #endif
 }
+
+/*******************************************************/
+
+Z3950ConnectionLoop* Z3950ConnectionLoop::self() {
+  static Z3950ConnectionLoop loop;
+  return &loop;
+}
+
+Z3950ConnectionLoop::Z3950ConnectionLoop() : QThread(), m_quit(false) {
+  if(::pipe(m_wakePipe) == 0) {
+    // neither end ever blocks, a full pipe means the loop is about to wake up anyway
+    ::fcntl(m_wakePipe[0], F_SETFL, ::fcntl(m_wakePipe[0], F_GETFL) | O_NONBLOCK);
+    ::fcntl(m_wakePipe[1], F_SETFL, ::fcntl(m_wakePipe[1], F_GETFL) | O_NONBLOCK);
+  } else {
+    myWarning() << "unable to create the wake-up pipe";
+    // poll() ignores negative descriptors
+    m_wakePipe[0] = m_wakePipe[1] = -1;
+  }
+}
+
+Z3950ConnectionLoop::~Z3950ConnectionLoop() {
+  m_mutex.lock();
+  m_quit = true;
+  m_condition.wakeAll();
+  m_mutex.unlock();
+  // the loop might be waiting on the network, not the condition
+  wake();
+  wait();
+  if(m_wakePipe[0] > -1) {
+    ::close(m_wakePipe[0]);
+    ::close(m_wakePipe[1]);
+  }
+}
+
+void Z3950ConnectionLoop::add(Tellico::Fetch::Z3950Connection* conn_) {
+  QMutexLocker locker(&m_mutex);
+  if(!m_queued.contains(conn_) && !m_running.contains(conn_)) {
+    m_queued.append(conn_);
+  }
+  if(isRunning()) {
+    m_condition.wakeAll();
+    locker.unlock();
+    wake();
+  } else {
+    start();
+  }
+}
+
+void Z3950ConnectionLoop::waitForConnection(Tellico::Fetch::Z3950Connection* conn_) {
+  QMutexLocker locker(&m_mutex);
+  // a search which hasn't been sent yet can just be dropped
+  m_queued.removeAll(conn_);
+  while(m_running.contains(conn_)) {
+    m_condition.wait(&m_mutex);
+  }
+}
+
+void Z3950ConnectionLoop::release(Tellico::Fetch::Z3950Connection* conn_) {
+  {
+    // nothing gets posted to the fetcher anymore
+    QMutexLocker locker(&conn_->m_fetcherMutex);
+    conn_->m_fetcher = nullptr;
+  }
+  conn_->m_aborted = 1;
+  QMutexLocker locker(&m_mutex);
+  m_queued.removeAll(conn_);
+  if(m_running.contains(conn_)) {
+    m_released.append(conn_);
+    locker.unlock();
+    wake();
+  } else {
+    delete conn_;
+  }
+}
+
+void Z3950ConnectionLoop::wake() {
+  if(m_wakePipe[1] > -1) {
+    const char c = 0;
+    const ssize_t n = ::write(m_wakePipe[1], &c, 1);
+    Q_UNUSED(n);
+  }
+}
+
+void Z3950ConnectionLoop::run() {
+#ifdef HAVE_YAZ
+  QVector<pollfd> fds;
+  QList<Z3950Connection*> polled;
+  forever {
+    m_mutex.lock();
+    while(!m_quit && m_queued.isEmpty() && m_running.isEmpty()) {
+      m_condition.wait(&m_mutex);
+    }
+    if(m_quit) {
+      foreach(Z3950Connection* conn, m_running) {
+        conn->m_aborted = 1;
+        conn->finish();
+      }
+      qDeleteAll(m_released);
+      m_released.clear();
+      m_running.clear();
+      m_condition.wakeAll();
+      m_mutex.unlock();
+      return;
+    }
+    // the new searches count as running right away, so a released connection is never deleted
+    // while the search is being sent
+    QList<Z3950Connection*> queued;
+    queued.swap(m_queued);
+    m_running += queued;
+    m_mutex.unlock();
+
+    foreach(Z3950Connection* conn, queued) {
+      conn->m_lastActivity.start();
+      if(!conn->begin()) {
+        finish(conn);
+      }
+    }
+    foreach(Z3950Connection* conn, m_running) {
+      if(conn->m_aborted) {
+        conn->done();
+        finish(conn);
+      }
+    }
+
+    // first, let every connection do whatever it can without waiting
+    bool progressed = false;
+    foreach(Z3950Connection* conn, m_running) {
+      while(ZOOM_connection_process(conn->d->conn)) {
+        progressed = true;
+        conn->m_lastActivity.restart();
+        if(ZOOM_connection_last_event(conn->d->conn) == ZOOM_EVENT_END && !conn->handleEnd()) {
+          finish(conn);
+          break;
+        }
+      }
+    }
+    if(progressed || m_running.isEmpty()) {
+      continue;
+    }
+
+    // then wait on every socket at once, along with the wake-up pipe
+    fds.resize(1);
+    fds[0].fd = m_wakePipe[0];
+    fds[0].events = POLLIN;
+    fds[0].revents = 0;
+    polled.clear();
+    int timeout = -1;
+    foreach(Z3950Connection* conn, m_running) {
+      const int fd = ZOOM_connection_get_socket(conn->d->conn);
+      const int mask = ZOOM_connection_get_mask(conn->d->conn);
+      if(fd < 0 || mask == 0) {
+        continue;
+      }
+      pollfd pfd;
+      pfd.fd = fd;
+      pfd.events = 0;
+      pfd.revents = 0;
+      if(mask & ZOOM_SELECT_READ) {
+        pfd.events |= POLLIN;
+      }
+      if(mask & ZOOM_SELECT_WRITE) {
+        pfd.events |= POLLOUT;
+      }
+      if(mask & ZOOM_SELECT_EXCEPT) {
+        pfd.events |= POLLPRI;
+      }
+      fds.append(pfd);
+      polled.append(conn);
+      // each connection times out on its own, counting from its last activity
+      const int connTimeout = ZOOM_connection_get_timeout(conn->d->conn) * 1000;
+      const int remaining = qMax(0, connTimeout - static_cast<int>(conn->m_lastActivity.elapsed()));
+      timeout = timeout < 0 ? remaining : qMin(timeout, remaining);
+    }
+    if(polled.isEmpty()) {
+      // none of the connections have anything left to do, so move each one along
+      foreach(Z3950Connection* conn, m_running) {
+        if(!conn->handleEnd()) {
+          finish(conn);
+        }
+      }
+      continue;
+    }
+
+    // waking up early doesn't reset the server timeouts
+    const int r = ::poll(fds.data(), fds.count(), timeout);
+    if(r < 0) {
+      if(errno != EINTR) {
+        myWarning() << "poll error:" << errno;
+      }
+      continue;
+    }
+    if(fds.at(0).revents & POLLIN) {
+      char buffer[64];
+      while(::read(m_wakePipe[0], buffer, sizeof(buffer)) > 0) {
+      }
+    }
+    for(int i = 0; i < polled.count(); ++i) {
+      Z3950Connection* conn = polled.at(i);
+      const short revents = fds.at(i+1).revents;
+      if(revents == 0) {
+        // only the connections whose own deadline has passed get the timeout
+        if(conn->m_lastActivity.elapsed() >= ZOOM_connection_get_timeout(conn->d->conn) * 1000) {
+          ZOOM_connection_fire_event_timeout(conn->d->conn);
+          conn->m_lastActivity.restart();
+        }
+        continue;
+      }
+      int mask = 0;
+      if(revents & POLLIN) {
+        mask |= ZOOM_SELECT_READ;
+      }
+      if(revents & POLLOUT) {
+        mask |= ZOOM_SELECT_WRITE;
+      }
+      if(revents & (POLLPRI | POLLERR | POLLHUP)) {
+        mask |= ZOOM_SELECT_EXCEPT;
+      }
+      ZOOM_connection_fire_event_socket(conn->d->conn, mask);
+      conn->m_lastActivity.restart();
+    }
+  }
+#endif
+}
+
+void Z3950ConnectionLoop::finish(Tellico::Fetch::Z3950Connection* conn_) {
+  conn_->finish();
+  QMutexLocker locker(&m_mutex);
+  m_running.removeAll(conn_);
+  if(m_released.removeAll(conn_) > 0) {
+    delete conn_;
+  }
+  m_condition.wakeAll();
+}
@@ -27,7 +27,11 @@
 
 #include <QThread>
 #include <QEvent>
-#include <QExplicitlySharedDataPointer>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QStringList>
 
 namespace Tellico {
   namespace Fetch {
@@ -35,8 +39,7 @@ namespace Tellico {
 
 class Z3950ResultFound : public QEvent {
 public:
-  Z3950ResultFound(const QString& s);
-  ~Z3950ResultFound();
+  Z3950ResultFound(const QString& s) : QEvent(uid()), m_result(s) {}
   const QString& result() const { return m_result; }
 
   static QEvent::Type uid() { return static_cast<QEvent::Type>(QEvent::User + 11111); }
@@ -62,21 +65,30 @@ private:
   bool m_hasMore;
 };
 
+/**
+ * Posted when the record syntax or the character set of a server has been detected,
+ * so it can be remembered for the next search.
+ */
 class Z3950SyntaxChange : public QEvent {
 public:
-  Z3950SyntaxChange(const QString& s) : QEvent(uid()), m_syntax(s) {}
+  Z3950SyntaxChange(const QString& s, const QString& c) : QEvent(uid()), m_syntax(s), m_charSet(c) {}
   const QString& syntax() const { return m_syntax; }
+  const QString& charSet() const { return m_charSet; }
 
   static QEvent::Type uid() { return static_cast<QEvent::Type>(QEvent::User + 33333); }
 
 private:
   QString m_syntax;
+  QString m_charSet;
 };
 
 /**
+ * The connection to a single Z39.50 server. The searches are run asynchronously by
+ * @ref Z3950ConnectionLoop, and the results are posted to the fetcher as events.
+ *
  * @author Robby Stephenson
  */
-class Z3950Connection : public QThread {
+class Z3950Connection {
 public:
   Z3950Connection(Z3950Fetcher* fetcher,
                   const QString& host,
@@ -90,28 +102,62 @@ public:
   void reset();
   void setQuery(const QString& query);
   void setUserPassword(const QString& user, const QString& pword);
-  void run() Q_DECL_OVERRIDE;
-
-  void abort() { m_aborted = true; }
+  /**
+   * Queues the search in the connection loop.
+   */
+  void start();
+  /**
+   * Waits until the connection loop is done with the current search.
+   */
+  void wait();
+  /**
+   * Aborts the current search. The connection loop is woken up, so it notices right away.
+   */
+  void abort();
 
 private:
+  friend class Z3950ConnectionLoop;
+
+  enum State {
+    Idle,
+    Searching,
+    Probing,
+    Presenting
+  };
+
   static QByteArray iconvRun(const QByteArray& text, const QString& fromCharSet, const QString& toCharSet);
   static QString toXML(const QByteArray& marc, const QString& fromCharSet);
 
+  // these are only called from the loop thread. They return false once the search is done
+  bool begin();
+  bool handleEnd();
+  void finish();
+
   bool makeConnection();
+  bool checkError();
+  bool probeNextSyntax();
+  void setRecordSyntax(const QString& syntax);
+  void collectRecords();
+  void detectCharSet(const QByteArray& marc);
   void done();
   void done(const QString& message, int type);
-  const char* toCString(const QString& text);
+  void post(QEvent* event);
+  QByteArray toCString(const QString& text);
   QString toString(const QByteArray& text);
-  void checkPendingEvents();
 
   class Private;
   Private* d;
 
   bool m_connected;
-  bool m_aborted;
-
-  QExplicitlySharedDataPointer<Z3950Fetcher> m_fetcher;
+  bool m_connecting;
+  QAtomicInt m_aborted;
+  State m_state;
+  // the time since the last network activity, only used by the loop thread
+  QElapsedTimer m_lastActivity;
+
+  // cleared by the loop when the fetcher is deleted before the search is done
+  Z3950Fetcher* m_fetcher;
+  QMutex m_fetcherMutex;
   QString m_host;
   uint m_port;
   QString m_dbname;
@@ -124,9 +170,54 @@ private:
   size_t m_start;
   size_t m_limit;
   bool m_hasMore;
+  // the syntax and character set are only detected once, then remembered by the fetcher
+  bool m_detectCharSet;
+  bool m_settingsChanged;
+  QStringList m_probeSyntaxes;
+  QString m_probeSyntax;
+};
+
+/**
+ * A single thread runs the searches for every Z39.50 server. The connections are asynchronous
+ * and the thread waits on all of them at once, so searching several servers takes as long as the
+ * slowest one, rather than the sum of all of them.
+ *
+ * @author Robby Stephenson
+ */
+class Z3950ConnectionLoop : public QThread {
+public:
+  static Z3950ConnectionLoop* self();
+  ~Z3950ConnectionLoop();
+
+  void add(Z3950Connection* conn);
+  void waitForConnection(Z3950Connection* conn);
+  /**
+   * Aborts the search and deletes the connection once the loop is done with it,
+   * without waiting for the server to answer.
+   */
+  void release(Z3950Connection* conn);
+  /**
+   * Interrupts the wait for network events, so aborted searches are noticed right away.
+   */
+  void wake();
+
+protected:
+  void run() Q_DECL_OVERRIDE;
 
-  friend class Z3950ResultFound;
-  static int resultsLeft;
+private:
+  Z3950ConnectionLoop();
+  void finish(Z3950Connection* conn);
+
+  QMutex m_mutex;
+  QWaitCondition m_condition;
+  QList<Z3950Connection*> m_queued;
+  // only modified by the loop thread, while holding the mutex
+  QList<Z3950Connection*> m_running;
+  // released connections which are still running, to be deleted by the loop thread
+  QList<Z3950Connection*> m_released;
+  bool m_quit;
+  // the loop waits on the read end along with the sockets, and wake() writes to the other one
+  int m_wakePipe[2];
 };
 
   } // end namespace
@@ -55,6 +55,7 @@
 #include <KAcceleratorManager>
 #include <KSeparator>
 #include <KConfig>
+#include <KSharedConfig>
 
 #include <QSpinBox>
 #include <QFile>
@@ -68,6 +69,8 @@
 namespace {
   static const int Z3950_DEFAULT_PORT = 210;
   static const QString Z3950_DEFAULT_ESN = QLatin1String("F");
+  // the detected record syntax and character set of each server, no matter which source uses it
+  static const char* Z3950_DETECTED_GROUP = "Z39.50 Servers";
 }
 
 using namespace Tellico;
@@ -120,8 +123,8 @@ Z3950Fetcher::~Z3950Fetcher() {
   m_MODSHandler = nullptr;
 
   if(m_conn) {
-    m_conn->wait();
-    m_conn->deleteLater();
+    // the server might not answer for a long time, so let the connection loop delete it
+    Z3950ConnectionLoop::self()->release(m_conn);
     m_conn = nullptr;
   }
 }
@@ -284,9 +287,8 @@ void Z3950Fetcher::stop() {
   }
   m_started = false;
   if(m_conn) {
-   // give it a second to cleanup
+    // the connection loop cleans up once the server responds
     m_conn->abort();
-    m_conn->wait(1000);
   }
   emit signalDone(this);
 }
@@ -369,7 +371,13 @@ void Z3950Fetcher::process() {
   if(m_conn) {
     m_conn->wait();
   } else {
-    m_conn = new Z3950Connection(this, m_host, m_port, m_dbname, m_sourceCharSet, m_syntax, m_esn);
+    // use whatever was detected for the server before, unless it's set explicitly
+    const KConfigGroup detected(KSharedConfig::openConfig(), QLatin1String(Z3950_DETECTED_GROUP));
+    const QString syntax = m_syntax.isEmpty() ? detected.readEntry(serverKey() + QLatin1String(" Syntax"))
+                                              : m_syntax;
+    const QString charSet = m_sourceCharSet.isEmpty() ? detected.readEntry(serverKey() + QLatin1String(" Charset"))
+                                                      : m_sourceCharSet;
+    m_conn = new Z3950Connection(this, m_host, m_port, m_dbname, charSet, syntax, m_esn);
     if(!m_user.isEmpty()) {
       m_conn->setUserPassword(m_user, m_password);
     }
@@ -518,11 +526,23 @@ void Z3950Fetcher::customEvent(QEvent* event_) {
       m_syntax = e->syntax();
       // it gets saved when saveConfigHook() get's called from the Fetcher() d'tor
     }
+    // presets are read from the server file every time, so remember the detected settings
+    // by server right away
+    KConfigGroup detected(KSharedConfig::openConfig(), QLatin1String(Z3950_DETECTED_GROUP));
+    detected.writeEntry(serverKey() + QLatin1String(" Syntax"), e->syntax());
+    if(m_sourceCharSet.isEmpty() && !e->charSet().isEmpty()) {
+      detected.writeEntry(serverKey() + QLatin1String(" Charset"), e->charSet());
+    }
+    detected.sync();
   } else {
     myWarning() << "weird type: " << event_->type();
   }
 }
 
+QString Z3950Fetcher::serverKey() const {
+  return QString::fromLatin1("%1:%2/%3").arg(m_host).arg(m_port).arg(m_dbname);
+}
+
 Tellico::Fetch::FetchRequest Z3950Fetcher::updateRequest(Data::EntryPtr entry_) {
 //  myDebug() << source() << ": " << entry_->title();
   QString isbn = entry_->field(QLatin1String("isbn"));
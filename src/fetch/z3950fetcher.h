@@ -102,6 +102,7 @@ private:
   void process();
   void handleResult(const QString& result);
   void done();
+  QString serverKey() const;
 
   Z3950Connection* m_conn;
 
@@ -101,6 +101,21 @@ namespace {
   private:
     QImage m_image;
   };
+
+  Tellico::Fetch::KeyMap sourceKeyMap(const QString& source_, bool allSources_, int collType_) {
+    if(!allSources_) {
+      return Tellico::Fetch::Manager::self()->keyMap(source_);
+    }
+    // when searching all sources, any key supported by at least one of them is allowed
+    Tellico::Fetch::KeyMap map;
+    foreach(Tellico::Fetch::Fetcher::Ptr fetcher, Tellico::Fetch::Manager::self()->fetchers(collType_)) {
+      const Tellico::Fetch::KeyMap sourceMap = Tellico::Fetch::Manager::self()->keyMap(fetcher->source());
+      for(Tellico::Fetch::KeyMap::ConstIterator it = sourceMap.constBegin(); it != sourceMap.constEnd(); ++it) {
+        map.insert(it.key(), it.value());
+      }
+    }
+    return map;
+  }
 }
 
 using Tellico::FetchDialog;
@@ -214,6 +229,10 @@ FetchDialog::FetchDialog(QWidget* parent_)
   foreach(Fetch::Fetcher::Ptr fetcher, sources) {
     m_sourceCombo->addItem(Fetch::Manager::self()->fetcherIcon(fetcher), fetcher->source());
   }
+  if(sources.count() > 1) {
+    // the item data marks the choice for searching all sources at once
+    m_sourceCombo->addItem(QIcon::fromTheme(QLatin1String("edit-find")), i18n("All Sources"), true);
+  }
   connect(m_sourceCombo, SIGNAL(activated(const QString&)), SLOT(slotSourceChanged(const QString&)));
   m_sourceCombo->setWhatsThis(i18n("Select the database to search"));
 
@@ -376,9 +395,12 @@ void FetchDialog::slotSearchClicked() {
     startProgress();
     setStatus(i18n("Searching..."));
     qApp->processEvents();
-    Fetch::Manager::self()->startSearch(m_sourceCombo->currentText(),
-                                        static_cast<Fetch::FetchKey>(m_keyCombo->currentData().toInt()),
-                                        value);
+    const Fetch::FetchKey key = static_cast<Fetch::FetchKey>(m_keyCombo->currentData().toInt());
+    if(m_sourceCombo->currentData().toBool()) {
+      Fetch::Manager::self()->startSearchAll(key, value);
+    } else {
+      Fetch::Manager::self()->startSearch(m_sourceCombo->currentText(), key, value);
+    }
   }
 }
 
@@ -652,7 +674,8 @@ void FetchDialog::slotKeyChanged(int idx_) {
       connect(upc, SIGNAL(signalISBN()), SLOT(slotUPC2ISBN()));
       m_valueLineEdit->setValidator(upc);
       // only want to convert to ISBN if ISBN is accepted by the fetcher
-      Fetch::KeyMap map = Fetch::Manager::self()->keyMap(m_sourceCombo->currentText());
+      Fetch::KeyMap map = sourceKeyMap(m_sourceCombo->currentText(),
+                                       m_sourceCombo->currentData().toBool(), m_collType);
       upc->setCheckISBN(map.contains(Fetch::ISBN));
     }
   } else {
@@ -672,7 +695,7 @@ void FetchDialog::slotKeyChanged(int idx_) {
 void FetchDialog::slotSourceChanged(const QString& source_) {
   int curr = m_keyCombo->currentData().toInt();
   m_keyCombo->clear();
-  Fetch::KeyMap map = Fetch::Manager::self()->keyMap(source_);
+  Fetch::KeyMap map = sourceKeyMap(source_, m_sourceCombo->currentData().toBool(), m_collType);
   for(Fetch::KeyMap::ConstIterator it = map.constBegin(); it != map.constEnd(); ++it) {
     m_keyCombo->addItem(it.value(), it.key());
   }
@@ -836,6 +859,10 @@ void FetchDialog::slotResetCollection() {
   foreach(Fetch::Fetcher::Ptr fetcher, sources) {
     m_sourceCombo->addItem(Fetch::Manager::self()->fetcherIcon(fetcher), fetcher->source());
   }
+  if(sources.count() > 1) {
+    // the item data marks the choice for searching all sources at once
+    m_sourceCombo->addItem(QIcon::fromTheme(QLatin1String("edit-find")), i18n("All Sources"), true);
+  }
 
   m_addButton->setIcon(QIcon(QLatin1String(":/icons/") + Kernel::self()->collectionTypeName()));
 
@@ -82,7 +82,7 @@ Field::Field(const Field& field_)
     : QSharedData(field_), m_name(field_.name()), m_title(field_.title()), m_category(field_.category()),
       m_desc(field_.description()), m_type(field_.type()), m_allowed(field_.allowed()),
       m_flags(field_.flags()), m_formatType(field_.formatType()),
-      m_properties(field_.propertyList()) {
+      m_properties(field_.propertyList()), m_derivedValue(field_.m_derivedValue) {
 }
 
 Field& Field::operator=(const Field& field_) {
@@ -98,6 +98,7 @@ Field& Field::operator=(const Field& field_) {
   m_flags = field_.flags();
   m_formatType = field_.formatType();
   m_properties = field_.propertyList();
+  m_derivedValue = field_.m_derivedValue;
   return *this;
 }
 
@@ -230,16 +231,25 @@ void Field::addAllowed(const QString& value_) {
   }
 }
 
+void Field::setDescription(const QString& desc_) {
+  m_desc = desc_;
+  m_derivedValue.clear();
+}
+
 void Field::setProperty(const QString& key_, const QString& value_) {
   if(value_.isEmpty()) {
     m_properties.remove(key_);
   } else {
     m_properties.insert(key_, value_);
   }
+  if(key_ == QLatin1String("template")) {
+    m_derivedValue.clear();
+  }
 }
 
 void Field::setPropertyList(const Tellico::StringMap& props_) {
   m_properties = props_;
+  m_derivedValue.clear();
 }
 
 QString Field::property(const QString& key_) const {
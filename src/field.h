@@ -30,9 +30,11 @@
 
 #include <QStringList>
 #include <QRegExp>
+#include <QSharedPointer>
 
 namespace Tellico {
   namespace Data {
+    class DerivedValue;
 
 /**
  * The Field class encapsulates all the possible properties of a entry.
@@ -250,7 +252,7 @@ public:
    *
    * @param desc The field description
    */
-  void setDescription(const QString& desc) { m_desc = desc; }
+  void setDescription(const QString& desc);
   /**
    * Returns the default value for the field.
    *
@@ -282,6 +284,14 @@ public:
    * @param properties The property list
    */
   void setPropertyList(const StringMap& properties);
+  /**
+   * Returns the compiled template of a derived field. The template is compiled the
+   * first time it is needed, and again after it changes. Since the compiled template
+   * is cached, this should only be called from the GUI thread.
+   *
+   * @return The compiled template, or a null pointer if the field is not derived
+   */
+  const DerivedValue* derivedValue() const;
   /**
    * Return a property value.
    *
@@ -332,6 +342,8 @@ private:
   int m_flags;
   FieldFormat::Type m_formatType;
   StringMap m_properties;
+  // the compiled template never changes, so copies of the field can share it
+  mutable QSharedPointer<const DerivedValue> m_derivedValue;
 };
 
   } // end namespace
@@ -55,6 +55,18 @@ QString FieldCompletion::makeCompletion(const QString& string_) {
   return m_beginText + KCompletion::makeCompletion(final);
 }
 
+void FieldCompletion::setItemCounts(const QHash<QString, int>& counts_) {
+  // weighted items are given as "item:weight"
+  setOrder(KCompletion::Weighted);
+  QStringList items;
+  items.reserve(counts_.size());
+  QHash<QString, int>::const_iterator it = counts_.constBegin();
+  for( ; it != counts_.constEnd(); ++it) {
+    items += it.key() + QLatin1Char(':') + QString::number(it.value());
+  }
+  setItems(items);
+}
+
 void FieldCompletion::clear() {
   m_beginText.clear();
   KCompletion::clear();
@@ -27,6 +27,8 @@
 
 #include <KCompletion/KCompletion>
 
+#include <QHash>
+
 namespace Tellico {
 
 /**
@@ -39,6 +41,12 @@ public:
   FieldCompletion(bool multiple);
 
   void setMultiple(bool m) { m_multiple = m; }
+  /**
+   * Sets the completion items, ordered so the values used by the most entries come first
+   *
+   * @param counts The values, mapped to the number of entries using them
+   */
+  void setItemCounts(const QHash<QString, int>& counts);
   virtual QString makeCompletion(const QString& string) Q_DECL_OVERRIDE;
   virtual void clear() Q_DECL_OVERRIDE;
 
@@ -24,13 +24,64 @@
 
 #include "filter.h"
 #include "entry.h"
+#include "collection.h"
+#include "fulltextindex.h"
 #include "utils/string_utils.h"
 #include "tellico_debug.h"
 
 #include <QRegExp>
 
+#include <algorithm>
+
 using Tellico::Filter;
 using Tellico::FilterRule;
+using Tellico::FilterPlan;
+
+namespace {
+  // relative cost of checking a rule, looking at every field is much more expensive
+  static const double FILTER_COST_FIELD = 1.0;
+  static const double FILTER_COST_REGEXP = 4.0;
+  static const double FILTER_COST_ALL_FIELDS = 10.0;
+
+  // strings with only ascii characters have no accents to remove
+  bool isAscii(const QString& str) {
+    const QChar* c = str.constData();
+    const QChar* end = c + str.length();
+    for( ; c != end; ++c) {
+      if(c->unicode() > 0x7f) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool containsPattern(const QStringMatcher& matcher_, const QString& value_) {
+    if(matcher_.indexIn(value_) > -1) {
+      return true;
+    }
+    // only bother removing accents if there might be some
+    if(isAscii(value_)) {
+      return false;
+    }
+    const QString value2 = Tellico::removeAccents(value_);
+    return value2 != value_ && matcher_.indexIn(value2) > -1;
+  }
+
+  // a rough guess at the fraction of entries that a rule matches
+  double matchProbability(FilterRule::Function func_, const QString& pattern_) {
+    switch(func_) {
+      case FilterRule::FuncEquals:
+        return 0.05;
+      case FilterRule::FuncContains:
+        // longer words are less likely to match
+        return qMax(0.05, 0.5 - 0.05*pattern_.length());
+      case FilterRule::FuncRegExp:
+        return 0.2;
+      default:
+        return 0.5;
+    }
+  }
+}
 
 FilterRule::FilterRule() : m_function(FuncEquals) {
 }
@@ -284,3 +335,254 @@ bool Filter::operator==(const Filter& other) const {
          m_name == other.m_name &&
          *static_cast<const QList<FilterRule*>*>(this) == static_cast<const QList<FilterRule*>&>(other);
 }
+
+/*******************************************************/
+
+FilterPlan::FilterPlan() : m_op(Filter::MatchAll), m_fieldGeneration(-1), m_useIndex(false), m_index(nullptr), m_indexGeneration(-1) {
+}
+
+FilterPlan::FilterPlan(Tellico::FilterPtr filter_) : m_op(Filter::MatchAll), m_fieldGeneration(-1), m_useIndex(false)
+    , m_index(nullptr), m_indexGeneration(-1) {
+  if(!filter_) {
+    return;
+  }
+  m_op = filter_->op();
+  foreach(const FilterRule* rule, *filter_) {
+    Step step;
+    step.negate = false;
+    step.function = rule->function();
+    switch(step.function) {
+      case FilterRule::FuncNotContains:
+        step.function = FilterRule::FuncContains;
+        step.negate = true;
+        break;
+      case FilterRule::FuncNotEquals:
+        step.function = FilterRule::FuncEquals;
+        step.negate = true;
+        break;
+      case FilterRule::FuncNotRegExp:
+        step.function = FilterRule::FuncRegExp;
+        step.negate = true;
+        break;
+      default:
+        break;
+    }
+    step.fieldName = rule->fieldName();
+    step.formatted = false;
+    step.pattern = rule->pattern();
+    step.number = 0.0;
+    // any entry which contains or equals the pattern in some field also contains it in the full text
+    step.indexed = (step.function == FilterRule::FuncContains || step.function == FilterRule::FuncEquals) &&
+                   Data::FullTextIndex::canLookup(step.pattern);
+    m_useIndex = m_useIndex || step.indexed;
+    switch(step.function) {
+      case FilterRule::FuncContains:
+        step.matcher = QStringMatcher(step.pattern, Qt::CaseInsensitive);
+        break;
+      case FilterRule::FuncRegExp:
+        // saved filters use the QRegExp syntax, so keep using it rather than QRegularExpression
+        step.regExp = QRegExp(step.pattern, Qt::CaseInsensitive);
+        break;
+      case FilterRule::FuncBefore:
+      case FilterRule::FuncAfter:
+        step.date = QDate::fromString(step.pattern, Qt::ISODate);
+        break;
+      case FilterRule::FuncLess:
+      case FilterRule::FuncGreater:
+        step.number = step.pattern.toDouble();
+        break;
+      default:
+        break;
+    }
+
+    // the cost is weighted by how likely the rule is to decide the match. For
+    // MatchAll, that's when the rule fails and for MatchAny, when the rule matches
+    double p = matchProbability(step.function, step.pattern);
+    if(step.negate) {
+      p = 1.0 - p;
+    }
+    if(m_op == Filter::MatchAll) {
+      p = 1.0 - p;
+    }
+    double cost = step.function == FilterRule::FuncRegExp ? FILTER_COST_REGEXP : FILTER_COST_FIELD;
+    // when the index rules out most entries, checking every field is only done for a few
+    if(step.fieldName.isEmpty() && !step.indexed) {
+      cost *= FILTER_COST_ALL_FIELDS;
+    }
+    step.cost = cost / qMax(p, 0.01);
+    m_steps.append(step);
+  }
+
+  // the order of the rules doesn't change the result, so the cheapest are checked first
+  std::stable_sort(m_steps.begin(), m_steps.end());
+}
+
+bool FilterPlan::matches(Tellico::Data::EntryPtr entry_) const {
+  if(m_steps.isEmpty()) {
+    return true;
+  }
+  Q_ASSERT(entry_);
+  Data::CollPtr coll = entry_ ? entry_->collection() : Data::CollPtr();
+  Q_ASSERT(coll);
+  if(!coll) {
+    return false;
+  }
+  // the fields might have been modified or removed since they were looked up
+  if(coll.data() != m_coll.data() || coll->fieldGeneration() != m_fieldGeneration) {
+    resolveFields(coll);
+  }
+  if(m_useIndex) {
+    // the index is kept current by the collection, but the candidates need to be looked up again
+    m_index = coll->fullTextIndex();
+    if(m_index->generation() != m_indexGeneration) {
+      lookupCandidates(m_index);
+    }
+  }
+
+  // the steps are already sorted, so stop as soon as the result is known
+  const bool matchAll = m_op == Filter::MatchAll;
+  foreach(const Step& step, m_steps) {
+    if(matchesStep(step, entry_) != matchAll) {
+      return !matchAll;
+    }
+  }
+  return matchAll;
+}
+
+void FilterPlan::resolveFields(Tellico::Data::CollPtr coll_) const {
+  m_coll = coll_.data();
+  m_fieldGeneration = coll_->fieldGeneration();
+  for(int i = 0; i < m_steps.count(); ++i) {
+    Step& step = m_steps[i];
+    step.field = step.fieldName.isEmpty() ? Data::FieldPtr() : coll_->fieldByName(step.fieldName);
+    step.formatted = step.field && step.field->formatType() != FieldFormat::FormatNone;
+  }
+}
+
+void FilterPlan::lookupCandidates(const Tellico::Data::FullTextIndex* index_) const {
+  m_indexGeneration = index_->generation();
+  for(int i = 0; i < m_steps.count(); ++i) {
+    Step& step = m_steps[i];
+    if(step.indexed) {
+      bool ok = false;
+      step.candidates = index_->candidates(step.pattern, &ok);
+      Q_ASSERT(ok);
+    }
+  }
+}
+
+bool FilterPlan::isCandidate(const Step& step_, Tellico::Data::EntryPtr entry_) const {
+  if(!step_.indexed || std::binary_search(step_.candidates.constBegin(), step_.candidates.constEnd(), entry_->id())) {
+    return true;
+  }
+  // an entry which isn't in the index, like one which hasn't been added yet, still needs to be checked
+  return !m_index->hasEntry(entry_->id());
+}
+
+bool FilterPlan::matchesStep(const Step& step_, Tellico::Data::EntryPtr entry_) const {
+  bool match = false;
+  switch(step_.function) {
+    case FilterRule::FuncEquals:
+      match = equals(step_, entry_);
+      break;
+    case FilterRule::FuncContains:
+      match = contains(step_, entry_);
+      break;
+    case FilterRule::FuncRegExp:
+      match = matchesRegExp(step_, entry_);
+      break;
+    case FilterRule::FuncBefore:
+    case FilterRule::FuncAfter:
+      // the rule widget should limit this function to date fields only
+      if(step_.field) {
+        // Bug 361625: some older versions of Tellico serialized the date with single digit month and day
+        const QDate value = QDate::fromString(entry_->field(step_.field), QLatin1String("yyyy-M-d"));
+        match = value.isValid() && (step_.function == FilterRule::FuncBefore ? value < step_.date
+                                                                             : value > step_.date);
+      }
+      break;
+    case FilterRule::FuncLess:
+    case FilterRule::FuncGreater:
+      // the rule widget should limit this function to number fields only
+      if(step_.field) {
+        bool ok = false;
+        const double value = entry_->field(step_.field).toDouble(&ok);
+        match = ok && (step_.function == FilterRule::FuncLess ? value < step_.number
+                                                              : value > step_.number);
+      }
+      break;
+    default:
+      myWarning() << "invalid function!";
+      return false;
+  }
+  return match != step_.negate;
+}
+
+bool FilterPlan::equals(const Step& step_, Tellico::Data::EntryPtr entry_) const {
+  if(!isCandidate(step_, entry_)) {
+    return false;
+  }
+  const int length = step_.pattern.length();
+  // empty field name means search all
+  if(step_.fieldName.isEmpty()) {
+    foreach(const QString& value, entry_->fieldValues()) {
+      if(value.length() == length && step_.pattern.compare(value, Qt::CaseInsensitive) == 0) {
+        return true;
+      }
+    }
+    foreach(const QString& value, entry_->formattedFieldValues()) {
+      if(value.length() == length && step_.pattern.compare(value, Qt::CaseInsensitive) == 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+  if(step_.pattern.compare(entry_->field(step_.field), Qt::CaseInsensitive) == 0) {
+    return true;
+  }
+  return step_.formatted &&
+         step_.pattern.compare(entry_->formattedField(step_.field, FieldFormat::ForceFormat), Qt::CaseInsensitive) == 0;
+}
+
+bool FilterPlan::contains(const Step& step_, Tellico::Data::EntryPtr entry_) const {
+  if(!isCandidate(step_, entry_)) {
+    return false;
+  }
+  // empty field name means search all
+  if(step_.fieldName.isEmpty()) {
+    // match is true if any strings match
+    foreach(const QString& value, entry_->fieldValues()) {
+      if(containsPattern(step_.matcher, value)) {
+        return true;
+      }
+    }
+    foreach(const QString& value, entry_->formattedFieldValues()) {
+      if(containsPattern(step_.matcher, value)) {
+        return true;
+      }
+    }
+    return false;
+  }
+  return containsPattern(step_.matcher, entry_->field(step_.field)) ||
+         (step_.formatted && containsPattern(step_.matcher, entry_->formattedField(step_.field)));
+}
+
+bool FilterPlan::matchesRegExp(const Step& step_, Tellico::Data::EntryPtr entry_) const {
+  // empty field name means search all
+  if(step_.fieldName.isEmpty()) {
+    foreach(const QString& value, entry_->fieldValues()) {
+      if(step_.regExp.indexIn(value) >= 0) {
+        return true;
+      }
+    }
+    foreach(const QString& value, entry_->formattedFieldValues()) {
+      if(step_.regExp.indexIn(value) >= 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+  return step_.regExp.indexIn(entry_->field(step_.field)) >= 0 ||
+         (step_.formatted &&
+          step_.regExp.indexIn(entry_->formattedField(step_.field, FieldFormat::ForceFormat)) >= 0);
+}
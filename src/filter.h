@@ -26,14 +26,22 @@
 #define TELLICO_FILTER_H
 
 #include "datavectors.h"
+#include "field.h"
 
 #include <QList>
+#include <QVector>
 #include <QString>
 #include <QVariant>
+#include <QStringMatcher>
+#include <QRegExp>
+#include <QDate>
+#include <QPointer>
 
 namespace Tellico {
   namespace Data {
     class Entry;
+    class Collection;
+    class FullTextIndex;
   }
 
 /**
@@ -146,5 +154,64 @@ private:
   QString m_name;
 };
 
+/**
+ * A filter compiled for checking a large number of entries. The rules are copied
+ * out of the filter, so later changes to the filter are not reflected in the plan.
+ * The patterns are prepared once, the fields are looked up again only when the fields
+ * of the collection change, and the rules are ordered so that the ones most likely
+ * to decide the match, at the lowest cost, are checked first.
+ *
+ * @author Robby Stephenson
+ */
+class FilterPlan {
+
+public:
+  FilterPlan();
+  explicit FilterPlan(FilterPtr filter);
+
+  /**
+   * A plan is empty if there is no filter or the filter has no rules,
+   * in which case every entry matches.
+   */
+  bool isEmpty() const { return m_steps.isEmpty(); }
+  bool matches(Data::EntryPtr entry) const;
+
+private:
+  struct Step {
+    FilterRule::Function function; // the non-negated version of the rule function
+    bool negate;
+    QString fieldName;
+    Data::FieldPtr field;
+    bool formatted; // whether the formatted value needs to be checked, too
+    QString pattern;
+    QStringMatcher matcher;
+    QRegExp regExp;
+    QDate date;
+    double number;
+    double cost;
+    // whether the full-text index can rule out entries which don't contain the pattern
+    bool indexed;
+    QVector<Data::ID> candidates;
+
+    bool operator<(const Step& other) const { return cost < other.cost; }
+  };
+
+  void resolveFields(Data::CollPtr coll) const;
+  void lookupCandidates(const Data::FullTextIndex* index) const;
+  bool isCandidate(const Step& step, Data::EntryPtr entry) const;
+  bool matchesStep(const Step& step, Data::EntryPtr entry) const;
+  bool equals(const Step& step, Data::EntryPtr entry) const;
+  bool contains(const Step& step, Data::EntryPtr entry) const;
+  bool matchesRegExp(const Step& step, Data::EntryPtr entry) const;
+
+  Filter::FilterOp m_op;
+  mutable QVector<Step> m_steps;
+  mutable QPointer<Data::Collection> m_coll;
+  mutable int m_fieldGeneration;
+  bool m_useIndex;
+  mutable const Data::FullTextIndex* m_index;
+  mutable int m_indexGeneration;
+};
+
 } // end namespace
 #endif
@@ -199,10 +199,11 @@ void FilterView::invalidate(Tellico::Data::EntryList entries_) {
     if(!filter) {
       continue;
     }
+    const FilterPlan plan(filter);
     // two cases: if the filter used to match the entry and no longer does, then check the children indexes
     // if the filter matches now, check the actual match
     foreach(Data::EntryPtr entry, entries_) {
-      if(sourceModel()->indexContainsEntry(index, entry) || filter->matches(entry)) {
+      if(sourceModel()->indexContainsEntry(index, entry) || plan.matches(entry)) {
         sourceModel()->invalidate(index);
         break;
       }
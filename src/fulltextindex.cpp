@@ -0,0 +1,194 @@
+/***************************************************************************
+    Copyright (C) 2019 Robby Stephenson <robby@periapsis.org>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "fulltextindex.h"
+#include "utils/string_utils.h"
+
+#include <QAtomicInt>
+
+#include <algorithm>
+#include <iterator>
+
+using Tellico::Data::FullTextIndex;
+
+namespace {
+  // every modification of any index gets a new generation
+  static QAtomicInt s_lastGeneration(0);
+
+  // strings with only ascii characters have no accents to remove
+  bool isAscii(const QString& str) {
+    const QChar* c = str.constData();
+    const QChar* end = c + str.length();
+    for( ; c != end; ++c) {
+      if(c->unicode() > 0x7f) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  QString foldText(const QString& text_) {
+    return isAscii(text_) ? text_.toCaseFolded() : Tellico::removeAccents(text_).toCaseFolded();
+  }
+
+  bool shorterList(const QVector<Tellico::Data::ID>* list1_, const QVector<Tellico::Data::ID>* list2_) {
+    return list1_->count() < list2_->count();
+  }
+}
+
+FullTextIndex::FullTextIndex() : m_generation(++s_lastGeneration) {
+}
+
+void FullTextIndex::addEntry(ID id_, const QStringList& text_) {
+  if(m_entryTrigrams.contains(id_)) {
+    updateEntry(id_, text_);
+    return;
+  }
+  insertEntry(id_, trigrams(text_));
+}
+
+void FullTextIndex::removeEntry(ID id_) {
+  QHash<ID, QVector<Trigram> >::iterator it = m_entryTrigrams.find(id_);
+  if(it == m_entryTrigrams.end()) {
+    return;
+  }
+  foreach(Trigram trigram, it.value()) {
+    QHash<Trigram, QVector<ID> >::iterator postIt = m_postings.find(trigram);
+    if(postIt == m_postings.end()) {
+      continue;
+    }
+    QVector<ID>& ids = postIt.value();
+    QVector<ID>::iterator idIt = std::lower_bound(ids.begin(), ids.end(), id_);
+    if(idIt != ids.end() && *idIt == id_) {
+      ids.erase(idIt);
+    }
+    if(ids.isEmpty()) {
+      m_postings.erase(postIt);
+    }
+  }
+  m_entryTrigrams.erase(it);
+  touch();
+}
+
+void FullTextIndex::updateEntry(ID id_, const QStringList& text_) {
+  const QVector<Trigram> entryTrigrams = trigrams(text_);
+  QHash<ID, QVector<Trigram> >::const_iterator it = m_entryTrigrams.constFind(id_);
+  if(it != m_entryTrigrams.constEnd()) {
+    if(it.value() == entryTrigrams) {
+      return;
+    }
+    removeEntry(id_);
+  }
+  insertEntry(id_, entryTrigrams);
+}
+
+QVector<Tellico::Data::ID> FullTextIndex::candidates(const QString& text_, bool* ok_) const {
+  QVector<Trigram> textTrigrams;
+  addTrigrams(text_, textTrigrams);
+  if(ok_) {
+    *ok_ = !textTrigrams.isEmpty();
+  }
+  if(textTrigrams.isEmpty()) {
+    return QVector<ID>();
+  }
+
+  QList<const QVector<ID>*> postings;
+  foreach(Trigram trigram, textTrigrams) {
+    QHash<Trigram, QVector<ID> >::const_iterator it = m_postings.constFind(trigram);
+    if(it == m_postings.constEnd()) {
+      // no entry has this sequence, so no entry can match
+      return QVector<ID>();
+    }
+    postings << &it.value();
+  }
+
+  // intersecting with the shortest lists first keeps the intermediate results small
+  std::sort(postings.begin(), postings.end(), shorterList);
+  QVector<ID> ids = *postings.first();
+  QVector<ID> result;
+  for(int i = 1; i < postings.count() && !ids.isEmpty(); ++i) {
+    result.clear();
+    std::set_intersection(ids.constBegin(), ids.constEnd(),
+                          postings.at(i)->constBegin(), postings.at(i)->constEnd(),
+                          std::back_inserter(result));
+    ids.swap(result);
+  }
+  return ids;
+}
+
+bool FullTextIndex::canLookup(const QString& text_) {
+  QVector<Trigram> textTrigrams;
+  addTrigrams(text_, textTrigrams);
+  return !textTrigrams.isEmpty();
+}
+
+QVector<FullTextIndex::Trigram> FullTextIndex::trigrams(const QStringList& text_) {
+  QVector<Trigram> result;
+  foreach(const QString& text, text_) {
+    addTrigrams(text, result);
+  }
+  std::sort(result.begin(), result.end());
+  result.erase(std::unique(result.begin(), result.end()), result.end());
+  return result;
+}
+
+void FullTextIndex::addTrigrams(const QString& text_, QVector<Trigram>& trigrams_) {
+  if(text_.length() < 3) {
+    return;
+  }
+  const QString text = foldText(text_);
+  // sequences don't span tokens, so the same is true when looking up text with spaces
+  const QChar* c = text.constData();
+  const QChar* end = c + text.length();
+  while(c != end) {
+    while(c != end && c->isSpace()) {
+      ++c;
+    }
+    const QChar* tokenStart = c;
+    while(c != end && !c->isSpace()) {
+      ++c;
+    }
+    for(const QChar* t = tokenStart; t + 2 < c; ++t) {
+      trigrams_.append((Trigram(t[0].unicode()) << 32) | (Trigram(t[1].unicode()) << 16) | t[2].unicode());
+    }
+  }
+}
+
+void FullTextIndex::insertEntry(ID id_, const QVector<Trigram>& trigrams_) {
+  foreach(Trigram trigram, trigrams_) {
+    QVector<ID>& ids = m_postings[trigram];
+    // entries are usually added in order of their id
+    if(ids.isEmpty() || ids.last() < id_) {
+      ids.append(id_);
+    } else {
+      ids.insert(std::lower_bound(ids.begin(), ids.end(), id_), id_);
+    }
+  }
+  m_entryTrigrams.insert(id_, trigrams_);
+  touch();
+}
+
+void FullTextIndex::touch() {
+  m_generation = ++s_lastGeneration;
+}
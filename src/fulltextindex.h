@@ -0,0 +1,92 @@
+/***************************************************************************
+    Copyright (C) 2019 Robby Stephenson <robby@periapsis.org>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef TELLICO_FULLTEXTINDEX_H
+#define TELLICO_FULLTEXTINDEX_H
+
+#include "datavectors.h"
+
+#include <QHash>
+#include <QVector>
+#include <QStringList>
+
+namespace Tellico {
+  namespace Data {
+
+/**
+ * The FullTextIndex maps the text of every entry in a collection to the entry ids, so that
+ * substring searches don't need to look at every entry. The text is split into tokens, which
+ * are folded to lower case without accents, and every three-character sequence of a token is
+ * posted to the ids of the entries using it. A lookup intersects the postings for the
+ * sequences in the search text, which gives every entry that might contain the text.
+ * The candidates still need to be checked, since the sequences may not be adjacent.
+ *
+ * @author Robby Stephenson
+ */
+class FullTextIndex {
+
+public:
+  FullTextIndex();
+
+  void addEntry(ID id, const QStringList& text);
+  void removeEntry(ID id);
+  void updateEntry(ID id, const QStringList& text);
+  bool hasEntry(ID id) const { return m_entryTrigrams.contains(id); }
+
+  /**
+   * Returns the sorted ids of every entry whose text might contain @p text, ignoring case
+   * and accents. The list may include entries which don't.
+   *
+   * @param ok Set to false when the text is too short to look up, in which case
+   *           every entry needs to be checked
+   */
+  QVector<ID> candidates(const QString& text, bool* ok) const;
+  /**
+   * The generation changes every time the index is modified, and is never shared with
+   * another index, so that any lookup results can be checked for being current.
+   */
+  int generation() const { return m_generation; }
+
+  /**
+   * Returns true if @p text is long enough to be looked up.
+   */
+  static bool canLookup(const QString& text);
+
+private:
+  typedef quint64 Trigram;
+
+  static QVector<Trigram> trigrams(const QStringList& text);
+  static void addTrigrams(const QString& text, QVector<Trigram>& trigrams);
+  void insertEntry(ID id, const QVector<Trigram>& trigrams);
+  void touch();
+
+  QHash<ID, QVector<Trigram> > m_entryTrigrams;
+  QHash<Trigram, QVector<ID> > m_postings;
+  int m_generation;
+};
+
+  } // end namespace
+} // end namespace
+
+#endif
@@ -138,7 +138,7 @@ void FilterRuleWidget::slotRuleFieldChanged(int which_) {
   Data::FieldPtr field = Data::Document::self()->collection()->fieldByTitle(fieldTitle);
   if(field && field->hasFlag(Data::Field::AllowCompletion)) {
     FieldCompletion* completion = new FieldCompletion(field->hasFlag(Data::Field::AllowMultiple));
-    completion->setItems(Kernel::self()->valuesByFieldName(field->name()));
+    completion->setItemCounts(Kernel::self()->valueCountsByFieldName(field->name()));
     completion->setIgnoreCase(true);
     m_ruleValue->setCompletionObject(completion);
     m_ruleValue->setAutoDeleteCompletionObject(true);
@@ -70,6 +70,14 @@ Image::Image(const QByteArray& data_, const QString& format_, const QString& id_
   }
 }
 
+// used for images that have already been decoded elsewhere, and the id is known
+Image::Image(const QImage& img_, const QString& format_, const QString& id_)
+    : QImage(img_), m_id(idClean(id_)), m_format(format_.toLatin1()), m_linkOnly(false) {
+  if(isNull()) {
+    m_id.clear();
+  }
+}
+
 Image::~Image() {
 }
 
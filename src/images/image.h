@@ -75,6 +75,7 @@ private:
   explicit Image(const QString& filename, const QString& id = QString());
   Image(const QImage& image, const QString& format);
   Image(const QByteArray& data, const QString& format, const QString& id);
+  Image(const QImage& image, const QString& format, const QString& id);
 
   void setID(const QString& id);
   void setFormat(const QByteArray& format_) { m_format = format_; }
@@ -33,6 +33,7 @@
 #include <QDir>
 #include <QUrl>
 #include <QTemporaryDir>
+#include <QMutexLocker>
 
 using namespace Tellico;
 using Tellico::ImageStorage;
@@ -155,6 +156,7 @@ ImageZipArchive::~ImageZipArchive() {
 }
 
 void ImageZipArchive::setZip(KZip* zip_) {
+  QMutexLocker locker(&m_mutex);
   m_images.clear();
   delete m_zip;
   m_zip = zip_;
@@ -177,26 +179,25 @@ void ImageZipArchive::setZip(KZip* zip_) {
 }
 
 bool ImageZipArchive::hasImage(const QString& id_) {
+  QMutexLocker locker(&m_mutex);
   return m_images.has(id_);
 }
 
 Tellico::Data::Image* ImageZipArchive::imageById(const QString& id_) {
-  if(!hasImage(id_)) {
-    return nullptr;
+  QByteArray data;
+  {
+    QMutexLocker locker(&m_mutex);
+    if(!m_images.has(id_)) {
+      return nullptr;
+    }
+    data = imageDataImpl(id_);
+    // might be unexpected behavior, but in order to delete the zip object after
+    // all images are read, we need to consider the image gone now
+    releaseImageImpl(id_);
   }
   Data::Image* img = nullptr;
-  const KArchiveEntry* file = m_imgDir->entry(id_);
-  if(file && file->isFile()) {
-    img = new Data::Image(static_cast<const KArchiveFile*>(file)->data(),
-                          id_.section(QLatin1Char('.'), -1).toUpper(), id_);
-  }
-  // might be unexpected behavior, but in order to delete the zip object after
-  // all images are read, we need to consider the image gone now
-  m_images.remove(id_);
-  if(m_images.isEmpty()) {
-    delete m_zip;
-    m_zip = nullptr;
-    m_imgDir = nullptr;
+  if(!data.isEmpty()) {
+    img = new Data::Image(data, id_.section(QLatin1Char('.'), -1).toUpper(), id_);
   }
   if(!img) {
     myLog() << "image not found:" << id_;
@@ -209,3 +210,38 @@ Tellico::Data::Image* ImageZipArchive::imageById(const QString& id_) {
   }
   return img;
 }
+
+QStringList ImageZipArchive::imageIds() {
+  QMutexLocker locker(&m_mutex);
+  return m_images.toList();
+}
+
+QByteArray ImageZipArchive::imageData(const QString& id_) {
+  QMutexLocker locker(&m_mutex);
+  if(!m_images.has(id_)) {
+    return QByteArray();
+  }
+  return imageDataImpl(id_);
+}
+
+void ImageZipArchive::releaseImage(const QString& id_) {
+  QMutexLocker locker(&m_mutex);
+  releaseImageImpl(id_);
+}
+
+QByteArray ImageZipArchive::imageDataImpl(const QString& id_) {
+  const KArchiveEntry* file = m_imgDir ? m_imgDir->entry(id_) : nullptr;
+  if(file && file->isFile()) {
+    return static_cast<const KArchiveFile*>(file)->data();
+  }
+  return QByteArray();
+}
+
+void ImageZipArchive::releaseImageImpl(const QString& id_) {
+  m_images.remove(id_);
+  if(m_images.isEmpty()) {
+    delete m_zip;
+    m_zip = nullptr;
+    m_imgDir = nullptr;
+  }
+}
@@ -28,6 +28,7 @@
 #include "../utils/stringset.h"
 
 #include <QString>
+#include <QMutex>
 
 class QTemporaryDir;
 
@@ -93,7 +94,20 @@ public:
   bool hasImage(const QString& id) Q_DECL_OVERRIDE;
   Data::Image* imageById(const QString& id) Q_DECL_OVERRIDE;
 
+  /**
+   * The remaining functions may be called from worker threads. Reading the data
+   * leaves the image in the archive until it is released.
+   */
+  QStringList imageIds();
+  QByteArray imageData(const QString& id);
+  void releaseImage(const QString& id);
+
 private:
+  QByteArray imageDataImpl(const QString& id);
+  void releaseImageImpl(const QString& id);
+
+  // KZip is not thread-safe
+  QMutex m_mutex;
   KZip* m_zip;
   const KArchiveDirectory* m_imgDir;
   StringSet m_images;
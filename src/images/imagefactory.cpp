@@ -29,6 +29,8 @@
 #include "imageinfo.h"
 #include "imagedirectory.h"
 #include "imagejob.h"
+#include "imageloader.h"
+#include "thumbnailcache.h"
 #include "../config/tellico_config.h"
 #include "../utils/tellico_utils.h"
 #include "../tellico_debug.h"
@@ -38,6 +40,7 @@
 #include <QCache>
 #include <QFileInfo>
 #include <QDir>
+#include <QPointer>
 #ifdef HAVE_QIMAGEBLITZ
 #include <qimageblitz.h>
 #endif
@@ -67,12 +70,19 @@ public:
   TemporaryImageDirectory tempImageDir; // kept in tmp directory
   ImageZipArchive imageZipArchive;
   StringSet nullImages;
+  QPointer<ImageLoader> zipLoader;
+  // declared last so it is deleted first, since its tasks read from the zip archive
+  ThumbnailCache thumbnailCache;
 };
 
 ImageFactory::ImageFactory() : QObject(), d(new Private()) {
+  connect(&d->thumbnailCache, &ThumbnailCache::thumbnailAvailable,
+          this, &ImageFactory::thumbnailAvailable);
 }
 
 ImageFactory::~ImageFactory() {
+  // the loader threads read from the zip archive, so they have to finish first
+  delete d->zipLoader;
   delete d;
 }
 
@@ -566,6 +576,60 @@ QPixmap ImageFactory::pixmap(const QString& id_, int width_, int height_) {
   return *pix;
 }
 
+QPixmap ImageFactory::thumbnail(const QString& id_, int size_, bool* pending_) {
+  Q_ASSERT(factory && "ImageFactory is not initialized!");
+  if(pending_) {
+    *pending_ = false;
+  }
+  if(id_.isEmpty() || !factory || size_ <= 0) {
+    return QPixmap();
+  }
+  ThumbnailCache& cache = factory->d->thumbnailCache;
+  const QPixmap pix = cache.thumbnail(id_, size_);
+  if(!pix.isNull() || cache.hasFailed(id_, size_)) {
+    return pix;
+  }
+
+  if(!cache.isPending(id_, size_)) {
+    // an image already in memory is cheapest to scale, otherwise read straight from
+    // wherever the image data is, without adding the full image to the cache
+    ThumbnailCache::Source source;
+    Data::Image* img = factory->d->imageCache.object(id_);
+    if(!img) {
+      img = factory->d->imageDict.value(id_);
+    }
+    if(img) {
+      source.image = *img;
+    } else {
+      if(factory->d->imageZipArchive.hasImage(id_)) {
+        source.zip = &factory->d->imageZipArchive;
+      }
+      // the zip loader may move the image to the temp dir while the thumbnail is pending
+      if(source.zip || factory->d->tempImageDir.hasImage(id_)) {
+        source.files << factory->d->tempImageDir.path() + id_;
+      }
+      if(factory->d->localImageDir.hasImage(id_)) {
+        source.files << factory->d->localImageDir.path() + id_;
+      }
+      if(factory->d->dataImageDir.hasImage(id_)) {
+        source.files << factory->d->dataImageDir.path() + id_;
+      }
+      const QUrl u(id_);
+      if(u.isValid() && !u.isRelative() && u.isLocalFile()) {
+        source.files << u.toLocalFile();
+      }
+    }
+    if(source.image.isNull() && !source.zip && source.files.isEmpty()) {
+      return QPixmap();
+    }
+    cache.generate(id_, size_, source);
+  }
+  if(pending_) {
+    *pending_ = true;
+  }
+  return QPixmap();
+}
+
 void ImageFactory::clean(bool purgeTempDirectory_) {
   // the caches all auto-delete
   s_imagesToRelease.clear();
@@ -574,6 +638,7 @@ void ImageFactory::clean(bool purgeTempDirectory_) {
   s_imageInfoMap.clear();
   factory->d->imageCache.clear();
   factory->d->pixmapCache.clear();
+  factory->d->thumbnailCache.clear();
   if(purgeTempDirectory_) {
     factory->d->tempImageDir.purge();
     // just to make sure all the image locations clean themselves up
@@ -728,6 +793,20 @@ void ImageFactory::setZipArchive(KZip* zip_) {
   factory->d->imageZipArchive.setZip(zip_);
 }
 
+Tellico::ImageLoader* ImageFactory::loadZipImages(const QAtomicInt* cancel_) {
+  Q_ASSERT(factory && "ImageFactory is not initialized!");
+  // only one loader at a time, otherwise they'd compete for the same images
+  delete factory->d->zipLoader;
+  ImageLoader* loader = new ImageLoader(&factory->d->imageZipArchive, tempDir(), cancel_, factory);
+  connect(loader, SIGNAL(imageLoaded(QString, QImage)),
+          factory, SLOT(slotImageLoaded(QString, QImage)));
+  factory->d->zipLoader = loader;
+  // start once the caller has a chance to connect to finished()
+  QMetaObject::invokeMethod(loader, "start", Qt::QueuedConnection,
+                            Q_ARG(QStringList, factory->d->imageZipArchive.imageIds()));
+  return loader;
+}
+
 void ImageFactory::slotImageJobResult(KJob* job_) {
   ImageJob* imageJob = qobject_cast<ImageJob*>(job_);
   Q_ASSERT(imageJob);
@@ -751,4 +830,24 @@ void ImageFactory::slotImageJobResult(KJob* job_) {
   emit factory->imageAvailable(img.id());
 }
 
+void ImageFactory::slotImageLoaded(const QString& id_, const QImage& image_) {
+  // the image file has already been written to the temp dir, so if someone else
+  // already loaded the image or it doesn't fit in the cache, there's nothing to do
+  if(d->imageCache.contains(id_) || d->imageDict.contains(id_)) {
+    return;
+  }
+  Data::Image* img = new Data::Image(image_, id_.section(QLatin1Char('.'), -1).toUpper(), id_);
+  if(img->isNull()) {
+    delete img;
+    return;
+  }
+  s_imageInfoMap.insert(img->id(), Data::ImageInfo(*img));
+  if(img->byteCount() > d->imageCache.maxCost()) {
+    delete img;
+    return;
+  }
+  // imageCache.insert will delete the image by itself if it fails
+  d->imageCache.insert(img->id(), img, img->byteCount());
+}
+
 #undef RELEASE_IMAGES
@@ -35,6 +35,7 @@
 
 class KZip;
 class KJob;
+class QAtomicInt;
 
 namespace Tellico {
   namespace Data {
@@ -42,6 +43,7 @@ namespace Tellico {
     class ImageInfo;
   }
   class ImageDirectory;
+  class ImageLoader;
 
 class StyleOptions {
 public:
@@ -148,6 +150,17 @@ public:
   static bool validImage(const QString& id);
 
   static QPixmap pixmap(const QString& id, int w, int h);
+  /**
+   * Returns a thumbnail of the image, scaled to fit within @p size, from the on-disk thumbnail cache.
+   * If the thumbnail has to be generated, a null pixmap is returned with @p pending set to true,
+   * and thumbnailAvailable() is emitted once it is ready. A null pixmap without @p pending means
+   * no thumbnail can be made and the full image should be used instead.
+   *
+   * @param id The image id
+   * @param size The maximum width and height
+   * @param pending Set to true if the thumbnail is being generated
+   */
+  static QPixmap thumbnail(const QString& id, int size, bool* pending = nullptr);
 
   /**
    * Clear the image cache and dict
@@ -165,15 +178,25 @@ public:
   static QString localDirectory(const QUrl& url);
   static void setLocalDirectory(const QUrl& url);
   static void setZipArchive(KZip* zip);
+  /**
+   * Starts reading and decoding all the images remaining in the zip archive on
+   * a thread pool. The images are written to the temporary directory and added to the
+   * cache as they finish. The loader is owned by the factory and emits finished() when done.
+   *
+   * @param cancel Loading stops when the value becomes non-zero
+   */
+  static ImageLoader* loadZipImages(const QAtomicInt* cancel);
 
   static ImageFactory* self();
 
 Q_SIGNALS:
   void imageAvailable(const QString& id);
+  void thumbnailAvailable(const QString& id);
   void imageLocationMismatch();
 
 private Q_SLOTS:
   void slotImageJobResult(KJob* job);
+  void slotImageLoaded(const QString& id, const QImage& image);
 
 private:
   /**
@@ -23,6 +23,7 @@
  ***************************************************************************/
 
 #include "imagejob.h"
+#include "../core/fetchtransport.h"
 #include "../tellico_debug.h"
 
 #include <KLocalizedString>
@@ -88,7 +89,8 @@ void ImageJob::slotStart() {
     }
     // non-local valid url
     // KIO::storedGet seems to handle Content-Encoding: gzip ok
-    KIO::StoredTransferJob* getJob = KIO::storedGet(m_url, KIO::NoReload, flags);
+    // and the transport caches the images the same as the fetcher data
+    FetchTransferJob* getJob = FetchTransport::get(m_url, flags);
     QObject::connect(getJob, &KJob::result, this, &ImageJob::getJobResult);
     if(!m_referrer.isEmpty()) {
       getJob->addMetaData(QLatin1String("referrer"), m_referrer.url());
@@ -104,7 +106,7 @@ void ImageJob::getJobResult(KJob* job_) {
     setErrorText(i18n("Tellico is unable to load the image - %1.", m_url.toDisplayString()));
     return;
   }
-  KIO::StoredTransferJob* getJob = qobject_cast<KIO::StoredTransferJob*>(job_);
+  FetchTransferJob* getJob = qobject_cast<FetchTransferJob*>(job_);
   if(getJob) {
     // If we used the Image() c'tor that take a bytearray of data, I'm not sure how to
     // figure out the image format directly. Instead, write into a buffer and use QImageReader
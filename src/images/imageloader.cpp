@@ -0,0 +1,127 @@
+/***************************************************************************
+    Copyright (C) 2018 Robby Stephenson <robby@periapsis.org>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#include "imageloader.h"
+#include "imagedirectory.h"
+#include "../tellico_debug.h"
+
+#include <QRunnable>
+#include <QSaveFile>
+#include <QThread>
+
+using Tellico::ImageLoader;
+
+class ImageLoader::Task : public QRunnable {
+public:
+  Task(ImageLoader* loader, const QString& id) : QRunnable(), m_loader(loader), m_id(id) {}
+
+  virtual void run() Q_DECL_OVERRIDE {
+    QImage img;
+    if(!m_loader->isCancelled()) {
+      // the image is left in the archive until the file is written, so that
+      // ImageFactory::imageById() can always find it in one of the two places
+      const QByteArray data = m_loader->m_zip->imageData(m_id);
+      if(!data.isEmpty()) {
+        QSaveFile file(m_loader->m_tempDir + m_id);
+        if(file.open(QIODevice::WriteOnly) && file.write(data) == data.size()) {
+          file.commit();
+        }
+        m_loader->m_zip->releaseImage(m_id);
+        img = QImage::fromData(data);
+      }
+    }
+    // always report back, even for a null image, so the loader can keep count
+    QMetaObject::invokeMethod(m_loader, "slotImageDecoded", Qt::QueuedConnection,
+                              Q_ARG(QString, m_id), Q_ARG(QImage, img));
+  }
+
+private:
+  ImageLoader* m_loader;
+  const QString m_id;
+};
+
+ImageLoader::ImageLoader(ImageZipArchive* zip_, const QString& tempDir_, const QAtomicInt* cancel_, QObject* parent_)
+    : QObject(parent_), m_zip(zip_), m_tempDir(tempDir_), m_cancel(cancel_), m_stopped(0), m_inFlight(0) {
+  Q_ASSERT(m_zip);
+  // leave a core for the GUI
+  m_pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1));
+  m_maxInFlight = 2 * m_pool.maxThreadCount();
+}
+
+ImageLoader::~ImageLoader() {
+  stop();
+}
+
+void ImageLoader::start(const QStringList& ids_) {
+  if(m_stopped.load()) {
+    return;
+  }
+  m_pending += ids_;
+  startTasks();
+  if(m_inFlight == 0) {
+    emit finished();
+  }
+}
+
+void ImageLoader::stop() {
+  m_stopped = 1;
+  m_pending.clear();
+  m_pool.clear();
+  m_pool.waitForDone();
+}
+
+bool ImageLoader::isCancelled() const {
+  return m_stopped.load() || (m_cancel && m_cancel->load());
+}
+
+void ImageLoader::startTasks() {
+  if(isCancelled()) {
+    m_pending.clear();
+    return;
+  }
+  while(m_inFlight < m_maxInFlight && !m_pending.isEmpty()) {
+    ++m_inFlight;
+    m_pool.start(new Task(this, m_pending.takeFirst()));
+  }
+}
+
+void ImageLoader::slotImageDecoded(const QString& id_, const QImage& image_) {
+  // once stopped, whoever stopped the loader is responsible for cleaning up
+  if(m_stopped.load()) {
+    return;
+  }
+  --m_inFlight;
+  if(!isCancelled()) {
+    if(image_.isNull()) {
+      myDebug() << "Null image:" << id_;
+    } else {
+      emit imageLoaded(id_, image_);
+    }
+  }
+  startTasks();
+  if(m_inFlight == 0 && m_pending.isEmpty()) {
+    emit finished();
+  }
+}
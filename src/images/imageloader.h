@@ -0,0 +1,92 @@
+/***************************************************************************
+    Copyright (C) 2018 Robby Stephenson <robby@periapsis.org>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef TELLICO_IMAGELOADER_H
+#define TELLICO_IMAGELOADER_H
+
+#include <QObject>
+#include <QThreadPool>
+#include <QStringList>
+#include <QAtomicInt>
+#include <QImage>
+
+namespace Tellico {
+  class ImageZipArchive;
+
+/**
+ * Reads images out of the zip archive and decodes them on a thread pool, so that loading
+ * all the images from a large file does not block the GUI. Each image is also written
+ * to the temporary image directory. The number of images in flight is bounded, so
+ * decoded images don't pile up in the event queue faster than the cache takes them.
+ *
+ * @author Robby Stephenson
+ */
+class ImageLoader : public QObject {
+Q_OBJECT
+
+public:
+  /**
+   * @param zip The archive to read from, which must outlive the loader
+   * @param tempDir The directory for writing the image files
+   * @param cancel Loading stops as soon as the value is non-zero
+   */
+  ImageLoader(ImageZipArchive* zip, const QString& tempDir, const QAtomicInt* cancel, QObject* parent = nullptr);
+  virtual ~ImageLoader();
+
+  /**
+   * Waits for any images currently being decoded, without starting any more
+   */
+  void stop();
+  bool isCancelled() const;
+
+public Q_SLOTS:
+  void start(const QStringList& ids);
+
+Q_SIGNALS:
+  void imageLoaded(const QString& id, const QImage& image);
+  void finished();
+
+private Q_SLOTS:
+  void slotImageDecoded(const QString& id, const QImage& image);
+
+private:
+  class Task;
+  friend class Task;
+
+  void startTasks();
+
+  ImageZipArchive* m_zip;
+  const QString m_tempDir;
+  const QAtomicInt* m_cancel;
+  QAtomicInt m_stopped;
+  QThreadPool m_pool;
+  QStringList m_pending;
+  int m_inFlight;
+  int m_maxInFlight;
+};
+
+} // end namespace
+
+#endif
@@ -0,0 +1,319 @@
+/***************************************************************************
+    Copyright (C) 2018 Robby Stephenson <robby@periapsis.org>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#include "thumbnailcache.h"
+#include "imagedirectory.h"
+#include "../config/tellico_config.h"
+#include "../tellico_debug.h"
+
+#include <QRunnable>
+#include <QSaveFile>
+#include <QFile>
+#include <QDir>
+#include <QBuffer>
+#include <QImageReader>
+#include <QStandardPaths>
+#include <QCryptographicHash>
+#include <QThread>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QMultiMap>
+#include <QUrl>
+
+#include <cstring>
+
+using Tellico::ThumbnailCache;
+
+namespace {
+  // the thumbnail file is a fixed header followed by the raw pixels, so it can be mapped
+  // straight into a QImage. The cache is never shared between machines, so byte order is native
+  static const char THUMBNAIL_MAGIC[] = "TLTHUMB1";
+  static const int THUMBNAIL_MAGIC_SIZE = 8;
+  static const int THUMBNAIL_HEADER_SIZE = THUMBNAIL_MAGIC_SIZE + 4*sizeof(qint32);
+  // the default maximum size of all the thumbnail files, 100 MB
+  static const qint64 THUMBNAIL_CACHE_SIZE = 100 * 1024 * 1024;
+  // remote linked images can change without notice, so their thumbnails are made again after a day
+  static const int LINKED_THUMBNAIL_MAX_AGE = 24 * 60 * 60;
+
+  // linked images use the url as the id, rather than a hash of the image data
+  bool isLinkedImage(const QString& id_) {
+    return id_.contains(QLatin1Char('/')) || id_.contains(QLatin1Char('\\')) || id_.contains(QLatin1Char(':'));
+  }
+
+  // returns an image that points into the mapped file, only valid until the file is unmapped
+  QImage mapThumbnail(QFile& file_) {
+    if(!file_.open(QIODevice::ReadOnly) || file_.size() < THUMBNAIL_HEADER_SIZE) {
+      return QImage();
+    }
+    const uchar* data = file_.map(0, file_.size());
+    if(!data || std::memcmp(data, THUMBNAIL_MAGIC, THUMBNAIL_MAGIC_SIZE) != 0) {
+      return QImage();
+    }
+    qint32 header[4];
+    std::memcpy(header, data + THUMBNAIL_MAGIC_SIZE, sizeof(header));
+    const qint32 width = header[0];
+    const qint32 height = header[1];
+    const qint32 bytesPerLine = header[2];
+    const qint32 format = header[3];
+    if(width <= 0 || height <= 0 || bytesPerLine <= 0 ||
+       format <= QImage::Format_Invalid || format >= QImage::NImageFormats ||
+       file_.size() < THUMBNAIL_HEADER_SIZE + qint64(bytesPerLine) * height) {
+      return QImage();
+    }
+    return QImage(data + THUMBNAIL_HEADER_SIZE, width, height, bytesPerLine,
+                  static_cast<QImage::Format>(format));
+  }
+
+  // let the image reader do the scaling, since some formats like JPEG can decode at a smaller size
+  QImage readScaledImage(QIODevice* device_, int size_) {
+    QImageReader reader(device_);
+    const QSize imageSize = reader.size();
+    if(imageSize.isValid() && (imageSize.width() > size_ || imageSize.height() > size_)) {
+      reader.setScaledSize(imageSize.scaled(size_, size_, Qt::KeepAspectRatio));
+    }
+    QImage img = reader.read();
+    if(img.width() > size_ || img.height() > size_) {
+      img = img.scaled(size_, size_, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    }
+    return img;
+  }
+}
+
+class ThumbnailCache::Task : public QRunnable {
+public:
+  Task(ThumbnailCache* cache, const QString& id, int size, const Source& source)
+      : QRunnable(), m_cache(cache), m_id(id), m_size(size), m_source(source) {}
+
+  virtual void run() Q_DECL_OVERRIDE {
+    QImage img;
+    if(!m_source.image.isNull()) {
+      img = m_source.image;
+      if(img.width() > m_size || img.height() > m_size) {
+        img = img.scaled(m_size, m_size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+      }
+    }
+    if(img.isNull() && m_source.zip) {
+      QByteArray data = m_source.zip->imageData(m_id);
+      if(!data.isEmpty()) {
+        QBuffer buffer(&data);
+        img = readScaledImage(&buffer, m_size);
+      }
+    }
+    foreach(const QString& file, m_source.files) {
+      if(!img.isNull()) {
+        break;
+      }
+      QFile f(file);
+      img = readScaledImage(&f, m_size);
+    }
+    if(!img.isNull()) {
+      img = img.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+      writeThumbnail(m_cache->fileName(m_id, m_size), img);
+    }
+    // always report back, so the id is no longer pending
+    QMetaObject::invokeMethod(m_cache, "slotThumbnailDone", Qt::QueuedConnection,
+                              Q_ARG(QString, m_id), Q_ARG(int, m_size), Q_ARG(QImage, img));
+  }
+
+private:
+  ThumbnailCache* m_cache;
+  const QString m_id;
+  const int m_size;
+  const Source m_source;
+};
+
+ThumbnailCache::ThumbnailCache(QObject* parent_) : QObject(parent_)
+    , m_maxCacheSize(THUMBNAIL_CACHE_SIZE), m_cacheSize(0) {
+  setCacheDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QLatin1String("/thumbnails/"));
+  // leave a core for the GUI
+  m_pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1));
+  m_pixmaps.setMaxCost(Config::imageCacheSize());
+  pruneCache();
+}
+
+ThumbnailCache::~ThumbnailCache() {
+  m_pool.clear();
+  m_pool.waitForDone();
+}
+
+QPixmap ThumbnailCache::thumbnail(const QString& id_, int size_) {
+  const QString k = key(id_, size_);
+  QPixmap* pix = m_pixmaps.object(k);
+  if(pix) {
+    return *pix;
+  }
+  if(m_pending.contains(k) || m_failed.contains(k)) {
+    return QPixmap();
+  }
+
+  QFile file(fileName(id_, size_));
+  if(!file.exists()) {
+    return QPixmap();
+  }
+  if(isLinkedImage(id_) && !QUrl(id_).isLocalFile() &&
+     QFileInfo(file).lastModified().secsTo(QDateTime::currentDateTime()) > LINKED_THUMBNAIL_MAX_AGE) {
+    file.remove();
+    return QPixmap();
+  }
+  // the pixmap makes its own copy of the pixels before the file is unmapped
+  const QPixmap pixmap = QPixmap::fromImage(mapThumbnail(file));
+  file.close();
+  if(!pixmap.isNull()) {
+    insertPixmap(k, pixmap);
+  }
+  return pixmap;
+}
+
+bool ThumbnailCache::isPending(const QString& id_, int size_) const {
+  return m_pending.contains(key(id_, size_));
+}
+
+bool ThumbnailCache::hasFailed(const QString& id_, int size_) const {
+  return m_failed.contains(key(id_, size_));
+}
+
+void ThumbnailCache::generate(const QString& id_, int size_, const Source& source_) {
+  const QString k = key(id_, size_);
+  if(m_pending.contains(k)) {
+    return;
+  }
+  m_pending.insert(k);
+  m_pool.start(new Task(this, id_, size_, source_));
+}
+
+void ThumbnailCache::clear() {
+  // any task already running still reports back, which is harmless
+  m_pool.clear();
+  m_pending.clear();
+  m_failed.clear();
+  m_pixmaps.clear();
+}
+
+void ThumbnailCache::setCacheDir(const QString& dir_) {
+  m_dir = dir_;
+  if(!m_dir.endsWith(QLatin1Char('/'))) {
+    m_dir += QLatin1Char('/');
+  }
+  if(!QDir().mkpath(m_dir)) {
+    myWarning() << "Unable to create thumbnail directory:" << m_dir;
+    m_dir.clear();
+  }
+}
+
+void ThumbnailCache::setMaximumCacheSize(qint64 bytes_) {
+  m_maxCacheSize = bytes_;
+  pruneCache();
+}
+
+void ThumbnailCache::pruneCache() {
+  if(m_dir.isEmpty()) {
+    return;
+  }
+  // the time a file was last read is only updated now and then, depending on how
+  // the file system is mounted, but it's close enough to find the least recently used
+  QMultiMap<QDateTime, QFileInfo> filesByUse;
+  qint64 total = 0;
+  foreach(const QFileInfo& info, QDir(m_dir).entryInfoList(QDir::Files)) {
+    filesByUse.insert(qMax(info.lastRead(), info.lastModified()), info);
+    total += info.size();
+  }
+  for(QMultiMap<QDateTime, QFileInfo>::ConstIterator it = filesByUse.constBegin();
+      it != filesByUse.constEnd() && total > m_maxCacheSize; ++it) {
+    if(QFile::remove(it.value().filePath())) {
+      total -= it.value().size();
+    }
+  }
+  m_cacheSize = total;
+}
+
+bool ThumbnailCache::writeThumbnail(const QString& fileName_, const QImage& image_) {
+  if(fileName_.isEmpty() || image_.isNull()) {
+    return false;
+  }
+  QSaveFile file(fileName_);
+  if(!file.open(QIODevice::WriteOnly)) {
+    return false;
+  }
+  const qint32 header[4] = { image_.width(), image_.height(),
+                             image_.bytesPerLine(), image_.format() };
+  file.write(THUMBNAIL_MAGIC, THUMBNAIL_MAGIC_SIZE);
+  file.write(reinterpret_cast<const char*>(header), sizeof(header));
+  file.write(reinterpret_cast<const char*>(image_.constBits()), qint64(image_.bytesPerLine()) * image_.height());
+  return file.commit();
+}
+
+QImage ThumbnailCache::readThumbnail(const QString& fileName_) {
+  QFile file(fileName_);
+  // copy the pixels out of the mapped memory before the file goes away
+  return mapThumbnail(file).copy();
+}
+
+void ThumbnailCache::slotThumbnailDone(const QString& id_, int size_, const QImage& image_) {
+  const QString k = key(id_, size_);
+  if(!m_pending.remove(k)) {
+    // the cache was cleared in the meantime
+    return;
+  }
+  if(image_.isNull()) {
+    myDebug() << "Unable to create thumbnail:" << id_;
+    m_failed.insert(k);
+  } else {
+    insertPixmap(k, QPixmap::fromImage(image_));
+    m_cacheSize += THUMBNAIL_HEADER_SIZE + qint64(image_.bytesPerLine()) * image_.height();
+    if(m_cacheSize > m_maxCacheSize) {
+      pruneCache();
+    }
+  }
+  // even on failure, so the views can fall back to the full image
+  emit thumbnailAvailable(id_);
+}
+
+QString ThumbnailCache::key(const QString& id_, int size_) {
+  return id_ + QLatin1Char('|') + QString::number(size_);
+}
+
+QString ThumbnailCache::fileName(const QString& id_, int size_) const {
+  if(m_dir.isEmpty()) {
+    return QString();
+  }
+  // image ids are normally an md5 hash plus the format, but linked images use the url
+  QString name = id_;
+  if(isLinkedImage(id_)) {
+    QByteArray linkKey = id_.toUtf8();
+    // a linked local file may be changed, so a new modification time means a new thumbnail
+    const QUrl u(id_);
+    if(u.isLocalFile()) {
+      linkKey += QFileInfo(u.toLocalFile()).lastModified().toString(Qt::ISODate).toUtf8();
+    }
+    name = QLatin1String(QCryptographicHash::hash(linkKey, QCryptographicHash::Md5).toHex());
+  }
+  return m_dir + name + QLatin1Char('_') + QString::number(size_);
+}
+
+bool ThumbnailCache::insertPixmap(const QString& key_, const QPixmap& pixmap_) {
+  const int cost = pixmap_.width() * pixmap_.height() * pixmap_.depth() / 8;
+  // QCache::insert deletes the pixmap if it fails
+  return m_pixmaps.insert(key_, new QPixmap(pixmap_), cost);
+}
@@ -0,0 +1,125 @@
+/***************************************************************************
+    Copyright (C) 2018 Robby Stephenson <robby@periapsis.org>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef TELLICO_THUMBNAILCACHE_H
+#define TELLICO_THUMBNAILCACHE_H
+
+#include <QObject>
+#include <QThreadPool>
+#include <QStringList>
+#include <QCache>
+#include <QPixmap>
+#include <QImage>
+#include <QSet>
+
+namespace Tellico {
+  class ImageZipArchive;
+
+/**
+ * Keeps small, pre-scaled copies of images on disk, so that the views don't have to decode
+ * the full-size image every time they show a cover. Thumbnails are keyed by image id and size.
+ * Image ids are normally calculated from the image data, but linked images use the url, so
+ * thumbnails of linked local files are also keyed by the file's modification time, and thumbnails
+ * of linked remote images expire after a day. The least recently used thumbnails are removed once
+ * the cache is bigger than its maximum size.
+ * The thumbnail files hold the raw pixels so they can be memory-mapped rather than decoded.
+ * Missing thumbnails are generated on a thread pool and thumbnailAvailable() is emitted
+ * once they are ready.
+ *
+ * @author Robby Stephenson
+ */
+class ThumbnailCache : public QObject {
+Q_OBJECT
+
+public:
+  /**
+   * The places a thumbnail can be generated from, checked in order
+   */
+  struct Source {
+    Source() : zip(nullptr) {}
+    QImage image;
+    ImageZipArchive* zip;
+    QStringList files;
+  };
+
+  explicit ThumbnailCache(QObject* parent = nullptr);
+  virtual ~ThumbnailCache();
+
+  /**
+   * Returns the thumbnail from memory or from disk, or a null pixmap if it has not been generated
+   */
+  QPixmap thumbnail(const QString& id, int size);
+  bool isPending(const QString& id, int size) const;
+  bool hasFailed(const QString& id, int size) const;
+  /**
+   * Starts generating a thumbnail in the background. The zip archive in the source
+   * must outlive the cache.
+   */
+  void generate(const QString& id, int size, const Source& source);
+  void clear();
+
+  QString cacheDir() const { return m_dir; }
+  void setCacheDir(const QString& dir);
+  qint64 maximumCacheSize() const { return m_maxCacheSize; }
+  /**
+   * Sets the maximum size of the thumbnail files in bytes. Once it's bigger,
+   * the least recently used thumbnails are removed.
+   */
+  void setMaximumCacheSize(qint64 bytes);
+  /**
+   * Removes the least recently used thumbnails until the cache fits the maximum size
+   */
+  void pruneCache();
+
+  static bool writeThumbnail(const QString& fileName, const QImage& image);
+  static QImage readThumbnail(const QString& fileName);
+
+Q_SIGNALS:
+  void thumbnailAvailable(const QString& id);
+
+private Q_SLOTS:
+  void slotThumbnailDone(const QString& id, int size, const QImage& image);
+
+private:
+  class Task;
+  friend class Task;
+
+  static QString key(const QString& id, int size);
+  QString fileName(const QString& id, int size) const;
+  bool insertPixmap(const QString& key, const QPixmap& pixmap);
+
+  QString m_dir;
+  qint64 m_maxCacheSize;
+  // only an estimate between calls to pruneCache()
+  qint64 m_cacheSize;
+  QThreadPool m_pool;
+  QCache<QString, QPixmap> m_pixmaps;
+  QSet<QString> m_pending;
+  QSet<QString> m_failed;
+};
+
+} // end namespace
+
+#endif
@@ -772,6 +772,8 @@ void MainWindow::initView() {
   connect(m_entryView, SIGNAL(signalAction(const QUrl&)),
           SLOT(slotURLAction(const QUrl&)));
   m_entryView->view()->setWhatsThis(i18n("<qt>The <i>Entry View</i> shows a formatted view of the entry's contents.</qt>"));
+  // every change to the document entries goes through the controller, so the rendered html can be cached
+  m_entryView->setUseHtmlCache(true);
 
   setMinimumWidth(MAIN_WINDOW_MIN_WIDTH);
 
@@ -793,6 +795,8 @@ void MainWindow::initConnections() {
           m_editDialog, SLOT(setContents(Tellico::Data::EntryList)));
   connect(proxySelect, SIGNAL(entriesSelected(Tellico::Data::EntryList)),
           m_entryView, SLOT(showEntries(Tellico::Data::EntryList)));
+  connect(proxySelect, SIGNAL(adjacentEntries(Tellico::Data::EntryList)),
+          m_entryView, SLOT(prefetchEntries(Tellico::Data::EntryList)));
 
   // let the group view call filters, too
   connect(m_groupView, SIGNAL(signalUpdateFilter(Tellico::FilterPtr)),
@@ -25,16 +25,24 @@
 #include "entryiconmodel.h"
 #include "models.h"
 #include "../collectionfactory.h"
+#include "../images/imagefactory.h"
 #include "../config/tellico_config.h"
 #include "../tellico_debug.h"
 
 #include <QIcon>
 #include <QPixmap>
 
+namespace {
+  static const int MIN_THUMBNAIL_SIZE = 64;
+  static const int MAX_THUMBNAIL_SIZE = 512;
+}
+
 using Tellico::EntryIconModel;
 
-EntryIconModel::EntryIconModel(QObject* parent_) : QIdentityProxyModel(parent_) {
+EntryIconModel::EntryIconModel(QObject* parent_) : QIdentityProxyModel(parent_)
+    , m_thumbnailSize(MAX_THUMBNAIL_SIZE) {
   m_iconCache.setMaxCost(Config::iconCacheSize());
+  connect(ImageFactory::self(), &ImageFactory::thumbnailAvailable, this, &EntryIconModel::refreshImage);
 }
 
 EntryIconModel::~EntryIconModel() {
@@ -69,12 +77,24 @@ QVariant EntryIconModel::data(const QModelIndex& index_, int role_) const {
         return QIcon(*m_iconCache.object(id));
       }
 
-      QVariant v = QIdentityProxyModel::data(index_, PrimaryImageRole);
-      if(v.isNull() || !v.canConvert<QPixmap>()) {
-        return defaultIcon(entry->collection());
+      // prefer a thumbnail, which avoids decoding the full image
+      bool pending = false;
+      QPixmap p = ImageFactory::thumbnail(id, m_thumbnailSize, &pending);
+      if(p.isNull()) {
+        if(pending) {
+          const QPersistentModelIndex pIndex(index_);
+          if(!m_pendingIndexes.contains(id, pIndex)) {
+            m_pendingIndexes.insert(id, pIndex);
+          }
+          return defaultIcon(entry->collection());
+        }
+        QVariant v = QIdentityProxyModel::data(index_, PrimaryImageRole);
+        if(v.isNull() || !v.canConvert<QPixmap>()) {
+          return defaultIcon(entry->collection());
+        }
+        p = v.value<QPixmap>();
       }
 
-      const QPixmap p = v.value<QPixmap>();
       QIcon* icon = new QIcon(p);
       if(!m_iconCache.insert(id, icon)) {
         // failing to insert invalidates the icon pointer
@@ -88,8 +108,32 @@ QVariant EntryIconModel::data(const QModelIndex& index_, int role_) const {
   return QIdentityProxyModel::data(index_, role_);
 }
 
+void EntryIconModel::setIconSize(int size_) {
+  int size = MIN_THUMBNAIL_SIZE;
+  while(size < size_ && size < MAX_THUMBNAIL_SIZE) {
+    size *= 2;
+  }
+  if(size != m_thumbnailSize) {
+    m_thumbnailSize = size;
+    clearCache();
+  }
+}
+
 void EntryIconModel::clearCache() {
   m_iconCache.clear();
+  m_pendingIndexes.clear();
+}
+
+void EntryIconModel::refreshImage(const QString& id_) {
+  QMultiHash<QString, QPersistentModelIndex>::iterator i = m_pendingIndexes.find(id_);
+  while(i != m_pendingIndexes.end() && i.key() == id_) {
+    const QModelIndex index = i.value();
+    if(index.isValid()) {
+      emit dataChanged(index, index, QVector<int>() << Qt::DecorationRole);
+    }
+    ++i;
+  }
+  m_pendingIndexes.remove(id_);
 }
 
 const QIcon& EntryIconModel::defaultIcon(Data::CollPtr coll_) const {
@@ -30,6 +30,7 @@
 #include <QIdentityProxyModel>
 #include <QHash>
 #include <QCache>
+#include <QPersistentModelIndex>
 
 namespace Tellico {
 
@@ -48,15 +49,26 @@ public:
 
   void setSourceModel(QAbstractItemModel* newSourceModel) Q_DECL_OVERRIDE;
   QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const Q_DECL_OVERRIDE;
+  /**
+   * Sets the size of the icons, which is rounded up to one of a few thumbnail sizes
+   * so that resizing the view doesn't keep generating new thumbnails
+   */
+  void setIconSize(int size);
 
 public Q_SLOTS:
   void clearCache();
 
+private Q_SLOTS:
+  void refreshImage(const QString& id);
+
 private:
   const QIcon& defaultIcon(Data::CollPtr coll) const;
 
   mutable QHash<int, QIcon*> m_defaultIcons;
   mutable QCache<QString, QIcon> m_iconCache;
+  int m_thumbnailSize;
+  // maps ids of pending thumbnails into the indexes showing them
+  mutable QMultiHash<QString, QPersistentModelIndex> m_pendingIndexes;
 };
 
 } // end namespace
@@ -43,6 +43,7 @@ EntryModel::EntryModel(QObject* parent) : QAbstractItemModel(parent),
     m_imagesAreAvailable(false) {
   m_checkPix = QIcon::fromTheme(QLatin1String("checkmark"), QIcon(QLatin1String(":/icons/checkmark")));
   connect(ImageFactory::self(), &ImageFactory::imageAvailable, this, &EntryModel::refreshImage);
+  connect(ImageFactory::self(), &ImageFactory::thumbnailAvailable, this, &EntryModel::refreshImage);
 }
 
 EntryModel::~EntryModel() {
@@ -140,8 +141,8 @@ QVariant EntryModel::data(const QModelIndex& index_, int role_) const {
       }
 
       if(field->type() == Data::Field::Image) {
-        // convert pixmap to icon
-        QVariant v = requestImage(entry, value);
+        // convert pixmap to icon, the column only ever shows a small image
+        QVariant v = requestImage(entry, value, ENTRYMODEL_IMAGE_HEIGHT);
         if(!v.isNull() && v.canConvert<QPixmap>()) {
           return QIcon(v.value<QPixmap>());
         }
@@ -362,12 +363,26 @@ void EntryModel::setImagesAreAvailable(bool available_) {
   }
 }
 
-QVariant EntryModel::requestImage(Data::EntryPtr entry_, const QString& id_) const {
+QVariant EntryModel::requestImage(Data::EntryPtr entry_, const QString& id_, int size_) const {
   if(!m_imagesAreAvailable) {
     return QVariant();
   }
   // if it's not a local image, request that it be downloaded
   if(ImageFactory::hasLocalImage(id_)) {
+    if(size_ > 0) {
+      bool pending = false;
+      const QPixmap pix = ImageFactory::thumbnail(id_, size_, &pending);
+      if(!pix.isNull()) {
+        return pix;
+      }
+      if(pending) {
+        // refreshed once the thumbnail is done, rather than decoding the full image now
+        if(!m_requestedImages.contains(id_, entry_)) {
+          m_requestedImages.insert(id_, entry_);
+        }
+        return QVariant();
+      }
+    }
     const Data::Image& img = ImageFactory::imageById(id_);
     if(!img.isNull()) {
       return img.convertToPixmap();
@@ -383,7 +398,10 @@ void EntryModel::refreshImage(const QString& id_) {
   QMultiHash<QString, Data::EntryPtr>::iterator i = m_requestedImages.find(id_);
   while(i != m_requestedImages.end() && i.key() == id_) {
     QModelIndex index = indexFromEntry(i.value());
-    emit dataChanged(index, index);
+    if(index.isValid()) {
+      // the image could be in any column
+      emit dataChanged(index, index.sibling(index.row(), columnCount() - 1));
+    }
     ++i;
   }
   m_requestedImages.remove(id_);
@@ -75,7 +75,10 @@ private Q_SLOTS:
 private:
   Data::EntryPtr entry(const QModelIndex& index) const;
   Data::FieldPtr field(const QModelIndex& index) const;
-  QVariant requestImage(Data::EntryPtr entry, const QString& id) const;
+  /**
+   * Returns the image as a pixmap, or a thumbnail no bigger than @p size if it is positive
+   */
+  QVariant requestImage(Data::EntryPtr entry, const QString& id, int size = 0) const;
 
   Data::EntryList m_entries;
   Data::FieldList m_fields;
@@ -85,6 +85,26 @@ void EntrySelectionModel::selectedEntriesChanged(const QItemSelection& selected_
   }
 
   emit entriesSelected(m_selectedEntries);
+  if(m_selectedEntries.count() == 1) {
+    // the current index is in the sorted model of the view, so its siblings are the next entries to be shown
+    const QModelIndex current = selectionModel->currentIndex();
+    if(current.data(EntryPtrRole).value<Data::EntryPtr>() == m_selectedEntries.first()) {
+      Data::EntryList adjacent;
+      const QModelIndex prev = current.sibling(current.row()-1, current.column());
+      const QModelIndex next = current.sibling(current.row()+1, current.column());
+      Data::EntryPtr entry = next.data(EntryPtrRole).value<Data::EntryPtr>();
+      if(entry) {
+        adjacent += entry;
+      }
+      entry = prev.data(EntryPtrRole).value<Data::EntryPtr>();
+      if(entry) {
+        adjacent += entry;
+      }
+      if(!adjacent.isEmpty()) {
+        emit adjacentEntries(adjacent);
+      }
+    }
+  }
   // for every selection model which did not call this function, clear the selection
   foreach(const QPointer<QItemSelectionModel>& ptr, m_modelList) { //krazy:exclude=foreach
     QItemSelectionModel* const otherModel = ptr.data();
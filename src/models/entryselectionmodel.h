@@ -49,6 +49,11 @@ public:
 
 Q_SIGNALS:
   void entriesSelected(Tellico::Data::EntryList entries);
+  /**
+   * Emitted with the entries before and after a single selected entry,
+   * in the order of the view which made the selection.
+   */
+  void adjacentEntries(Tellico::Data::EntryList entries);
 
 private Q_SLOTS:
   void selectedEntriesChanged(const QItemSelection& selected, const QItemSelection& deselected);
@@ -39,6 +39,7 @@ EntrySortModel::EntrySortModel(QObject* parent) : AbstractSortModel(parent) {
 void EntrySortModel::setFilter(Tellico::FilterPtr filter_) {
   if(m_filter != filter_ || (m_filter && *m_filter != *filter_)) {
     m_filter = filter_;
+    m_filterPlan = FilterPlan(m_filter);
     invalidateFilter();
   }
 }
@@ -48,14 +49,14 @@ Tellico::FilterPtr EntrySortModel::filter() const {
 }
 
 bool EntrySortModel::filterAcceptsRow(int row_, const QModelIndex& parent_) const {
-  if(!m_filter) {
+  if(m_filterPlan.isEmpty()) {
     return true;
   }
   QModelIndex index = sourceModel()->index(row_, 0, parent_);
   Q_ASSERT(index.isValid());
   Data::EntryPtr entry = index.data(EntryPtrRole).value<Data::EntryPtr>();
   Q_ASSERT(entry);
-  return m_filter->matches(entry);
+  return m_filterPlan.matches(entry);
 }
 
 bool EntrySortModel::lessThan(const QModelIndex& left_, const QModelIndex& right_) const {
@@ -58,6 +58,7 @@ private:
   FieldComparison* getComparison(const QModelIndex& index) const;
 
   FilterPtr m_filter;
+  FilterPlan m_filterPlan;
   mutable QHash<int, FieldComparison*> m_comparisons;
 };
 
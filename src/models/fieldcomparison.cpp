@@ -26,6 +26,7 @@
 #include "stringcomparison.h"
 #include "../field.h"
 #include "../collection.h"
+#include "../entry.h"
 #include "../document.h"
 #include "../images/imagefactory.h"
 #include "../images/image.h"
@@ -55,7 +56,9 @@ int Tellico::FieldComparison::compare(Data::EntryPtr entry1_, Data::EntryPtr ent
 
 Tellico::ValueComparison::ValueComparison(Data::FieldPtr field, StringComparison* comp)
     : FieldComparison(field)
-    , m_stringComparison(comp) {
+    , m_stringComparison(comp)
+    // derived values depend on other fields, so the cached key can't be invalidated properly
+    , m_useCache(!field->hasFlag(Data::Field::Derived)) {
   Q_ASSERT(comp);
 }
 
@@ -63,10 +66,27 @@ Tellico::ValueComparison::~ValueComparison() {
   delete m_stringComparison;
 }
 
+int Tellico::ValueComparison::compare(Data::EntryPtr entry1_, Data::EntryPtr entry2_) {
+  if(!m_useCache) {
+    return FieldComparison::compare(entry1_, entry2_);
+  }
+  return m_stringComparison->compareKeys(sortKey(entry1_), sortKey(entry2_));
+}
+
 int Tellico::ValueComparison::compare(const QString& str1_, const QString& str2_) {
   return m_stringComparison->compare(str1_, str2_);
 }
 
+QVariant Tellico::ValueComparison::sortKey(Data::EntryPtr entry_) {
+  const QString fieldName = field()->name();
+  QVariant key = entry_->sortKey(fieldName);
+  if(!key.isValid()) {
+    key = m_stringComparison->sortKey(entry_->formattedField(field()));
+    entry_->setSortKey(fieldName, key);
+  }
+  return key;
+}
+
 Tellico::ImageComparison::ImageComparison(Data::FieldPtr field) : FieldComparison(field) {
 }
 
@@ -28,6 +28,7 @@
 #include "../datavectors.h"
 
 #include <QStringList>
+#include <QVariant>
 
 namespace Tellico {
 
@@ -56,13 +57,19 @@ public:
   ValueComparison(Data::FieldPtr field, StringComparison* comp);
   ~ValueComparison();
 
-  using FieldComparison::compare;
+  /**
+   * Compares the sort keys cached in each entry, computing them the first time
+   */
+  virtual int compare(Data::EntryPtr entry1, Data::EntryPtr entry2) Q_DECL_OVERRIDE;
 
 protected:
   virtual int compare(const QString& str1, const QString& str2) Q_DECL_OVERRIDE;
 
 private:
+  QVariant sortKey(Data::EntryPtr entry);
+
   StringComparison* m_stringComparison;
+  const bool m_useCache;
 };
 
 class ImageComparison : public FieldComparison {
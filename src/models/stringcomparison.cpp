@@ -27,8 +27,15 @@
 #include "../tellico_debug.h"
 
 #include <QDateTime>
+#include <QVector>
+
+#include <limits>
 
 namespace {
+  // julian days are never this small, so empty values and invalid dates sort before any date
+  static const qint64 EMPTY_DATE_KEY = std::numeric_limits<qint64>::min();
+  static const qint64 INVALID_DATE_KEY = EMPTY_DATE_KEY + 1;
+
   int compareFloat(const QString& s1, const QString& s2) {
     bool ok1, ok2;
     float n1 = s1.toFloat(&ok1);
@@ -41,6 +48,45 @@ namespace {
     }
     return n1 > n2 ? 1 : (n1 < n2 ? -1 : 0);
   }
+
+  // the numeric key is the list of leading values that can be parsed as numbers
+  QVector<double> numberKey(const QString& str) {
+    QVector<double> key;
+    foreach(const QString& value, Tellico::FieldFormat::splitValue(str)) {
+      bool ok;
+      const double num = value.toDouble(&ok);
+      if(!ok) {
+        break;
+      }
+      key.append(num);
+    }
+    return key;
+  }
+
+  int compareNumberKeys(const QVector<double>& key1, const QVector<double>& key2) {
+    const int count = qMin(key1.count(), key2.count());
+    for(int i = 0; i < count; ++i) {
+      const double num1 = key1.at(i);
+      const double num2 = key2.at(i);
+      if(!qFuzzyCompare(num1, num2)) {
+        const double ret = num1 - num2;
+        // if abs(ret) < 0.5, we want to round up/down to -1 or 1
+        // so that comparing 0.2 to 0.4 yields 1, for example, and not 0
+        return ret < 0 ? qMin(-1, qRound(ret)) : qMax(1, qRound(ret));
+      }
+    }
+    return key1.count() > count ? 1 : (key2.count() > count ? -1 : 0);
+  }
+}
+
+int Tellico::CollatorSortKey::compare(const CollatorSortKey& other_) const {
+  if(!m_key) {
+    return other_.m_key ? -1 : 0;
+  }
+  if(!other_.m_key) {
+    return 1;
+  }
+  return m_key->compare(*other_.m_key);
 }
 
 Tellico::StringComparison* Tellico::StringComparison::create(Data::FieldPtr field_) {
@@ -68,7 +114,15 @@ Tellico::StringComparison::StringComparison() {
 }
 
 int Tellico::StringComparison::compare(const QString& str1_, const QString& str2_) {
-  return str1_.localeAwareCompare(str2_);
+  return m_collator.compare(str1_, str2_);
+}
+
+QVariant Tellico::StringComparison::sortKey(const QString& str_) {
+  return QVariant::fromValue(CollatorSortKey(m_collator.sortKey(str_)));
+}
+
+int Tellico::StringComparison::compareKeys(const QVariant& key1_, const QVariant& key2_) {
+  return key1_.value<CollatorSortKey>().compare(key2_.value<CollatorSortKey>());
 }
 
 Tellico::BoolComparison::BoolComparison() : StringComparison() {
@@ -78,49 +132,40 @@ int Tellico::BoolComparison::compare(const QString& str1_, const QString& str2_)
   return str1_.compare(str2_);
 }
 
+QVariant Tellico::BoolComparison::sortKey(const QString& str_) {
+  return str_;
+}
+
+int Tellico::BoolComparison::compareKeys(const QVariant& key1_, const QVariant& key2_) {
+  return compare(key1_.toString(), key2_.toString());
+}
+
 Tellico::TitleComparison::TitleComparison() : StringComparison() {
 }
 
 int Tellico::TitleComparison::compare(const QString& str1_, const QString& str2_) {
   const QString title1 = FieldFormat::sortKeyTitle(str1_).toLower();
   const QString title2 = FieldFormat::sortKeyTitle(str2_).toLower();
-  return title1.localeAwareCompare(title2);
+  return m_collator.compare(title1, title2);
+}
+
+QVariant Tellico::TitleComparison::sortKey(const QString& str_) {
+  return StringComparison::sortKey(FieldFormat::sortKeyTitle(str_).toLower());
 }
 
 Tellico::NumberComparison::NumberComparison() : StringComparison() {
 }
 
 int Tellico::NumberComparison::compare(const QString& str1_, const QString& str2_) {
-  bool ok1, ok2;
-  float num1 = 0, num2 = 0;
-
-  const QStringList values1 = FieldFormat::splitValue(str1_);
-  const QStringList values2 = FieldFormat::splitValue(str2_);
-  int index = 0;
-  do {
-    if((ok1 = index < values1.count())) {
-      num1 = values1.at(index).toFloat(&ok1);
-    }
-    if((ok2 = index < values2.count())) {
-      num2 = values2.at(index).toFloat(&ok2);
-    }
-    if(ok1 && ok2) {
-      if(!qFuzzyCompare(num1, num2)) {
-        const float ret = num1 - num2;
-        // if abs(ret) < 0.5, we want to round up/down to -1 or 1
-        // so that comparing 0.2 to 0.4 yields 1, for example, and not 0
-        return ret < 0 ? qMin(-1, qRound(ret)) : qMax(1, qRound(ret));
-      }
-    }
-    ++index;
-  } while(ok1 && ok2);
+  return compareNumberKeys(numberKey(str1_), numberKey(str2_));
+}
 
-  if(ok1 && !ok2) {
-    return 1;
-  } else if(!ok1 && ok2) {
-    return -1;
-  }
-  return 0;
+QVariant Tellico::NumberComparison::sortKey(const QString& str_) {
+  return QVariant::fromValue(numberKey(str_));
+}
+
+int Tellico::NumberComparison::compareKeys(const QVariant& key1_, const QVariant& key2_) {
+  return compareNumberKeys(key1_.value<QVector<double> >(), key2_.value<QVector<double> >());
 }
 
 // for details on the LCC comparison, see
@@ -158,6 +203,15 @@ int Tellico::LCCComparison::compare(const QString& str1_, const QString& str2_)
   return StringComparison::compare(str1_, str2_);
 }
 
+// the regexp captures are cheap enough compared to everything else, so just keep the string
+QVariant Tellico::LCCComparison::sortKey(const QString& str_) {
+  return str_;
+}
+
+int Tellico::LCCComparison::compareKeys(const QVariant& key1_, const QVariant& key2_) {
+  return compare(key1_.toString(), key2_.toString());
+}
+
 int Tellico::LCCComparison::compareLCC(const QStringList& cap1, const QStringList& cap2) const {
   // the first item in the list is the full match, so start array index at 1
   int res = 0;
@@ -182,44 +236,49 @@ int Tellico::ISODateComparison::compare(const QString& str1, const QString& str2
   if(str2.isEmpty()) { // str1 is not
     return 1;
   }
+  const QDate date1 = toDate(str1);
+  const QDate date2 = toDate(str2);
+  if(date1 < date2) {
+    return -1;
+  } else if(date1 > date2) {
+    return 1;
+  }
+  return 0;
+}
+
+// the key is the julian day, with empty strings sorting first, then invalid dates.
+// the key for an empty string has to be valid, too, or it would never be cached
+QVariant Tellico::ISODateComparison::sortKey(const QString& str_) {
+  if(str_.isEmpty()) {
+    return QVariant(EMPTY_DATE_KEY);
+  }
+  const QDate date = toDate(str_);
+  return QVariant(date.isValid() ? date.toJulianDay() : INVALID_DATE_KEY);
+}
+
+int Tellico::ISODateComparison::compareKeys(const QVariant& key1_, const QVariant& key2_) {
+  const qint64 jd1 = key1_.toLongLong();
+  const qint64 jd2 = key2_.toLongLong();
+  return jd1 < jd2 ? -1 : (jd1 > jd2 ? 1 : 0);
+}
+
+QDate Tellico::ISODateComparison::toDate(const QString& str_) {
   // modelled after Field::formatDate()
   // so dates would sort as expected without padding month and day with zero
   // and accounting for "current year - 1 - 1" default scheme
-  QStringList dlist1 = str1.split(QLatin1Char('-'), QString::KeepEmptyParts);
+  QStringList dlist = str_.split(QLatin1Char('-'), QString::KeepEmptyParts);
   bool ok = true;
-  int y1 = dlist1.count() > 0 ? dlist1[0].toInt(&ok) : QDate::currentDate().year();
-  if(!ok) {
-    y1 = QDate::currentDate().year();
-  }
-  int m1 = dlist1.count() > 1 ? dlist1[1].toInt(&ok) : 1;
-  if(!ok) {
-    m1 = 1;
-  }
-  int d1 = dlist1.count() > 2 ? dlist1[2].toInt(&ok) : 1;
-  if(!ok) {
-    d1 = 1;
-  }
-  QDate date1(y1, m1, d1);
-
-  QStringList dlist2 = str2.split(QLatin1Char('-'), QString::KeepEmptyParts);
-  int y2 = dlist2.count() > 0 ? dlist2[0].toInt(&ok) : QDate::currentDate().year();
+  int y = dlist.count() > 0 ? dlist[0].toInt(&ok) : QDate::currentDate().year();
   if(!ok) {
-    y2 = QDate::currentDate().year();
+    y = QDate::currentDate().year();
   }
-  int m2 = dlist2.count() > 1 ? dlist2[1].toInt(&ok) : 1;
+  int m = dlist.count() > 1 ? dlist[1].toInt(&ok) : 1;
   if(!ok) {
-    m2 = 1;
+    m = 1;
   }
-  int d2 = dlist2.count() > 2 ? dlist2[2].toInt(&ok) : 1;
+  int d = dlist.count() > 2 ? dlist[2].toInt(&ok) : 1;
   if(!ok) {
-    d2 = 1;
+    d = 1;
   }
-  QDate date2(y2, m2, d2);
-
-  if(date1 < date2) {
-    return -1;
-  } else if(date1 > date2) {
-    return 1;
-  }
-  return 0;
+  return QDate(y, m, d);
 }
@@ -26,42 +26,76 @@
 #define TELLICO_STRINGCOMPARISON_H
 
 #include <QRegExp>
+#include <QCollator>
+#include <QVariant>
+#include <QSharedPointer>
 
 #include "../datavectors.h"
 
 namespace Tellico {
 
+/**
+ * QCollatorSortKey has no default constructor, so it can't be stored in a QVariant directly
+ */
+class CollatorSortKey {
+public:
+  CollatorSortKey() {}
+  explicit CollatorSortKey(const QCollatorSortKey& key) : m_key(new QCollatorSortKey(key)) {}
+
+  int compare(const CollatorSortKey& other) const;
+
+private:
+  QSharedPointer<QCollatorSortKey> m_key;
+};
+
 class StringComparison {
 public:
   StringComparison();
   virtual ~StringComparison() {}
   virtual int compare(const QString& str1, const QString& str2);
 
+  /**
+   * Returns a key for the string which can be cached and later compared with
+   * compareKeys(), giving the same result as compare() on the original strings.
+   */
+  virtual QVariant sortKey(const QString& str);
+  virtual int compareKeys(const QVariant& key1, const QVariant& key2);
+
   static StringComparison* create(Data::FieldPtr field);
+
+protected:
+  QCollator m_collator;
 };
 
 class BoolComparison : public StringComparison {
 public:
   BoolComparison();
   virtual int compare(const QString& str1, const QString& str2) Q_DECL_OVERRIDE;
+  virtual QVariant sortKey(const QString& str) Q_DECL_OVERRIDE;
+  virtual int compareKeys(const QVariant& key1, const QVariant& key2) Q_DECL_OVERRIDE;
 };
 
 class TitleComparison : public StringComparison {
 public:
   TitleComparison();
   virtual int compare(const QString& str1, const QString& str2) Q_DECL_OVERRIDE;
+  virtual QVariant sortKey(const QString& str) Q_DECL_OVERRIDE;
 };
 
 class NumberComparison : public StringComparison {
 public:
   NumberComparison();
   virtual int compare(const QString& str1, const QString& str2) Q_DECL_OVERRIDE;
+  virtual QVariant sortKey(const QString& str) Q_DECL_OVERRIDE;
+  virtual int compareKeys(const QVariant& key1, const QVariant& key2) Q_DECL_OVERRIDE;
 };
 
 class LCCComparison : public StringComparison {
 public:
   LCCComparison();
   virtual int compare(const QString& str1, const QString& str2) Q_DECL_OVERRIDE;
+  virtual QVariant sortKey(const QString& str) Q_DECL_OVERRIDE;
+  virtual int compareKeys(const QVariant& key1, const QVariant& key2) Q_DECL_OVERRIDE;
 
 private:
   int compareLCC(const QStringList& cap1, const QStringList& cap2) const;
@@ -72,7 +106,15 @@ class ISODateComparison : public StringComparison {
 public:
   ISODateComparison();
   virtual int compare(const QString& str1, const QString& str2) Q_DECL_OVERRIDE;
+  virtual QVariant sortKey(const QString& str) Q_DECL_OVERRIDE;
+  virtual int compareKeys(const QVariant& key1, const QVariant& key2) Q_DECL_OVERRIDE;
+
+private:
+  static QDate toDate(const QString& str);
 };
 
 }
+
+Q_DECLARE_METATYPE(Tellico::CollatorSortKey)
+
 #endif
@@ -43,6 +43,8 @@
 #include "collectionfactory.h"
 #include "utils/stringset.h"
 #include "utils/cursorsaver.h"
+#include "config/tellico_config.h"
+#include "tellico_debug.h"
 
 #include <KMessageBox>
 #include <KLocalizedString>
@@ -53,8 +55,56 @@
 using Tellico::Kernel;
 Kernel* Kernel::s_self = nullptr;
 
+/**
+ * Every undo step holds its commands in a group, so the steps can be moved to a new history
+ * when the oldest ones get dropped. QUndoStack has no way to remove a command without deleting it.
+ */
+class Kernel::CommandGroup : public QUndoCommand {
+public:
+  CommandGroup() : QUndoCommand(), m_byteCount(0), m_skipRedo(false) {}
+  // the commands have already been done, so the first redo() is skipped
+  CommandGroup(const QList<QUndoCommand*>& commands_, qint64 byteCount_)
+      : QUndoCommand(), m_commands(commands_), m_byteCount(byteCount_), m_skipRedo(true) {}
+  ~CommandGroup() { qDeleteAll(m_commands); }
+
+  virtual void redo() Q_DECL_OVERRIDE {
+    if(m_skipRedo) {
+      m_skipRedo = false;
+      return;
+    }
+    foreach(QUndoCommand* command, m_commands) {
+      command->redo();
+    }
+  }
+  virtual void undo() Q_DECL_OVERRIDE {
+    for(int i = m_commands.count() - 1; i >= 0; --i) {
+      m_commands.at(i)->undo();
+    }
+  }
+
+  // the command must already be done, so the size of its saved values is known
+  void append(QUndoCommand* command_) {
+    m_commands.append(command_);
+    m_byteCount += Command::ModifyEntries::byteCount(command_);
+  }
+  QList<QUndoCommand*> takeCommands() {
+    QList<QUndoCommand*> commands;
+    commands.swap(m_commands);
+    return commands;
+  }
+  qint64 byteCount() const { return m_byteCount; }
+
+private:
+  QList<QUndoCommand*> m_commands;
+  qint64 m_byteCount;
+  bool m_skipRedo;
+};
+
 Kernel::Kernel(Tellico::MainWindow* parent) : m_widget(parent)
-    , m_commandHistory(new QUndoStack(parent)) {
+    , m_commandHistory(new QUndoStack(parent))
+    , m_commandGroupDepth(0)
+    , m_commandGroup(nullptr)
+    , m_historyBytes(0) {
 }
 
 Kernel::~Kernel() {
@@ -80,6 +130,10 @@ QStringList Kernel::valuesByFieldName(const QString& name_) const {
   return Data::Document::self()->collection()->valuesByFieldName(name_);
 }
 
+QHash<QString, int> Kernel::valueCountsByFieldName(const QString& name_) const {
+  return Data::Document::self()->collection()->valueCountsByFieldName(name_);
+}
+
 int Kernel::collectionType() const {
   return Data::Document::self()->collection() ?
          Data::Document::self()->collection()->type() :
@@ -99,16 +153,33 @@ void Kernel::sorry(const QString& text_, QWidget* widget_/* =0 */) {
 }
 
 void Kernel::beginCommandGroup(const QString& name_) {
-  m_commandHistory->beginMacro(name_);
+  if(m_commandGroupDepth == 0) {
+    // starting the macro deletes any undone steps
+    for(int i = m_commandHistory->index(); i < m_commandHistory->count(); ++i) {
+      m_historyBytes -= commandGroup(m_commandHistory->command(i))->byteCount();
+    }
+    // the macro keeps the undo stack from being used while the group is recorded
+    m_commandHistory->beginMacro(name_);
+    m_commandGroup = new CommandGroup();
+    m_commandHistory->push(m_commandGroup);
+  }
+  ++m_commandGroupDepth;
 }
 
 void Kernel::endCommandGroup() {
-  m_commandHistory->endMacro();
+  --m_commandGroupDepth;
+  if(m_commandGroupDepth == 0) {
+    m_commandHistory->endMacro();
+    m_historyBytes += m_commandGroup->byteCount();
+    m_commandGroup = nullptr;
+    checkHistoryMemory();
+  }
 }
 
 void Kernel::resetHistory() {
   m_commandHistory->clear();
   m_commandHistory->setClean();
+  m_historyBytes = 0;
 }
 
 bool Kernel::addField(Tellico::Data::FieldPtr field_) {
@@ -326,7 +397,78 @@ void Kernel::renameCollection() {
 }
 
 void Kernel::doCommand(QUndoCommand* command_) {
-  m_commandHistory->push(command_);
+  if(m_commandGroupDepth == 0) {
+    // every undo step is a group, even for a single command
+    beginCommandGroup(command_->text());
+    doCommand(command_);
+    endCommandGroup();
+    return;
+  }
+  command_->redo();
+  m_commandGroup->append(command_);
+}
+
+void Kernel::checkHistoryMemory() {
+  // the history can't be changed in the middle of a command group
+  if(m_commandGroupDepth > 0 || m_historyBytes <= Config::undoMemoryLimit()) {
+    return;
+  }
+  // this is only called right after a step is recorded, so there are no undone steps.
+  // Keep the newest steps that fit, but always the last one
+  const int count = m_commandHistory->count();
+  int first = count - 1;
+  qint64 keptBytes = commandGroup(m_commandHistory->command(first))->byteCount();
+  while(first > 0) {
+    const qint64 bytes = commandGroup(m_commandHistory->command(first - 1))->byteCount();
+    if(keptBytes + bytes > Config::undoMemoryLimit()) {
+      break;
+    }
+    keptBytes += bytes;
+    --first;
+  }
+  if(first == 0) {
+    return;
+  }
+  myLog() << "Undo history uses" << m_historyBytes << "bytes, dropping the oldest" << first << "steps";
+
+  // QUndoStack can't drop just the oldest commands, so the newer ones are moved to a new history
+  QStringList texts;
+  QList<QList<QUndoCommand*> > commands;
+  QList<qint64> byteCounts;
+  for(int i = first; i < count; ++i) {
+    const QUndoCommand* step = m_commandHistory->command(i);
+    CommandGroup* group = commandGroup(step);
+    texts << step->text();
+    byteCounts << group->byteCount();
+    commands << group->takeCommands();
+  }
+  const int cleanIndex = m_commandHistory->cleanIndex();
+  m_commandHistory->clear();
+  for(int i = 0; i < commands.count(); ++i) {
+    m_commandHistory->beginMacro(texts.at(i));
+    m_commandHistory->push(new CommandGroup(commands.at(i), byteCounts.at(i)));
+    m_commandHistory->endMacro();
+    if(first + i + 1 == cleanIndex) {
+      m_commandHistory->setClean();
+    }
+  }
+  m_historyBytes = keptBytes;
+  // clearing the stack also marks it clean, which would hide unsaved changes
+  // if the saved state was in the dropped steps
+  if(cleanIndex < first) {
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 8, 0))
+    // so that undoing later commands never makes the document look unmodified
+    m_commandHistory->resetClean();
+#else
+    Data::Document::self()->slotSetModified(true);
+#endif
+  }
+}
+
+Kernel::CommandGroup* Kernel::commandGroup(const QUndoCommand* command_) {
+  // every step in the history is a macro holding a single group
+  Q_ASSERT(command_->childCount() == 1);
+  return const_cast<CommandGroup*>(static_cast<const CommandGroup*>(command_->child(0)));
 }
 
 int Kernel::askAndMerge(Tellico::Data::EntryPtr entry1_, Tellico::Data::EntryPtr entry2_, Tellico::Data::FieldPtr field_,
@@ -88,6 +88,7 @@ public:
    */
   QString fieldTitleByName(const QString& name) const;
   QStringList valuesByFieldName(const QString& name) const;
+  QHash<QString, int> valueCountsByFieldName(const QString& name) const;
 
   int collectionType() const;
   QString collectionTypeName() const;
@@ -128,6 +129,7 @@ public:
                   QString value1 = QString(), QString value2 = QString());
 
 private:
+  class CommandGroup;
   static Kernel* s_self;
 
   // all constructors are private
@@ -137,9 +139,19 @@ private:
   ~Kernel();
 
   void doCommand(QUndoCommand* command);
+  /**
+   * Drops the oldest undo steps if the saved values take more memory than allowed
+   */
+  void checkHistoryMemory();
+  static CommandGroup* commandGroup(const QUndoCommand* command);
 
   QWidget* m_widget;
   QUndoStack* m_commandHistory;
+  int m_commandGroupDepth;
+  // the group of the undo step being recorded, if any
+  CommandGroup* m_commandGroup;
+  // the memory used by every undo step in the history
+  qint64 m_historyBytes;
 };
 
 } // end namespace
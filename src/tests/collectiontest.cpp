@@ -29,8 +29,11 @@
 #include "../collection.h"
 #include "../field.h"
 #include "../entry.h"
+#include "../entrygroup.h"
+#include "../entrycomparison.h"
 #include "../collectionfactory.h"
 #include "../collections/collectioninitializer.h"
+#include "../collections/bookcollection.h"
 #include "../translators/tellicoxmlexporter.h"
 #include "../translators/tellicoimporter.h"
 #include "../images/imagefactory.h"
@@ -303,6 +306,109 @@ void CollectionTest::testDerived() {
 
   field->setProperty(QLatin1String("template"), QLatin1String("%{author:-2}"));
   QCOMPARE(entry->field(QLatin1String("test")), QLatin1String("Albert Einstein"));
+
+  // the derived values are cached, so check that changing a source field updates
+  // the derived value as well as any derived value that depends on it
+  field->setProperty(QLatin1String("template"), QLatin1String("%{author:1}"));
+  QCOMPARE(entry->field(QLatin1String("test")), QLatin1String("Albert Einstein"));
+  QCOMPARE(entry->field(QLatin1String("test2")), QLatin1String("Albert Einstein"));
+  entry->setField(QLatin1String("author"), QLatin1String("Niels Bohr; Albert Einstein"));
+  QCOMPARE(entry->field(QLatin1String("test")), QLatin1String("Niels Bohr"));
+  QCOMPARE(entry->field(QLatin1String("test2")), QLatin1String("Niels Bohr"));
+  QCOMPARE(entry->formattedField(QLatin1String("test"), Tellico::FieldFormat::ForceFormat), QLatin1String("Bohr, Niels"));
+
+  // changing the template directly changes which fields the derived values depend on
+  field->setProperty(QLatin1String("template"), QLatin1String("%{title}"));
+  QCOMPARE(coll->derivedFieldsUsing(QLatin1String("title")), QStringList() << QLatin1String("test") << QLatin1String("test2"));
+  QVERIFY(coll->derivedFieldsUsing(QLatin1String("author")).isEmpty());
+  entry->setField(QLatin1String("title"), QLatin1String("Relativity"));
+  QCOMPARE(entry->field(QLatin1String("test")), QLatin1String("Relativity"));
+  QCOMPARE(entry->field(QLatin1String("test2")), QLatin1String("Relativity"));
+  entry->setField(QLatin1String("title"), QLatin1String("Quantum Theory"));
+  QCOMPARE(entry->field(QLatin1String("test")), QLatin1String("Quantum Theory"));
+  QCOMPARE(entry->field(QLatin1String("test2")), QLatin1String("Quantum Theory"));
+}
+
+void CollectionTest::testGroups() {
+  Tellico::Data::CollPtr coll(new Tellico::Data::BookCollection(true));
+  coll->setTrackGroups(true);
+
+  Tellico::Data::EntryPtr entry1(new Tellico::Data::Entry(coll));
+  entry1->setField(QLatin1String("author"), QLatin1String("Weber; Ringo"));
+  entry1->setField(QLatin1String("publisher"), QLatin1String("Publisher"));
+  Tellico::Data::EntryPtr entry2(new Tellico::Data::Entry(coll));
+  entry2->setField(QLatin1String("author"), QLatin1String("Ringo"));
+  coll->addEntries(Tellico::Data::EntryList() << entry1 << entry2);
+
+  Tellico::Data::EntryGroupDict* dict = coll->entryGroupDictByName(QLatin1String("author"));
+  QVERIFY(dict);
+  QCOMPARE(dict->count(), 2);
+  Tellico::Data::EntryGroup* group2 = dict->value(QLatin1String("Ringo"));
+  QVERIFY(group2);
+  QCOMPARE(group2->count(), 2);
+
+  entry1->setField(QLatin1String("author"), QLatin1String("Ringo; Sanderson"));
+  coll->updateDicts(Tellico::Data::EntryList() << entry1, QStringList() << QLatin1String("author"));
+  // the unchanged group is the same object and still has both entries
+  QCOMPARE(dict->count(), 2);
+  QCOMPARE(dict->value(QLatin1String("Ringo")), group2);
+  QCOMPARE(group2->count(), 2);
+  QVERIFY(!dict->contains(QLatin1String("Weber")));
+  QVERIFY(dict->contains(QLatin1String("Sanderson")));
+  QCOMPARE(entry1->groups().count(), 2);
+
+  // modifying the format type only resets that one dict
+  Tellico::Data::EntryGroupDict* pubDict = coll->entryGroupDictByName(QLatin1String("publisher"));
+  QVERIFY(pubDict);
+  QCOMPARE(pubDict->count(), 2);
+  Tellico::Data::FieldPtr authorField(new Tellico::Data::Field(*coll->fieldByName(QLatin1String("author"))));
+  authorField->setFormatType(Tellico::FieldFormat::FormatPlain);
+  coll->modifyField(authorField);
+  QVERIFY(dict->isEmpty());
+  QCOMPARE(pubDict->count(), 2);
+  QCOMPARE(entry1->groups().count(), 1);
+  QCOMPARE(coll->entryGroupDictByName(QLatin1String("author"))->count(), 2);
+  QCOMPARE(entry1->groups().count(), 3);
+}
+
+void CollectionTest::testValues() {
+  Tellico::Data::CollPtr coll(new Tellico::Data::BookCollection(true));
+  const QString keyword = QLatin1String("keyword");
+
+  Tellico::Data::EntryPtr entry1(new Tellico::Data::Entry(coll));
+  entry1->setField(keyword, QLatin1String("one; two"));
+  Tellico::Data::EntryPtr entry2(new Tellico::Data::Entry(coll));
+  entry2->setField(keyword, QLatin1String("two; three; two"));
+  coll->addEntries(Tellico::Data::EntryList() << entry1 << entry2);
+
+  QStringList values = coll->valuesByFieldName(keyword);
+  values.sort();
+  QCOMPARE(values, QStringList() << QLatin1String("one") << QLatin1String("three") << QLatin1String("two"));
+  QHash<QString, int> counts = coll->valueCountsByFieldName(keyword);
+  QCOMPARE(counts.count(), 3);
+  QCOMPARE(counts.value(QLatin1String("one")), 1);
+  // a repeated value only counts once per entry
+  QCOMPARE(counts.value(QLatin1String("two")), 2);
+
+  // the index is kept current as entries are added, modified, and removed
+  Tellico::Data::EntryPtr entry3(new Tellico::Data::Entry(coll));
+  entry3->setField(keyword, QLatin1String("two"));
+  coll->addEntries(Tellico::Data::EntryList() << entry3);
+  QCOMPARE(coll->valueCountsByFieldName(keyword).value(QLatin1String("two")), 3);
+
+  entry1->setField(keyword, QLatin1String("four"));
+  coll->updateDicts(Tellico::Data::EntryList() << entry1, QStringList() << keyword);
+  counts = coll->valueCountsByFieldName(keyword);
+  QVERIFY(!counts.contains(QLatin1String("one")));
+  QCOMPARE(counts.value(QLatin1String("two")), 2);
+  QCOMPARE(counts.value(QLatin1String("four")), 1);
+
+  coll->removeEntries(Tellico::Data::EntryList() << entry2);
+  counts = coll->valueCountsByFieldName(keyword);
+  QVERIFY(!counts.contains(QLatin1String("three")));
+  QCOMPARE(counts.value(QLatin1String("two")), 1);
+
+  QVERIFY(coll->valuesByFieldName(QLatin1String("nonexistent")).isEmpty());
 }
 
 void CollectionTest::testValue() {
@@ -588,6 +694,69 @@ void CollectionTest::testMergeCollection() {
   QCOMPARE(coll1->entryCount(), coll2->entryCount());
 }
 
+void CollectionTest::testMergeAuthorOnly() {
+  Tellico::Data::CollPtr coll1(new Tellico::Data::BookCollection(true));
+  Tellico::Data::EntryPtr entry1(new Tellico::Data::Entry(coll1));
+  entry1->setField(QLatin1String("title"), QLatin1String("The Hobbit"));
+  entry1->setField(QLatin1String("author"), QLatin1String("J. R. R. Tolkien"));
+  coll1->addEntries(entry1);
+
+  Tellico::Data::CollPtr coll2(new Tellico::Data::BookCollection(true));
+  Tellico::Data::EntryPtr entry2(new Tellico::Data::Entry(coll2));
+  entry2->setField(QLatin1String("title"), QLatin1String("Hobbit, or There and Back Again"));
+  entry2->setField(QLatin1String("author"), QLatin1String("J. R. R. Tolkien"));
+  coll2->addEntries(entry2);
+
+  // the entries share no title key, but the author alone is a good match for books
+  QVERIFY(coll1->sameEntry(entry1, entry2) >= Tellico::EntryComparison::ENTRY_GOOD_MATCH);
+
+  Tellico::Data::MergePair mergePair = Tellico::Data::Document::mergeCollection(coll1, coll2);
+  QVERIFY(mergePair.first.isEmpty());
+  QCOMPARE(coll1->entryCount(), 1);
+}
+
+void CollectionTest::testMergeUnkeyed() {
+  Tellico::Data::CollPtr coll1(new Tellico::Data::Collection(false));
+  Tellico::Data::CollPtr coll2(new Tellico::Data::Collection(false));
+  foreach(Tellico::Data::CollPtr coll, Tellico::Data::CollList() << coll1 << coll2) {
+    coll->addField(Tellico::Data::Field::createDefaultField(Tellico::Data::Field::TitleField));
+    foreach(const QString& name, QStringList() << QLatin1String("a") << QLatin1String("b")
+                                               << QLatin1String("c") << QLatin1String("d")) {
+      coll->addField(Tellico::Data::FieldPtr(new Tellico::Data::Field(name, name)));
+    }
+  }
+
+  // the first entry shares the title key, but the second one has no key at all and is a better match
+  Tellico::Data::EntryPtr entry1(new Tellico::Data::Entry(coll1));
+  entry1->setField(QLatin1String("title"), QLatin1String("Title"));
+  Tellico::Data::EntryPtr entry2(new Tellico::Data::Entry(coll1));
+  entry2->setField(QLatin1String("a"), QLatin1String("1"));
+  entry2->setField(QLatin1String("b"), QLatin1String("2"));
+  entry2->setField(QLatin1String("c"), QLatin1String("3"));
+  entry2->setField(QLatin1String("d"), QLatin1String("4"));
+  coll1->addEntries(Tellico::Data::EntryList() << entry1 << entry2);
+  QVERIFY(Tellico::EntryComparison::matchKeys(entry2).isEmpty());
+
+  Tellico::Data::EntryPtr entry3(new Tellico::Data::Entry(coll2));
+  entry3->setField(QLatin1String("title"), QLatin1String("Title"));
+  entry3->setField(QLatin1String("a"), QLatin1String("1"));
+  entry3->setField(QLatin1String("b"), QLatin1String("2"));
+  entry3->setField(QLatin1String("c"), QLatin1String("3"));
+  entry3->setField(QLatin1String("d"), QLatin1String("4"));
+  coll2->addEntries(entry3);
+
+  const int match1 = coll1->sameEntry(entry1, entry3);
+  QVERIFY(match1 >= Tellico::EntryComparison::ENTRY_GOOD_MATCH);
+  QVERIFY(match1 < Tellico::EntryComparison::ENTRY_PERFECT_MATCH);
+  QVERIFY(coll1->sameEntry(entry2, entry3) >= Tellico::EntryComparison::ENTRY_PERFECT_MATCH);
+
+  Tellico::Data::MergePair mergePair = Tellico::Data::Document::mergeCollection(coll1, coll2);
+  QVERIFY(mergePair.first.isEmpty());
+  QCOMPARE(coll1->entryCount(), 2);
+  QCOMPARE(entry2->field(QLatin1String("title")), QLatin1String("Title"));
+  QVERIFY(entry1->field(QLatin1String("a")).isEmpty());
+}
+
 void CollectionTest::testMergeBenchmark() {
   QUrl url = QUrl::fromLocalFile(QFINDTESTDATA("data/movies-many.tc"));
 
@@ -608,3 +777,44 @@ void CollectionTest::testMergeBenchmark() {
     Tellico::Data::Document::mergeCollection(coll1, coll2);
   }
 }
+
+void CollectionTest::testMergeLargeBenchmark() {
+  const int total = 50000;
+  Tellico::Data::CollPtr coll1(new Tellico::Data::BookCollection(true));
+  Tellico::Data::CollPtr coll2(new Tellico::Data::BookCollection(true));
+
+  // the second collection overlaps the first one by half, and half of the
+  // overlapping entries only match by isbn
+  Tellico::Data::EntryList entries1, entries2;
+  for(int i = 0; i < total; ++i) {
+    Tellico::Data::EntryPtr entry1(new Tellico::Data::Entry(coll1));
+    entry1->setField(QLatin1String("title"), QString::fromLatin1("The Title %1").arg(i));
+    entry1->setField(QLatin1String("author"), QString::fromLatin1("Author %1").arg(i));
+    entry1->setField(QLatin1String("pub_year"), QString::number(1900 + i % 100));
+    entries1 << entry1;
+
+    const int j = i + total/2;
+    Tellico::Data::EntryPtr entry2(new Tellico::Data::Entry(coll2));
+    entry2->setField(QLatin1String("title"), QString::fromLatin1("The Title %1").arg(j));
+    entry2->setField(QLatin1String("author"), QString::fromLatin1("Author %1").arg(j));
+    entry2->setField(QLatin1String("pub_year"), QString::number(1900 + j % 100));
+    entries2 << entry2;
+  }
+  for(int i = 0; i < total; i += 2) {
+    const QString isbn = QString::fromLatin1("0-%1-X").arg(i, 8, 10, QLatin1Char('0'));
+    entries1.at(i)->setField(QLatin1String("isbn"), isbn);
+    if(i >= total/2) {
+      entries2.at(i - total/2)->setField(QLatin1String("title"), QString::fromLatin1("Different Title %1").arg(i));
+      entries2.at(i - total/2)->setField(QLatin1String("isbn"), isbn);
+    }
+  }
+  coll1->addEntries(entries1);
+  coll2->addEntries(entries2);
+
+  Tellico::Data::MergePair mergePair;
+  QBENCHMARK_ONCE {
+    mergePair = Tellico::Data::Document::mergeCollection(coll1, coll2);
+  }
+  QCOMPARE(mergePair.first.count(), total/2);
+  QCOMPARE(coll1->entryCount(), total + total/2);
+}
@@ -38,6 +38,8 @@ private Q_SLOTS:
   void testCollection();
   void testFields();
   void testDerived();
+  void testGroups();
+  void testValues();
   void testValue();
   void testValue_data();
   void testDtd();
@@ -46,7 +48,10 @@ private Q_SLOTS:
   void testMergeFields();
   void testAppendCollection();
   void testMergeCollection();
+  void testMergeAuthorOnly();
+  void testMergeUnkeyed();
   void testMergeBenchmark();
+  void testMergeLargeBenchmark();
 };
 
 #endif
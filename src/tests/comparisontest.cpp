@@ -39,6 +39,8 @@ void ComparisonTest::testNumber() {
   Tellico::NumberComparison comp;
 
   QCOMPARE(comp.compare(string1, string2), res);
+  // the cached sort keys must compare the same way
+  QCOMPARE(comp.compareKeys(comp.sortKey(string1), comp.sortKey(string2)), res);
 }
 
 void ComparisonTest::testNumber_data() {
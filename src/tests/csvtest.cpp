@@ -28,6 +28,8 @@
 #include "../translators/csvexporter.h"
 
 #include <QTest>
+#include <QBuffer>
+#include <QTextCodec>
 
 QTEST_MAIN( CsvTest )
 
@@ -86,3 +88,53 @@ void CsvTest::testEntry() {
   output.chop(1);
   QCOMPARE(output, QLatin1String("\"title, with comma\""));
 }
+
+void CsvTest::testDevice() {
+  // enough rows to need several chunks from the device
+  QByteArray data("title,author\n");
+  for(int i = 0; i < 5000; ++i) {
+    data += "\"Title, " + QByteArray::number(i) + "\",Author " + QByteArray::number(i) + '\n';
+  }
+  // the last row has a quoted newline and no newline at the end
+  data += "last,\"multi\nline\"";
+
+  QBuffer buffer(&data);
+  QVERIFY(buffer.open(QIODevice::ReadOnly));
+  Tellico::CSVParser p(&buffer);
+  p.setDelimiter(QL1(","));
+  p.skipLine();
+
+  int rows = 0;
+  QStringList tokens;
+  while(p.hasNext()) {
+    tokens = p.nextTokens();
+    if(rows == 1234) {
+      QCOMPARE(tokens, QStringList() << QL1("Title, 1234") << QL1("Author 1234"));
+    }
+    ++rows;
+  }
+  QCOMPARE(rows, 5001);
+  QCOMPARE(tokens, QStringList() << QL1("last") << QL1("multi\nline"));
+  QCOMPARE(p.pos(), qint64(data.size()));
+
+  // reading again starts from the beginning
+  p.reset(&buffer);
+  QVERIFY(p.hasNext());
+  QCOMPARE(p.nextTokens(), QStringList() << QL1("title") << QL1("author"));
+}
+
+void CsvTest::testDeviceUtf16() {
+  QTextCodec* codec = QTextCodec::codecForName("UTF-16LE");
+  QVERIFY(codec);
+  QByteArray data("\xFF\xFE", 2);
+  data += codec->fromUnicode(QString::fromUtf8("caf\xC3\xA9,na\xC3\xAFve\n"));
+
+  QBuffer buffer(&data);
+  QVERIFY(buffer.open(QIODevice::ReadOnly));
+  Tellico::CSVParser p(&buffer);
+  p.setDelimiter(QL1(","));
+
+  QVERIFY(p.hasNext());
+  QCOMPARE(p.nextTokens(), QStringList() << QString::fromUtf8("caf\xC3\xA9") << QString::fromUtf8("na\xC3\xAFve"));
+  QVERIFY(!p.hasNext());
+}
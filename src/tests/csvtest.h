@@ -37,6 +37,8 @@ private Q_SLOTS:
   void testAll();
   void testAll_data();
   void testEntry();
+  void testDevice();
+  void testDeviceUtf16();
 };
 
 #endif
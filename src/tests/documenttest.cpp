@@ -26,6 +26,8 @@
 
 #include "documenttest.h"
 #include "../document.h"
+#include "../entry.h"
+#include "../field.h"
 #include "../images/imagefactory.h"
 #include "../images/image.h"
 #include "../config/tellico_config.h"
@@ -139,3 +141,54 @@ void DocumentTest::testImageLocalDirectory() {
   tempDir.remove();
   QVERIFY(!QDir(tempDirName).exists());
 }
+
+void DocumentTest::testAppendUndo() {
+  Tellico::Data::Document* doc = Tellico::Data::Document::self();
+  QVERIFY(doc->newDocument(Tellico::Data::Collection::Book));
+  Tellico::Data::CollPtr coll = doc->collection();
+  QVERIFY(coll);
+  Tellico::Data::EntryPtr entry(new Tellico::Data::Entry(coll));
+  entry->setField(QLatin1String("title"), QLatin1String("Original"));
+  coll->addEntries(entry);
+  QCOMPARE(coll->entryCount(), 1);
+
+  Tellico::Data::FieldList origFields;
+  foreach(Tellico::Data::FieldPtr field, coll->fields()) {
+    origFields.append(Tellico::Data::FieldPtr(new Tellico::Data::Field(*field)));
+  }
+
+  Tellico::Data::CollPtr coll2(new Tellico::Data::BookCollection(true));
+  coll2->addField(Tellico::Data::FieldPtr(new Tellico::Data::Field(QLatin1String("test"), QLatin1String("Test"))));
+  Tellico::Data::EntryList newEntries;
+  for(int i = 0; i < 3; ++i) {
+    Tellico::Data::EntryPtr newEntry(new Tellico::Data::Entry(coll2));
+    newEntry->setField(QLatin1String("title"), QString::number(i));
+    newEntry->setField(QLatin1String("test"), QLatin1String("value"));
+    newEntries << newEntry;
+  }
+  coll2->addEntries(newEntries);
+
+  // the entries are moved, not copied, and get consecutive ids
+  const Tellico::Data::ID firstId = doc->appendCollection(coll2);
+  QCOMPARE(coll->entryCount(), 4);
+  QVERIFY(coll->hasField(QLatin1String("test")));
+  for(int i = 0; i < newEntries.count(); ++i) {
+    QCOMPARE(coll->entryById(firstId + i), newEntries.at(i));
+    QCOMPARE(newEntries.at(i)->collection(), coll);
+    QCOMPARE(newEntries.at(i)->field(QLatin1String("test")), QLatin1String("value"));
+  }
+  QVERIFY(coll->entryById(entry->id()) == entry);
+
+  doc->unAppendCollection(coll2, origFields, firstId);
+  QCOMPARE(coll->entryCount(), 1);
+  QCOMPARE(coll->entries().at(0), entry);
+  QVERIFY(!coll->hasField(QLatin1String("test")));
+  foreach(Tellico::Data::EntryPtr newEntry, newEntries) {
+    QCOMPARE(newEntry->collection(), coll2);
+    QCOMPARE(newEntry->field(QLatin1String("test")), QLatin1String("value"));
+  }
+
+  // and redo the append
+  doc->appendCollection(coll2);
+  QCOMPARE(coll->entryCount(), 4);
+}
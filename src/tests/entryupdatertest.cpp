@@ -0,0 +1,235 @@
+/***************************************************************************
+    Copyright (C) 2019 Robby Stephenson <robby@periapsis.org>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "entryupdatertest.h"
+
+#include "../entryupdater.h"
+#include "../entrymatchdialog.h"
+#include "../tellico_kernel.h"
+#include "../document.h"
+#include "../entry.h"
+#include "../collections/bookcollection.h"
+#include "../collectionfactory.h"
+#include "../fetch/fetchmanager.h"
+#include "../gui/statusbar.h"
+
+#include <KSharedConfig>
+#include <KConfigGroup>
+
+#include <QTest>
+#include <QTimer>
+#include <QPointer>
+#include <QSet>
+#include <QStandardPaths>
+
+QTEST_MAIN( EntryUpdaterTest )
+
+namespace {
+  // the updates the kernel was asked to make, in order
+  QList<QPair<Tellico::Data::EntryPtr, Tellico::Data::EntryPtr> > s_updates;
+  int s_commandGroups = 0;
+  int s_matchDialogs = 0;
+
+  Tellico::Fetch::Fetcher::Ptr createFakeFetcher(QObject* parent_) {
+    return Tellico::Fetch::Fetcher::Ptr(new Tellico::Fetch::FakeUpdateFetcher(parent_));
+  }
+  QString fakeFetcherName() {
+    return QLatin1String("Fake Source");
+  }
+  QString fakeFetcherIcon() {
+    return QString();
+  }
+  Tellico::StringHash fakeFetcherFields() {
+    return Tellico::StringHash();
+  }
+  Tellico::Fetch::ConfigWidget* fakeFetcherConfigWidget(QWidget*) {
+    return nullptr;
+  }
+}
+
+// the kernel and the match dialog need the main window, so the updater gets simple versions of them
+Tellico::Kernel* Tellico::Kernel::s_self = nullptr;
+
+Tellico::Kernel::Kernel(Tellico::MainWindow*) : m_widget(nullptr), m_commandHistory(nullptr), m_commandGroupDepth(0)
+    , m_commandGroup(nullptr), m_historyBytes(0) {
+}
+
+Tellico::Kernel::~Kernel() {
+}
+
+void Tellico::Kernel::beginCommandGroup(const QString&) {
+  ++s_commandGroups;
+}
+
+void Tellico::Kernel::endCommandGroup() {
+  --s_commandGroups;
+}
+
+void Tellico::Kernel::updateEntry(Tellico::Data::EntryPtr oldEntry_, Tellico::Data::EntryPtr newEntry_, bool) {
+  s_updates << qMakePair(oldEntry_, newEntry_);
+}
+
+Tellico::EntryMatchDialog::EntryMatchDialog(QWidget* parent_, Tellico::Data::EntryPtr, Tellico::Fetch::Fetcher::Ptr,
+                                            const Tellico::EntryUpdater::ResultList&)
+    : QDialog(parent_), m_treeWidget(nullptr), m_entryView(nullptr) {
+  ++s_matchDialogs;
+}
+
+Tellico::EntryUpdater::UpdateResult Tellico::EntryMatchDialog::updateResult() const {
+  return EntryUpdater::UpdateResult(nullptr, false);
+}
+
+void Tellico::EntryMatchDialog::slotShowEntry() {
+}
+
+using Tellico::Fetch::FakeUpdateFetcher;
+
+int FakeUpdateFetcher::s_running = 0;
+int FakeUpdateFetcher::s_maxRunning = 0;
+
+FakeUpdateFetcher::FakeUpdateFetcher(QObject* parent_) : Fetcher(parent_), m_searching(false) {
+}
+
+bool FakeUpdateFetcher::canFetch(int type_) const {
+  return type_ == Data::Collection::Book;
+}
+
+bool FakeUpdateFetcher::canSearch(FetchKey key_) const {
+  return key_ == Title;
+}
+
+Tellico::Fetch::Type FakeUpdateFetcher::type() const {
+  // no other fetchers are registered in the test, so any type will do
+  return Amazon;
+}
+
+QString FakeUpdateFetcher::source() const {
+  return m_name.isEmpty() ? fakeFetcherName() : m_name;
+}
+
+Tellico::Fetch::FetchRequest FakeUpdateFetcher::updateRequest(Data::EntryPtr entry_) {
+  m_updateEntry = entry_;
+  return FetchRequest(Title, entry_->title());
+}
+
+void FakeUpdateFetcher::search() {
+  m_searching = true;
+  ++s_running;
+  s_maxRunning = qMax(s_maxRunning, s_running);
+  QTimer::singleShot(700, this, SLOT(slotFinish()));
+}
+
+void FakeUpdateFetcher::stop() {
+  if(!m_searching) {
+    return;
+  }
+  m_searching = false;
+  --s_running;
+  emit signalDone(this);
+}
+
+void FakeUpdateFetcher::slotFinish() {
+  if(!m_searching) {
+    return;
+  }
+  Data::CollPtr coll(new Data::BookCollection(true));
+  Data::EntryPtr entry(new Data::Entry(coll));
+  entry->setField(QLatin1String("title"), m_updateEntry->field(QLatin1String("title")));
+  entry->setField(QLatin1String("author"), m_updateEntry->field(QLatin1String("author")));
+  entry->setField(QLatin1String("publisher"), QLatin1String("Fake Publisher"));
+  coll->addEntries(entry);
+
+  FetchResult* r = new FetchResult(Fetcher::Ptr(this), entry);
+  m_entries.insert(r->uid, entry);
+  emit signalResultFound(r);
+  // a perfect match stops the search right away
+  stop();
+}
+
+Tellico::Data::EntryPtr FakeUpdateFetcher::fetchEntryHook(uint uid_) {
+  return m_entries.value(uid_);
+}
+
+void EntryUpdaterTest::initTestCase() {
+  QStandardPaths::setTestModeEnabled(true);
+  Tellico::RegisterCollection<Tellico::Data::BookCollection> registerBook(Tellico::Data::Collection::Book, "book");
+
+  Tellico::Fetch::Manager::FetcherFunction f;
+  f.create = createFakeFetcher;
+  f.name = fakeFetcherName;
+  f.icon = fakeFetcherIcon;
+  f.optionalFields = fakeFetcherFields;
+  f.configWidget = fakeFetcherConfigWidget;
+  Tellico::Fetch::Manager::self()->registerFunction(Tellico::Fetch::Amazon, f);
+
+  KSharedConfigPtr config = KSharedConfig::openConfig();
+  KConfigGroup sourcesGroup(config, QLatin1String("Data Sources"));
+  sourcesGroup.writeEntry("Sources Count", 1);
+  KConfigGroup sourceGroup(config, QLatin1String("Data Source 0"));
+  sourceGroup.writeEntry("Type", int(Tellico::Fetch::Amazon));
+  sourceGroup.writeEntry("Name", fakeFetcherName());
+
+  Tellico::Kernel::init(nullptr);
+  // the updater shows its status in the status bar
+  new Tellico::StatusBar(nullptr);
+}
+
+void EntryUpdaterTest::testPipelinedUpdate() {
+  // more entries than a single batch, so the matches get applied more than once
+  const int total = 25;
+  Tellico::Data::CollPtr coll = Tellico::Data::Document::self()->collection();
+  QVERIFY(coll);
+  Tellico::Data::EntryList entries;
+  for(int i = 0; i < total; ++i) {
+    Tellico::Data::EntryPtr entry(new Tellico::Data::Entry(coll));
+    entry->setField(QLatin1String("title"), QString::fromLatin1("Title %1").arg(i));
+    entry->setField(QLatin1String("author"), QString::fromLatin1("Author %1").arg(i));
+    entries << entry;
+  }
+  coll->addEntries(entries);
+
+  QPointer<Tellico::EntryUpdater> updater = new Tellico::EntryUpdater(coll, entries, nullptr);
+  QCOMPARE(s_commandGroups, 1);
+  // the requests to the same source are spaced out, so this takes a while
+  QTRY_VERIFY_WITH_TIMEOUT(updater.isNull(), 60000);
+
+  QCOMPARE(s_commandGroups, 0);
+  QCOMPARE(s_matchDialogs, 0);
+  // both fetchers for the source were searching at the same time
+  QCOMPARE(FakeUpdateFetcher::s_maxRunning, 2);
+  QCOMPARE(FakeUpdateFetcher::s_running, 0);
+
+  // every entry got updated once with its own match
+  QCOMPARE(s_updates.count(), total);
+  QSet<Tellico::Data::ID> updatedIds;
+  for(int i = 0; i < s_updates.count(); ++i) {
+    Tellico::Data::EntryPtr oldEntry = s_updates.at(i).first;
+    Tellico::Data::EntryPtr newEntry = s_updates.at(i).second;
+    QVERIFY(entries.contains(oldEntry));
+    QCOMPARE(newEntry->title(), oldEntry->title());
+    QCOMPARE(newEntry->field(QLatin1String("publisher")), QLatin1String("Fake Publisher"));
+    updatedIds.insert(oldEntry->id());
+  }
+  QCOMPARE(updatedIds.count(), total);
+}
@@ -0,0 +1,82 @@
+/***************************************************************************
+    Copyright (C) 2019 Robby Stephenson <robby@periapsis.org>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef ENTRYUPDATERTEST_H
+#define ENTRYUPDATERTEST_H
+
+#include "../fetch/fetcher.h"
+
+#include <QObject>
+#include <QHash>
+
+namespace Tellico {
+  namespace Fetch {
+
+/**
+ * A fetcher which answers each update with a copy of the entry, after a short delay
+ */
+class FakeUpdateFetcher : public Fetcher {
+Q_OBJECT
+
+public:
+  FakeUpdateFetcher(QObject* parent);
+
+  virtual bool canFetch(int type) const Q_DECL_OVERRIDE;
+  virtual bool canSearch(FetchKey key) const Q_DECL_OVERRIDE;
+  virtual Type type() const Q_DECL_OVERRIDE;
+  virtual QString source() const Q_DECL_OVERRIDE;
+  virtual bool isSearching() const Q_DECL_OVERRIDE { return m_searching; }
+  virtual void stop() Q_DECL_OVERRIDE;
+  virtual ConfigWidget* configWidget(QWidget*) const Q_DECL_OVERRIDE { return nullptr; }
+
+  // the most searches running at the same time, across all the fake fetchers
+  static int s_running;
+  static int s_maxRunning;
+
+private Q_SLOTS:
+  void slotFinish();
+
+private:
+  virtual void search() Q_DECL_OVERRIDE;
+  virtual FetchRequest updateRequest(Data::EntryPtr entry) Q_DECL_OVERRIDE;
+  virtual void readConfigHook(const KConfigGroup&) Q_DECL_OVERRIDE {}
+  virtual Data::EntryPtr fetchEntryHook(uint uid) Q_DECL_OVERRIDE;
+
+  bool m_searching;
+  Data::EntryPtr m_updateEntry;
+  QHash<uint, Data::EntryPtr> m_entries;
+};
+
+  }
+}
+
+class EntryUpdaterTest : public QObject {
+Q_OBJECT
+
+private Q_SLOTS:
+  void initTestCase();
+  void testPipelinedUpdate();
+};
+
+#endif
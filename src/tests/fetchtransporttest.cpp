@@ -0,0 +1,303 @@
+/***************************************************************************
+    Copyright (C) 2019 Robby Stephenson <robby@periapsis.org>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#undef QT_NO_CAST_FROM_ASCII
+
+#include "fetchtransporttest.h"
+
+#include "../core/fetchtransport.h"
+
+#include <KIO/Job>
+
+#include <QTest>
+#include <QTemporaryDir>
+#include <QStandardPaths>
+#include <QSignalSpy>
+#include <QFile>
+#include <QDir>
+#include <QTcpSocket>
+
+QTEST_GUILESS_MAIN( FetchTransportTest )
+
+namespace {
+  void writeFile(const QString& fileName_, const QByteArray& data_) {
+    QFile f(fileName_);
+    QVERIFY(f.open(QIODevice::WriteOnly));
+    f.write(data_);
+  }
+}
+
+TestHttpServer::TestHttpServer(int status_, const QByteArray& body_) : QTcpServer()
+    , m_status(status_), m_body(body_), m_requestCount(0) {
+  connect(this, SIGNAL(newConnection()), SLOT(slotNewConnection()));
+}
+
+void TestHttpServer::slotNewConnection() {
+  while(hasPendingConnections()) {
+    QTcpSocket* socket = nextPendingConnection();
+    connect(socket, SIGNAL(readyRead()), SLOT(slotReadyRead()));
+    connect(socket, SIGNAL(disconnected()), socket, SLOT(deleteLater()));
+  }
+}
+
+void TestHttpServer::slotReadyRead() {
+  QTcpSocket* socket = static_cast<QTcpSocket*>(sender());
+  QByteArray request = socket->property("request").toByteArray() + socket->readAll();
+  socket->setProperty("request", request);
+  if(!request.contains("\r\n\r\n")) {
+    return;
+  }
+  ++m_requestCount;
+  // KIO keeps its own cache, which would hide the requests
+  socket->write("HTTP/1.1 " + QByteArray::number(m_status) + " Test\r\n"
+                "Content-Type: text/plain\r\n"
+                "Cache-Control: no-store\r\n"
+                "Connection: close\r\n"
+                "Content-Length: " + QByteArray::number(m_body.size()) + "\r\n\r\n" + m_body);
+  socket->disconnectFromHost();
+}
+
+void FetchTransportTest::initTestCase() {
+  QStandardPaths::setTestModeEnabled(true);
+}
+
+void FetchTransportTest::cleanup() {
+  Tellico::FetchTransport::self()->setMode(Tellico::FetchTransport::Normal);
+}
+
+void FetchTransportTest::testCacheKey() {
+  const QUrl u(QLatin1String("http://example.com/search?q=tellico"));
+  const QByteArray key = Tellico::FetchTransport::cacheKey(u);
+  QCOMPARE(key.length(), 40);
+  QCOMPARE(Tellico::FetchTransport::cacheKey(u), key);
+  QVERIFY(Tellico::FetchTransport::cacheKey(QUrl(QLatin1String("http://example.com/search?q=kde"))) != key);
+
+  KIO::MetaData metaData;
+  metaData.insert(QLatin1String("accept"), QLatin1String("application/json"));
+  QVERIFY(Tellico::FetchTransport::cacheKey(u, metaData) != key);
+  QCOMPARE(Tellico::FetchTransport::cacheKey(u, metaData), Tellico::FetchTransport::cacheKey(u, metaData));
+}
+
+void FetchTransportTest::testReplay() {
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  Tellico::FetchTransport::self()->setMode(Tellico::FetchTransport::Replay, dir.path());
+
+  const QUrl u(QLatin1String("http://example.com/replay"));
+  writeFile(dir.path() + QLatin1Char('/') + QLatin1String(Tellico::FetchTransport::cacheKey(u)), "recorded");
+
+  Tellico::FetchTransferJob* job = Tellico::FetchTransport::get(u);
+  job->setAutoDelete(false);
+  QVERIFY(job->exec());
+  QCOMPARE(job->error(), 0);
+  QCOMPARE(job->data(), QByteArray("recorded"));
+  QVERIFY(job->isCached());
+  delete job;
+}
+
+void FetchTransportTest::testReplayMissing() {
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  Tellico::FetchTransport::self()->setMode(Tellico::FetchTransport::Replay, dir.path());
+
+  // no network access is made in replay mode
+  Tellico::FetchTransferJob* job = Tellico::FetchTransport::get(QUrl(QLatin1String("http://example.com/missing")));
+  job->setAutoDelete(false);
+  QVERIFY(!job->exec());
+  QCOMPARE(job->error(), int(KIO::ERR_DOES_NOT_EXIST));
+  QVERIFY(job->data().isEmpty());
+  QVERIFY(!job->errorString().isEmpty());
+  delete job;
+}
+
+void FetchTransportTest::testReplayRedirection() {
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  Tellico::FetchTransport::self()->setMode(Tellico::FetchTransport::Replay, dir.path());
+
+  const QUrl u(QLatin1String("http://example.com/title"));
+  const QUrl redirect(QLatin1String("http://example.com/title/tt0000001/"));
+  const QString fileName = dir.path() + QLatin1Char('/') + QLatin1String(Tellico::FetchTransport::cacheKey(u));
+  writeFile(fileName, "redirected");
+  writeFile(fileName + QLatin1String(".url"), redirect.toEncoded());
+
+  Tellico::FetchTransferJob* job = Tellico::FetchTransport::get(u);
+  job->setAutoDelete(false);
+  QSignalSpy spy(job, SIGNAL(redirection(KJob*, const QUrl&)));
+  QVERIFY(job->exec());
+  QCOMPARE(spy.count(), 1);
+  QCOMPARE(spy.at(0).at(1).toUrl(), redirect);
+  QCOMPARE(job->data(), QByteArray("redirected"));
+  delete job;
+}
+
+void FetchTransportTest::testCache() {
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  Tellico::FetchTransport* transport = Tellico::FetchTransport::self();
+  const QString oldCacheDir = transport->cacheDir();
+  transport->setCacheDir(dir.path());
+  QCOMPARE(transport->mode(), Tellico::FetchTransport::Normal);
+
+  const QUrl u(QLatin1String("http://cache.example.com/entry"));
+  transport->setTimeToLive(u.host(), 60);
+  QCOMPARE(transport->timeToLive(u.host()), 60);
+  writeFile(dir.path() + QLatin1Char('/') + QLatin1String(Tellico::FetchTransport::cacheKey(u)), "cached");
+
+  Tellico::FetchTransferJob* job = Tellico::FetchTransport::get(u);
+  job->setAutoDelete(false);
+  QVERIFY(job->exec());
+  QCOMPARE(job->data(), QByteArray("cached"));
+  QVERIFY(job->isCached());
+  delete job;
+
+  transport->clear();
+  QVERIFY(!QDir(dir.path()).exists());
+  transport->setCacheDir(oldCacheDir);
+}
+
+void FetchTransportTest::testCoalesce() {
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  Tellico::FetchTransport* transport = Tellico::FetchTransport::self();
+  const QString oldCacheDir = transport->cacheDir();
+  transport->setCacheDir(dir.path());
+
+  TestHttpServer server(200, "shared");
+  QVERIFY(server.listen(QHostAddress::LocalHost));
+  const QUrl u(QString::fromLatin1("http://127.0.0.1:%1/coalesce").arg(server.serverPort()));
+  transport->setTimeToLive(u.host(), 60);
+
+  // both jobs start before either one gets a response
+  Tellico::FetchTransferJob* job1 = Tellico::FetchTransport::get(u);
+  job1->setAutoDelete(false);
+  Tellico::FetchTransferJob* job2 = Tellico::FetchTransport::get(u);
+  job2->setAutoDelete(false);
+  QSignalSpy spy1(job1, SIGNAL(result(KJob*)));
+  QSignalSpy spy2(job2, SIGNAL(result(KJob*)));
+  QTRY_COMPARE_WITH_TIMEOUT(spy1.count(), 1, 10000);
+  QTRY_COMPARE_WITH_TIMEOUT(spy2.count(), 1, 10000);
+
+  QCOMPARE(server.requestCount(), 1);
+  QCOMPARE(job1->data(), QByteArray("shared"));
+  QCOMPARE(job2->data(), QByteArray("shared"));
+  QVERIFY(!job1->isCached());
+  QVERIFY(!job2->isCached());
+  delete job1;
+  delete job2;
+
+  transport->setCacheDir(oldCacheDir);
+}
+
+void FetchTransportTest::testExpired() {
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  Tellico::FetchTransport* transport = Tellico::FetchTransport::self();
+  const QString oldCacheDir = transport->cacheDir();
+  transport->setCacheDir(dir.path());
+
+  TestHttpServer server(200, "fresh");
+  QVERIFY(server.listen(QHostAddress::LocalHost));
+  const QUrl u(QString::fromLatin1("http://127.0.0.1:%1/expired").arg(server.serverPort()));
+  const QString fileName = dir.path() + QLatin1Char('/') + QLatin1String(Tellico::FetchTransport::cacheKey(u));
+  writeFile(fileName, "stale");
+  transport->setTimeToLive(u.host(), 1);
+  // the age of the entry is only checked to the second
+  QTest::qWait(2100);
+
+  Tellico::FetchTransferJob* job = Tellico::FetchTransport::get(u);
+  job->setAutoDelete(false);
+  QVERIFY(job->exec());
+  QCOMPARE(job->data(), QByteArray("fresh"));
+  QVERIFY(!job->isCached());
+  QCOMPARE(server.requestCount(), 1);
+  delete job;
+
+  // the new response replaces the expired one
+  transport->setTimeToLive(u.host(), 60);
+  job = Tellico::FetchTransport::get(u);
+  job->setAutoDelete(false);
+  QVERIFY(job->exec());
+  QCOMPARE(job->data(), QByteArray("fresh"));
+  QVERIFY(job->isCached());
+  QCOMPARE(server.requestCount(), 1);
+  delete job;
+
+  transport->setCacheDir(oldCacheDir);
+}
+
+void FetchTransportTest::testErrorPage() {
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  Tellico::FetchTransport* transport = Tellico::FetchTransport::self();
+  const QString oldCacheDir = transport->cacheDir();
+  transport->setCacheDir(dir.path());
+
+  TestHttpServer server(503, "rate limited");
+  QVERIFY(server.listen(QHostAddress::LocalHost));
+  const QUrl u(QString::fromLatin1("http://127.0.0.1:%1/error").arg(server.serverPort()));
+  transport->setTimeToLive(u.host(), 60);
+
+  Tellico::FetchTransferJob* job = Tellico::FetchTransport::get(u);
+  job->setAutoDelete(false);
+  job->exec();
+  QCOMPARE(server.requestCount(), 1);
+  delete job;
+  QVERIFY(!QFile::exists(dir.path() + QLatin1Char('/') + QLatin1String(Tellico::FetchTransport::cacheKey(u))));
+
+  transport->setCacheDir(oldCacheDir);
+}
+
+void FetchTransportTest::testCacheSize() {
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  Tellico::FetchTransport* transport = Tellico::FetchTransport::self();
+  const QString oldCacheDir = transport->cacheDir();
+  const qint64 oldMaxSize = transport->maximumCacheSize();
+  transport->setCacheDir(dir.path());
+  transport->setMaximumCacheSize(250);
+
+  const QByteArray data(100, 'x');
+  writeFile(dir.path() + QLatin1String("/entry1"), data);
+  writeFile(dir.path() + QLatin1String("/entry2"), data);
+  writeFile(dir.path() + QLatin1String("/entry3"), data);
+  writeFile(dir.path() + QLatin1String("/entry3.url"), "http://example.com");
+  transport->pruneCache();
+
+  qint64 total = 0;
+  int count = 0;
+  foreach(const QFileInfo& info, QDir(dir.path()).entryInfoList(QDir::Files)) {
+    total += info.size();
+    if(!info.fileName().endsWith(QLatin1String(".url"))) {
+      ++count;
+    }
+  }
+  QVERIFY(total <= 250);
+  QCOMPARE(count, 2);
+  // a redirection never outlives its response
+  QVERIFY(QFile::exists(dir.path() + QLatin1String("/entry3.url")) == QFile::exists(dir.path() + QLatin1String("/entry3")));
+
+  transport->setMaximumCacheSize(oldMaxSize);
+  transport->setCacheDir(oldCacheDir);
+}
@@ -0,0 +1,69 @@
+/***************************************************************************
+    Copyright (C) 2019 Robby Stephenson <robby@periapsis.org>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef FETCHTRANSPORTTEST_H
+#define FETCHTRANSPORTTEST_H
+
+#include <QObject>
+#include <QTcpServer>
+
+/**
+ * Answers every request with the same response, and counts the requests
+ */
+class TestHttpServer : public QTcpServer {
+Q_OBJECT
+
+public:
+  TestHttpServer(int status, const QByteArray& body);
+  int requestCount() const { return m_requestCount; }
+
+private Q_SLOTS:
+  void slotNewConnection();
+  void slotReadyRead();
+
+private:
+  int m_status;
+  QByteArray m_body;
+  int m_requestCount;
+};
+
+class FetchTransportTest : public QObject {
+Q_OBJECT
+
+private Q_SLOTS:
+  void initTestCase();
+  void cleanup();
+
+  void testCacheKey();
+  void testReplay();
+  void testReplayMissing();
+  void testReplayRedirection();
+  void testCache();
+  void testCoalesce();
+  void testExpired();
+  void testErrorPage();
+  void testCacheSize();
+};
+
+#endif
@@ -31,6 +31,7 @@
 #include "../images/imagefactory.h"
 
 #include <QTest>
+#include <QTemporaryDir>
 
 // KIO::listDir in FileListingImporter seems to require a GUI Application
 QTEST_MAIN( FileListingTest )
@@ -42,6 +43,10 @@ void FileListingTest::initTestCase() {
 void FileListingTest::testCpp() {
   QUrl url = QUrl::fromLocalFile(QFINDTESTDATA("filelistingtest.cpp"));
   Tellico::Import::FileListingImporter importer(url.adjusted(QUrl::RemoveFilename));
+  // don't touch the real metadata cache
+  QTemporaryDir cacheDir;
+  QVERIFY(cacheDir.isValid());
+  importer.setMetaDataCacheFile(cacheDir.path() + QLatin1String("/filelisting-metadata"));
   // can't import images for local test
 //  importer.setOptions(importer.options() & ~Tellico::Import::ImportShowImageErrors);
   Tellico::Data::CollPtr coll = importer.collection();
@@ -28,6 +28,8 @@
 
 #include "../filter.h"
 #include "../entry.h"
+#include "../fulltextindex.h"
+#include "../fieldformat.h"
 #include "../collections/bookcollection.h"
 
 #include <QTest>
@@ -250,3 +252,170 @@ void FilterTest::testGroupViewFilter() {
   QVERIFY(filter2.matches(entry4));
   QVERIFY(!filter2.matches(entry5));
 }
+
+void FilterTest::testFilterPlan() {
+  Tellico::Data::CollPtr coll(new Tellico::Data::BookCollection(true, QLatin1String("TestCollection")));
+  Tellico::Data::EntryPtr entry1(new Tellico::Data::Entry(coll));
+  entry1->setField(QLatin1String("title"), QString::fromUtf8("Tmavomodrý Svět"));
+  entry1->setField(QLatin1String("author"), QLatin1String("John Author"));
+  entry1->setField(QLatin1String("pub_year"), QLatin1String("1999"));
+  Tellico::Data::EntryPtr entry2(new Tellico::Data::Entry(coll));
+  entry2->setField(QLatin1String("title"), QLatin1String("Star Wars"));
+  entry2->setField(QLatin1String("author"), QLatin1String("James Author"));
+  entry2->setField(QLatin1String("pub_year"), QLatin1String("2010"));
+  coll->addEntries(Tellico::Data::EntryList() << entry1 << entry2);
+
+  // an empty plan matches everything
+  Tellico::FilterPlan emptyPlan;
+  QVERIFY(emptyPlan.isEmpty());
+  QVERIFY(emptyPlan.matches(entry1));
+
+  Tellico::FilterPtr filter(new Tellico::Filter(Tellico::Filter::MatchAll));
+  filter->append(new Tellico::FilterRule(QString(), QLatin1String("svet"), Tellico::FilterRule::FuncContains));
+  filter->append(new Tellico::FilterRule(QLatin1String("pub_year"), QLatin1String("2000"), Tellico::FilterRule::FuncLess));
+  filter->append(new Tellico::FilterRule(QLatin1String("author"), QLatin1String("^james"), Tellico::FilterRule::FuncNotRegExp));
+  Tellico::FilterPlan plan(filter);
+  QVERIFY(!plan.isEmpty());
+  QCOMPARE(plan.matches(entry1), filter->matches(entry1));
+  QCOMPARE(plan.matches(entry2), filter->matches(entry2));
+  QVERIFY(plan.matches(entry1));
+  QVERIFY(!plan.matches(entry2));
+
+  filter->setMatch(Tellico::Filter::MatchAny);
+  Tellico::FilterPlan plan2(filter);
+  QCOMPARE(plan2.matches(entry1), filter->matches(entry1));
+  QCOMPARE(plan2.matches(entry2), filter->matches(entry2));
+  QVERIFY(plan2.matches(entry1));
+  QVERIFY(!plan2.matches(entry2));
+
+  // the formatted value is checked, too
+  Tellico::FilterPtr filter3(new Tellico::Filter(Tellico::Filter::MatchAll));
+  filter3->append(new Tellico::FilterRule(QLatin1String("author"), QLatin1String("author, james"), Tellico::FilterRule::FuncEquals));
+  Tellico::FilterPlan plan3(filter3);
+  QCOMPARE(plan3.matches(entry2), filter3->matches(entry2));
+  QVERIFY(plan3.matches(entry2));
+  QVERIFY(!plan3.matches(entry1));
+
+  // the plan looks up the field again once it gets modified
+  Tellico::Data::FieldPtr author(new Tellico::Data::Field(*coll->fieldByName(QLatin1String("author"))));
+  author->setFormatType(Tellico::FieldFormat::FormatNone);
+  QVERIFY(coll->modifyField(author));
+  QCOMPARE(plan3.matches(entry2), filter3->matches(entry2));
+  QVERIFY(!plan3.matches(entry2));
+}
+
+void FilterTest::testFullTextIndex() {
+  Tellico::Data::FullTextIndex index;
+  index.addEntry(1, QStringList() << QString::fromUtf8("Tmavomodrý Svět") << QLatin1String("John Author"));
+  index.addEntry(2, QStringList() << QLatin1String("Star Wars") << QLatin1String("James Author"));
+  QVERIFY(index.hasEntry(1));
+
+  bool ok = true;
+  index.candidates(QLatin1String("sv"), &ok);
+  QVERIFY(!ok);
+  QVERIFY(!Tellico::Data::FullTextIndex::canLookup(QLatin1String("sv")));
+
+  // case and accents are ignored
+  QCOMPARE(index.candidates(QLatin1String("SVET"), &ok), QVector<Tellico::Data::ID>() << 1);
+  QVERIFY(ok);
+  QCOMPARE(index.candidates(QString::fromUtf8("svět"), &ok), QVector<Tellico::Data::ID>() << 1);
+  QCOMPARE(index.candidates(QLatin1String("author"), &ok), QVector<Tellico::Data::ID>() << 1 << 2);
+  QCOMPARE(index.candidates(QLatin1String("star author"), &ok), QVector<Tellico::Data::ID>() << 2);
+  QVERIFY(index.candidates(QLatin1String("wookie"), &ok).isEmpty());
+
+  const int generation = index.generation();
+  index.updateEntry(2, QStringList() << QLatin1String("Star Wars") << QLatin1String("James Author"));
+  QCOMPARE(index.generation(), generation);
+  index.updateEntry(2, QStringList() << QLatin1String("Star Trek"));
+  QVERIFY(index.generation() != generation);
+  QVERIFY(index.candidates(QLatin1String("wars"), &ok).isEmpty());
+  QCOMPARE(index.candidates(QLatin1String("author"), &ok), QVector<Tellico::Data::ID>() << 1);
+
+  index.removeEntry(1);
+  QVERIFY(!index.hasEntry(1));
+  QVERIFY(index.candidates(QLatin1String("author"), &ok).isEmpty());
+
+  // the plan looks up the candidates again when the collection changes
+  Tellico::Data::CollPtr coll(new Tellico::Data::BookCollection(true, QLatin1String("TestCollection")));
+  Tellico::Data::EntryPtr entry1(new Tellico::Data::Entry(coll));
+  entry1->setField(QLatin1String("title"), QString::fromUtf8("Tmavomodrý Svět"));
+  Tellico::Data::EntryPtr entry2(new Tellico::Data::Entry(coll));
+  entry2->setField(QLatin1String("title"), QLatin1String("Star Wars"));
+  coll->addEntries(Tellico::Data::EntryList() << entry1 << entry2);
+
+  Tellico::FilterPtr filter(new Tellico::Filter(Tellico::Filter::MatchAll));
+  filter->append(new Tellico::FilterRule(QString(), QLatin1String("wars"), Tellico::FilterRule::FuncContains));
+  Tellico::FilterPlan plan(filter);
+  QVERIFY(!plan.matches(entry1));
+  QVERIFY(plan.matches(entry2));
+
+  entry1->setField(QLatin1String("title"), QLatin1String("Star Wars Again"));
+  coll->updateDicts(Tellico::Data::EntryList() << entry1, QStringList() << QLatin1String("title"));
+  QVERIFY(plan.matches(entry1));
+
+  // an entry which isn't in the collection yet is still checked
+  Tellico::Data::EntryPtr entry3(new Tellico::Data::Entry(coll));
+  entry3->setField(QLatin1String("title"), QLatin1String("Star Wars Returns"));
+  QVERIFY(plan.matches(entry3));
+}
+
+// values set after the entries are added, like default values or merged values, never go
+// through updateDicts(), but the indexes still need to be current
+void FilterTest::testModifiedAfterAdding() {
+  Tellico::Data::CollPtr coll(new Tellico::Data::BookCollection(true, QLatin1String("TestCollection")));
+  Tellico::Data::EntryPtr entry1(new Tellico::Data::Entry(coll));
+  entry1->setField(QLatin1String("title"), QLatin1String("Star Wars"));
+  Tellico::Data::EntryPtr entry2(new Tellico::Data::Entry(coll));
+  entry2->setField(QLatin1String("title"), QLatin1String("Star Trek"));
+  coll->addEntries(Tellico::Data::EntryList() << entry1 << entry2);
+
+  Tellico::FilterPtr filter(new Tellico::Filter(Tellico::Filter::MatchAll));
+  filter->append(new Tellico::FilterRule(QString(), QLatin1String("wookie"), Tellico::FilterRule::FuncContains));
+  Tellico::FilterPlan plan(filter);
+  // builds the index
+  QVERIFY(!plan.matches(entry1));
+  QCOMPARE(coll->valuesByFieldName(QLatin1String("publisher")), QStringList());
+
+  entry1->setField(QLatin1String("publisher"), QLatin1String("Wookie Press"));
+  QVERIFY(plan.matches(entry1));
+  QVERIFY(!plan.matches(entry2));
+  QCOMPARE(coll->valuesByFieldName(QLatin1String("publisher")), QStringList() << QLatin1String("Wookie Press"));
+
+  // clearing the value takes it out of the indexes, too
+  entry1->setField(QLatin1String("publisher"), QString());
+  QVERIFY(!plan.matches(entry1));
+  QCOMPARE(coll->valuesByFieldName(QLatin1String("publisher")), QStringList());
+}
+
+void FilterTest::testFilterPlanBenchmark() {
+  const int total = 100000;
+  Tellico::Data::CollPtr coll(new Tellico::Data::BookCollection(true, QLatin1String("TestCollection")));
+  Tellico::Data::EntryList entries;
+  for(int i = 0; i < total; ++i) {
+    Tellico::Data::EntryPtr entry(new Tellico::Data::Entry(coll));
+    entry->setField(QLatin1String("title"), QString::fromLatin1("The Title %1").arg(i));
+    entry->setField(QLatin1String("author"), QString::fromLatin1("Author %1").arg(i % 1000));
+    entry->setField(QLatin1String("publisher"), QString::fromLatin1("Publisher %1").arg(i % 50));
+    entry->setField(QLatin1String("pub_year"), QString::number(1900 + i % 100));
+    entries << entry;
+  }
+  coll->addEntries(entries);
+
+  // same as the quick filter, every word is checked against every field
+  Tellico::FilterPtr filter(new Tellico::Filter(Tellico::Filter::MatchAll));
+  filter->append(new Tellico::FilterRule(QString(), QLatin1String("title"), Tellico::FilterRule::FuncContains));
+  filter->append(new Tellico::FilterRule(QString(), QLatin1String("author 42"), Tellico::FilterRule::FuncContains));
+
+  int count = 0;
+  QBENCHMARK {
+    count = 0;
+    const Tellico::FilterPlan plan(filter);
+    foreach(Tellico::Data::EntryPtr entry, entries) {
+      if(plan.matches(entry)) {
+        ++count;
+      }
+    }
+  }
+  // Author 42, Author 420-429
+  QCOMPARE(count, 11 * total / 1000);
+}
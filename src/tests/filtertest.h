@@ -34,6 +34,10 @@ private Q_SLOTS:
   void initTestCase();
   void testFilter();
   void testGroupViewFilter();
+  void testFilterPlan();
+  void testFullTextIndex();
+  void testModifiedAfterAdding();
+  void testFilterPlanBenchmark();
 };
 
 #endif
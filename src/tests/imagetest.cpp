@@ -27,8 +27,13 @@
 #include "imagetest.h"
 
 #include "../images/imagefactory.h"
+#include "../images/thumbnailcache.h"
 
 #include <QTest>
+#include <QTemporaryDir>
+#include <QImage>
+#include <QFileInfo>
+#include <QDir>
 
 QTEST_GUILESS_MAIN( ImageTest )
 
@@ -42,3 +47,53 @@ void ImageTest::testLinkOnly() {
   QString id = Tellico::ImageFactory::addImage(u, false, QUrl(), true);
   QCOMPARE(id, u.url());
 }
+
+void ImageTest::testThumbnailFile() {
+  QImage img(QFINDTESTDATA("../../icons/hi128-app-tellico.png"));
+  QVERIFY(!img.isNull());
+  img = img.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  const QString fileName = dir.path() + QLatin1String("/thumb");
+  QVERIFY(Tellico::ThumbnailCache::writeThumbnail(fileName, img));
+
+  QImage img2 = Tellico::ThumbnailCache::readThumbnail(fileName);
+  QCOMPARE(img2.size(), img.size());
+  QCOMPARE(img2.format(), img.format());
+  QCOMPARE(img2, img);
+
+  // not a thumbnail file
+  QVERIFY(Tellico::ThumbnailCache::readThumbnail(QFINDTESTDATA("../../icons/hi128-app-tellico.png")).isNull());
+  QVERIFY(Tellico::ThumbnailCache::readThumbnail(dir.path() + QLatin1String("/nothing")).isNull());
+}
+
+void ImageTest::testThumbnailPrune() {
+  QImage img(QFINDTESTDATA("../../icons/hi128-app-tellico.png"));
+  QVERIFY(!img.isNull());
+  img = img.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  Tellico::ThumbnailCache cache;
+  cache.setCacheDir(dir.path());
+
+  QStringList fileNames;
+  for(int i = 0; i < 3; ++i) {
+    fileNames << cache.cacheDir() + QLatin1String("thumb") + QString::number(i);
+    QVERIFY(Tellico::ThumbnailCache::writeThumbnail(fileNames.last(), img));
+    // so the files have different times
+    QTest::qWait(20);
+  }
+  const qint64 fileSize = QFileInfo(fileNames.first()).size();
+  QVERIFY(fileSize > 0);
+
+  // the least recently used thumbnail goes first
+  cache.setMaximumCacheSize(2*fileSize);
+  QVERIFY(!QFile::exists(fileNames.at(0)));
+  QVERIFY(QFile::exists(fileNames.at(1)));
+  QVERIFY(QFile::exists(fileNames.at(2)));
+
+  cache.setMaximumCacheSize(0);
+  QVERIFY(QDir(cache.cacheDir()).entryList(QDir::Files).isEmpty());
+}
@@ -33,6 +33,8 @@ Q_OBJECT
 private Q_SLOTS:
   void initTestCase();
   void testLinkOnly();
+  void testThumbnailFile();
+  void testThumbnailPrune();
 };
 
 #endif
@@ -24,6 +24,7 @@
 
 #include "iso6937test.h"
 #include "../utils/iso6937converter.h"
+#include "../utils/iso5426converter.h"
 
 #include <QTest>
 
@@ -225,3 +226,55 @@ void Iso6937Test::testAccent_data() {
   QTest::newRow("e3") << QU8("ª") << QByteArray::fromHex("e3");
   QTest::newRow("ff") << QU8("\u00ad") << QByteArray::fromHex("ff");
 }
+
+void Iso6937Test::testMixed() {
+  QFETCH(QByteArray, input);
+  QFETCH(QString, output);
+
+  QCOMPARE(Tellico::Iso6937Converter::toUtf8(input), output);
+}
+
+void Iso6937Test::testMixed_data() {
+  QTest::addColumn<QByteArray>("input");
+  QTest::addColumn<QString>("output");
+
+  QTest::newRow("empty") << QByteArray() << QString();
+  QTest::newRow("leading") << QByteArray::fromHex("c245") + QByteArray("cole des Beaux-Arts") << QU8("École des Beaux-Arts");
+  QTest::newRow("long run") << QByteArray("abcdefghijklmnop") + QByteArray::fromHex("c265") << QU8("abcdefghijklmnopé");
+  QTest::newRow("several") << QByteArray("caf") + QByteArray::fromHex("c265") + QByteArray(" au lait, tr")
+                                + QByteArray::fromHex("c165") + QByteArray("s bon") << QU8("café au lait, très bon");
+  QTest::newRow("spacing") << QByteArray("price ") + QByteArray::fromHex("a3") + QByteArray("10") << QU8("price £10");
+  QTest::newRow("nul") << QByteArray("a\0b", 3) << QString::fromLatin1("a\0b", 3);
+}
+
+namespace {
+  // about a megabyte of typical MARC text, mostly ascii with a few accents
+  QByteArray benchmarkInput() {
+    const QByteArray sample = QByteArray("Les Mis") + QByteArray::fromHex("c265")
+                            + QByteArray("rables / Victor Hugo ; pr") + QByteArray::fromHex("c265")
+                            + QByteArray("face de l'auteur. Paris : Gallimard, 1995. ");
+    QByteArray input;
+    while(input.size() < (1 << 20)) {
+      input += sample;
+    }
+    return input;
+  }
+}
+
+void Iso6937Test::benchmarkIso6937() {
+  const QByteArray input = benchmarkInput();
+  QString output;
+  QBENCHMARK {
+    output = Tellico::Iso6937Converter::toUtf8(input);
+  }
+  QVERIFY(output.startsWith(QU8("Les Misérables / Victor Hugo ; préface")));
+}
+
+void Iso6937Test::benchmarkIso5426() {
+  const QByteArray input = benchmarkInput();
+  QString output;
+  QBENCHMARK {
+    output = Tellico::Iso5426Converter::toUtf8(input);
+  }
+  QVERIFY(output.startsWith(QU8("Les Misérables / Victor Hugo ; préface")));
+}
@@ -35,6 +35,10 @@ private Q_SLOTS:
   void testAscii_data();
   void testAccent();
   void testAccent_data();
+  void testMixed();
+  void testMixed_data();
+  void benchmarkIso6937();
+  void benchmarkIso5426();
 };
 
 #endif
@@ -33,10 +33,12 @@
 #include "../models/entrygroupmodel.h"
 #include "../models/groupsortmodel.h"
 #include "../models/modeliterator.h"
+#include "../models/fieldcomparison.h"
 #include "../collections/bookcollection.h"
 #include "../collectionfactory.h"
 #include "../document.h"
 #include "../entrygroup.h"
+#include "../fieldformat.h"
 #include "../images/imagefactory.h"
 
 #include <QTest>
@@ -179,3 +181,79 @@ void TellicoModelTest::testGroupModel() {
     QVERIFY(!group->hasEmptyGroupName());
   }
 }
+
+void TellicoModelTest::testSortKeyCache() {
+  QFETCH(int, fieldType);
+  QFETCH(int, formatType);
+  QFETCH(QString, value1);
+  QFETCH(QString, value2);
+  QFETCH(int, res);
+  QFETCH(QString, newValue1);
+  QFETCH(int, newRes);
+
+  Tellico::Data::CollPtr coll(new Tellico::Data::Collection(true)); // add default fields
+  Tellico::Data::FieldPtr field(new Tellico::Data::Field(QLatin1String("test"), QLatin1String("Test"),
+                                                         Tellico::Data::Field::Type(fieldType)));
+  field->setFormatType(Tellico::FieldFormat::Type(formatType));
+  coll->addField(field);
+
+  Tellico::Data::EntryPtr entry1(new Tellico::Data::Entry(coll));
+  entry1->setField(field, value1);
+  Tellico::Data::EntryPtr entry2(new Tellico::Data::Entry(coll));
+  entry2->setField(field, value2);
+  coll->addEntries(Tellico::Data::EntryList() << entry1 << entry2);
+
+  QScopedPointer<Tellico::FieldComparison> comp(Tellico::FieldComparison::create(field));
+  QVERIFY(comp);
+  QVERIFY(!entry1->sortKey(field->name()).isValid());
+  QVERIFY(!entry2->sortKey(field->name()).isValid());
+
+  QCOMPARE(qBound(-1, comp->compare(entry1, entry2), 1), res);
+  // every key gets cached, even for empty values
+  QVERIFY(entry1->sortKey(field->name()).isValid());
+  QVERIFY(entry2->sortKey(field->name()).isValid());
+  // and the cached keys give the same result
+  QCOMPARE(qBound(-1, comp->compare(entry2, entry1), 1), -res);
+  QCOMPARE(qBound(-1, comp->compare(entry1, entry1), 1), 0);
+
+  // changing the value drops the cached key
+  entry1->setField(field, newValue1);
+  QVERIFY(!entry1->sortKey(field->name()).isValid());
+  QVERIFY(entry2->sortKey(field->name()).isValid());
+  QCOMPARE(qBound(-1, comp->compare(entry1, entry2), 1), newRes);
+}
+
+void TellicoModelTest::testSortKeyCache_data() {
+  QTest::addColumn<int>("fieldType");
+  QTest::addColumn<int>("formatType");
+  QTest::addColumn<QString>("value1");
+  QTest::addColumn<QString>("value2");
+  QTest::addColumn<int>("res");
+  QTest::addColumn<QString>("newValue1");
+  QTest::addColumn<int>("newRes");
+
+  const int date = Tellico::Data::Field::Date;
+  const int number = Tellico::Data::Field::Number;
+  const int line = Tellico::Data::Field::Line;
+  const int formatNone = Tellico::FieldFormat::FormatNone;
+  const int formatTitle = Tellico::FieldFormat::FormatTitle;
+
+  QTest::newRow("date") << date << formatNone << QString::fromLatin1("2001-02-03") << QString::fromLatin1("1999-12-31") << 1
+                        << QString::fromLatin1("1999-1-1") << -1;
+  QTest::newRow("date empty") << date << formatNone << QString() << QString::fromLatin1("1999-12-31") << -1
+                              << QString::fromLatin1("2001-02-03") << 1;
+  QTest::newRow("date both empty") << date << formatNone << QString() << QString() << 0
+                                   << QString::fromLatin1("2001-02-03") << 1;
+  QTest::newRow("number") << number << formatNone << QString::fromLatin1("10") << QString::fromLatin1("9") << 1
+                          << QString::fromLatin1("2") << -1;
+  QTest::newRow("number empty") << number << formatNone << QString() << QString::fromLatin1("0") << -1
+                                << QString::fromLatin1("0") << 0;
+  QTest::newRow("number multiple") << number << formatNone << QString::fromLatin1("1; 2") << QString::fromLatin1("1; 3") << -1
+                                   << QString::fromLatin1("1; 4") << 1;
+  QTest::newRow("title") << line << formatTitle << QString::fromLatin1("The Zebra") << QString::fromLatin1("Apple") << 1
+                         << QString::fromLatin1("Aardvark") << -1;
+  QTest::newRow("title article") << line << formatTitle << QString::fromLatin1("The Apple") << QString::fromLatin1("Banana") << -1
+                                 << QString::fromLatin1("Cherry") << 1;
+  QTest::newRow("title empty") << line << formatTitle << QString() << QString::fromLatin1("Apple") << -1
+                               << QString::fromLatin1("Apple") << 0;
+}
@@ -35,6 +35,8 @@ private Q_SLOTS:
   void testEntryModel();
   void testFilterModel();
   void testGroupModel();
+  void testSortKeyCache();
+  void testSortKeyCache_data();
 };
 
 #endif
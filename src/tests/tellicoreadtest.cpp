@@ -29,8 +29,10 @@
 #include "../translators/tellicoimporter.h"
 #include "../collections/bookcollection.h"
 #include "../collections/coincollection.h"
+#include "../collections/videocollection.h"
 #include "../collectionfactory.h"
 #include "../translators/tellicoxmlexporter.h"
+#include "../translators/tellicozipexporter.h"
 #include "../images/imagefactory.h"
 #include "../images/image.h"
 #include "../fieldformat.h"
@@ -38,6 +40,17 @@
 #include "../utils/xmlhandler.h"
 
 #include <QTest>
+#include <QDomDocument>
+#include <QBuffer>
+#include <QTemporaryFile>
+
+extern "C" {
+#include <libxml/tree.h>
+}
+
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
 
 QTEST_GUILESS_MAIN( TellicoReadTest )
 
@@ -48,6 +61,7 @@ void TellicoReadTest::initTestCase() {
   // need to register this first
   Tellico::RegisterCollection<Tellico::Data::BookCollection> registerBook(Tellico::Data::Collection::Book, "book");
   Tellico::RegisterCollection<Tellico::Data::CoinCollection> registerCoin(Tellico::Data::Collection::Coin, "coin");
+  Tellico::RegisterCollection<Tellico::Data::VideoCollection> registerVideo(Tellico::Data::Collection::Video, "video");
   Tellico::RegisterCollection<Tellico::Data::Collection> registerBase(Tellico::Data::Collection::Base, "entry");
 
   for(int i = 1; i < TELLICOREAD_NUMBER_OF_CASES; ++i) {
@@ -190,6 +204,43 @@ void TellicoReadTest::testTableData() {
   QCOMPARE(cols.count(), 3);
 }
 
+void TellicoReadTest::testXMLDoc() {
+  QUrl url = QUrl::fromLocalFile(QFINDTESTDATA("/data/tabletest.tc"));
+
+  Tellico::Import::TellicoImporter importer(url);
+  Tellico::Data::CollPtr coll = importer.collection();
+  QVERIFY(coll);
+
+  // the libxml2 tree should have exactly the same content as the text output
+  Tellico::Export::TellicoXMLExporter exporter(coll);
+  exporter.setEntries(coll->entries());
+  xmlDocPtr doc = exporter.exportXMLDoc();
+  QVERIFY(doc);
+  xmlChar* buffer = nullptr;
+  int size = 0;
+  xmlDocDumpMemoryEnc(doc, &buffer, &size, "UTF-8");
+  const QString text = QString::fromUtf8(reinterpret_cast<const char*>(buffer), size);
+  xmlFree(buffer);
+  xmlFreeDoc(doc);
+
+  Tellico::Import::TellicoImporter importer2(text);
+  Tellico::Data::CollPtr coll2 = importer2.collection();
+
+  QVERIFY(coll2);
+  QCOMPARE(coll2->type(), coll->type());
+  QCOMPARE(coll2->title(), coll->title());
+  QCOMPARE(coll2->fields().count(), coll->fields().count());
+  QCOMPARE(coll2->entryCount(), coll->entryCount());
+
+  foreach(Tellico::Data::EntryPtr e1, coll->entries()) {
+    Tellico::Data::EntryPtr e2 = coll2->entryById(e1->id());
+    QVERIFY(e2);
+    foreach(Tellico::Data::FieldPtr f, coll->fields()) {
+      QCOMPARE(f->name() + e1->field(f), f->name() + e2->field(f));
+    }
+  }
+}
+
 void TellicoReadTest::testDuplicateLoans() {
   QUrl url = QUrl::fromLocalFile(QFINDTESTDATA("/data/duplicate_loan.xml"));
 
@@ -313,3 +364,184 @@ void TellicoReadTest::testXMLHandler_data() {
   QTest::newRow("latin1") << QByteArray("<?xml encoding=\"latin1\"?>\n<x>value</x>")
                           << QString::fromUtf8("<?xml encoding=\"utf-8\"?>\n<x>value</x>") << true;
 }
+
+namespace {
+  // the attributes are sorted, so the order they are written in doesn't matter, and the
+  // namespace declarations are skipped, since the DOM might repeat them
+  QString canonicalXML(const QDomNode& node_) {
+    if(node_.isText()) {
+      return node_.nodeValue();
+    }
+    if(!node_.isElement()) {
+      return QString();
+    }
+    const QDomElement elem = node_.toElement();
+    QStringList atts;
+    const QDomNamedNodeMap attMap = elem.attributes();
+    for(int i = 0; i < attMap.count(); ++i) {
+      const QDomAttr att = attMap.item(i).toAttr();
+      if(!att.name().startsWith(QL1("xmlns"))) {
+        atts << att.name() + QL1("=\"") + att.value() + QL1("\"");
+      }
+    }
+    atts.sort();
+    QString text = QL1("<") + elem.tagName();
+    if(!atts.isEmpty()) {
+      text += QL1(" ") + atts.join(QL1(" "));
+    }
+    text += QL1(">");
+    for(QDomNode child = elem.firstChild(); !child.isNull(); child = child.nextSibling()) {
+      text += canonicalXML(child);
+    }
+    return text + QL1("</") + elem.tagName() + QL1(">");
+  }
+}
+
+void TellicoReadTest::testStreamWriter() {
+  QFETCH(QString, fileName);
+
+  QUrl url = QUrl::fromLocalFile(QFINDTESTDATA(fileName));
+  Tellico::Import::TellicoImporter importer(url);
+  Tellico::Data::CollPtr coll = importer.collection();
+  QVERIFY(coll);
+
+  Tellico::Export::TellicoXMLExporter exporter(coll);
+  exporter.setEntries(coll->entries());
+  exporter.setOptions(exporter.options() | Tellico::Export::ExportUTF8 | Tellico::Export::ExportImages);
+
+  // the DOM tree is what the exporter used to write
+  QDomDocument domDoc;
+  QVERIFY(domDoc.setContent(exporter.exportXML().toString()));
+
+  QByteArray data;
+  QBuffer buffer(&data);
+  QVERIFY(buffer.open(QIODevice::WriteOnly));
+  QVERIFY(exporter.writeXML(&buffer));
+  buffer.close();
+  QDomDocument streamDoc;
+  QVERIFY(streamDoc.setContent(data));
+
+  QCOMPARE(canonicalXML(streamDoc.documentElement()), canonicalXML(domDoc.documentElement()));
+}
+
+void TellicoReadTest::testStreamWriter_data() {
+  QTest::addColumn<QString>("fileName");
+
+  QTest::newRow("books") << QL1("data/books-format9.bc");
+  QTest::newRow("coins") << QL1("data/coins-format9.tc");
+  QTest::newRow("table") << QL1("data/tabletest.tc");
+  QTest::newRow("images") << QL1("data/with-image.tc");
+  QTest::newRow("loans") << QL1("data/duplicate_loan.xml");
+  QTest::newRow("movies") << QL1("data/movies-many.tc");
+}
+
+void TellicoReadTest::testZipWriter() {
+  QUrl url = QUrl::fromLocalFile(QFINDTESTDATA("data/with-image.tc"));
+  Tellico::Import::TellicoImporter importer(url);
+  Tellico::Data::CollPtr coll = importer.collection();
+  QVERIFY(coll);
+
+  QTemporaryFile tempFile(QL1("tellicoreadtest.XXXXXX.tc"));
+  QVERIFY(tempFile.open());
+  Tellico::Export::TellicoZipExporter exporter(coll);
+  exporter.setEntries(coll->entries());
+  exporter.setURL(QUrl::fromLocalFile(tempFile.fileName()));
+  exporter.setOptions(exporter.options() | Tellico::Export::ExportForce);
+  QVERIFY(exporter.exec());
+
+  Tellico::Import::TellicoImporter importer2(QUrl::fromLocalFile(tempFile.fileName()));
+  Tellico::Data::CollPtr coll2 = importer2.collection();
+  QVERIFY(coll2);
+  QCOMPARE(importer2.format(), Tellico::Import::TellicoImporter::Zip);
+  QCOMPARE(coll2->type(), coll->type());
+  QCOMPARE(coll2->entryCount(), coll->entryCount());
+  QCOMPARE(importer2.hasImages(), importer.hasImages());
+}
+
+namespace {
+  // writes a large book collection, with plenty of repeated values
+  bool writeLargeCollection(QTemporaryFile* file_, int total_) {
+    Tellico::Data::CollPtr coll(new Tellico::Data::BookCollection(true));
+    Tellico::Data::EntryList entries;
+    for(int i = 0; i < total_; ++i) {
+      Tellico::Data::EntryPtr entry(new Tellico::Data::Entry(coll));
+      entry->setField(QL1("title"), QL1("The Title %1").arg(i));
+      entry->setField(QL1("author"), QL1("Author %1; Second Author").arg(i % 1000));
+      entry->setField(QL1("publisher"), QL1("Publisher %1").arg(i % 50));
+      entry->setField(QL1("pub_year"), QString::number(1900 + i % 100));
+      entry->setField(QL1("genre"), QL1("Fiction; Fantasy"));
+      entry->setField(QL1("binding"), QL1("Paperback"));
+      entry->setField(QL1("keyword"), QL1("keyword%1").arg(i % 10));
+      entries << entry;
+    }
+    coll->addEntries(entries);
+
+    if(!file_->open()) {
+      return false;
+    }
+    Tellico::Export::TellicoXMLExporter exporter(coll);
+    exporter.setEntries(coll->entries());
+    const bool success = exporter.writeXML(file_);
+    file_->close();
+    return success;
+  }
+
+  // the resident set size in bytes, only available on Linux
+  qint64 residentMemory() {
+#ifndef Q_OS_LINUX
+    return -1;
+#else
+    QFile file(QL1("/proc/self/statm"));
+    if(!file.open(QIODevice::ReadOnly)) {
+      return -1;
+    }
+    const QList<QByteArray> values = file.readAll().split(' ');
+    if(values.count() < 2) {
+      return -1;
+    }
+    return values.at(1).toLongLong() * sysconf(_SC_PAGESIZE);
+#endif
+  }
+}
+
+void TellicoReadTest::testLoadBenchmark() {
+  const int total = 100000;
+  QTemporaryFile tempFile(QL1("tellicoreadtest.XXXXXX.tc"));
+  QVERIFY(writeLargeCollection(&tempFile, total));
+
+  Tellico::Data::CollPtr coll;
+  QBENCHMARK_ONCE {
+    Tellico::Import::TellicoImporter importer(QUrl::fromLocalFile(tempFile.fileName()));
+    coll = importer.collection();
+  }
+  QVERIFY(coll);
+  QCOMPARE(coll->entryCount(), total);
+}
+
+void TellicoReadTest::testMemoryBenchmark() {
+  // writing and loading this many entries takes a while, so it only runs when asked for
+  if(qgetenv("TELLICO_MEMORY_BENCHMARK").isEmpty()) {
+    QSKIP("Set TELLICO_MEMORY_BENCHMARK to run the memory benchmark", SkipAll);
+  }
+  if(residentMemory() < 0) {
+    QSKIP("Resident memory is not available on this platform", SkipAll);
+  }
+  const int total = 200000;
+  QTemporaryFile tempFile(QL1("tellicoreadtest.XXXXXX.tc"));
+  QVERIFY(writeLargeCollection(&tempFile, total));
+
+  const qint64 before = residentMemory();
+  Tellico::Import::TellicoImporter importer(QUrl::fromLocalFile(tempFile.fileName()));
+  Tellico::Data::CollPtr coll = importer.collection();
+  QVERIFY(coll);
+  QCOMPARE(coll->entryCount(), total);
+  const qint64 after = residentMemory();
+  // the result is reported as the memory used for each entry
+  QTest::setBenchmarkResult(qreal(after - before) / total, QTest::BytesAllocated);
+
+  // the repeated values should all be shared
+  Tellico::Data::EntryPtr entry1 = coll->entries().at(0);
+  Tellico::Data::EntryPtr entry2 = coll->entries().at(50);
+  QCOMPARE(entry1->field(QL1("publisher")), entry2->field(QL1("publisher")));
+  QVERIFY(entry1->field(QL1("publisher")).constData() == entry2->field(QL1("publisher")).constData());
+}
@@ -42,12 +42,18 @@ private Q_SLOTS:
   void testEntries_data();
   void testCoinCollection();
   void testTableData();
+  void testXMLDoc();
   void testDuplicateLoans();
   void testDuplicateBorrowers();
   void testLocalImage();
   void testRemoteImage();
   void testXMLHandler();
   void testXMLHandler_data();
+  void testStreamWriter();
+  void testStreamWriter_data();
+  void testZipWriter();
+  void testLoadBenchmark();
+  void testMemoryBenchmark();
 
 private:
   QList<Tellico::Data::CollPtr> m_collections;
@@ -0,0 +1,94 @@
+/***************************************************************************
+    Copyright (C) 2019 Robby Stephenson <robby@periapsis.org>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#undef QT_NO_CAST_FROM_ASCII
+
+#include "z3950connectiontest.h"
+
+#include "../fetch/z3950fetcher.h"
+#include "../fetch/fetchrequest.h"
+#include "../collections/bookcollection.h"
+#include "../collectionfactory.h"
+
+#include <QTest>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QElapsedTimer>
+
+QTEST_GUILESS_MAIN( Z3950ConnectionTest )
+
+// the server accepts the connection but never answers, which would block ZOOM_event()
+// until the connection timed out
+void Z3950ConnectionTest::initTestCase() {
+  Tellico::RegisterCollection<Tellico::Data::BookCollection> registerBook(Tellico::Data::Collection::Book, "book");
+  m_server = new QTcpServer(this);
+  QVERIFY(m_server->listen(QHostAddress::LocalHost));
+}
+
+void Z3950ConnectionTest::testAbort() {
+  Tellico::Fetch::FetchRequest request(Tellico::Data::Collection::Book, Tellico::Fetch::Title,
+                                       QLatin1String("Foundations of Qt Development"));
+  Tellico::Fetch::Fetcher::Ptr fetcher(new Tellico::Fetch::Z3950Fetcher(this,
+                                                                        QLatin1String("127.0.0.1"),
+                                                                        m_server->serverPort(),
+                                                                        QLatin1String("test"),
+                                                                        QLatin1String("usmarc")));
+  fetcher->startSearch(request);
+  QVERIFY(m_server->waitForNewConnection(5000));
+  QTcpSocket* socket = m_server->nextPendingConnection();
+  QVERIFY(socket);
+
+  fetcher->stop();
+  QElapsedTimer timer;
+  timer.start();
+  // starting the next search waits for the loop to be done with the aborted one
+  fetcher->startSearch(request);
+  QVERIFY(timer.elapsed() < 2000);
+  fetcher->stop();
+  delete socket;
+}
+
+void Z3950ConnectionTest::testRelease() {
+  Tellico::Fetch::FetchRequest request(Tellico::Data::Collection::Book, Tellico::Fetch::Title,
+                                       QLatin1String("Foundations of Qt Development"));
+  Tellico::Fetch::Fetcher::Ptr fetcher(new Tellico::Fetch::Z3950Fetcher(this,
+                                                                        QLatin1String("127.0.0.1"),
+                                                                        m_server->serverPort(),
+                                                                        QLatin1String("test"),
+                                                                        QLatin1String("usmarc")));
+  fetcher->startSearch(request);
+  QVERIFY(m_server->waitForNewConnection(5000));
+  QTcpSocket* socket = m_server->nextPendingConnection();
+  QVERIFY(socket);
+
+  QElapsedTimer timer;
+  timer.start();
+  // deleting the fetcher doesn't wait for the server
+  fetcher = Tellico::Fetch::Fetcher::Ptr();
+  QVERIFY(timer.elapsed() < 1000);
+
+  // the loop deletes the connection, which closes the socket
+  QVERIFY(socket->state() == QAbstractSocket::UnconnectedState || socket->waitForDisconnected(5000));
+  delete socket;
+}
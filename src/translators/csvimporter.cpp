@@ -27,6 +27,7 @@
 #include "translators.h" // needed for ImportAction
 #include "../collectionfieldsdialog.h"
 #include "../collection.h"
+#include "../fieldformat.h"
 #include "../tellico_debug.h"
 #include "../collectionfactory.h"
 #include "../gui/collectiontypecombo.h"
@@ -54,10 +55,88 @@
 #include <QHBoxLayout>
 #include <QButtonGroup>
 #include <QApplication>
+#include <QBuffer>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QVector>
+
+namespace {
+  // the rows are cleaned up in the background and added to the collection in batches
+  static const int CSV_BATCH_SIZE = 500;
+
+  struct CSVColumn {
+    enum Special { Plain, LibraryThingIsbn, LibraryThingKeyword, LibraryThingDate };
+    int index;
+    bool replaceColDelimiter;
+    bool replaceRowDelimiter;
+    Special special;
+  };
+
+  // replaces the parsed tokens in each row with the values for the imported columns
+  class NormalizeTask : public QRunnable {
+  public:
+    NormalizeTask(QVector<QStringList>* rows_, const QVector<CSVColumn>& columns_,
+                  const QString& colDelimiter_, const QString& rowDelimiter_)
+        : QRunnable(), m_rows(rows_), m_columns(columns_), m_colDelimiter(colDelimiter_), m_rowDelimiter(rowDelimiter_)
+        , m_colDelimiterString(Tellico::FieldFormat::columnDelimiterString())
+        , m_rowDelimiterString(Tellico::FieldFormat::rowDelimiterString())
+        , m_delimiterString(Tellico::FieldFormat::delimiterString()) {}
+
+    void run() Q_DECL_OVERRIDE {
+      for(int row = 0; row < m_rows->size(); ++row) {
+        const QStringList tokens = m_rows->at(row);
+        QStringList values;
+        values.reserve(m_columns.size());
+        foreach(const CSVColumn& column, m_columns) {
+          if(column.index >= tokens.size()) {
+            break;
+          }
+          QString value = tokens.at(column.index).trimmed();
+          // only replace delimiters for tables
+          // see https://forum.kde.org/viewtopic.php?f=200&t=142712
+          if(column.replaceColDelimiter) {
+            value.replace(m_colDelimiter, m_colDelimiterString);
+          }
+          if(column.replaceRowDelimiter) {
+            value.replace(m_rowDelimiter, m_rowDelimiterString);
+          }
+          // special cases for LibraryThing import
+          switch(column.special) {
+            case CSVColumn::LibraryThingIsbn:
+              // ISBN values are enclosed by brackets
+              value.remove(QLatin1Char('[')).remove(QLatin1Char(']'));
+              break;
+            case CSVColumn::LibraryThingKeyword:
+              // LT values are comma-separated
+              value.replace(QLatin1String(","), m_delimiterString);
+              break;
+            case CSVColumn::LibraryThingDate:
+              // only want date, not time. 10 characters since it's zero-padded
+              value.truncate(10);
+              break;
+            case CSVColumn::Plain:
+              break;
+          }
+          values << value;
+        }
+        (*m_rows)[row] = values;
+      }
+    }
+
+  private:
+    QVector<QStringList>* m_rows;
+    const QVector<CSVColumn> m_columns;
+    const QString m_colDelimiter;
+    const QString m_rowDelimiter;
+    const QString m_colDelimiterString;
+    const QString m_rowDelimiterString;
+    const QString m_delimiterString;
+  };
+}
 
 using Tellico::Import::CSVImporter;
 
-CSVImporter::CSVImporter(const QUrl& url_) : Tellico::Import::TextImporter(url_),
+CSVImporter::CSVImporter(const QUrl& url_) : Tellico::Import::DataImporter(url_),
     m_existingCollection(nullptr),
     m_firstRowHeader(false),
     m_delimiter(QLatin1String(",")),
@@ -78,7 +157,8 @@ CSVImporter::CSVImporter(const QUrl& url_) : Tellico::Import::TextImporter(url_)
     m_setColumnBtn(nullptr),
     m_hasAssignedFields(false),
     m_isLibraryThing(false),
-    m_parser(new CSVParser(text())) {
+    m_parser(new CSVParser(QString())),
+    m_buffer(nullptr) {
   m_parser->setDelimiter(m_delimiter);
 }
 
@@ -87,6 +167,24 @@ CSVImporter::~CSVImporter() {
   m_parser = nullptr;
 }
 
+QIODevice* CSVImporter::device() {
+  if(source() == Text) {
+    if(!m_buffer) {
+      m_buffer = new QBuffer(this);
+      m_buffer->setData(data());
+      m_buffer->open(QIODevice::ReadOnly);
+    }
+    return m_buffer;
+  }
+  if(!fileRef().isValid()) {
+    return nullptr;
+  }
+  if(!fileRef().file()->isOpen() && !fileRef().open()) {
+    return nullptr;
+  }
+  return fileRef().file();
+}
+
 Tellico::Data::CollPtr CSVImporter::collection() {
   // don't just check if m_coll is non-null since the collection can be created elsewhere
   if(m_coll && m_coll->entryCount() > 0) {
@@ -97,95 +195,117 @@ Tellico::Data::CollPtr CSVImporter::collection() {
     createCollection();
   }
 
-  const QStringList existingNames = m_coll->fieldNames();
+  // do we need to replace column or row delimiters
+  const bool replaceColDelimiter = (!m_colDelimiter.isEmpty() && m_colDelimiter != FieldFormat::columnDelimiterString());
+  const bool replaceRowDelimiter = (!m_rowDelimiter.isEmpty() && m_rowDelimiter != FieldFormat::rowDelimiterString());
 
-  QList<int> cols;
-  QStringList names;
+  // resolve the field for each assigned column once, rather than for every row
+  QVector<CSVColumn> columns;
+  Data::FieldList fields;
   for(int col = 0; col < m_table->columnCount(); ++col) {
-    QString t = m_table->horizontalHeaderItem(col)->text();
-    if(m_coll->fieldByTitle(t)) {
-      cols << col;
-      names << m_coll->fieldNameByTitle(t);
+    Data::FieldPtr field = m_coll->fieldByTitle(m_table->horizontalHeaderItem(col)->text());
+    if(!field) {
+      continue;
+    }
+    const bool isTable = field->type() == Data::Field::Table;
+    CSVColumn column;
+    column.index = col;
+    column.replaceColDelimiter = replaceColDelimiter && isTable;
+    column.replaceRowDelimiter = replaceRowDelimiter && isTable;
+    column.special = CSVColumn::Plain;
+    if(m_isLibraryThing) {
+      if(field->name() == QLatin1String("isbn")) {
+        column.special = CSVColumn::LibraryThingIsbn;
+      } else if(field->name() == QLatin1String("keyword")) {
+        column.special = CSVColumn::LibraryThingKeyword;
+      } else if(field->name() == QLatin1String("cdate")) {
+        column.special = CSVColumn::LibraryThingDate;
+      }
     }
+    columns << column;
+    fields << field;
   }
 
-  if(names.isEmpty()) {
+  if(columns.isEmpty()) {
     myDebug() << "no fields assigned";
     return Data::CollPtr();
   }
 
-  m_parser->reset(text());
+  QIODevice* dev = device();
+  if(!dev) {
+    return Data::CollPtr();
+  }
+  m_parser->reset(dev);
 
   // if the first row are headers, skip it
   if(m_firstRowHeader) {
     m_parser->skipLine();
   }
 
-  const uint numChars = text().size();
-  const uint stepSize = qMax(s_stepSize, numChars/100);
+  const qint64 totalBytes = qMax(Q_INT64_C(1), dev->size());
   const bool showProgress = options() & ImportProgress;
 
-  // do we need to replace column or row delimiters
-  const bool replaceColDelimiter = (!m_colDelimiter.isEmpty() && m_colDelimiter != FieldFormat::columnDelimiterString());
-  const bool replaceRowDelimiter = (!m_rowDelimiter.isEmpty() && m_rowDelimiter != FieldFormat::rowDelimiterString());
+  // while one batch is being cleaned up by the worker, the next one is parsed
+  // and the previous one is added to the collection
+  QVector<QStringList> parsed, pending, normalized;
+  QThreadPool pool;
+  pool.setMaxThreadCount(1);
 
-  uint j = 0;
-  while(!m_cancelled && m_parser->hasNext()) {
-    bool empty = true;
-    Data::EntryPtr entry(new Data::Entry(m_coll));
-    QStringList values = m_parser->nextTokens();
-    for(int i = 0; i < names.size(); ++i) {
-      if(cols[i] >= values.size()) {
+  while(!m_cancelled) {
+    parsed.clear();
+    while(parsed.size() < CSV_BATCH_SIZE && m_parser->hasNext()) {
+      parsed.append(m_parser->nextTokens());
+    }
+
+    pool.waitForDone();
+    normalized.swap(pending);
+    pending.swap(parsed);
+    if(!pending.isEmpty()) {
+      pool.start(new NormalizeTask(&pending, columns, m_colDelimiter, m_rowDelimiter));
+    }
+    if(normalized.isEmpty()) {
+      if(pending.isEmpty()) {
         break;
       }
-      QString value = values[cols[i]].trimmed();
-      // only replace delimiters for tables
-      // see https://forum.kde.org/viewtopic.php?f=200&t=142712
-      if(replaceColDelimiter && m_coll->fieldByName(names[i])->type() == Data::Field::Table) {
-        value.replace(m_colDelimiter, FieldFormat::columnDelimiterString());
-      }
-      if(replaceRowDelimiter && m_coll->fieldByName(names[i])->type() == Data::Field::Table) {
-        value.replace(m_rowDelimiter, FieldFormat::rowDelimiterString());
-      }
-      if(m_isLibraryThing) {
-        // special cases for LibraryThing import
-        if(names[i] == QLatin1String("isbn")) {
-          // ISBN values are enclosed by brackets
-          value.remove(QLatin1Char('[')).remove(QLatin1Char(']'));
-        } else if(names[i] == QLatin1String("keyword")) {
-          // LT values are comma-separated
-          value.replace(QLatin1String(","), FieldFormat::delimiterString());
-        } else if(names[i] == QLatin1String("cdate")) {
-          // only want date, not time. 10 characters since it's zero-padded
-          value.truncate(10);
+      continue;
+    }
+
+    Data::EntryList entries;
+    entries.reserve(normalized.size());
+    foreach(const QStringList& values, normalized) {
+      bool empty = true;
+      Data::EntryPtr entry(new Data::Entry(m_coll));
+      for(int i = 0; i < values.size(); ++i) {
+        const QString& value = values.at(i);
+        const QString& name = fields.at(i)->name();
+        bool success = entry->setField(name, value);
+        // we might need to add a new allowed value
+        // assume that if the user is importing the value, it should be allowed
+        if(!success && fields.at(i)->type() == Data::Field::Choice) {
+          Data::FieldPtr f = fields.at(i);
+          StringSet allow;
+          allow.add(f->allowed());
+          allow.add(value);
+          f->setAllowed(allow.toList());
+          m_coll->modifyField(f);
+          success = entry->setField(name, value);
+        }
+        if(empty && success) {
+          empty = false;
         }
       }
-      bool success = entry->setField(names[i], value);
-      // we might need to add a new allowed value
-      // assume that if the user is importing the value, it should be allowed
-      if(!success && m_coll->fieldByName(names[i])->type() == Data::Field::Choice) {
-        Data::FieldPtr f = m_coll->fieldByName(names[i]);
-        StringSet allow;
-        allow.add(f->allowed());
-        allow.add(value);
-        f->setAllowed(allow.toList());
-        m_coll->modifyField(f);
-        success = entry->setField(names[i], value);
-      }
-      if(empty && success) {
-        empty = false;
+      if(!empty) {
+        entries << entry;
       }
-      j += value.size();
-    }
-    if(!empty) {
-      m_coll->addEntries(entry);
     }
+    m_coll->addEntries(entries);
 
-    if(showProgress && j%stepSize == 0) {
-      emit signalProgress(this, 100*j/numChars);
+    if(showProgress) {
+      emit signalProgress(this, 100*m_parser->pos()/totalBytes);
       qApp->processEvents();
     }
   }
+  pool.waitForDone();
 
   {
     KConfigGroup config(KSharedConfig::openConfig(), QLatin1String("ImportOptions - CSV"));
@@ -389,7 +509,11 @@ void CSVImporter::fillTable() {
     return;
   }
 
-  m_parser->reset(text());
+  QIODevice* dev = device();
+  if(!dev) {
+    return;
+  }
+  m_parser->reset(dev);
   // not skipping first row since the updateHeader() call depends on it
 
   int maxCols = 0;
@@ -25,7 +25,7 @@
 #ifndef TELLICO_CSVIMPORTER_H
 #define TELLICO_CSVIMPORTER_H
 
-#include "textimporter.h"
+#include "dataimporter.h"
 #include "../datavectors.h"
 
 class CSVImporterWidget;
@@ -38,6 +38,8 @@ class QPushButton;
 class QCheckBox;
 class QRadioButton;
 class QTableWidget;
+class QBuffer;
+class QIODevice;
 
 namespace Tellico {
   namespace GUI {
@@ -49,7 +51,7 @@ namespace Tellico {
 /**
  * @author Robby Stephenson
  */
-class CSVImporter : public TextImporter {
+class CSVImporter : public DataImporter {
 Q_OBJECT
 
 public:
@@ -87,6 +89,11 @@ private:
   void updateHeader();
   void createCollection();
   void updateFieldCombo();
+  /**
+   * Returns the open device for the file, which is read in chunks rather than
+   * all at once, since CSV files can be very large.
+   */
+  QIODevice* device();
 
   Data::CollPtr m_coll;
   Data::CollPtr m_existingCollection; // used to grab fields from current collection in window
@@ -114,6 +121,7 @@ private:
   bool m_isLibraryThing;
 
   CSVParser* m_parser;
+  QBuffer* m_buffer;
 };
 
   } // end namespace
@@ -25,7 +25,9 @@
 #include "csvparser.h"
 
 #include <QTextStream>
+#include <QTextCodec>
 #include <QStringList>
+#include <QIODevice>
 
 #include <config.h>
 
@@ -45,29 +47,77 @@ static int isSpace(unsigned char c);
 static int isSpaceOrTab(unsigned char c);
 static int isTab(unsigned char c);
 
+namespace {
+  // devices are read 64 KiB at a time
+  static const qint64 CSV_CHUNK_SIZE = 64 * 1024;
+}
+
 using Tellico::CSVParser;
 
 class CSVParser::Private {
 public:
-  Private() : stream(nullptr), done(false) {
+  Private(CSVParser* q_) : q(q_), stream(nullptr), device(nullptr), decoder(nullptr),
+      bytesRead(0), done(false), finished(false) {
     csv_init(&parser, 0);
   }
   ~Private() {
     csv_free(&parser);
     delete stream;
+    delete decoder;
   }
 
+  void fill();
+
+  CSVParser* q;
   struct csv_parser parser;
   QString str;
   QTextStream* stream;
   QStringList tokens;
+  // used when reading from a device
+  QIODevice* device;
+  QTextDecoder* decoder;
+  QList<QStringList> rows;
+  qint64 bytesRead;
   bool done;
+  bool finished;
 };
 
-CSVParser::CSVParser(QString str) : d(new Private()) {
+void CSVParser::Private::fill() {
+  while(rows.isEmpty() && !finished) {
+    QByteArray chunk = device->read(CSV_CHUNK_SIZE);
+    if(chunk.isEmpty()) {
+      // the last row might not end with a newline
+      csv_fini(&parser, &writeToken, &writeRow, q);
+      finished = true;
+      break;
+    }
+    if(bytesRead == 0) {
+      // libcsv is fed utf-8, so anything else gets converted first
+      // check for a byte order mark, otherwise use the locale, same as QTextStream
+      QTextCodec* codec = QTextCodec::codecForUtfText(chunk, QTextCodec::codecForLocale());
+      if(codec && codec->mibEnum() != 106) { // 106 is UTF-8
+        decoder = codec->makeDecoder();
+      } else if(chunk.startsWith("\xEF\xBB\xBF")) {
+        chunk.remove(0, 3);
+        bytesRead += 3;
+      }
+    }
+    bytesRead += chunk.size();
+    if(decoder) {
+      chunk = decoder->toUnicode(chunk).toUtf8();
+    }
+    csv_parse(&parser, chunk.constData(), chunk.size(), &writeToken, &writeRow, q);
+  }
+}
+
+CSVParser::CSVParser(QString str) : d(new Private(this)) {
   reset(str);
 }
 
+CSVParser::CSVParser(QIODevice* device) : d(new Private(this)) {
+  reset(device);
+}
+
 CSVParser::~CSVParser() {
   delete d;
 }
@@ -84,25 +134,68 @@ void CSVParser::reset(QString str) {
   delete d->stream;
   d->str = str;
   d->stream = new QTextStream(&d->str);
+  d->device = nullptr;
+  d->rows.clear();
+}
+
+void CSVParser::reset(QIODevice* device) {
+  // drop any partial row left over from a previous parse
+  csv_fini(&d->parser, nullptr, nullptr, nullptr);
+  delete d->stream;
+  d->stream = nullptr;
+  d->str.clear();
+  delete d->decoder;
+  d->decoder = nullptr;
+  d->device = device;
+  if(d->device && !d->device->isSequential()) {
+    d->device->seek(0);
+  }
+  d->tokens.clear();
+  d->rows.clear();
+  d->bytesRead = 0;
+  d->finished = false;
 }
 
 bool CSVParser::hasNext() const {
+  if(d->device) {
+    d->fill();
+    return !d->rows.isEmpty();
+  }
   return !d->stream->atEnd();
 }
 
 void CSVParser::skipLine() {
+  if(d->device) {
+    // a row may have quoted newlines, so skip the whole row
+    if(hasNext()) {
+      d->rows.removeFirst();
+    }
+    return;
+  }
   d->stream->readLine();
 }
 
+qint64 CSVParser::pos() const {
+  return d->bytesRead;
+}
+
 void CSVParser::addToken(const QString& t) {
   d->tokens += t;
 }
 
 void CSVParser::setRowDone(bool b) {
   d->done = b;
+  // a single chunk from a device may hold many rows
+  if(b && d->device) {
+    d->rows.append(d->tokens);
+    d->tokens.clear();
+  }
 }
 
 QStringList CSVParser::nextTokens() {
+  if(d->device) {
+    return hasNext() ? d->rows.takeFirst() : QStringList();
+  }
   d->tokens.clear();
   d->done = false;
   while(hasNext() && !d->done) {
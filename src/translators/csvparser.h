@@ -27,17 +27,33 @@
 
 #include <QString>
 
+class QIODevice;
+
 namespace Tellico {
 
+/**
+ * The CSVParser splits text into rows of tokens. The text is either a string,
+ * which is parsed line by line, or a device, which is read and parsed in chunks,
+ * so that the whole file is never in memory.
+ */
 class CSVParser {
 public:
   CSVParser(QString str);
+  /**
+   * The device must already be open. It is not owned by the parser.
+   */
+  explicit CSVParser(QIODevice* device);
   ~CSVParser();
 
   void setDelimiter(const QString& s);
   void reset(QString str);
+  void reset(QIODevice* device);
   bool hasNext() const;
   void skipLine();
+  /**
+   * Returns how many bytes of the device have been read so far.
+   */
+  qint64 pos() const;
 
   void addToken(const QString& t);
   void setRowDone(bool b);
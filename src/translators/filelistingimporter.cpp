@@ -58,15 +58,162 @@
 #include <QFileInfo>
 #include <QVBoxLayout>
 #include <QApplication>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QStandardPaths>
 
 namespace {
   static const int FILE_PREVIEW_SIZE = 128;
 }
 
+#ifdef HAVE_KFILEMETADATA
+namespace {
+  // number of files queued for metadata extraction for each thread
+  static const int FILE_METADATA_QUEUE_DEPTH = 4;
+  static const quint32 FILE_METADATA_CACHE_MAGIC = 0x544c4d44; // "TLMD"
+  static const quint32 FILE_METADATA_CACHE_VERSION = 1;
+
+  // the metadata of a file is only extracted again if the modification time or size changed
+  struct MetaDataCacheItem {
+    qint64 modified;
+    qint64 size;
+    QString metaInfo;
+  };
+  typedef QHash<QString, MetaDataCacheItem> MetaDataCache;
+
+  void readMetaDataCache(const QString& fileName_, MetaDataCache& cache_) {
+    QFile file(fileName_);
+    if(!file.open(QIODevice::ReadOnly)) {
+      return;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_4);
+    quint32 magic, version;
+    stream >> magic >> version;
+    if(magic != FILE_METADATA_CACHE_MAGIC || version != FILE_METADATA_CACHE_VERSION) {
+      return;
+    }
+    quint32 count;
+    stream >> count;
+    for(quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+      QString path;
+      MetaDataCacheItem item;
+      stream >> path >> item.modified >> item.size >> item.metaInfo;
+      cache_.insert(path, item);
+    }
+    if(stream.status() != QDataStream::Ok) {
+      myDebug() << "corrupt metadata cache";
+      cache_.clear();
+    }
+  }
+
+  void writeMetaDataCache(const QString& fileName_, const MetaDataCache& cache_) {
+    QDir().mkpath(QFileInfo(fileName_).absolutePath());
+    QSaveFile file(fileName_);
+    if(!file.open(QIODevice::WriteOnly)) {
+      myDebug() << "unable to write metadata cache";
+      return;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_4);
+    stream << FILE_METADATA_CACHE_MAGIC << FILE_METADATA_CACHE_VERSION << quint32(cache_.count());
+    for(MetaDataCache::ConstIterator it = cache_.constBegin(); it != cache_.constEnd(); ++it) {
+      stream << it.key() << it.value().modified << it.value().size << it.value().metaInfo;
+    }
+    file.commit();
+  }
+
+  // the extraction results, keyed by the index of the file, so the entries can be added in order
+  struct MetaDataResults {
+    QMutex mutex;
+    QWaitCondition resultReady;
+    QHash<int, QString> results;
+
+    void insert(int index_, const QString& metaInfo_) {
+      QMutexLocker lock(&mutex);
+      results.insert(index_, metaInfo_);
+      resultReady.wakeAll();
+    }
+    // a slow file shouldn't freeze the gui, so events are processed while waiting.
+    // Returns an empty string once the import is cancelled
+    QString take(int index_, const bool& cancelled_) {
+      QMutexLocker lock(&mutex);
+      while(!results.contains(index_)) {
+        if(cancelled_) {
+          return QString();
+        }
+        if(!resultReady.wait(&mutex, 100)) {
+          lock.unlock();
+          qApp->processEvents();
+          lock.relock();
+        }
+      }
+      return results.take(index_);
+    }
+  };
+
+  QString extractMetaData(const QString& path_, const QString& mimeType_,
+                          const QList<KFileMetaData::Extractor*>& extractors_) {
+    static const QStringList metaIgnore = QStringList()
+                                        << QLatin1String("mimeType")
+                                        << QLatin1String("url")
+                                        << QLatin1String("fileName")
+                                        << QLatin1String("lastModified")
+                                        << QLatin1String("contentSize")
+                                        << QLatin1String("type");
+    KFileMetaData::SimpleExtractionResult result(path_, mimeType_, KFileMetaData::ExtractionResult::ExtractMetaData);
+    foreach(KFileMetaData::Extractor* ex, extractors_) {
+      ex->extract(&result);
+    }
+    QStringList strings;
+    KFileMetaData::PropertyMap properties = result.properties();
+    KFileMetaData::PropertyMap::const_iterator it = properties.constBegin();
+    for( ; it != properties.constEnd(); ++it) {
+      const QString s = it.value().toString();
+      if(!s.isEmpty()) {
+        const QString label = KFileMetaData::PropertyInfo(it.key()).displayName();
+        if(!metaIgnore.contains(label)) {
+          strings << label + Tellico::FieldFormat::columnDelimiterString() + s;
+        }
+      }
+    }
+    return strings.join(Tellico::FieldFormat::rowDelimiterString());
+  }
+
+  class MetaDataTask : public QRunnable {
+  public:
+    MetaDataTask(MetaDataResults* results_, int index_, const QString& path_, const QString& mimeType_,
+                 const QList<KFileMetaData::Extractor*>& extractors_)
+        : QRunnable(), m_results(results_), m_index(index_), m_path(path_), m_mimeType(mimeType_)
+        , m_extractors(extractors_) {}
+
+    void run() Q_DECL_OVERRIDE {
+      m_results->insert(m_index, extractMetaData(m_path, m_mimeType, m_extractors));
+    }
+
+  private:
+    MetaDataResults* m_results;
+    int m_index;
+    QString m_path;
+    QString m_mimeType;
+    QList<KFileMetaData::Extractor*> m_extractors;
+  };
+}
+#endif
+
 using Tellico::Import::FileListingImporter;
 
 FileListingImporter::FileListingImporter(const QUrl& url_) : Importer(url_), m_coll(nullptr), m_widget(nullptr),
-    m_recursive(nullptr), m_filePreview(nullptr), m_job(nullptr), m_cancelled(false) {
+    m_recursive(nullptr), m_filePreview(nullptr), m_metaDataCache(nullptr), m_job(nullptr), m_cancelled(false) {
+  m_metaDataCacheFile = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QLatin1String("/filelisting-metadata");
+}
+
+void FileListingImporter::setMetaDataCacheFile(const QString& fileName_) {
+  m_metaDataCacheFile = fileName_;
 }
 
 bool FileListingImporter::canImport(int type) const {
@@ -87,7 +234,8 @@ Tellico::Data::CollPtr FileListingImporter::collection() {
   const QString volume = volumeName();
 
   // the importer might be running without a gui/widget
-  m_job = (m_widget && m_recursive->isChecked())
+  const bool recursive = m_widget && m_recursive->isChecked();
+  m_job = recursive
           ? KIO::listRecursive(url(), KIO::DefaultFlags, false /* include hidden */)
           : KIO::listDir(url(), KIO::DefaultFlags, false /* include hidden */);
   KJobWidgets::setWindow(m_job, GUI::Proxy::widget());
@@ -99,18 +247,6 @@ Tellico::Data::CollPtr FileListingImporter::collection() {
     return Data::CollPtr();
   }
 
-#ifdef HAVE_KFILEMETADATA
-  KFileMetaData::ExtractorCollection extractors;
-#endif
-
-  QStringList metaIgnore = QStringList()
-                         << QLatin1String("mimeType")
-                         << QLatin1String("url")
-                         << QLatin1String("fileName")
-                         << QLatin1String("lastModified")
-                         << QLatin1String("contentSize")
-                         << QLatin1String("type");
-
   const bool usePreview = m_widget && m_filePreview->isChecked();
 
   const QString title    = QLatin1String("title");
@@ -130,15 +266,52 @@ Tellico::Data::CollPtr FileListingImporter::collection() {
 
   m_coll = new Data::FileCatalog(true);
   QString tmp;
-  const uint stepSize = qMax(1, m_files.count()/100);
+  const int stepSize = qMax(1, m_files.count()/100);
   const bool showProgress = options() & ImportProgress;
 
   item.setTotalSteps(m_files.count());
-  uint j = 0;
-  foreach(const KFileItem& item, m_files) {
+
+#ifdef HAVE_KFILEMETADATA
+  // the cache is used by default when running without a gui
+  const bool useCache = !m_widget || m_metaDataCache->isChecked();
+  MetaDataCache cache, scannedCache;
+  if(useCache) {
+    readMetaDataCache(m_metaDataCacheFile, cache);
+  }
+  // the extractor plugins are loaded through QPluginLoader, which shares a single instance of each
+  // plugin across the whole process, and extract() isn't documented to be thread-safe. So the
+  // metadata extraction runs in a single background thread, never calling an extractor concurrently.
+  KFileMetaData::ExtractorCollection extractors;
+  // the entries are created here in order, while the metadata of the next files gets extracted.
+  // only a few files are queued, so the pending results stay small
+  MetaDataResults metaResults;
+  QThreadPool pool;
+  pool.setMaxThreadCount(1);
+  const int queueDepth = FILE_METADATA_QUEUE_DEPTH * qMax(1, pool.maxThreadCount());
+  int queued = 0;
+#endif
+
+  for(int j = 0; j < m_files.count(); ++j) {
     if(m_cancelled) {
       break;
     }
+    const KFileItem& item = m_files.at(j);
+
+#ifdef HAVE_KFILEMETADATA
+    for( ; queued < m_files.count() && queued < j + queueDepth; ++queued) {
+      const KFileItem& queuedItem = m_files.at(queued);
+      const QString path = queuedItem.url().isLocalFile() ? queuedItem.url().toLocalFile() : queuedItem.url().url();
+      const qint64 fileModified = queuedItem.time(KFileItem::ModificationTime).toMSecsSinceEpoch();
+      const qint64 fileSize = static_cast<qint64>(queuedItem.size());
+      MetaDataCache::ConstIterator cacheIt = cache.constFind(path);
+      if(cacheIt != cache.constEnd() && cacheIt.value().modified == fileModified && cacheIt.value().size == fileSize) {
+        metaResults.insert(queued, cacheIt.value().metaInfo);
+      } else {
+        pool.start(new MetaDataTask(&metaResults, queued, path, queuedItem.mimetype(),
+                                    extractors.fetchExtractors(queuedItem.mimetype())));
+      }
+    }
+#endif
 
     Data::EntryPtr entry(new Data::Entry(m_coll));
 
@@ -166,24 +339,18 @@ Tellico::Data::CollPtr FileListingImporter::collection() {
     }
 
 #ifdef HAVE_KFILEMETADATA
-    KFileMetaData::SimpleExtractionResult result(u.url(), item.mimetype(), KFileMetaData::ExtractionResult::ExtractMetaData);
-    QList<KFileMetaData::Extractor*> exList = extractors.fetchExtractors(item.mimetype());
-    foreach(KFileMetaData::Extractor* ex, exList) {
-      ex->extract(&result);
+    const QString metaInfo = metaResults.take(j, m_cancelled);
+    if(m_cancelled) {
+      break;
     }
-    QStringList strings;
-    KFileMetaData::PropertyMap properties = result.properties();
-    KFileMetaData::PropertyMap::const_iterator it = properties.constBegin();
-    for( ; it != properties.constEnd(); ++it) {
-      const QString s = it.value().toString();
-      if(!s.isEmpty()) {
-        const QString label = KFileMetaData::PropertyInfo(it.key()).displayName();
-        if(!metaIgnore.contains(label)) {
-          strings << label + FieldFormat::columnDelimiterString() + s;
-        }
-      }
+    entry->setField(metainfo, metaInfo);
+    if(useCache) {
+      MetaDataCacheItem cacheItem;
+      cacheItem.modified = item.time(KFileItem::ModificationTime).toMSecsSinceEpoch();
+      cacheItem.size = static_cast<qint64>(item.size());
+      cacheItem.metaInfo = metaInfo;
+      scannedCache.insert(u.isLocalFile() ? u.toLocalFile() : u.url(), cacheItem);
     }
-    entry->setField(metainfo, strings.join(FieldFormat::rowDelimiterString()));
 #endif
 
     if(!m_cancelled && usePreview) {
@@ -209,9 +376,30 @@ Tellico::Data::CollPtr FileListingImporter::collection() {
       ProgressManager::self()->setProgress(this, j);
       qApp->processEvents();
     }
-    ++j;
   }
 
+#ifdef HAVE_KFILEMETADATA
+  // don't wait for files which are no longer needed
+  pool.clear();
+  pool.waitForDone();
+  if(useCache && !m_cancelled) {
+    // files in the scanned folder which no longer exist are dropped from the cache. Without
+    // recursion, the subfolders weren't scanned, so only the files directly in the folder are dropped
+    QString scannedPath = this->url().isLocalFile() ? this->url().toLocalFile() : this->url().url();
+    if(!scannedPath.endsWith(QLatin1Char('/'))) {
+      scannedPath += QLatin1Char('/');
+    }
+    for(MetaDataCache::ConstIterator it = cache.constBegin(); it != cache.constEnd(); ++it) {
+      const bool scanned = it.key().startsWith(scannedPath) &&
+                           (recursive || it.key().indexOf(QLatin1Char('/'), scannedPath.length()) == -1);
+      if(!scanned) {
+        scannedCache.insert(it.key(), it.value());
+      }
+    }
+    writeMetaDataCache(m_metaDataCacheFile, scannedCache);
+  }
+#endif
+
   if(m_cancelled) {
     m_coll = Data::CollPtr();
     return m_coll;
@@ -242,8 +430,14 @@ QWidget* FileListingImporter::widget(QWidget* parent_) {
   // by default, make it no previews
   m_filePreview->setChecked(false);
 
+  m_metaDataCache = new QCheckBox(i18n("Remember file metadata"), gbox);
+  m_metaDataCache->setWhatsThis(i18n("If checked, the metadata read from each file is saved, and only files which "
+                                     "have changed are read again the next time the folder is scanned."));
+  m_metaDataCache->setChecked(true);
+
   vlay->addWidget(m_recursive);
   vlay->addWidget(m_filePreview);
+  vlay->addWidget(m_metaDataCache);
 
   l->addWidget(gbox);
   l->addStretch(1);
@@ -58,6 +58,10 @@ public:
    */
   virtual QWidget* widget(QWidget*) Q_DECL_OVERRIDE;
   virtual bool canImport(int type) const Q_DECL_OVERRIDE;
+  /**
+   * Sets the file used to remember the metadata of each file. By default, it's in the cache location.
+   */
+  void setMetaDataCacheFile(const QString& fileName);
 
 public Q_SLOTS:
   void slotCancel();
@@ -72,9 +76,11 @@ private:
   QWidget* m_widget;
   QCheckBox* m_recursive;
   QCheckBox* m_filePreview;
+  QCheckBox* m_metaDataCache;
   QPointer<KIO::Job> m_job;
   KFileItemList m_files;
   QPixmap m_pixmap;
+  QString m_metaDataCacheFile;
   bool m_cancelled;
 };
 
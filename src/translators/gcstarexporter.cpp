@@ -154,7 +154,7 @@ QString GCstarExporter::text() {
   exporter.setIncludeImages(false); // do not include images in XML
 // yes, this should be in utf8, always
   exporter.setOptions(options() | Export::ExportUTF8);
-  return m_handler->applyStylesheet(exporter.exportXML().toString());
+  return m_handler->applyStylesheet(exporter.exportXMLDoc());
 }
 
 QWidget* GCstarExporter::widget(QWidget* parent_) {
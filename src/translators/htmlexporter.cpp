@@ -60,14 +60,97 @@
 #include <QFileInfo>
 #include <QApplication>
 #include <QLocale>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QVector>
 
 extern "C" {
-#include <libxml/HTMLparser.h>
-#include <libxml/HTMLtree.h>
+#include <libxml/tree.h>
 }
 
 using Tellico::Export::HTMLExporter;
 
+namespace {
+
+// state shared by all the entry file tasks, only the counters are modified while the tasks run
+struct EntryFileState {
+  Tellico::XSLTHandler* handler;
+  xmlNodePtr root;
+  xmlNodePtr collection;
+  bool encodeUTF8;
+  QAtomicInt done;
+  QAtomicInt failed;
+  QAtomicInt cancelled;
+};
+
+// creates a document with the collection, but only a single entry and its images
+xmlDocPtr entryDocument(const EntryFileState* state_, xmlNodePtr entry_, const QVector<xmlNodePtr>& images_) {
+  xmlDocPtr doc = xmlNewDoc(reinterpret_cast<const xmlChar*>("1.0"));
+  xmlNodePtr root = xmlDocCopyNode(state_->root, doc, 2 /* attributes and namespaces */);
+  xmlDocSetRootElement(doc, root);
+  for(xmlNodePtr rootChild = state_->root->children; rootChild; rootChild = rootChild->next) {
+    if(rootChild != state_->collection) {
+      // borrowers and filters
+      xmlAddChild(root, xmlDocCopyNode(rootChild, doc, 1));
+      continue;
+    }
+    xmlNodePtr coll = xmlAddChild(root, xmlDocCopyNode(rootChild, doc, 2));
+    for(xmlNodePtr child = rootChild->children; child; child = child->next) {
+      if(child->type == XML_ELEMENT_NODE && xmlStrEqual(child->name, reinterpret_cast<const xmlChar*>("entry"))) {
+        if(child == entry_) {
+          xmlAddChild(coll, xmlDocCopyNode(child, doc, 1));
+        }
+      } else if(child->type == XML_ELEMENT_NODE && xmlStrEqual(child->name, reinterpret_cast<const xmlChar*>("images"))) {
+        if(!images_.isEmpty()) {
+          xmlNodePtr images = xmlAddChild(coll, xmlDocCopyNode(child, doc, 2));
+          foreach(xmlNodePtr image, images_) {
+            xmlAddChild(images, xmlDocCopyNode(image, doc, 1));
+          }
+        }
+      } else {
+        xmlAddChild(coll, xmlDocCopyNode(child, doc, 1));
+      }
+    }
+  }
+  return doc;
+}
+
+// transforms a single entry and writes it to a local file, or keeps the text if the file is remote
+class EntryFileTask : public QRunnable {
+public:
+  EntryFileTask(EntryFileState* state_, xmlNodePtr entry_, const QVector<xmlNodePtr>& images_,
+                const QString& fileName_, QString* text_)
+      : QRunnable(), m_state(state_), m_entry(entry_), m_images(images_), m_fileName(fileName_), m_text(text_) {}
+
+  void run() Q_DECL_OVERRIDE {
+    if(m_state->cancelled.load()) {
+      return;
+    }
+    const QString text = m_state->handler->applyStylesheet(entryDocument(m_state, m_entry, m_images));
+    if(m_fileName.isEmpty()) {
+      *m_text = text;
+    } else {
+      QSaveFile f(m_fileName);
+      if(text.isEmpty() ||
+         !f.open(QIODevice::WriteOnly) ||
+         !Tellico::FileHandler::writeTextFile(f, text, m_state->encodeUTF8)) {
+        m_state->failed.ref();
+      }
+    }
+    m_state->done.ref();
+  }
+
+private:
+  EntryFileState* m_state;
+  xmlNodePtr m_entry;
+  QVector<xmlNodePtr> m_images;
+  QString m_fileName;
+  QString* m_text;
+};
+
+}
+
 HTMLExporter::HTMLExporter(Tellico::Data::CollPtr coll_) : Tellico::Export::Exporter(coll_),
     m_handler(nullptr),
     m_printHeaders(true),
@@ -240,49 +323,39 @@ QString HTMLExporter::text() {
   exporter.setIncludeGroups(m_printGrouped);
 // yes, this should be in utf8, always
   exporter.setOptions(options() | Export::ExportUTF8 | Export::ExportImages);
-  QDomDocument output = exporter.exportXML();
-#if 0
-  QFile f(QLatin1String("/tmp/test.xml"));
-  if(f.open(QIODevice::WriteOnly)) {
-    QTextStream t(&f);
-    t << output.toString();
-  }
-  f.close();
-#endif
-
-  const QString outputText = m_handler->applyStylesheet(output.toString());
+  // the tree goes straight to libxslt, without being serialized and parsed again
+  xmlDocPtr output = exporter.exportXMLDoc();
 #if 0
-  myDebug() << "Remove debug2 from htmlexporter.cpp";
-  QFile f2(QLatin1String("/tmp/test.html"));
-  if(f2.open(QIODevice::WriteOnly)) {
-    QTextStream t(&f2);
-    t << outputText;
-//    t << "\n\n-------------------------------------------------------\n\n";
-//    t << Tellico::i18nReplace(outputText);
-  }
-  f2.close();
+  xmlSaveFile("/tmp/test.xml", output);
 #endif
 
   if(!m_parseDOM) {
-    return outputText;
+    return m_handler->applyStylesheet(output);
   }
 
-  htmlDocPtr htmlDoc = htmlParseDoc(reinterpret_cast<xmlChar*>(outputText.toUtf8().data()), nullptr);
+  // the links are fixed in the result tree, rather than parsing the serialized html
+  xmlDocPtr htmlDoc = m_handler->applyStylesheetToDoc(output);
+  if(!htmlDoc) {
+    return QString();
+  }
   xmlNodePtr root = xmlDocGetRootElement(htmlDoc);
   if(root == nullptr) {
     myDebug() << "no root";
-    return outputText;
+  } else {
+    parseDOM(root);
   }
-  parseDOM(root);
 
-  xmlChar* c;
-  int bytes;
-  htmlDocDumpMemory(htmlDoc, &c, &bytes);
-  QString allText;
-  if(bytes > 0) {
-    allText = QString::fromUtf8(reinterpret_cast<const char*>(c), bytes);
-    xmlFree(c);
+  const QString allText = m_handler->resultToString(htmlDoc);
+  xmlFreeDoc(htmlDoc);
+#if 0
+  myDebug() << "Remove debug2 from htmlexporter.cpp";
+  QFile f2(QLatin1String("/tmp/test.html"));
+  if(f2.open(QIODevice::WriteOnly)) {
+    QTextStream t(&f2);
+    t << allText;
   }
+  f2.close();
+#endif
   return allText;
 }
 
@@ -734,7 +807,6 @@ bool HTMLExporter::writeEntryFiles() {
 
   const int start = 60;
   const int stepSize = qMax(1, entries().count()/40);
-  int j = 0;
 
   // now worry about actually exporting entry files
   // I can't reliable encode a string as a URI, so I'm punting, and I'll just replace everything but
@@ -756,12 +828,12 @@ bool HTMLExporter::writeEntryFiles() {
   exporter.setOptions(opt);
   exporter.setXSLTFile(m_entryXSLTFile);
   exporter.setCollectionURL(url());
-  bool parseDOM = true;
 
   const QString title = QLatin1String("title");
   const QString html = QLatin1String(".html");
   bool multipleTitles = collection()->fieldByName(title)->hasFlag(Data::Field::AllowMultiple);
   Data::EntryList entries = this->entries(); // not const since the pointer has to be copied
+  QList<QUrl> outputFiles;
   foreach(Data::EntryPtr entryIt, entries) {
     QString file = entryIt->formattedField(title, formatted);
 
@@ -773,30 +845,114 @@ bool HTMLExporter::writeEntryFiles() {
     file += QLatin1Char('-') + QString::number(entryIt->id()) + html;
     outputFile = outputFile.adjusted(QUrl::RemoveFilename);
     outputFile.setPath(outputFile.path() + file);
+    outputFiles += outputFile;
+  }
 
-    exporter.setEntries(Data::EntryList() << entryIt);
-    exporter.setURL(outputFile);
-    exporter.exec();
-
-    // no longer need to parse DOM
-    if(parseDOM) {
-      parseDOM = false;
-      exporter.setParseDOM(false);
-      // this is rather stupid, but I'm too lazy to figure out the better way
-      // since we parsed the DOM for the first entry file to grab any
-      // images used in the template, need to resave it so the image links
-      // get written correctly
-      exporter.exec();
+  if(!entries.isEmpty()) {
+    // parse the DOM for the first entry file to grab any images used in the template
+    // and copy them, but the entry files themselves are written without parsing, so the links
+    // stay relative to the entry directory
+    exporter.setEntries(Data::EntryList() << entries.first());
+    exporter.setURL(outputFiles.first());
+    exporter.text();
+    exporter.copyFiles();
+    exporter.setParseDOM(false);
+    if(!exporter.loadXSLTFile()) {
+      myWarning() << "error loading entry xslt file:" << m_entryXSLTFile;
+      return false;
+    }
+    // sets the image directory param
+    exporter.writeImages(collection());
+
+    // the XML for the whole collection is only built once, every entry file is created
+    // from a copy of its own entry element, and the transformations run in parallel
+    // the URL is only used for relative links, which are the same for every entry file
+    TellicoXMLExporter xmlExporter(collection());
+    xmlExporter.setURL(outputFiles.first());
+    xmlExporter.setEntries(entries);
+    xmlExporter.setFields(fields());
+    xmlExporter.setOptions(opt | Export::ExportUTF8 | Export::ExportImages);
+    xmlDocPtr collDoc = xmlExporter.exportXMLDoc();
+
+    EntryFileState state;
+    state.handler = exporter.m_handler;
+    state.root = xmlDocGetRootElement(collDoc);
+    state.collection = nullptr;
+    state.encodeUTF8 = options() & Export::ExportUTF8;
+
+    QVector<xmlNodePtr> entryNodes;
+    QHash<QString, xmlNodePtr> imageNodes;
+    for(xmlNodePtr child = state.root ? state.root->children : nullptr; child; child = child->next) {
+      if(child->type == XML_ELEMENT_NODE && xmlStrEqual(child->name, reinterpret_cast<const xmlChar*>("collection"))) {
+        state.collection = child;
+        break;
+      }
+    }
+    for(xmlNodePtr child = state.collection ? state.collection->children : nullptr; child; child = child->next) {
+      if(child->type != XML_ELEMENT_NODE) {
+        continue;
+      }
+      if(xmlStrEqual(child->name, reinterpret_cast<const xmlChar*>("entry"))) {
+        entryNodes += child;
+      } else if(xmlStrEqual(child->name, reinterpret_cast<const xmlChar*>("images"))) {
+        for(xmlNodePtr image = child->children; image; image = image->next) {
+          xmlChar* id = xmlGetProp(image, reinterpret_cast<const xmlChar*>("id"));
+          if(id) {
+            imageNodes.insert(QString::fromUtf8(reinterpret_cast<const char*>(id)), image);
+            xmlFree(id);
+          }
+        }
+      }
+    }
+    // the entry elements are in the same order as the entries
+    if(entryNodes.count() != entries.count()) {
+      myWarning() << "mismatched entry XML";
+      xmlFreeDoc(collDoc);
+      return false;
     }
 
-    if(j%stepSize == 0) {
+    const bool writeLocal = url().isLocalFile();
+    Data::FieldList imageFields = collection()->imageFields();
+    QSet<Data::FieldPtr> imageFieldsSet = imageFields.toSet();
+    imageFields = imageFieldsSet.intersect(fields().toSet()).toList();
+    QVector<QString> texts(writeLocal ? 0 : entries.count());
+
+    QThreadPool pool;
+    for(int i = 0; i < entries.count(); ++i) {
+      // the entries are not thread-safe, so grab the image ids now
+      QVector<xmlNodePtr> images;
+      foreach(Data::FieldPtr field, imageFields) {
+        xmlNodePtr image = imageNodes.value(entries.at(i)->field(field));
+        if(image && !images.contains(image)) {
+          images += image;
+        }
+      }
+      pool.start(new EntryFileTask(&state, entryNodes.at(i), images,
+                                   writeLocal ? outputFiles.at(i).toLocalFile() : QString(),
+                                   writeLocal ? nullptr : &texts[i]));
+    }
+
+    while(!pool.waitForDone(100)) {
+      if(m_cancelled && !state.cancelled.load()) {
+        state.cancelled.store(1);
+        pool.clear();
+      }
       if(options() & ExportProgress) {
-        ProgressManager::self()->setProgress(this, qMin(start+j/stepSize, 99));
+        ProgressManager::self()->setProgress(this, qMin(start+state.done.load()/stepSize, 99));
       }
       qApp->processEvents();
     }
-    ++j;
+    xmlFreeDoc(collDoc);
+
+    if(state.failed.load() > 0) {
+      myWarning() << "unable to write" << state.failed.load() << "entry files";
+    }
+    // KIO is not thread-safe, so remote files are written afterwards
+    for(int i = 0; i < texts.count() && !m_cancelled; ++i) {
+      FileHandler::writeTextURL(outputFiles.at(i), texts.at(i), options() & Export::ExportUTF8, true);
+    }
   }
+
   // the images in "pics/" are special data images, copy them always
   // since the entry files may refer to them, but we don't know that
   QStringList dataImages;
@@ -45,7 +45,6 @@
 #include <QBuffer>
 #include <QCheckBox>
 #include <QGroupBox>
-#include <QTextStream>
 #include <QVBoxLayout>
 
 using Tellico::Export::ONIXExporter;
@@ -156,16 +155,7 @@ QString ONIXExporter::text() {
   exporter.setIncludeImages(false); // do not include images in XML
 // yes, this should be in utf8, always
   exporter.setOptions(options() | Export::ExportUTF8);
-  QDomDocument output = exporter.exportXML();
-#if 0
-  QFile f(QLatin1String("/tmp/test.xml"));
-  if(f.open(QIODevice::WriteOnly)) {
-    QTextStream t(&f);
-    t << output.toString();
-  }
-  f.close();
-#endif
-  return m_handler->applyStylesheet(output.toString());
+  return m_handler->applyStylesheet(exporter.exportXMLDoc());
 }
 
 QWidget* ONIXExporter::widget(QWidget* parent_) {
@@ -44,6 +44,9 @@
 #include <QTimer>
 #include <QApplication>
 #include <QPointer>
+#include <QXmlStreamReader>
+#include <QElapsedTimer>
+#include <QScopedPointer>
 
 using Tellico::Import::TellicoImporter;
 
@@ -97,7 +100,15 @@ Tellico::Data::CollPtr TellicoImporter::collection() {
   // if the first 5 characters are <?xml then treat it like text
   if(s[0] == '<' && s[1] == '?' && s[2] == 'x' && s[3] == 'm' && s[4] == 'l') {
     m_format = XML;
-    loadXMLData(source() == URL ? fileRef().file()->readAll() : data(), true);
+    if(source() == URL) {
+      QIODevice* f = fileRef().file();
+      loadXMLData(f, f->size(), true);
+    } else {
+      QBuffer buffer;
+      buffer.setData(data());
+      buffer.open(QIODevice::ReadOnly);
+      loadXMLData(&buffer, buffer.size(), true);
+    }
   } else {
     m_format = Zip;
     loadZipData();
@@ -105,40 +116,37 @@ Tellico::Data::CollPtr TellicoImporter::collection() {
   return thisPtr ? m_coll : Data::CollPtr();
 }
 
-void TellicoImporter::loadXMLData(const QByteArray& data_, bool loadImages_) {
+void TellicoImporter::loadXMLData(QIODevice* device_, qint64 size_, bool loadImages_) {
   const bool showProgress = options() & ImportProgress;
 
   TellicoXMLHandler handler;
   handler.setLoadImages(loadImages_);
   handler.setShowImageLoadErrors(options() & ImportShowImageErrors);
 
-  QXmlSimpleReader reader;
-  reader.setContentHandler(&handler);
-
-  QXmlInputSource source;
-  source.setData(QByteArray()); // necessary
-  bool success = reader.parse(&source, true);
+  // the reader pulls from the device as needed, so the whole file is never in memory at once
+  QXmlStreamReader reader(device_);
+  bool success = true;
 
-  const int blockSize = data_.size()/100 + 1;
-  int pos = 0;
-  emit signalTotalSteps(this, data_.size());
+  emit signalTotalSteps(this, size_);
+  // only update progress and process events every so often
+  QElapsedTimer progressTimer;
+  progressTimer.start();
 
   // hack to allow processEvents
   QPointer<TellicoImporter> thisPtr(this);
-  while(thisPtr && success && !m_cancelled && pos < data_.size()) {
-    uint size = qMin(blockSize, data_.size() - pos);
-    QByteArray block = QByteArray::fromRawData(data_.data() + pos, size);
-    source.setData(block);
-    success = reader.parseContinue();
-    pos += blockSize;
-    if(thisPtr && showProgress) {
-      emit signalProgress(this, pos);
+  while(thisPtr && success && !m_cancelled && !reader.atEnd()) {
+    success = handler.readToken(reader);
+    if(showProgress && progressTimer.elapsed() > 100) {
+      // the size is in bytes, so the device position is used instead of the character offset
+      emit signalProgress(this, device_->pos());
       qApp->processEvents();
+      progressTimer.restart();
     }
   }
   if(!thisPtr) {
     return;
   }
+  success = success && !reader.hasError();
 
   if(!success) {
     m_format = Error;
@@ -209,10 +217,12 @@ void TellicoImporter::loadZipData() {
     return;
   }
 
-  const QByteArray xmlData = static_cast<const KArchiveFile*>(entry)->data();
+  // read straight from the compressed file, rather than extracting it all first
+  const KArchiveFile* xmlFile = static_cast<const KArchiveFile*>(entry);
+  QScopedPointer<QIODevice> xmlDevice(xmlFile->createDevice());
   // hack to account for processEvents and deletion
   QPointer<TellicoImporter> thisPtr(this);
-  loadXMLData(xmlData, false);
+  loadXMLData(xmlDevice.data(), xmlFile->size(), false);
   if(!thisPtr) {
     return;
   }
@@ -30,6 +30,7 @@
 #include "../utils/stringset.h"
 
 class QBuffer;
+class QIODevice;
 class KZip;
 class KArchiveDirectory;
 
@@ -79,7 +80,7 @@ public Q_SLOTS:
   void slotCancel();
 
 private:
-  void loadXMLData(const QByteArray& data, bool loadImages);
+  void loadXMLData(QIODevice* device, qint64 size, bool loadImages);
   void loadZipData();
 
   Data::CollPtr m_coll;
@@ -47,11 +47,87 @@
 #include <QGroupBox>
 #include <QCheckBox>
 #include <QDomDocument>
+#include <QXmlStreamWriter>
 #include <QTextCodec>
 #include <QVBoxLayout>
 
 #include <algorithm>
 
+extern "C" {
+#include <libxml/tree.h>
+}
+
+namespace {
+
+class XMLDeviceWriter : public Tellico::FileHandler::DeviceWriter {
+public:
+  XMLDeviceWriter(const Tellico::Export::TellicoXMLExporter* exporter) : m_exporter(exporter) {}
+  bool write(QIODevice* device) Q_DECL_OVERRIDE { return m_exporter->writeXML(device); }
+
+private:
+  const Tellico::Export::TellicoXMLExporter* m_exporter;
+};
+
+inline const xmlChar* xmlString(const QByteArray& s) {
+  return reinterpret_cast<const xmlChar*>(s.constData());
+}
+
+// builds a libxml2 tree using the same calls as QXmlStreamWriter, so no text has to be parsed again
+class XMLTreeWriter {
+public:
+  XMLTreeWriter(xmlNodePtr root_, xmlNsPtr ns_) : m_ns(ns_), m_current(root_), m_attributeNode(root_) {}
+
+  void writeStartElement(const QString& name_) {
+    m_current = xmlNewChild(m_current, m_ns, xmlString(name_.toUtf8()), nullptr);
+    m_attributeNode = m_current;
+  }
+  void writeEmptyElement(const QString& name_) {
+    // the attributes which follow belong to the empty element
+    m_attributeNode = xmlNewChild(m_current, m_ns, xmlString(name_.toUtf8()), nullptr);
+  }
+  void writeEndElement() {
+    m_current = m_current->parent;
+    m_attributeNode = m_current;
+  }
+  void writeAttribute(const QString& name_, const QString& value_) {
+    xmlSetProp(m_attributeNode, xmlString(name_.toUtf8()), xmlString(value_.toUtf8()));
+  }
+  void writeCharacters(const QString& text_) {
+    const QByteArray text = text_.toUtf8();
+    xmlNodeAddContentLen(m_current, xmlString(text), text.size());
+    m_attributeNode = m_current;
+  }
+  void writeTextElement(const QString& name_, const QString& text_) {
+    writeStartElement(name_);
+    writeCharacters(text_);
+    writeEndElement();
+  }
+
+private:
+  xmlNsPtr m_ns;
+  xmlNodePtr m_current;
+  xmlNodePtr m_attributeNode;
+};
+
+QString filterFunctionName(Tellico::FilterRule::Function function_) {
+  switch(function_) {
+    case Tellico::FilterRule::FuncContains:    return QLatin1String("contains");
+    case Tellico::FilterRule::FuncNotContains: return QLatin1String("notcontains");
+    case Tellico::FilterRule::FuncEquals:      return QLatin1String("equals");
+    case Tellico::FilterRule::FuncNotEquals:   return QLatin1String("notequals");
+    case Tellico::FilterRule::FuncRegExp:      return QLatin1String("regexp");
+    case Tellico::FilterRule::FuncNotRegExp:   return QLatin1String("notregexp");
+    case Tellico::FilterRule::FuncBefore:      return QLatin1String("before");
+    case Tellico::FilterRule::FuncAfter:       return QLatin1String("after");
+    case Tellico::FilterRule::FuncGreater:     return QLatin1String("greaterthan");
+    case Tellico::FilterRule::FuncLess:        return QLatin1String("lessthan");
+    /* If anything is updated here, be sure to update xmlstatehandler */
+  }
+  return QString();
+}
+
+}
+
 using namespace Tellico;
 using Tellico::Export::TellicoXMLExporter;
 
@@ -72,25 +148,43 @@ QString TellicoXMLExporter::fileFilter() const {
 }
 
 bool TellicoXMLExporter::exec() {
-  QDomDocument doc = exportXML();
-  if(doc.isNull()) {
+  if(!collection()) {
     return false;
   }
-  return FileHandler::writeTextURL(url(), doc.toString(),
-                                   options() & ExportUTF8,
-                                   options() & Export::ExportForce);
+  // write straight to the file rather than building the whole document first
+  XMLDeviceWriter writer(this);
+  return FileHandler::writeDeviceURL(url(), writer, options() & Export::ExportForce);
 }
 
 QString TellicoXMLExporter::text() const {
-  return exportXML().toString();
+  QString text;
+  QXmlStreamWriter writer(&text);
+  writeXML(writer);
+  return text;
 }
 
-QDomDocument TellicoXMLExporter::exportXML() const {
+bool TellicoXMLExporter::writeXML(QIODevice* device_) const {
+  QXmlStreamWriter writer(device_);
+  if(options() & Export::ExportUTF8) {
+    writer.setCodec("UTF-8");
+  } else {
+    writer.setCodec(QTextCodec::codecForLocale());
+  }
+  writeXML(writer);
+  return !writer.hasError();
+}
+
+int TellicoXMLExporter::exportVersion() const {
   int exportVersion = XML::syntaxVersion;
 
   if(exportVersion == 12 && !version12Needed()) {
     exportVersion = 11;
   }
+  return exportVersion;
+}
+
+QDomDocument TellicoXMLExporter::exportXML() const {
+  const int exportVersion = this->exportVersion();
 
   QDomImplementation impl;
   QDomDocumentType doctype = impl.createDocumentType(QLatin1String("tellico"),
@@ -243,6 +337,26 @@ void TellicoXMLExporter::exportFieldXML(QDomDocument& dom_, QDomElement& parent_
   parent_.appendChild(elem);
 }
 
+QString TellicoXMLExporter::exportFieldValue(Tellico::Data::EntryPtr entry_, Tellico::Data::FieldPtr field_, int format_) const {
+  // Date fields are special, don't format in export
+  QString fieldValue = (format_ == FieldFormat::ForceFormat && field_->type() != Data::Field::Date) ?
+                                                         entry_->formattedField(field_->name(), FieldFormat::ForceFormat) :
+                                                         entry_->field(field_->name());
+  if(options() & ExportClean) {
+    BibtexHandler::cleanText(fieldValue);
+  }
+
+  // optionally, verify images exist
+  if(!fieldValue.isEmpty() && field_->type() == Data::Field::Image && (options() & Export::ExportVerifyImages)) {
+    if(!ImageFactory::validImage(fieldValue)) {
+      myDebug() << "entry: " << entry_->title();
+      myDebug() << "skipping image: " << fieldValue;
+      return QString();
+    }
+  }
+  return fieldValue;
+}
+
 void TellicoXMLExporter::exportEntryXML(QDomDocument& dom_, QDomElement& parent_, Tellico::Data::EntryPtr entry_, int format_) const {
   QDomElement entryElem = dom_.createElement(QLatin1String("entry"));
   entryElem.setAttribute(QLatin1String("id"), QString::number(entry_->id()));
@@ -250,29 +364,13 @@ void TellicoXMLExporter::exportEntryXML(QDomDocument& dom_, QDomElement& parent_
   // iterate through every field for the entry
   foreach(Data::FieldPtr fIt, fields()) {
     QString fieldName = fIt->name();
-
-    // Date fields are special, don't format in export
-    QString fieldValue = (format_ == FieldFormat::ForceFormat && fIt->type() != Data::Field::Date) ?
-                                                           entry_->formattedField(fieldName, FieldFormat::ForceFormat) :
-                                                           entry_->field(fieldName);
-    if(options() & ExportClean) {
-      BibtexHandler::cleanText(fieldValue);
-    }
+    QString fieldValue = exportFieldValue(entry_, fIt, format_);
 
     // if empty, then no field element is added and just continue
     if(fieldValue.isEmpty()) {
       continue;
     }
 
-    // optionally, verify images exist
-    if(fIt->type() == Data::Field::Image && (options() & Export::ExportVerifyImages)) {
-      if(!ImageFactory::validImage(fieldValue)) {
-        myDebug() << "entry: " << entry_->title();
-        myDebug() << "skipping image: " << fieldValue;
-        continue;
-      }
-    }
-
     if(fIt->type() == Data::Field::Table) {
       // who cares about grammar, just add an 's' to the name
       QDomElement parElem = dom_.createElement(fieldName + QLatin1Char('s'));
@@ -440,39 +538,7 @@ void TellicoXMLExporter::exportFilterXML(QDomDocument& dom_, QDomElement& parent
     QDomElement ruleElem = dom_.createElement(QLatin1String("rule"));
     ruleElem.setAttribute(QLatin1String("field"), rule->fieldName());
     ruleElem.setAttribute(QLatin1String("pattern"), rule->pattern());
-    switch(rule->function()) {
-      case FilterRule::FuncContains:
-        ruleElem.setAttribute(QLatin1String("function"), QLatin1String("contains"));
-        break;
-      case FilterRule::FuncNotContains:
-        ruleElem.setAttribute(QLatin1String("function"), QLatin1String("notcontains"));
-        break;
-      case FilterRule::FuncEquals:
-        ruleElem.setAttribute(QLatin1String("function"), QLatin1String("equals"));
-        break;
-      case FilterRule::FuncNotEquals:
-        ruleElem.setAttribute(QLatin1String("function"), QLatin1String("notequals"));
-        break;
-      case FilterRule::FuncRegExp:
-        ruleElem.setAttribute(QLatin1String("function"), QLatin1String("regexp"));
-        break;
-      case FilterRule::FuncNotRegExp:
-        ruleElem.setAttribute(QLatin1String("function"), QLatin1String("notregexp"));
-        break;
-      case FilterRule::FuncBefore:
-        ruleElem.setAttribute(QLatin1String("function"), QLatin1String("before"));
-        break;
-      case FilterRule::FuncAfter:
-        ruleElem.setAttribute(QLatin1String("function"), QLatin1String("after"));
-        break;
-      case FilterRule::FuncGreater:
-        ruleElem.setAttribute(QLatin1String("function"), QLatin1String("greaterthan"));
-        break;
-      case FilterRule::FuncLess:
-        ruleElem.setAttribute(QLatin1String("function"), QLatin1String("lessthan"));
-        break;
-      /* If anything is updated here, be sure to update xmlstatehandler */
-    }
+    ruleElem.setAttribute(QLatin1String("function"), filterFunctionName(rule->function()));
     filterElem.appendChild(ruleElem);
   }
 
@@ -507,6 +573,391 @@ void TellicoXMLExporter::exportBorrowerXML(QDomDocument& dom_, QDomElement& pare
   }
 }
 
+_xmlDoc* TellicoXMLExporter::exportXMLDoc() const {
+  const int exportVersion = this->exportVersion();
+  const FieldFormat::Request format = (options() & Export::ExportFormatted ?
+                                                      FieldFormat::ForceFormat :
+                                                      FieldFormat::AsIsFormat);
+
+  xmlDocPtr doc = xmlNewDoc(xmlString("1.0"));
+  xmlCreateIntSubset(doc, xmlString("tellico"),
+                     xmlString(XML::pubTellico(exportVersion).toUtf8()),
+                     xmlString(XML::dtdTellico(exportVersion).toUtf8()));
+
+  xmlNodePtr root = xmlNewDocNode(doc, nullptr, xmlString("tellico"), nullptr);
+  xmlDocSetRootElement(doc, root);
+  //default namespace
+  xmlNsPtr ns = xmlNewNs(root, xmlString(XML::nsTellico.toUtf8()), nullptr);
+  xmlSetNs(root, ns);
+  xmlSetProp(root, xmlString("syntaxVersion"), xmlString(QByteArray::number(exportVersion)));
+
+  XMLTreeWriter writer(root, ns);
+  writeCollectionXML(writer, format);
+
+  // clear image list
+  m_images.clear();
+
+  return doc;
+}
+
+void TellicoXMLExporter::writeXML(QXmlStreamWriter& writer_) const {
+  const int exportVersion = this->exportVersion();
+  const FieldFormat::Request format = (options() & Export::ExportFormatted ?
+                                                      FieldFormat::ForceFormat :
+                                                      FieldFormat::AsIsFormat);
+
+  // match the indentation of QDomDocument::toString()
+  writer_.setAutoFormatting(true);
+  writer_.setAutoFormattingIndent(1);
+  writer_.writeStartDocument();
+  writer_.writeDTD(QString::fromLatin1("<!DOCTYPE tellico PUBLIC '%1' '%2'>")
+                                      .arg(XML::pubTellico(exportVersion), XML::dtdTellico(exportVersion)));
+
+  writer_.writeStartElement(QLatin1String("tellico"));
+  writer_.writeDefaultNamespace(XML::nsTellico);
+  writer_.writeAttribute(QLatin1String("syntaxVersion"), QString::number(exportVersion));
+
+  writeCollectionXML(writer_, format);
+
+  writer_.writeEndElement(); // tellico
+  writer_.writeEndDocument();
+
+  // clear image list
+  m_images.clear();
+}
+
+template <class Writer>
+void TellicoXMLExporter::writeCollectionXML(Writer& writer_, int format_) const {
+  Data::CollPtr coll = collection();
+  if(!coll) {
+    myWarning() << "no collection pointer!";
+    return;
+  }
+
+  writer_.writeStartElement(QLatin1String("collection"));
+  writer_.writeAttribute(QLatin1String("type"), QString::number(coll->type()));
+  writer_.writeAttribute(QLatin1String("title"), coll->title());
+
+  writer_.writeStartElement(QLatin1String("fields"));
+  foreach(Data::FieldPtr field, fields()) {
+    writeFieldXML(writer_, field);
+  }
+  writer_.writeEndElement(); // fields
+
+  if(coll->type() == Data::Collection::Bibtex) {
+    const Data::BibtexCollection* c = static_cast<const Data::BibtexCollection*>(coll.data());
+    if(!c->preamble().isEmpty()) {
+      writer_.writeTextElement(QLatin1String("bibtex-preamble"), c->preamble());
+    }
+
+    bool wroteMacros = false;
+    for(StringMap::ConstIterator macroIt = c->macroList().constBegin(); macroIt != c->macroList().constEnd(); ++macroIt) {
+      if(!macroIt.value().isEmpty()) {
+        if(!wroteMacros) {
+          writer_.writeStartElement(QLatin1String("macros"));
+          wroteMacros = true;
+        }
+        writer_.writeStartElement(QLatin1String("macro"));
+        writer_.writeAttribute(QLatin1String("name"), macroIt.key());
+        writer_.writeCharacters(macroIt.value());
+        writer_.writeEndElement(); // macro
+      }
+    }
+    if(wroteMacros) {
+      writer_.writeEndElement(); // macros
+    }
+  }
+
+  foreach(Data::EntryPtr entry, entries()) {
+    writeEntryXML(writer_, entry, format_);
+  }
+
+  if(!m_images.isEmpty() && (options() & Export::ExportImages)) {
+    bool wroteImages = false;
+    foreach(const QString& id, m_images) {
+      writeImageXML(writer_, id, &wroteImages);
+    }
+    if(wroteImages) {
+      writer_.writeEndElement(); // images
+    }
+  }
+
+  if(m_includeGroups) {
+    writeGroupXML(writer_);
+  }
+
+  writer_.writeEndElement(); // collection
+
+  // the borrowers and filters are in the tellico object, not the collection
+  if(options() & Export::ExportComplete) {
+    bool hasBorrowers = false;
+    foreach(Data::BorrowerPtr borrower, coll->borrowers()) {
+      if(!borrower->isEmpty()) {
+        hasBorrowers = true;
+        break;
+      }
+    }
+    if(hasBorrowers) {
+      writer_.writeStartElement(QLatin1String("borrowers"));
+      foreach(Data::BorrowerPtr borrower, coll->borrowers()) {
+        writeBorrowerXML(writer_, borrower);
+      }
+      writer_.writeEndElement(); // borrowers
+    }
+
+    if(!coll->filters().isEmpty()) {
+      writer_.writeStartElement(QLatin1String("filters"));
+      foreach(FilterPtr filter, coll->filters()) {
+        writeFilterXML(writer_, filter);
+      }
+      writer_.writeEndElement(); // filters
+    }
+  }
+}
+
+template <class Writer>
+void TellicoXMLExporter::writeFieldXML(Writer& writer_, Tellico::Data::FieldPtr field_) const {
+  writer_.writeStartElement(QLatin1String("field"));
+
+  writer_.writeAttribute(QLatin1String("name"),     field_->name());
+  writer_.writeAttribute(QLatin1String("title"),    field_->title());
+  writer_.writeAttribute(QLatin1String("category"), field_->category());
+  writer_.writeAttribute(QLatin1String("type"),     QString::number(field_->type()));
+  writer_.writeAttribute(QLatin1String("flags"),    QString::number(field_->flags()));
+  writer_.writeAttribute(QLatin1String("format"),   QString::number(field_->formatType()));
+
+  if(field_->type() == Data::Field::Choice) {
+    writer_.writeAttribute(QLatin1String("allowed"), field_->allowed().join(QLatin1String(";")));
+  }
+
+  // only save description if it's not equal to title, which is the default
+  // title is never empty, so this indirectly checks for empty descriptions
+  if(field_->description() != field_->title()) {
+    writer_.writeAttribute(QLatin1String("description"), field_->description());
+  }
+
+  for(StringMap::ConstIterator it = field_->propertyList().begin(); it != field_->propertyList().end(); ++it) {
+    if(it.value().isEmpty()) {
+      continue;
+    }
+    writer_.writeStartElement(QLatin1String("prop"));
+    writer_.writeAttribute(QLatin1String("name"), it.key());
+    writer_.writeCharacters(it.value());
+    writer_.writeEndElement(); // prop
+  }
+
+  writer_.writeEndElement(); // field
+}
+
+template <class Writer>
+void TellicoXMLExporter::writeEntryXML(Writer& writer_, Tellico::Data::EntryPtr entry_, int format_) const {
+  writer_.writeStartElement(QLatin1String("entry"));
+  writer_.writeAttribute(QLatin1String("id"), QString::number(entry_->id()));
+
+  // iterate through every field for the entry
+  foreach(Data::FieldPtr fIt, fields()) {
+    const QString fieldValue = exportFieldValue(entry_, fIt, format_);
+    // if empty, then no field element is added and just continue
+    if(fieldValue.isEmpty()) {
+      continue;
+    }
+    const QString fieldName = fIt->name();
+
+    if(fIt->type() == Data::Field::Table) {
+      // who cares about grammar, just add an 's' to the name
+      writer_.writeStartElement(fieldName + QLatin1Char('s'));
+
+      bool ok;
+      int ncols = Tellico::toUInt(fIt->property(QLatin1String("columns")), &ok);
+      if(!ok || ncols < 1) {
+        ncols = 1;
+      }
+      foreach(const QString& rowValue, FieldFormat::splitTable(fieldValue)) {
+        writer_.writeStartElement(fieldName);
+
+        QStringList columnValues = FieldFormat::splitRow(rowValue);
+        if(ncols < columnValues.count()) {
+          // need to combine all the last values, from ncols-1 to end
+          QString lastValue = QStringList(columnValues.mid(ncols-1)).join(FieldFormat::columnDelimiterString());
+          columnValues = columnValues.mid(0, ncols);
+          columnValues.replace(ncols-1, lastValue);
+        }
+        for(int col = 0; col < columnValues.count(); ++col) {
+          writer_.writeTextElement(QLatin1String("column"), columnValues.at(col));
+        }
+        writer_.writeEndElement(); // row
+      }
+      writer_.writeEndElement(); // table
+      continue;
+    }
+
+    if(fIt->hasFlag(Data::Field::AllowMultiple)) {
+      // if multiple versions are allowed, split them into separate elements
+      // who cares about grammar, just add an QLatin1Char('s') to the name
+      writer_.writeStartElement(fieldName + QLatin1Char('s'));
+      // the space after the semi-colon is enforced when the field is set for the entry
+      foreach(const QString& value, FieldFormat::splitValue(fieldValue)) {
+        writer_.writeTextElement(fieldName, value);
+      }
+      writer_.writeEndElement();
+    } else if(fIt->type() == Data::Field::Date) {
+      writer_.writeStartElement(fieldName);
+      // as of Tellico in KF5 (3.0), just forget about the calendar attribute for the moment, always use gregorian
+      writer_.writeAttribute(QLatin1String("calendar"), QLatin1String("gregorian"));
+      QStringList s = fieldValue.split(QLatin1Char('-'), QString::KeepEmptyParts);
+      if(s.count() > 0 && !s[0].isEmpty()) {
+        writer_.writeTextElement(QLatin1String("year"), s[0]);
+      }
+      if(s.count() > 1 && !s[1].isEmpty()) {
+        writer_.writeTextElement(QLatin1String("month"), s[1]);
+      }
+      if(s.count() > 2 && !s[2].isEmpty()) {
+        writer_.writeTextElement(QLatin1String("day"), s[2]);
+      }
+      writer_.writeEndElement();
+    } else if(fIt->type() == Data::Field::URL &&
+              fIt->property(QLatin1String("relative")) == QLatin1String("true") &&
+              !url().isEmpty()) {
+      // if a relative URL and url() is not empty, change the value!
+      QUrl old_url = Data::Document::self()->URL().resolved(QUrl(fieldValue));
+      writer_.writeTextElement(fieldName, QDir(url().toLocalFile()).relativeFilePath(old_url.path()));
+    } else {
+      writer_.writeTextElement(fieldName, fieldValue);
+    }
+
+    if(fIt->type() == Data::Field::Image) {
+      // possible to have more than one entry with the same image
+      // only want to include it in the output xml once
+      m_images.add(fieldValue);
+    }
+  } // end field loop
+
+  writer_.writeEndElement(); // entry
+}
+
+template <class Writer>
+void TellicoXMLExporter::writeImageXML(Writer& writer_, const QString& id_, bool* wroteParent_) const {
+  if(id_.isEmpty()) {
+    myDebug() << "empty image!";
+    return;
+  }
+
+  if(m_includeImages) {
+    const Data::Image& img = ImageFactory::imageById(id_);
+    if(img.isNull()) {
+      return;
+    }
+    if(!*wroteParent_) {
+      writer_.writeStartElement(QLatin1String("images"));
+      *wroteParent_ = true;
+    }
+    writer_.writeStartElement(QLatin1String("image"));
+    writer_.writeAttribute(QLatin1String("format"), QLatin1String(img.format()));
+    writer_.writeAttribute(QLatin1String("id"),     QString(img.id()));
+    writer_.writeAttribute(QLatin1String("width"),  QString::number(img.width()));
+    writer_.writeAttribute(QLatin1String("height"), QString::number(img.height()));
+    if(img.linkOnly()) {
+      writer_.writeAttribute(QLatin1String("link"), QLatin1String("true"));
+    }
+    writer_.writeCharacters(QLatin1String(img.byteArray().toBase64()));
+    writer_.writeEndElement(); // image
+  } else {
+    const Data::ImageInfo& info = ImageFactory::imageInfo(id_);
+    if(info.isNull()) {
+      return;
+    }
+    if(!*wroteParent_) {
+      writer_.writeStartElement(QLatin1String("images"));
+      *wroteParent_ = true;
+    }
+    writer_.writeStartElement(QLatin1String("image"));
+    writer_.writeAttribute(QLatin1String("format"), QLatin1String(info.format));
+    writer_.writeAttribute(QLatin1String("id"),     QString(info.id));
+    // only load the images to read the size if necessary
+    const bool loadImageIfNecessary = options() & Export::ExportImageSize;
+    writer_.writeAttribute(QLatin1String("width"),  QString::number(info.width(loadImageIfNecessary)));
+    writer_.writeAttribute(QLatin1String("height"), QString::number(info.height(loadImageIfNecessary)));
+    if(info.linkOnly) {
+      writer_.writeAttribute(QLatin1String("link"), QLatin1String("true"));
+    }
+    writer_.writeEndElement(); // image
+  }
+}
+
+template <class Writer>
+void TellicoXMLExporter::writeGroupXML(Writer& writer_) const {
+  Data::EntryList vec = entries();
+  bool exportAll = collection()->entries().count() == vec.count();
+  // iterate over each group, which are the first children
+  for(ModelIterator gIt(ModelManager::self()->groupModel()); gIt.group(); ++gIt) {
+    if(gIt.group()->isEmpty()) {
+      continue;
+    }
+    Data::EntryList sorted = sortEntries(*gIt.group());
+    if(!exportAll) {
+      Data::EntryList::Iterator it = sorted.begin();
+      while(it != sorted.end()) {
+        it = vec.contains(*it) ? it + 1 : sorted.erase(it);
+      }
+    }
+    if(sorted.isEmpty()) {
+      continue;
+    }
+    writer_.writeStartElement(QLatin1String("group"));
+    writer_.writeAttribute(QLatin1String("title"), gIt.group()->groupName());
+    // now iterate over all entry items in the group
+    foreach(Data::EntryPtr eIt, sorted) {
+      writer_.writeEmptyElement(QLatin1String("entryRef"));
+      writer_.writeAttribute(QLatin1String("id"), QString::number(eIt->id()));
+    }
+    writer_.writeEndElement(); // group
+  }
+}
+
+template <class Writer>
+void TellicoXMLExporter::writeFilterXML(Writer& writer_, Tellico::FilterPtr filter_) const {
+  writer_.writeStartElement(QLatin1String("filter"));
+  writer_.writeAttribute(QLatin1String("name"), filter_->name());
+
+  QString match = (filter_->op() == Filter::MatchAll) ? QLatin1String("all") : QLatin1String("any");
+  writer_.writeAttribute(QLatin1String("match"), match);
+
+  foreach(FilterRule* rule, *filter_) {
+    writer_.writeEmptyElement(QLatin1String("rule"));
+    writer_.writeAttribute(QLatin1String("field"), rule->fieldName());
+    writer_.writeAttribute(QLatin1String("pattern"), rule->pattern());
+    writer_.writeAttribute(QLatin1String("function"), filterFunctionName(rule->function()));
+  }
+
+  writer_.writeEndElement(); // filter
+}
+
+template <class Writer>
+void TellicoXMLExporter::writeBorrowerXML(Writer& writer_, Tellico::Data::BorrowerPtr borrower_) const {
+  if(borrower_->isEmpty()) {
+    return;
+  }
+
+  writer_.writeStartElement(QLatin1String("borrower"));
+  writer_.writeAttribute(QLatin1String("name"), borrower_->name());
+  writer_.writeAttribute(QLatin1String("uid"), borrower_->uid());
+
+  foreach(Data::LoanPtr it, borrower_->loans()) {
+    writer_.writeStartElement(QLatin1String("loan"));
+    writer_.writeAttribute(QLatin1String("uid"), it->uid());
+    writer_.writeAttribute(QLatin1String("entryRef"), QString::number(it->entry()->id()));
+    writer_.writeAttribute(QLatin1String("loanDate"), it->loanDate().toString(Qt::ISODate));
+    writer_.writeAttribute(QLatin1String("dueDate"), it->dueDate().toString(Qt::ISODate));
+    if(it->inCalendar()) {
+      writer_.writeAttribute(QLatin1String("calendar"), QLatin1String("true"));
+    }
+    writer_.writeCharacters(it->note());
+    writer_.writeEndElement(); // loan
+  }
+
+  writer_.writeEndElement(); // borrower
+}
+
 QWidget* TellicoXMLExporter::widget(QWidget* parent_) {
   if(m_widget) {
     return m_widget;
@@ -35,6 +35,12 @@ namespace Tellico {
 class QDomDocument;
 class QDomElement;
 class QCheckBox;
+class QIODevice;
+class QXmlStreamWriter;
+
+extern "C" {
+  struct _xmlDoc;
+}
 
 namespace Tellico {
   namespace Export {
@@ -54,7 +60,19 @@ public:
   virtual QString fileFilter() const Q_DECL_OVERRIDE;
 
   QString text() const;
+  /**
+   * Builds the XML as a DOM tree, for the exporters that need to process it further.
+   */
   QDomDocument exportXML() const;
+  /**
+   * Writes the XML directly to a device, without building the whole document in memory.
+   */
+  bool writeXML(QIODevice* device) const;
+  /**
+   * Builds the XML as a libxml2 document, which can be passed straight to the XSLT
+   * processor. The caller takes ownership and must free the document with xmlFreeDoc().
+   */
+  _xmlDoc* exportXMLDoc() const;
 
   void setIncludeImages(bool b) { m_includeImages = b; }
   void setIncludeGroups(bool b) { m_includeGroups = b; }
@@ -77,6 +95,19 @@ private:
   void exportFilterXML(QDomDocument& doc, QDomElement& parent, FilterPtr filter) const;
   void exportBorrowerXML(QDomDocument& doc, QDomElement& parent, Data::BorrowerPtr borrower) const;
 
+  // returns an empty string if the value should not be exported
+  QString exportFieldValue(Data::EntryPtr entry, Data::FieldPtr field, int format) const;
+  int exportVersion() const;
+  void writeXML(QXmlStreamWriter& writer) const;
+  // the writer is either a QXmlStreamWriter or builds a libxml2 tree with the same calls
+  template <class Writer> void writeCollectionXML(Writer& writer, int format) const;
+  template <class Writer> void writeFieldXML(Writer& writer, Data::FieldPtr field) const;
+  template <class Writer> void writeEntryXML(Writer& writer, Data::EntryPtr entry, int format) const;
+  template <class Writer> void writeImageXML(Writer& writer, const QString& imageID, bool* wroteParent) const;
+  template <class Writer> void writeGroupXML(Writer& writer) const;
+  template <class Writer> void writeFilterXML(Writer& writer, FilterPtr filter) const;
+  template <class Writer> void writeBorrowerXML(Writer& writer, Data::BorrowerPtr borrower) const;
+
   Data::EntryList sortEntries(const Data::EntryList& entries) const;
   bool version12Needed() const;
 
@@ -23,9 +23,12 @@
  ***************************************************************************/
 
 #include "tellicoxmlhandler.h"
+#include "xslthandler.h"
 #include "../collection.h"
 #include "../tellico_debug.h"
 
+#include <QXmlStreamReader>
+
 using Tellico::Import::TellicoXMLHandler;
 
 TellicoXMLHandler::TellicoXMLHandler() : QXmlDefaultHandler(), m_data(new SAX::StateData) {
@@ -69,6 +72,106 @@ bool TellicoXMLHandler::characters(const QString& ch_) {
   return true;
 }
 
+bool TellicoXMLHandler::readDocument(xmlDocPtr doc_) {
+  xmlNodePtr root = doc_ ? xmlDocGetRootElement(doc_) : nullptr;
+  if(!root) {
+    m_data->error = QLatin1String("empty document");
+    return false;
+  }
+  return readNode(root);
+}
+
+bool TellicoXMLHandler::readToken(QXmlStreamReader& reader_) {
+  switch(reader_.readNext()) {
+    case QXmlStreamReader::StartElement:
+      {
+        QXmlAttributes atts;
+        foreach(const QXmlStreamAttribute& att, reader_.attributes()) {
+          atts.append(att.qualifiedName().toString(), att.namespaceUri().toString(),
+                      att.name().toString(), att.value().toString());
+        }
+        return startElement(reader_.namespaceUri().toString(), reader_.name().toString(),
+                            reader_.qualifiedName().toString(), atts);
+      }
+    case QXmlStreamReader::EndElement:
+      return endElement(reader_.namespaceUri().toString(), reader_.name().toString(),
+                        reader_.qualifiedName().toString());
+    case QXmlStreamReader::Characters:
+      return characters(reader_.text().toString());
+    case QXmlStreamReader::Invalid:
+      m_data->error = reader_.errorString();
+      return false;
+    default:
+      // the document, DTD, comments and processing instructions are not needed
+      return true;
+  }
+}
+
+Tellico::Data::CollPtr TellicoXMLHandler::transformCollection(XSLTHandler* xsltHandler_, const QString& text_,
+                                                               bool showImageErrors_) {
+  Q_ASSERT(xsltHandler_);
+  xmlDocPtr doc = xsltHandler_->applyStylesheetToDoc(text_);
+  if(!doc) {
+    return Data::CollPtr();
+  }
+#if 0
+  myWarning() << "Remove debug from tellicoxmlhandler.cpp";
+  xmlSaveFormatFile("/tmp/test-tellico.xml", doc, 1);
+#endif
+  TellicoXMLHandler handler;
+  handler.setLoadImages(true);
+  handler.setShowImageLoadErrors(showImageErrors_);
+  const bool success = handler.readDocument(doc);
+  xmlFreeDoc(doc);
+  if(!success) {
+    myDebug() << handler.errorString();
+    return Data::CollPtr();
+  }
+  return handler.collection();
+}
+
+bool TellicoXMLHandler::readNode(xmlNodePtr node_) {
+  const QString localName = QString::fromUtf8(reinterpret_cast<const char*>(node_->name));
+  QString nsURI, qName = localName;
+  if(node_->ns) {
+    nsURI = QString::fromUtf8(reinterpret_cast<const char*>(node_->ns->href));
+    if(node_->ns->prefix) {
+      qName = QString::fromUtf8(reinterpret_cast<const char*>(node_->ns->prefix))
+            + QLatin1Char(':') + localName;
+    }
+  }
+
+  QXmlAttributes atts;
+  for(xmlAttrPtr attr = node_->properties; attr; attr = attr->next) {
+    const QString attName = QString::fromUtf8(reinterpret_cast<const char*>(attr->name));
+    QString attURI, attQName = attName;
+    if(attr->ns) {
+      attURI = QString::fromUtf8(reinterpret_cast<const char*>(attr->ns->href));
+      if(attr->ns->prefix) {
+        attQName = QString::fromUtf8(reinterpret_cast<const char*>(attr->ns->prefix))
+                 + QLatin1Char(':') + attName;
+      }
+    }
+    xmlChar* value = xmlNodeListGetString(node_->doc, attr->children, 1);
+    atts.append(attQName, attURI, attName, QString::fromUtf8(reinterpret_cast<const char*>(value)));
+    xmlFree(value);
+  }
+
+  if(!startElement(nsURI, localName, qName, atts)) {
+    return false;
+  }
+  for(xmlNodePtr child = node_->children; child; child = child->next) {
+    if(child->type == XML_ELEMENT_NODE) {
+      if(!readNode(child)) {
+        return false;
+      }
+    } else if(child->type == XML_TEXT_NODE || child->type == XML_CDATA_SECTION_NODE) {
+      characters(QString::fromUtf8(reinterpret_cast<const char*>(child->content)));
+    }
+  }
+  return endElement(nsURI, localName, qName);
+}
+
 QString TellicoXMLHandler::errorString() const {
   return m_data->error;
 }
@@ -29,7 +29,16 @@
 
 #include <QStack>
 
+class QXmlStreamReader;
+
+extern "C" {
+// for xmlDocPtr
+#include <libxml/tree.h>
+}
+
 namespace Tellico {
+  class XSLTHandler;
+
   namespace Import {
 
 class TellicoXMLHandler : public QXmlDefaultHandler {
@@ -45,6 +54,25 @@ public:
 
   virtual QString errorString() const Q_DECL_OVERRIDE;
 
+  /**
+   * Walks an already parsed libxml2 document, such as an XSLT result tree,
+   * and feeds it through the same handlers as the SAX parser. This avoids
+   * serializing the document to text only to parse it again.
+   */
+  bool readDocument(xmlDocPtr doc);
+  /**
+   * Reads the next token from a stream reader and passes it to the handlers.
+   * Returns false if the reader or a handler has an error.
+   */
+  bool readToken(QXmlStreamReader& reader);
+
+  /**
+   * Convenience function to transform text with an XSLT stylesheet whose output is
+   * Tellico XML and read the collection straight from the result tree.
+   */
+  static Data::CollPtr transformCollection(XSLTHandler* xsltHandler, const QString& text,
+                                           bool showImageErrors = true);
+
   Data::CollPtr collection() const;
   bool hasImages() const;
 
@@ -52,6 +80,8 @@ public:
   void setShowImageLoadErrors(bool showImageErrors);
 
 private:
+  bool readNode(xmlNodePtr node);
+
   QStack<SAX::StateHandler*> m_handlers;
   SAX::StateData* m_data;
 };
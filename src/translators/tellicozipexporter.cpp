@@ -36,10 +36,62 @@
 #include <KLocalizedString>
 #include <KZip>
 
-#include <QDomDocument>
-#include <QBuffer>
+#include <QIODevice>
 #include <QApplication>
 
+namespace {
+
+// a write-only device which passes everything through to the current file in the archive
+class ArchiveFileDevice : public QIODevice {
+public:
+  ArchiveFileDevice(KArchive* archive) : QIODevice(), m_archive(archive), m_size(0) {
+    open(QIODevice::WriteOnly);
+  }
+  qint64 size() const Q_DECL_OVERRIDE { return m_size; }
+
+protected:
+  qint64 readData(char*, qint64) Q_DECL_OVERRIDE { return -1; }
+  qint64 writeData(const char* data, qint64 len) Q_DECL_OVERRIDE {
+    if(!m_archive->writeData(data, len)) {
+      return -1;
+    }
+    m_size += len;
+    return len;
+  }
+
+private:
+  KArchive* m_archive;
+  qint64 m_size;
+};
+
+// passes everything through to another device, so the archive can close it without closing the file,
+// since closing a QSaveFile is not allowed
+class ForwardingDevice : public QIODevice {
+public:
+  ForwardingDevice(QIODevice* device) : QIODevice(), m_device(device) {}
+  bool isSequential() const Q_DECL_OVERRIDE { return m_device->isSequential(); }
+  qint64 size() const Q_DECL_OVERRIDE { return m_device->size(); }
+  bool seek(qint64 pos) Q_DECL_OVERRIDE { return QIODevice::seek(pos) && m_device->seek(pos); }
+
+protected:
+  qint64 readData(char* data, qint64 len) Q_DECL_OVERRIDE { return m_device->read(data, len); }
+  qint64 writeData(const char* data, qint64 len) Q_DECL_OVERRIDE { return m_device->write(data, len); }
+
+private:
+  QIODevice* m_device;
+};
+
+class ZipDeviceWriter : public Tellico::FileHandler::DeviceWriter {
+public:
+  ZipDeviceWriter(Tellico::Export::TellicoZipExporter* exporter) : m_exporter(exporter) {}
+  bool write(QIODevice* device) Q_DECL_OVERRIDE { return m_exporter->writeZip(device); }
+
+private:
+  Tellico::Export::TellicoZipExporter* m_exporter;
+};
+
+}
+
 using namespace Tellico;
 using Tellico::Export::TellicoZipExporter;
 
@@ -57,8 +109,7 @@ QString TellicoZipExporter::fileFilter() const {
 
 bool TellicoZipExporter::exec() {
   m_cancelled = false;
-  Data::CollPtr coll = collection();
-  if(!coll) {
+  if(!collection()) {
     return false;
   }
 
@@ -68,6 +119,18 @@ bool TellicoZipExporter::exec() {
   connect(&item, SIGNAL(signalCancelled(ProgressItem*)), SLOT(slotCancel()));
   ProgressItem::Done done(this);
 
+  // the archive is written straight to the file, which is left alone if the export is cancelled
+  ZipDeviceWriter writer(this);
+  const bool success = FileHandler::writeDeviceURL(url(), writer, options() & Export::ExportForce);
+  return success || m_cancelled; // intentionally cancelled
+}
+
+bool TellicoZipExporter::writeZip(QIODevice* device_) {
+  Data::CollPtr coll = collection();
+  if(!coll) {
+    return false;
+  }
+
   TellicoXMLExporter exp(coll);
   exp.setEntries(entries());
   exp.setFields(fields());
@@ -78,20 +141,31 @@ bool TellicoZipExporter::exec() {
   opt &= ~Export::ExportProgress; // don't show progress for xml export
   exp.setOptions(opt);
   exp.setIncludeImages(false); // do not include the images themselves in XML
-  QByteArray xml = exp.exportXML().toByteArray(); // encoded in utf-8
-  ProgressManager::self()->setProgress(this, 5);
 
-  QByteArray data;
-  QBuffer buf(&data);
+  ForwardingDevice zipDevice(device_);
+  KZip zip(&zipDevice);
+  if(!zip.open(QIODevice::WriteOnly)) {
+    myWarning() << "unable to open zip archive";
+    return false;
+  }
+  // the xml is written straight into the zip file, without keeping a copy of it
+  if(!zip.prepareWriting(QLatin1String("tellico.xml"), QString(), QString(), 0)) {
+    myWarning() << "unable to write tellico.xml";
+    return false;
+  }
+  ArchiveFileDevice xmlDevice(&zip);
+  const bool xmlWritten = exp.writeXML(&xmlDevice);
+  zip.finishWriting(xmlDevice.size());
+  if(!xmlWritten) {
+    myWarning() << "unable to write tellico.xml";
+    return false;
+  }
+  ProgressManager::self()->setProgress(this, 5);
 
   if(m_cancelled) {
-    return true; // intentionally cancelled
+    return false;
   }
 
-  KZip zip(&buf);
-  zip.open(QIODevice::WriteOnly);
-  zip.writeFile(QLatin1String("tellico.xml"), xml);
-
   if(m_includeImages) {
     ProgressManager::self()->setProgress(this, 10);
     // gonna be lazy and just increment progress every 3 images
@@ -141,12 +215,8 @@ bool TellicoZipExporter::exec() {
     ProgressManager::self()->setProgress(this, 80);
   }
 
-  zip.close();
-  if(m_cancelled) {
-    return true;
-  }
-
-  return FileHandler::writeDataURL(url(), data, options() & Export::ExportForce);
+  // closing the archive writes the central directory
+  return zip.close() && !m_cancelled;
 }
 
 void TellicoZipExporter::slotCancel() {
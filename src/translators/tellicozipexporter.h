@@ -27,6 +27,8 @@
 
 #include "exporter.h"
 
+class QIODevice;
+
 namespace Tellico {
   namespace Export {
 
@@ -47,6 +49,12 @@ public:
   virtual QWidget* widget(QWidget*) Q_DECL_OVERRIDE { return nullptr; }
 
   void setIncludeImages(bool b) { m_includeImages = b; }
+  /**
+   * Writes the zip archive straight to a device, without building it in memory first.
+   *
+   * @return false if the archive could not be written or the export was cancelled
+   */
+  bool writeZip(QIODevice* device);
 
 public Q_SLOTS:
   void slotCancel();
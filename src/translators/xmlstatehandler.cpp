@@ -63,6 +63,7 @@ QString realFieldName(int syntaxVersion, const QString& localName) {
 
 }
 
+using Tellico::Import::SAX::StateData;
 using Tellico::Import::SAX::StateHandler;
 using Tellico::Import::SAX::NullHandler;
 using Tellico::Import::SAX::RootHandler;
@@ -88,6 +89,15 @@ using Tellico::Import::SAX::BorrowersHandler;
 using Tellico::Import::SAX::BorrowerHandler;
 using Tellico::Import::SAX::LoanHandler;
 
+QString StateData::intern(const QString& str_) {
+  QSet<QString>::ConstIterator it = strings.constFind(str_);
+  if(it != strings.constEnd()) {
+    return *it;
+  }
+  strings.insert(str_);
+  return str_;
+}
+
 StateHandler* StateHandler::nextHandler(const QString& ns_, const QString& localName_, const QString& qName_) {
   StateHandler* handler = nextHandlerImpl(ns_, localName_, qName_);
   if(!handler) {
@@ -614,7 +624,8 @@ bool FieldValueHandler::end(const QString&, const QString& localName_, const QSt
   if(fieldName == QLatin1String("mdate")) {
     d->modifiedDate = fieldValue;
   } else {
-    entry->setField(fieldName, fieldValue);
+    // values which repeat are shared by the collection itself
+    entry->setField(d->intern(fieldName), fieldValue);
   }
   return true;
 }
@@ -26,6 +26,7 @@
 #define TELLICO_IMPORT_XMLSTATEHANDLER_H
 
 #include <QXmlAttributes>
+#include <QSet>
 
 #include "../datavectors.h"
 
@@ -36,6 +37,11 @@ namespace Tellico {
 class StateData {
 public:
   StateData() : syntaxVersion(0), collType(0), defaultFields(false), loadImages(false), hasImages(false), showImageLoadErrors(true) {}
+  /**
+   * Returns a shared copy of a field name, so the names repeated in every entry
+   * are only stored once in memory.
+   */
+  QString intern(const QString& str);
   QString text;
   QString error;
   QString ns; // namespace
@@ -55,6 +61,7 @@ public:
   bool loadImages;
   bool hasImages;
   bool showImageLoadErrors;
+  QSet<QString> strings;
 };
 
 class StateHandler {
@@ -35,7 +35,6 @@
 
 #include <QLabel>
 #include <QGroupBox>
-#include <QDomDocument>
 #include <QHBoxLayout>
 
 using namespace Tellico;
@@ -69,8 +68,7 @@ bool XSLTExporter::exec() {
   exporter.setEntries(entries());
   exporter.setFields(fields());
   exporter.setOptions(options());
-  QDomDocument dom = exporter.exportXML();
-  return FileHandler::writeTextURL(url(), handler.applyStylesheet(dom.toString()),
+  return FileHandler::writeTextURL(url(), handler.applyStylesheet(exporter.exportXMLDoc()),
                                    options() & ExportUTF8, options() & Export::ExportForce);
 }
 
@@ -233,10 +233,72 @@ QString XSLTHandler::applyStylesheet(const QString& text_) {
   return process(docIn);
 }
 
+xmlDocPtr XSLTHandler::applyStylesheetToDoc(const QString& text_) {
+  if(!m_stylesheet) {
+    myDebug() << "null stylesheet pointer!";
+    return nullptr;
+  }
+  if(text_.isEmpty()) {
+    myDebug() << "empty input";
+    return nullptr;
+  }
+
+  xmlDocPtr docIn;
+  docIn = xmlReadDoc(reinterpret_cast<xmlChar*>(text_.toUtf8().data()), nullptr, nullptr, xml_options);
+
+  return transform(docIn);
+}
+
+QString XSLTHandler::applyStylesheet(xmlDocPtr docIn_) {
+  if(!m_stylesheet) {
+    myDebug() << "null stylesheet pointer!";
+    xmlFreeDoc(docIn_);
+    return QString();
+  }
+  return process(docIn_);
+}
+
+xmlDocPtr XSLTHandler::applyStylesheetToDoc(xmlDocPtr docIn_) {
+  if(!m_stylesheet) {
+    myDebug() << "null stylesheet pointer!";
+    xmlFreeDoc(docIn_);
+    return nullptr;
+  }
+  return transform(docIn_);
+}
+
+QString XSLTHandler::resultToString(xmlDocPtr docOut_) {
+  if(!docOut_ || !m_stylesheet) {
+    return QString();
+  }
+
+  XMLOutputBuffer output;
+  if(output.isValid()) {
+    int num_bytes = xsltSaveResultTo(output.buffer(), docOut_, m_stylesheet);
+    if(num_bytes == -1) {
+      myDebug() << "error saving output buffer!";
+    }
+  }
+  return output.result();
+}
+
 QString XSLTHandler::process(xmlDocPtr docIn) {
+  xmlDocPtr docOut = transform(docIn);
+  if(!docOut) {
+    return QString();
+  }
+
+  const QString result = resultToString(docOut);
+  xmlFreeDoc(docOut);
+  docOut = nullptr;
+
+  return result;
+}
+
+xmlDocPtr XSLTHandler::transform(xmlDocPtr docIn) {
   if(!docIn) {
     myDebug() << "error parsing input string!";
-    return QString();
+    return nullptr;
   }
 
   QVector<const char*> params(2*m_params.count() + 1);
@@ -261,21 +323,8 @@ QString XSLTHandler::process(xmlDocPtr docIn) {
 
   if(!docOut) {
     myDebug() << "error applying stylesheet!";
-    return QString();
-  }
-
-  XMLOutputBuffer output;
-  if(output.isValid()) {
-    int num_bytes = xsltSaveResultTo(output.buffer(), docOut, m_stylesheet);
-    if(num_bytes == -1) {
-      myDebug() << "error saving output buffer!";
-    }
   }
-
-  xmlFreeDoc(docOut);
-  docOut = nullptr;
-
-  return output.result();
+  return docOut;
 }
 
 //static
@@ -98,6 +98,7 @@ public:
   void addStringParam(const QByteArray& name, const QByteArray& value);
   void removeParam(const QByteArray& name);
   const QByteArray& param(const QByteArray& name);
+  const QHash<QByteArray, QByteArray>& params() const { return m_params; }
   /**
    * Processes text through the XSLT transformation.
    *
@@ -105,12 +106,47 @@ public:
    * @return The transformed text
    */
   QString applyStylesheet(const QString& text);
+  /**
+   * Processes text through the XSLT transformation, returning the result tree
+   * rather than serializing it. The caller takes ownership and must free the
+   * document with xmlFreeDoc().
+   *
+   * @param text The text to be transformed
+   * @return The transformed document, or null on error
+   */
+  xmlDocPtr applyStylesheetToDoc(const QString& text);
+  /**
+   * Processes an already parsed document through the XSLT transformation. The handler
+   * takes ownership of the document. Since the compiled stylesheet is only read, this may
+   * be called from several threads at once, as long as the params are not changed.
+   *
+   * @param doc The document to be transformed
+   * @return The transformed text
+   */
+  QString applyStylesheet(xmlDocPtr doc);
+  /**
+   * Processes an already parsed document through the XSLT transformation, returning the
+   * result tree. The handler takes ownership of the input document, and the caller takes
+   * ownership of the result, which must be freed with xmlFreeDoc().
+   *
+   * @param doc The document to be transformed
+   * @return The transformed document, or null on error
+   */
+  xmlDocPtr applyStylesheetToDoc(xmlDocPtr doc);
+  /**
+   * Serializes a result tree using the output settings of the stylesheet.
+   *
+   * @param doc The result document, which is not freed
+   * @return The serialized text
+   */
+  QString resultToString(xmlDocPtr doc);
 
   static QDomDocument& setLocaleEncoding(QDomDocument& dom);
 
 private:
   void init();
   QString process(xmlDocPtr docIn);
+  xmlDocPtr transform(xmlDocPtr docIn);
 
   xsltStylesheetPtr m_stylesheet;
 
@@ -32,6 +32,7 @@ class QChar;
 #include <qglobal.h>
 
 namespace Tellico {
+  struct CharTables;
 
 /**
  * @author Robby Stephenson
@@ -41,7 +42,9 @@ public:
   static QString toUtf8(const QByteArray& text);
 
 private:
-  static bool hasNext(uint pos, uint len);
+  static const CharTables& tables();
+
+  static bool hasNext(int pos, int len);
   static bool isAscii(uchar c);
   static bool isCombining(uchar c);
 
@@ -33,6 +33,7 @@
 // code, and including a large portion of it here
 
 #include "iso6937converter.h"
+#include "string_utils.h"
 #include "../tellico_debug.h"
 
 #include <QString>
@@ -40,33 +41,55 @@
 
 using Tellico::Iso6937Converter;
 
+// the switch statements below are only used to fill the lookup tables
+const Tellico::CharTables& Iso6937Converter::tables() {
+  static const CharTables* s_tables = buildCharTables(&getChar, &getCombiningChar);
+  return *s_tables;
+}
+
 QString Iso6937Converter::toUtf8(const QByteArray& text_) {
-  const uint len = text_.length();
-  QString result;
-  result.reserve(len);
-  uint pos = 0;
-  for(uint i = 0; i < len; ++i) {
-    uchar c = text_[i];
+  const int len = text_.length();
+  const uchar* data = reinterpret_cast<const uchar*>(text_.constData());
+  int i = asciiLength(data, len);
+  if(i == len) {
+    // Qt has its own bulk conversion for latin1
+    return QString::fromLatin1(text_.constData(), len);
+  }
+
+  const CharTables& t = tables();
+  // the result is never longer than the input
+  QString result(len, Qt::Uninitialized);
+  QChar* const begin = result.data();
+  QChar* out = begin;
+  widen(data, i, out);
+  out += i;
+  while(i < len) {
+    uchar c = data[i];
     if(isAscii(c)) {
-      result[pos++] = c;
-    } else if(isCombining(c) && hasNext(i, len)) {
-      QChar d = getCombiningChar(c * 256 + text_[i + 1]);
+      const int n = asciiLength(data + i, len - i);
+      widen(data + i, n, out);
+      out += n;
+      i += n;
+      continue;
+    }
+    if(isCombining(c) && hasNext(i, len)) {
+      const QChar d = t.combining[c - 0xC0][data[i + 1]];
       if(!d.isNull()) {
-        result[pos++] = d;
-        ++i;
-      } else {
-        result[pos++] = getChar(c);
+        *out++ = d;
+        i += 2;
+        continue;
       }
-    } else {
-      result[pos++] = getChar(c);
+      myDebug() << "no match for" << QString::number(c * 256 + data[i + 1], 16);
     }
+    *out++ = t.chars[c - 0x80];
+    ++i;
   }
-  result.squeeze();
+  result.truncate(out - begin);
   return result;
 }
 
 inline
-bool Iso6937Converter::hasNext(uint pos, uint len) {
+bool Iso6937Converter::hasNext(int pos, int len) {
   return pos < (len - 1);
 }
 
@@ -604,7 +627,6 @@ QChar Iso6937Converter::getCombiningChar(uint c) {
     return 0x017E; // LATIN SMALL LETTER Z WITH CARON
 
   default:
-    myDebug() << "no match for " << c;
     return QChar();
   }
 }
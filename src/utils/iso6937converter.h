@@ -30,6 +30,7 @@ class QString;
 class QChar;
 
 namespace Tellico {
+  struct CharTables;
 
 /**
  * @author Robby Stephenson
@@ -39,7 +40,9 @@ public:
   static QString toUtf8(const QByteArray& text);
 
 private:
-  static bool hasNext(unsigned int pos, unsigned int len);
+  static const CharTables& tables();
+
+  static bool hasNext(int pos, int len);
   static bool isAscii(unsigned char c);
   static bool isCombining(unsigned char c);
 
@@ -34,6 +34,8 @@
 #include <QVariant>
 #include <QCache>
 
+#include <cstring>
+
 namespace {
   static const int STRING_STORE_SIZE = 4999; // too big, too small?
 }
@@ -179,3 +181,32 @@ QString Tellico::mapValue(const QVariantMap& map, const char* object, const char
     return QString();
   }
 }
+
+int Tellico::asciiLength(const uchar* data_, int len_) {
+  int i = 0;
+  // check eight bytes at a time for a high bit
+  for( ; i + 8 <= len_; i += 8) {
+    quint64 word;
+    memcpy(&word, data_ + i, sizeof(word));
+    if(word & Q_UINT64_C(0x8080808080808080)) {
+      break;
+    }
+  }
+  while(i < len_ && data_[i] < 0x80) {
+    ++i;
+  }
+  return i;
+}
+
+Tellico::CharTables* Tellico::buildCharTables(QChar (*getChar_)(uchar), QChar (*getCombiningChar_)(uint)) {
+  CharTables* tables = new CharTables;
+  for(uint c = 0x80; c <= 0xFF; ++c) {
+    tables->chars[c - 0x80] = getChar_(c);
+  }
+  for(uint c = 0xC0; c <= 0xDF; ++c) {
+    for(uint next = 0; next <= 0xFF; ++next) {
+      tables->combining[c - 0xC0][next] = getCombiningChar_(c * 256 + next);
+    }
+  }
+  return tables;
+}
@@ -30,6 +30,7 @@ class QString;
 
 #include <Qt>
 #include <QMetaType>
+#include <QChar>
 
 /**
  * This file contains utility functions for manipulating strings.
@@ -67,6 +68,34 @@ namespace Tellico {
   // helper methods for the QVariantMaps used by the JSON importers
   QString mapValue(const QVariantMap& map, const char* object);
   QString mapValue(const QVariantMap& map, const char* object, const char* name);
+
+  /**
+   * Returns the length of the run of ascii characters at the start of the data.
+   */
+  int asciiLength(const uchar* data, int len);
+  /**
+   * Copies latin1 characters into a buffer of QChars, which must be at least @p len long.
+   */
+  inline void widen(const uchar* data, int len, QChar* out) {
+    for(int i = 0; i < len; ++i) {
+      out[i] = QLatin1Char(data[i]);
+    }
+  }
+
+  /**
+   * Lookup tables for the character sets which map the upper half of the bytes to
+   * single characters, and a combining byte in 0xC0 - 0xDF followed by any byte
+   * to a single precomposed character. A null character means no match.
+   */
+  struct CharTables {
+    QChar chars[0x80]; // 0x80 - 0xFF
+    QChar combining[0x20][0x100]; // 0xC0 - 0xDF followed by any byte
+  };
+  /**
+   * Fills the lookup tables from the functions which map a single byte and a combining
+   * pair of bytes. The tables are never deleted, so they are meant to be built only once.
+   */
+  CharTables* buildCharTables(QChar (*getChar)(uchar), QChar (*getCombiningChar)(uint));
 }
 
 #endif
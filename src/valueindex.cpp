@@ -0,0 +1,96 @@
+/***************************************************************************
+    Copyright (C) 2018 Robby Stephenson <robby@periapsis.org>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "valueindex.h"
+#include "fieldformat.h"
+
+using Tellico::Data::ValueIndex;
+
+ValueIndex::ValueIndex() {
+}
+
+void ValueIndex::addEntry(ID id_, const QString& value_) {
+  if(m_entryValues.contains(id_)) {
+    updateEntry(id_, value_);
+    return;
+  }
+  if(value_.isEmpty()) {
+    return;
+  }
+  m_entryValues.insert(id_, value_);
+  addValues(value_);
+}
+
+void ValueIndex::removeEntry(ID id_) {
+  removeValues(m_entryValues.take(id_));
+}
+
+void ValueIndex::updateEntry(ID id_, const QString& value_) {
+  QHash<ID, QString>::iterator it = m_entryValues.find(id_);
+  if(it == m_entryValues.end()) {
+    addEntry(id_, value_);
+    return;
+  }
+  if(it.value() == value_) {
+    return;
+  }
+  removeValues(it.value());
+  if(value_.isEmpty()) {
+    m_entryValues.erase(it);
+  } else {
+    it.value() = value_;
+    addValues(value_);
+  }
+}
+
+void ValueIndex::addValues(const QString& value_) {
+  if(value_.isEmpty()) {
+    return;
+  }
+  // count each value only once per entry
+  const QStringList values = FieldFormat::splitValue(value_);
+  for(int i = 0; i < values.count(); ++i) {
+    const QString& value = values.at(i);
+    if(!value.isEmpty() && !values.mid(0, i).contains(value)) {
+      ++m_counts[value];
+    }
+  }
+}
+
+void ValueIndex::removeValues(const QString& value_) {
+  if(value_.isEmpty()) {
+    return;
+  }
+  const QStringList values = FieldFormat::splitValue(value_);
+  for(int i = 0; i < values.count(); ++i) {
+    const QString& value = values.at(i);
+    if(value.isEmpty() || values.mid(0, i).contains(value)) {
+      continue;
+    }
+    QHash<QString, int>::iterator it = m_counts.find(value);
+    if(it != m_counts.end() && --it.value() <= 0) {
+      m_counts.erase(it);
+    }
+  }
+}
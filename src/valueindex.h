@@ -0,0 +1,74 @@
+/***************************************************************************
+    Copyright (C) 2018 Robby Stephenson <robby@periapsis.org>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef TELLICO_VALUEINDEX_H
+#define TELLICO_VALUEINDEX_H
+
+#include "datavectors.h"
+
+#include <QHash>
+#include <QStringList>
+
+namespace Tellico {
+  namespace Data {
+
+/**
+ * The ValueIndex keeps track of every distinct value of a single field throughout
+ * a collection, along with the number of entries using it. Multiple values are split
+ * apart. The entry's last indexed value is remembered, so updates only need to
+ * compare against it rather than rescanning the whole collection.
+ *
+ * @author Robby Stephenson
+ */
+class ValueIndex {
+
+public:
+  ValueIndex();
+
+  void addEntry(ID id, const QString& value);
+  void removeEntry(ID id);
+  /**
+   * Updates the index for an entry's new value. Nothing is done if the value is unchanged.
+   */
+  void updateEntry(ID id, const QString& value);
+
+  QStringList values() const { return m_counts.keys(); }
+  /**
+   * Returns each value mapped to the number of entries using it
+   */
+  const QHash<QString, int>& valueCounts() const { return m_counts; }
+  int count(const QString& value) const { return m_counts.value(value); }
+
+private:
+  void addValues(const QString& value);
+  void removeValues(const QString& value);
+
+  QHash<ID, QString> m_entryValues;
+  QHash<QString, int> m_counts;
+};
+
+  } // end namespace
+} // end namespace
+
+#endif